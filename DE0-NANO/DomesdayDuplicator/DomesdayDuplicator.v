@@ -14,17 +14,40 @@ module DomesdayDuplicator(
 	inout [33:0] GPIO0,
 	inout [33:0] GPIO1,
 	output [7:0] LED
+`ifdef SDRAM_FIFO
+	,
+	// DE0-Nano SDRAM (only used by the SDRAM FIFO)
+	output [12:0] DRAM_ADDR,
+	output [1:0] DRAM_BA,
+	output DRAM_CAS_N,
+	output DRAM_CKE,
+	output DRAM_CLK,
+	output DRAM_CS_N,
+	inout [15:0] DRAM_DQ,
+	output [1:0] DRAM_DQM,
+	output DRAM_RAS_N,
+	output DRAM_WE_N
+`endif
 );
 
 // FX3 Hardware mapping begins ------------------------------------------------
 
 // Generic pin-mapping for FX3 (DomDupBoard revisions 2_0 to 3_0)
+//
+// The data bus is 16-bits wide by default.  Defining the GPIF_32BIT
+// macro (see DomesdayDuplicator.qsf) selects the full 32-bit data bus;
+// the FX3 firmware must be built with DOMDUP_GPIF_32BIT to match.
+`ifdef GPIF_32BIT
+wire [31:0] fx3_databus;	// 32-bit databus
+`else
 wire [15:0] fx3_databus;	// 32-bit databus (only 16-bits used)
+`endif
 wire [12:0] fx3_control;	// 13-bit control bus
 wire fx3_clock;				// FX3 GPIF Clock
 
 // 32-bit data bus physical mapping (output only)
-// Note: board supports 32-bits; software is limited to 16-bits
+// Note: board supports 32-bits; the upper 16-bits are only used in
+// 32-bit GPIF mode
 assign GPIO1[32] = fx3_databus[00];
 assign GPIO1[30] = fx3_databus[01];
 assign GPIO1[28] = fx3_databus[02];
@@ -42,7 +65,27 @@ assign GPIO1[06] = fx3_databus[13];
 assign GPIO1[04] = fx3_databus[14];
 assign GPIO1[02] = fx3_databus[15];
 
-// High-Z the unused FX3 databus pins 
+`ifdef GPIF_32BIT
+// Mappings for 32-bit databus
+assign GPIO0[02] = fx3_databus[16];
+assign GPIO0[03] = fx3_databus[17];
+assign GPIO0[04] = fx3_databus[18];
+assign GPIO0[05] = fx3_databus[19];
+assign GPIO0[06] = fx3_databus[20];
+assign GPIO0[07] = fx3_databus[21];
+assign GPIO0[12] = fx3_databus[22];
+assign GPIO0[13] = fx3_databus[23];
+assign GPIO0[14] = fx3_databus[24];
+assign GPIO0[15] = fx3_databus[25];
+assign GPIO0[16] = fx3_databus[26];
+assign GPIO0[17] = fx3_databus[27];
+assign GPIO0[18] = fx3_databus[28];
+assign GPIO0[19] = fx3_databus[29];
+assign GPIO0[20] = fx3_databus[30];
+assign GPIO0[21] = fx3_databus[31];
+`else
+// High-Z the unused FX3 databus pins (GPIO0[12] to [21] are the second
+// ADC's data bus in DUAL_ADC builds, see below)
 assign GPIO0[02] = 1'bZ;
 assign GPIO0[03] = 1'bZ;
 assign GPIO0[04] = 1'bZ;
@@ -59,24 +102,7 @@ assign GPIO0[18] = 1'bZ;
 assign GPIO0[19] = 1'bZ;
 assign GPIO0[20] = 1'bZ;
 assign GPIO0[21] = 1'bZ;
-
-// Mappings for 32-bit databus
-//assign GPIO0[02] = fx3_databus[16];
-//assign GPIO0[03] = fx3_databus[17];
-//assign GPIO0[04] = fx3_databus[18];
-//assign GPIO0[05] = fx3_databus[19];
-//assign GPIO0[06] = fx3_databus[20];
-//assign GPIO0[07] = fx3_databus[21];
-//assign GPIO0[12] = fx3_databus[22];
-//assign GPIO0[13] = fx3_databus[23];
-//assign GPIO0[14] = fx3_databus[24];
-//assign GPIO0[15] = fx3_databus[25];
-//assign GPIO0[16] = fx3_databus[26];
-//assign GPIO0[17] = fx3_databus[27];
-//assign GPIO0[18] = fx3_databus[28];
-//assign GPIO0[19] = fx3_databus[29];
-//assign GPIO0[20] = fx3_databus[30];
-//assign GPIO0[21] = fx3_databus[31];
+`endif
 
 // FX3 Clock physical mapping
 assign GPIO1[31] = fx3_clock; // FX3 GPIO_16
@@ -101,11 +127,11 @@ assign fx3_control[10] = GPIO1[07];	// FX3 CTL_10 GPIO_27
 // High-Z the unused GPIO0 pins
 assign GPIO0[0] = 1'bZ;
 assign GPIO0[1] = 1'bZ;
-assign GPIO0[8] = 1'bZ;
-assign GPIO0[9] = 1'bZ;
 assign GPIO0[10] = 1'bZ;
 assign GPIO0[11] = 1'bZ;
+`ifndef DUAL_ADC
 assign GPIO0[22] = 1'bZ;
+`endif
 assign GPIO0[23] = 1'bZ;
 assign GPIO0[24] = 1'bZ;
 assign GPIO0[25] = 1'bZ;
@@ -134,50 +160,79 @@ assign GPIO1[33] = 1'bZ;
 // FX3 Signal mapping:
 //
 // CLK					GPIO16		PCLK		Output	- Data clock
-// Databus				GPIO0:15					Output	- Databus
+// Databus				GPIO0:15					Output	- Databus (plus DQ16:31 in 32-bit mode)
 // dataAvailable		GPIO_17		CTL_00	Output	- FPGA signals if data is available for reading
 // nReset				GPIO_27		CTL_10	Input		- FX3 signals (not) reset condition
-// collectData			GPIO_19		CTL_02	Input		- Unused
+// collectData			GPIO_19		CTL_02	Input		- FX3 signals the host is collecting data
 // readData				GPIO_18		CTL_01	Input		- FX3 signals it is reading from the databus
 
 // input0				GPIO_20		CTL_03	Output	- Buffer error flag from FPGA
-// input1				GPIO_21		CTL_04	Output	- Unused
-// input2				GPIO_28		CTL_11	Output	- Unused
-// input3				GPIO_29		CTL_12	Output	- Unused
+// input1				GPIO_21		CTL_04	Output	- Register interface MISO
+// input2				GPIO_28		CTL_11	Output	- Unused (held low; reserved for player control)
+// input3				GPIO_29		CTL_12	Output	- Unused (held low; reserved for player control)
 
-// outputE0				GPIO_22		CTL_05	Input		- FX3 Configuration bit 0 (Test mode off/on)
-// outputD0				GPIO_23		CTL_06	Input		- FX3 Configuration bit 1 (Unused)
-// outputD1				GPIO_24		CTL_07	Input		- FX3 Configuration bit 2 (Unused)
-// outputD2				GPIO_25		CTL_08	Input		- FX3 Configuration bit 3 (Unused)
-// outputD3				GPIO_26		CTL_09	Input		- FX3 Configuration bit 4 (Unused)
+// outputE0				GPIO_22		CTL_05	Input		- Spare (held low by the FX3)
+// outputD0				GPIO_23		CTL_06	Input		- Spare (held low by the FX3)
+// outputD1				GPIO_24		CTL_07	Input		- Register interface nCS
+// outputD2				GPIO_25		CTL_08	Input		- Register interface SCLK
+// outputD3				GPIO_26		CTL_09	Input		- Register interface MOSI
 
 // Wire definitions for FX3 GPIO mapping
 wire fx3_nReset;
+wire fx3_collectData;
 wire fx3_dataAvailable;
 wire fx3_readData;
 wire fx3_bufferError;
 wire fx3_testMode;
+wire fx3_packedMode;
+wire fx3_registerMiso;
+wire fx3_registerNCS;
+wire fx3_registerSclk;
+wire fx3_registerMosi;
+wire [31:0] fx3_controlRegister;
+wire fx3_headerMode;
+wire [1:0] fx3_sampleRateSelect;
+wire fx3_decimationMode;
+wire fx3_compressionMode;
+wire fx3_soakMode;
+wire fx3_packetCrcMode;
+wire fx3_twoChannelMode;
+wire [1:0] fx3_packetSize;			// Packet size (register 0x25, see buffer.v)
 
 // Signal outputs to FX3
 assign fx3_control[00] 		= fx3_dataAvailable;
 assign fx3_control[03] 		= fx3_bufferError;
+assign fx3_control[04]		= fx3_registerMiso;
 
-// These are currently unused, but must have a defined value
-assign fx3_control[04]	= 1'b0;
+// These are currently unused, but must have a defined value.  They are
+// reserved for future player-control inputs, which will also be picked
+// up by the input line markers (see inputMarkers0 below)
 assign fx3_control[11]	= 1'b0;
 assign fx3_control[12]	= 1'b0;
 
 // Signal inputs from FX3
 assign fx3_nReset      = fx3_control[10];
-//assign fx3_unused = fx3_control[02];
+assign fx3_collectData = fx3_control[02];
 assign fx3_readData    = fx3_control[01];
 
-// Signal inputs from FX3 (configuration bits)
-assign fx3_testMode    		= fx3_control[05];
-//assign fx3_configBit1    = fx3_control[06];
-//assign fx3_configBit2 	= fx3_control[07];
-//assign fx3_configBit3		= fx3_control[07];
-//assign fx3_configBit4 	= fx3_control[07];
+// fx3_control[05] and [06] (FX3 GPIO 22 and 23) are spare; the FX3 holds
+// them low
+
+// Signal inputs from FX3 (register interface)
+assign fx3_registerNCS		= fx3_control[07];
+assign fx3_registerSclk		= fx3_control[08];
+assign fx3_registerMosi		= fx3_control[09];
+
+// Configuration from the FPGA control register
+assign fx3_testMode			= fx3_controlRegister[0];
+assign fx3_packedMode		= fx3_controlRegister[1];
+assign fx3_headerMode		= fx3_controlRegister[2];
+assign fx3_sampleRateSelect	= fx3_controlRegister[4:3];
+assign fx3_decimationMode	= fx3_controlRegister[5];
+assign fx3_compressionMode	= fx3_controlRegister[6];
+assign fx3_soakMode			= fx3_controlRegister[7];
+assign fx3_packetCrcMode		= fx3_controlRegister[8];
+assign fx3_twoChannelMode	= fx3_controlRegister[9];
 
 // FX3 Hardware mapping ends --------------------------------------------------
 
@@ -199,74 +254,815 @@ assign adc_databus[8] = GPIO0[24];
 assign adc_databus[9] = GPIO0[23];
 
 // ADC clock output
-// Select the correct sampling clock based on the configuration
+// The sampling clock is selected based on the configuration (see
+// clockSelect below)
 wire adc_clock;
 assign GPIO0[33] = adc_clock;
 
+// Second ADC (channel B)
+//
+// Defining the DUAL_ADC macro (see DomesdayDuplicator.qsf) adds a
+// second ADC on the spare GPIO0 pins that carry the upper 16 bits of
+// the FX3 data bus in 32-bit builds, so the two options can't be used
+// together.  The second ADC is clocked with the same sampling clock
+// as the first.  Two-channel mode (bit 9 of the control register)
+// interleaves the two channels into the sample stream (see
+// channelInterleave.v).
+wire [9:0] adc_databusB;
+wire adc_twoChannelMode;
+
+`ifdef DUAL_ADC
+`ifdef GPIF_32BIT
+DUAL_ADC_cannot_be_used_with_GPIF_32BIT error();
+`endif
+
+// 10-bit databus from the second ADC
+assign adc_databusB[0] = GPIO0[21];
+assign adc_databusB[1] = GPIO0[20];
+assign adc_databusB[2] = GPIO0[19];
+assign adc_databusB[3] = GPIO0[18];
+assign adc_databusB[4] = GPIO0[17];
+assign adc_databusB[5] = GPIO0[16];
+assign adc_databusB[6] = GPIO0[15];
+assign adc_databusB[7] = GPIO0[14];
+assign adc_databusB[8] = GPIO0[13];
+assign adc_databusB[9] = GPIO0[12];
+
+// Second ADC clock output
+assign GPIO0[22] = adc_clock;
+
+assign adc_twoChannelMode = fx3_twoChannelMode;
+`else
+assign adc_databusB = 10'd0;
+assign adc_twoChannelMode = 1'b0;
+`endif
+
 // ADC Hardware mapping ends --------------------------------------------------
 
 
+// Sync connector mapping begins ----------------------------------------------
+
+// Connects Duplicators for synchronised capture (see syncControl.v);
+// the master drives the pins and the slaves receive from them
+//
+// GPIO0[8] - Sampling clock
+// GPIO0[9] - Start strobe (active low)
+wire sync_clockIn;
+wire sync_nStartIn;
+wire sync_nStartOut;
+wire sync_isMaster;
+
+assign GPIO0[8] = sync_isMaster ? adc_clock : 1'bZ;
+assign GPIO0[9] = sync_isMaster ? sync_nStartOut : 1'bZ;
+assign sync_clockIn = GPIO0[8];
+assign sync_nStartIn = GPIO0[9];
+
+// Sync connector mapping ends ------------------------------------------------
+
+
 // Application logic begins ---------------------------------------------------
 
 
 // PLL clock generation
 // Generate 60 MHz FX3/FPGA system clock from the 50 MHz physical clock and
-// 40 MHz sampling clock
+// the 40 MHz and 20 MHz sampling clocks
+//
+// Defining the FX3_CLOCK_80MHZ macro (see DomesdayDuplicator.qsf) runs
+// the FX3 GPIF interface at 80 MHz instead, for more bus headroom over
+// the 80 MB/s stream (160 MB/s on the 16-bit bus rather than 120 MB/s);
+// the FX3 firmware must be built with DOMDUP_GPIF_CLOCK_80MHZ to match.
+wire adc_clock40;
+wire adc_clock28;
+wire adc_clock20;
+
+`ifdef FX3_CLOCK_80MHZ
+IPpllGenerator80 IPpllGenerator0 (
+	// Inputs
+	.inclk0(CLOCK_50),
+	
+	// Outputs
+	.c0(fx3_clock),	// 80 MHz system clock
+	.c1(adc_clock40),	// 40 MHz ADC clock
+	.c2(adc_clock20)	// 20 MHz ADC clock
+);
+`else
 IPpllGenerator IPpllGenerator0 (
 	// Inputs
 	.inclk0(CLOCK_50),
 	
 	// Outputs
 	.c0(fx3_clock),	// 60 MHz system clock
-	.c1(adc_clock)		// 40 MHz ADC clock
+	.c1(adc_clock40),	// 40 MHz ADC clock
+	.c2(adc_clock20)	// 20 MHz ADC clock
+);
+`endif
+
+// Generate the 28.636 MHz (8 x NTSC fsc) sampling clock
+IPpllNtsc IPpllNtsc0 (
+	// Inputs
+	.inclk0(CLOCK_50),
+	
+	// Outputs
+	.c0(adc_clock28)	// 28.636 MHz ADC clock
 );
 
+// Multi-device synchronisation
+wire [1:0] sync_role;
+wire sync_startRequest;
+wire sync_sequenceRestart;
+wire sync_clockPresent;
+wire sync_clockSelect;
+wire [31:0] sync_clockRate;
+wire sync_started;
+wire [31:0] sync_status;
+
+assign sync_isMaster = (sync_role == 2'd1);
+
+syncControl syncControl0 (
+	// Inputs
+	.nReset(fx3_nReset),						// Not reset
+	.statusClock(fx3_clock),				// FX3 clock
+	.sampleClock(adc_clock),				// ADC clock
+	.role(sync_role),							// 0 = Stand-alone, 1 = Master, 2 = Slave
+	.startRequest(sync_startRequest),	// Toggle to send a start strobe (master)
+	.syncClockIn(sync_clockIn),			// Sync connector clock
+	.nSyncStartIn(sync_nStartIn),			// Sync connector start strobe
+	
+	// Outputs
+	.nSyncStartOut(sync_nStartOut),		// Start strobe to the sync connector (master)
+	.sequenceRestart(sync_sequenceRestart),	// 1 = Restart the sequence counter
+	.syncClockPresent(sync_clockPresent),	// 1 = Sync clock is running
+	.syncClockSelect(sync_clockSelect),	// 1 = Sample from the sync clock (slave)
+	.syncClockRate(sync_clockRate),		// Measured sync clock rate in Hz
+	.syncStarted(sync_started)				// 1 = Start strobe sent or received
+);
+
+// Sync status register (see registerInterface.v)
+//
+// Bit 0 - Sync clock present
+// Bit 1 - Sampling from the sync clock
+// Bit 2 - Start strobe sent (master) or received (slave)
+assign sync_status = {29'd0, sync_started, (adc_clockActive == 3'd3), sync_clockPresent};
+
+// Select the sampling clock
+// The rate is selected by bits 4:3 of the control register:
+// 0 = 40 MHz, 1 = 28.636 MHz, 2 = 20 MHz (3 = 40 MHz).  A slave uses
+// the sync clock from the master whilst it is present.
+wire [1:0] adc_clockSelect;
+wire [2:0] adc_clockActive;
+reg [31:0] adc_sampleRate;
+
+assign adc_clockSelect = sync_clockSelect ? 2'd3 :
+	(fx3_sampleRateSelect == 2'd3) ? 2'd0 : fx3_sampleRateSelect;
+
+clockSelect clockSelect0 (
+	// Inputs
+	.statusClock(fx3_clock),			// FX3 clock
+	.select(adc_clockSelect),			// Selected sampling clock
+	.clock0(adc_clock40),				// 40 MHz ADC clock
+	.clock1(adc_clock28),				// 28.636 MHz ADC clock
+	.clock2(adc_clock20),				// 20 MHz ADC clock
+	.clock3(sync_clockIn),				// Sync connector clock
+	.clock3Valid(sync_clockSelect),	// 1 = Sync clock can be used
+	
+	// Outputs
+	.clockOut(adc_clock),				// Sampling clock
+	.activeClock(adc_clockActive)		// Currently selected clock (4 = changing)
+);
+
+// Sampling rate in Hz (reported to the FX3 by the register interface)
+always @ (*) begin
+	case (adc_clockActive)
+		3'd0: adc_sampleRate = 32'd40000000;
+		3'd1: adc_sampleRate = 32'd28636364;
+		3'd2: adc_sampleRate = 32'd20000000;
+		3'd3: adc_sampleRate = sync_clockRate;
+		default: adc_sampleRate = 32'd0;
+	endcase
+end
+
+`ifdef SDRAM_FIFO
+// SDRAM clock generation
+// Generate the 120 MHz SDRAM controller clock and the phase shifted
+// SDRAM device clock from the 50 MHz physical clock
+wire sdram_clock;
+
+IPpllSdram IPpllSdram0 (
+	// Inputs
+	.inclk0(CLOCK_50),
+	
+	// Outputs
+	.c0(sdram_clock),	// 120 MHz SDRAM controller clock
+	.c1(DRAM_CLK)		// 120 MHz SDRAM device clock (-3 ns)
+);
+`endif
+
+// Sample path reset
+//
+// The sample path (from the data generator to the FX3 state-machine)
+// is held in reset whilst the host is not collecting data.  Starting a
+// collection flushes the buffers and restarts the sample index and the
+// sequence numbers, so the first packet sent always starts with sample
+// 0.  The register interface, the sampling clock and the sync control
+// are not affected.
+wire sample_nReset;
+assign sample_nReset = fx3_nReset && fx3_collectData;
+
 wire fx3_isReading;
 wire [15:0] dataGeneratorOut;
 
 // Generate 16-bit data either from the ADC or the test data generator
 dataGenerator dataGenerator0 (
 	// Inputs
-	.nReset(fx3_nReset),				// Not reset
+	.nReset(sample_nReset),				// Sample path not reset
 	.clock(adc_clock),				// ADC clock
 	.adc_databus(adc_databus),		// 10-bit ADC databus
 	.testModeFlag(fx3_testMode),	// 1 = Test mode on
+	.soakModeFlag(fx3_soakMode),	// 1 = Soak mode on
+	.restart(sync_sequenceRestart),	// 1 = Restart the sequence counter
 	
 	// Outputs
 	.dataOut(dataGeneratorOut)		// 16-bit data out
 );
 
+// Signal preview
+//
+// A second data generator feeds the preview generator.  It is only
+// reset with the FX3, so the preview runs whether or not the host is
+// collecting data.
+wire [15:0] previewDataOut;
+wire [9:0] preview_min;
+wire [9:0] preview_max;
+wire [10:0] preview_number;
+wire preview_update;
+
+dataGenerator dataGeneratorPreview (
+	// Inputs
+	.nReset(fx3_nReset),				// Not reset
+	.clock(adc_clock),				// ADC clock
+	.adc_databus(adc_databus),		// 10-bit ADC databus
+	.testModeFlag(fx3_testMode),	// 1 = Test mode on
+	.soakModeFlag(fx3_soakMode),	// 1 = Soak mode on
+	.restart(1'b0),					// Sequence number not used
+	
+	// Outputs
+	.dataOut(previewDataOut)		// 16-bit data out
+);
+
+previewGenerator previewGenerator0 (
+	// Inputs
+	.nReset(fx3_nReset),				// Not reset
+	.clock(adc_clock),				// ADC clock
+	.dataIn(previewDataOut[9:0]),	// 10-bit samples
+	
+	// Outputs
+	.windowMin(preview_min),		// Smallest sample in the last window
+	.windowMax(preview_max),		// Largest sample in the last window
+	.windowNumber(preview_number),	// Number of the last window
+	.windowUpdate(preview_update)	// Toggles at the end of each window
+);
+
+// RF level and clipping statistics (from the preview data generator,
+// so they are also measured whilst the host is not collecting data)
+wire stats_hold;
+wire [6:0] stats_address;
+wire [31:0] stats_readData;
+
+rfStatistics rfStatistics0 (
+	// Inputs
+	.nReset(fx3_nReset),				// Not reset
+	.clock(adc_clock),				// ADC clock
+	.dataIn(previewDataOut[9:0]),	// 10-bit samples
+	.hold(stats_hold),				// 1 = Hold the snapshot
+	.readAddress(stats_address),	// Register being read
+	
+	// Outputs
+	.readData(stats_readData)		// Register read data
+);
+
+wire [15:0] decimationFilterOut;
+wire decimationFilterValid;
+
+// Both channels are decimated in two-channel mode, so the interleaved
+// stream has the same sample rate as a single channel
+wire adc_decimationMode;
+assign adc_decimationMode = fx3_decimationMode || adc_twoChannelMode;
+
+// Optionally low-pass filter and decimate the samples (2:1)
+decimationFilter decimationFilter0 (
+	// Inputs
+	.nReset(sample_nReset),						// Sample path not reset
+	.clock(adc_clock),						// ADC clock
+	.decimationMode(adc_decimationMode),	// 1 = Decimation mode on
+	.dataIn(dataGeneratorOut),				// 16-bit data in
+	
+	// Outputs
+	.dataOut(decimationFilterOut),		// 16-bit data out
+	.dataValid(decimationFilterValid)	// 1 = dataOut is valid
+);
+
+// Second channel (DUAL_ADC builds)
+//
+// Channel B has its own data generator and decimation filter, reset
+// together with channel A's so the two filters run in step.  Without
+// DUAL_ADC the interleaver only passes channel A on.
+wire [15:0] interleaveOut;
+wire interleaveValid;
+
+`ifdef DUAL_ADC
+wire [15:0] dataGeneratorOutB;
+wire [15:0] decimationFilterOutB;
+wire decimationFilterValidB;
+
+dataGenerator dataGeneratorB (
+	// Inputs
+	.nReset(sample_nReset),				// Sample path not reset
+	.clock(adc_clock),				// ADC clock
+	.adc_databus(adc_databusB),		// 10-bit second ADC databus
+	.testModeFlag(fx3_testMode),	// 1 = Test mode on
+	.soakModeFlag(fx3_soakMode),	// 1 = Soak mode on
+	.restart(sync_sequenceRestart),	// 1 = Restart the sequence counter
+	
+	// Outputs
+	.dataOut(dataGeneratorOutB)		// 16-bit data out
+);
+
+decimationFilter decimationFilterB (
+	// Inputs
+	.nReset(sample_nReset),						// Sample path not reset
+	.clock(adc_clock),						// ADC clock
+	.decimationMode(adc_decimationMode),	// 1 = Decimation mode on
+	.dataIn(dataGeneratorOutB),				// 16-bit data in
+	
+	// Outputs
+	.dataOut(decimationFilterOutB),		// 16-bit data out
+	.dataValid(decimationFilterValidB)	// 1 = dataOut is valid
+);
+
+channelInterleave channelInterleave0 (
+	// Inputs
+	.nReset(sample_nReset),					// Sample path not reset
+	.clock(adc_clock),						// ADC clock
+	.twoChannelMode(adc_twoChannelMode),	// 1 = Two-channel mode on
+	.dataInA(decimationFilterOut),		// Channel A data in
+	.dataInValidA(decimationFilterValid),	// 1 = dataInA is valid
+	.dataInB(decimationFilterOutB),		// Channel B data in
+	.dataInValidB(decimationFilterValidB),	// 1 = dataInB is valid
+	
+	// Outputs
+	.dataOut(interleaveOut),				// 16-bit data out
+	.dataValid(interleaveValid)			// 1 = dataOut is valid
+);
+`else
+assign interleaveOut = decimationFilterOut;
+assign interleaveValid = decimationFilterValid;
+`endif
+
+// Armed capture
+//
+// In armed mode the samples are only passed on once the trigger
+// condition has been met, starting with the pre-trigger history (see
+// captureTrigger.v and registerInterface.v).  Armed mode is off in
+// two-channel mode, so the stream always starts with a channel A
+// sample.
+wire [31:0] trigger_control;
+wire [23:0] trigger_holdCount;
+wire [11:0] trigger_preTrigger;
+wire trigger_triggered;
+wire [47:0] trigger_firstSampleIndex;
+wire [15:0] triggerOut;
+wire triggerValid;
+
+// Pre-trigger history size (see captureTrigger.v)
+`ifdef TRIGGER_HISTORY_BITS
+localparam triggerHistoryBits = `TRIGGER_HISTORY_BITS;
+`else
+localparam triggerHistoryBits = 12;
+`endif
+
+captureTrigger #(
+	.historyBits(triggerHistoryBits)
+) captureTrigger0 (
+	// Inputs
+	.nReset(sample_nReset),					// Sample path not reset
+	.clock(adc_clock),						// ADC clock
+	.armedMode(trigger_control[0] && !adc_twoChannelMode),	// 1 = Armed mode on
+	.activityMode(trigger_control[1]),	// 1 = Activity condition (0 = level)
+	.level(trigger_control[11:2]),		// Trigger level
+	.holdCount(trigger_holdCount),		// Samples the condition must hold for
+	.preTrigger(trigger_preTrigger),		// Pre-trigger history in samples
+	.dataIn(interleaveOut),					// 16-bit data in
+	.dataInValid(interleaveValid),		// 1 = dataIn is valid
+	
+	// Outputs
+	.dataOut(triggerOut),					// 16-bit data out
+	.dataValid(triggerValid),				// 1 = dataOut is valid
+	.triggered(trigger_triggered),		// 1 = Trigger condition met
+	.firstSampleIndex(trigger_firstSampleIndex)	// Index of the first sample passed on
+);
+
+// Sample source for the packer and the buffer
+//
+// Normally the packer and the buffer's write side take each sample
+// from the armed capture module on the ADC clock.  In SDRAM FIFO builds
+// (SDRAM_FIFO defined) the samples are passed through the SDRAM FIFO;
+// the packer and the buffer's write
+// side then run from the FX3 clock and take the samples as the buffer
+// is ready for them.
+wire sampleClock;
+wire [15:0] sampleData;
+wire sampleValid;
+wire bufferWriteReady;
+
+wire [31:0] overflowCount;
+wire [47:0] overflowIndex;
+wire overflowUpdate;
+
+wire bufferOverflow;
+wire [31:0] bufferOverflowCount;
+wire [47:0] bufferOverflowIndex;
+wire bufferOverflowUpdate;
+
+`ifdef SDRAM_FIFO
+wire sdramFifoValid;
+wire [31:0] sdramFifoOverflowCount;
+wire sdramFifoOverflowUpdate;
+
+assign sampleClock = fx3_clock;
+assign sampleValid = sdramFifoValid && bufferWriteReady;
+
+// SDRAM elastic FIFO
+sdramFifo sdramFifo0 (
+	// Inputs
+	.nReset(sample_nReset),					// Sample path not reset
+	.writeClock(adc_clock),				// ADC clock
+	.readClock(fx3_clock),				// FX3 clock
+	.sdramClock(sdram_clock),			// SDRAM controller clock
+	.dataIn(triggerOut),					// 16-bit data in
+	.dataInValid(triggerValid),			// 1 = dataIn is valid
+	.dataRead(sampleValid),				// 1 = Take the sample on dataOut
+	
+	// Outputs
+	.dataOut(sampleData),				// 16-bit data out
+	.dataValid(sdramFifoValid),			// 1 = dataOut is valid
+	.bufferOverflow(fx3_bufferError),	// Set if samples are dropped
+	.overflowCount(sdramFifoOverflowCount),	// Number of overflows
+	.overflowIndex(overflowIndex),		// Sample index of the last overflow
+	.overflowUpdate(sdramFifoOverflowUpdate),	// Toggles when the overflow status changes
+	
+	// SDRAM
+	.sdramAddress(DRAM_ADDR),
+	.sdramBank(DRAM_BA),
+	.sdramCke(DRAM_CKE),
+	.sdramNCs(DRAM_CS_N),
+	.sdramNRas(DRAM_RAS_N),
+	.sdramNCas(DRAM_CAS_N),
+	.sdramNWe(DRAM_WE_N),
+	.sdramDqm(DRAM_DQM),
+	.sdramDq(DRAM_DQ)
+);
+
+// Overflows are reported by the SDRAM FIFO (the buffer never overflows)
+assign overflowCount = sdramFifoOverflowCount;
+assign overflowUpdate = sdramFifoOverflowUpdate;
+`else
+assign sampleClock = adc_clock;
+assign sampleData = triggerOut;
+assign sampleValid = triggerValid;
+
+assign fx3_bufferError = bufferOverflow;
+assign overflowCount = bufferOverflowCount;
+assign overflowIndex = bufferOverflowIndex;
+assign overflowUpdate = bufferOverflowUpdate;
+`endif
+
+// Input line markers
+//
+// Records the sample index at which each FPGA to FX3 input line
+// changes (see inputMarkers.v and registerInterface.v).  The samples
+// are counted as they are passed on by the armed capture module,
+// which is the packet header sample index unless the SDRAM FIFO has
+// dropped samples.
+//
+// Only bit 0 (the buffer error flag) can change at present.  Bit 1 is
+// the register interface MISO, which is never recorded, and bits 2 and
+// 3 follow fx3_control[11] and [12], which are held low above.  They
+// are placeholders so that player-control inputs driven on those lines
+// in future are marked without changing the marker registers, firmware
+// or host.
+wire [3:0] marker_lineChanged;
+wire [47:0] marker_index;
+wire [3:0] marker_changed;
+wire [3:0] marker_levels;
+wire marker_update;
+
+inputMarkers inputMarkers0 (
+	// Inputs
+	.nReset(sample_nReset),					// Sample path not reset
+	.clock(adc_clock),						// ADC clock
+	.lines({fx3_control[12], fx3_control[11], 1'b0, fx3_bufferError}),	// FPGA to FX3 input lines
+	.sampleValid(triggerValid),			// 1 = A sample is passed on
+	
+	// Outputs
+	.lineChanged(marker_lineChanged),	// Set for a clock when a line changes
+	.markerIndex(marker_index),			// Sample index of the last marker
+	.markerChanged(marker_changed),		// Lines that changed
+	.markerLevels(marker_levels),			// Line levels after the change
+	.markerUpdate(marker_update)			// Toggles when a marker is recorded
+);
+
+wire [15:0] samplePackerOut;
+wire samplePackerValid;
+wire samplePackerPacked;
+wire samplePackerHeader;
+wire samplePackerCompressed;
+wire [47:0] samplePackerIndex;
+
+// Optionally pack or compress the 10-bit samples into a continuous bit-stream
+samplePacker samplePacker0 (
+	// Inputs
+	.nReset(sample_nReset),					// Sample path not reset
+	.clock(sampleClock),				// ADC clock (FX3 clock with SDRAM FIFO)
+	.packedMode(fx3_packedMode),		// 1 = Packed mode on
+	.headerMode(fx3_headerMode),		// 1 = Packet header mode on
+	.compressionMode(fx3_compressionMode),	// 1 = Compressed mode on
+	.packetSize(fx3_packetSize),			// 0 = 16 KB, 1 = 8 KB, 2 = 4 KB packets
+	.dataIn(sampleData),					// 16-bit data in
+	.dataInValid(sampleValid),			// 1 = dataIn is valid
+	
+	// Outputs
+	.dataOut(samplePackerOut),			// 16-bit data out
+	.dataValid(samplePackerValid),		// 1 = dataOut is valid
+	.framePacked(samplePackerPacked),	// 1 = Current frame is packed
+	.frameHeader(samplePackerHeader),	// 1 = Current frame has a packet header
+	.frameCompressed(samplePackerCompressed),	// 1 = Current frame is compressed
+	.frameSampleIndex(samplePackerIndex)	// Index of the first sample in the frame
+);
+
+wire packetHeaderEnable;
+wire [127:0] packetHeader;
+wire [1:0] bufferWriteBank;
+wire [1:0] bufferReadBank;
+wire buffer_dataAvailable;
+`ifdef GPIF_32BIT
+wire [31:0] bufferDataOut;
+`else
+wire [15:0] bufferDataOut;
+`endif
+
 // FIFO buffer
 buffer buffer0 (
 	// Inputs
-	.nReset(fx3_nReset),						// Not reset
-	.writeClock(adc_clock),					// ADC clock
+	.nReset(sample_nReset),						// Sample path not reset
+	.writeClock(sampleClock),				// ADC clock (FX3 clock with SDRAM FIFO)
 	.readClock(fx3_clock),					// FX3 clock
 	.isReading(fx3_isReading),				// 1 = FX3 is reading data
-	.dataIn(dataGeneratorOut),				// 16-bit ADC data bus input
+	.dataIn(samplePackerOut),				// 16-bit ADC data bus input
+	.dataValid(samplePackerValid),		// 1 = dataIn is valid
+	.testMode(fx3_testMode),				// 1 = Test mode on
+	.soakMode(fx3_soakMode),				// 1 = Soak mode on
+	.decimationMode(adc_decimationMode),	// 1 = Decimation mode on
+	.twoChannelMode(adc_twoChannelMode),	// 1 = Two-channel mode on
+	.packetSize(fx3_packetSize),			// 0 = 16 KB, 1 = 8 KB, 2 = 4 KB packets
+	.framePacked(samplePackerPacked),	// 1 = Current frame is packed
+	.frameHeader(samplePackerHeader),	// 1 = Current frame has a packet header
+	.frameCompressed(samplePackerCompressed),	// 1 = Current frame is compressed
+	.frameSampleIndex(samplePackerIndex),	// Index of the first sample in the frame
+`ifdef SDRAM_FIFO
+	.lineChanged(4'd0),						// Not flagged (see buffer.v)
+	.upstreamOverflowCount(sdramFifoOverflowCount),	// SDRAM FIFO overflows
+	.upstreamOverflowUpdate(sdramFifoOverflowUpdate),	// Toggles when the count changes
+`else
+	.lineChanged(marker_lineChanged),	// Set for a clock when an input line changes
+`endif
 	
 	// Outputs
-	.bufferOverflow(fx3_bufferError),	// Set if a buffer overflow occurs
-	.dataAvailable(fx3_dataAvailable),	// Set if buffer contains at least 8192 words of data
-	.dataOut(fx3_databus)					// 16-bit data output
+	.writeReady(bufferWriteReady),		// 1 = Buffer can accept data
+	.bufferOverflow(bufferOverflow),		// Set if a buffer overflow occurs
+	.overflowCount(bufferOverflowCount),	// Number of buffer overflows
+	.overflowIndex(bufferOverflowIndex),	// Stream position of the last overflow
+	.overflowUpdate(bufferOverflowUpdate),	// Toggles when the overflow status changes
+	.dataAvailable(buffer_dataAvailable),	// Set if buffer contains a complete packet
+	.packetHeaderEnable(packetHeaderEnable),	// 1 = Packet being read has a header
+	.packetHeader(packetHeader),			// Header for the packet being read
+	.currentWriteBank(bufferWriteBank),	// Bank being written
+	.currentReadBank(bufferReadBank),	// Bank being read
+	.dataOut(bufferDataOut)					// 16 or 32-bit data output
 );
 
 // FX3 GPIF state-machine logic
+wire fx3_sendingPacket;
+wire fx3_packetStart;
+wire [15:0] fx3_wordCounter;
+
 fx3StateMachine fx3StateMachine0 (
 	// Inputs
-	.nReset(fx3_nReset),						// Not reset
+	.nReset(sample_nReset),						// Sample path not reset
 	.fx3_clock(fx3_clock),					// FX3 clock
 	.readData(fx3_readData),				// FX3 is about to start sampling the databus
+	.headerEnable(packetHeaderEnable),	// 1 = Send the packet header
+	.header(packetHeader),					// Packet header
+	.crcEnable(fx3_soakMode),				// 1 = End each packet with its CRC
+	.headerCrcEnable(fx3_packetCrcMode),	// 1 = Send each packet's CRC in the next header
+	.packetSize(fx3_packetSize),			// 0 = 16 KB, 1 = 8 KB, 2 = 4 KB packets
+	.dataIn(bufferDataOut),					// 16 or 32-bit data from the buffer
 	
 	// Output
-	.fx3isReading(fx3_isReading)			// Flag to indicate FX3 is sampling the databus
+	.dataOut(fx3_databus),					// 16 or 32-bit data output
+	.fx3isReading(fx3_isReading),			// Flag to indicate FX3 is sampling the databus
+	.sendingPacket(fx3_sendingPacket),	// 1 = Sending a packet
+	.packetStart(fx3_packetStart),		// 1 = A packet is starting
+	.wordCounter(fx3_wordCounter)			// Word of the packet being sent
+);
+
+// Capture length
+//
+// Stops sending packets to the FX3 once the requested number have
+// been sent (see captureLength.v and registerInterface.v)
+wire [29:0] capture_packetLimit;
+wire [31:0] capture_status;
+
+captureLength captureLength0 (
+	// Inputs
+	.nReset(sample_nReset),						// Sample path not reset
+	.clock(fx3_clock),						// FX3 clock
+	.packetLimit(capture_packetLimit),	// Packets to send (0 = no limit)
+	.dataAvailableIn(buffer_dataAvailable),	// Set if the buffer contains a complete packet
+	.packetStart(fx3_packetStart),		// 1 = A packet is starting
+	.sendingPacket(fx3_sendingPacket),	// 1 = Sending a packet
+	
+	// Outputs
+	.dataAvailableOut(fx3_dataAvailable),	// dataAvailable to the FX3
+	.status(capture_status)					// Capture length status register
+);
+
+// Buffer to FX3 pipeline statistics
+//
+// Measures the sustained bus words per cycle and the service stalls
+// seen by the buffer (see pipelineStats.v and registerInterface.v)
+wire [31:0] pipeline_clocks;
+wire [31:0] pipeline_busWords;
+wire [31:0] pipeline_stallMax;
+wire [31:0] pipeline_stallTotal;
+wire [31:0] pipeline_status;
+
+pipelineStats pipelineStats0 (
+	// Inputs
+	.nReset(sample_nReset),						// Sample path not reset
+	.clock(fx3_clock),						// FX3 clock
+	.dataAvailable(fx3_dataAvailable),	// dataAvailable to the FX3
+	.sendingPacket(fx3_sendingPacket),	// 1 = Sending a packet
+	.packetStart(fx3_packetStart),		// 1 = A packet is starting
+	.fx3isReading(fx3_isReading),			// 1 = FX3 is sampling the databus
+	.writeBank(bufferWriteBank),			// Bank being written
+	.readBank(bufferReadBank),				// Bank being read
+	
+	// Outputs
+	.clocks(pipeline_clocks),				// Clocks since collection started
+	.busWords(pipeline_busWords),			// Words read by the FX3
+	.stallMax(pipeline_stallMax),			// Longest service stall
+	.stallTotal(pipeline_stallTotal),	// Total service stall clocks
+	.status(pipeline_status)				// Peak banks waiting and bank count
+);
+
+// GPIF handshake logic analyzer
+//
+// Only built with the LOGIC_ANALYZER macro defined (see
+// DomesdayDuplicator.qsf); it takes 2 M9K blocks.  Without it the
+// register interface reads the analyzer status as 0.
+wire [31:0] analyzer_control;
+wire analyzer_arm;
+wire [8:0] analyzer_readAddress;
+wire [31:0] analyzer_status;
+wire [31:0] analyzer_readEntry;
+
+`ifdef LOGIC_ANALYZER
+logicAnalyzer logicAnalyzer0 (
+	// Inputs
+	.nReset(fx3_nReset),						// Not reset
+	.clock(fx3_clock),						// FX3 clock
+	.readData(fx3_readData),				// FX3 is requesting data
+	.fx3isReading(fx3_isReading),			// FPGA is reading the buffer
+	.dataAvailable(fx3_dataAvailable),	// A complete packet is waiting
+	.bufferOverflow(fx3_bufferError),	// Buffer overflow flag
+	.sendingPacket(fx3_sendingPacket),	// FX3 state-machine is sending a packet
+	.startPacket(fx3_packetStart),		// A packet is starting
+	.collectData(fx3_collectData),		// Host is collecting data
+	.readBank(bufferReadBank),				// Bank being read
+	.writeBank(bufferWriteBank),			// Bank being written (write clock domain)
+	.wordCounter(fx3_wordCounter),		// Word of the packet being sent
+	.arm(analyzer_arm),						// Clear the ring and start a capture
+	.enable(analyzer_control[31]),		// 1 = Capture enabled
+	.triggerMask(analyzer_control[6:0]),	// Trigger mask
+	.triggerValue(analyzer_control[14:8]),	// Trigger value
+	.postTrigger(analyzer_control[24:16]),	// Entries recorded after the trigger
+	.readAddress(analyzer_readAddress),	// Entry being read
+	
+	// Outputs
+	.readEntry(analyzer_readEntry),		// Entry at readAddress
+	.status(analyzer_status)				// Status register
+);
+`else
+assign analyzer_status = 32'd0;
+assign analyzer_readEntry = 32'd0;
+`endif
+
+// Build features register (see registerInterface.v)
+`ifdef DUAL_ADC
+localparam featureDualAdc = 1'b1;
+`else
+localparam featureDualAdc = 1'b0;
+`endif
+`ifdef SDRAM_FIFO
+localparam featureSdramFifo = 1'b1;
+`else
+localparam featureSdramFifo = 1'b0;
+`endif
+`ifdef LOGIC_ANALYZER
+localparam featureLogicAnalyzer = 1'b1;
+`else
+localparam featureLogicAnalyzer = 1'b0;
+`endif
+`ifdef GPIF_32BIT
+localparam featureGpif32Bit = 1'b1;
+`else
+localparam featureGpif32Bit = 1'b0;
+`endif
+`ifdef FX3_CLOCK_80MHZ
+localparam featureFx3Clock80 = 1'b1;
+`else
+localparam featureFx3Clock80 = 1'b0;
+`endif
+localparam featurePacketSize = 1'b1; // Always built
+
+wire [31:0] buildFeatures;
+assign buildFeatures = {26'd0, featurePacketSize, featureFx3Clock80, featureGpif32Bit, featureLogicAnalyzer,
+	featureSdramFifo, featureDualAdc};
+
+// FX3 register interface
+registerInterface registerInterface0 (
+	// Inputs
+	.nReset(fx3_nReset),						// Not reset
+	.clock(fx3_clock),						// FX3 clock
+	.nCS(fx3_registerNCS),					// Register interface chip select
+	.sclk(fx3_registerSclk),				// Register interface clock
+	.mosi(fx3_registerMosi),				// Register interface data from FX3
+	.overflowCount(overflowCount),		// Number of buffer overflows
+	.overflowIndex(overflowIndex),		// Stream position of the last overflow
+	.overflowUpdate(overflowUpdate),		// Toggles when the overflow status changes
+	.overflowClear(!sample_nReset),		// 1 = Clear the overflow status
+	.sampleRate(adc_sampleRate),			// Sampling rate in Hz
+	.syncStatus(sync_status),				// Sync status register
+	.previewMin(preview_min),				// Preview window minimum
+	.previewMax(preview_max),				// Preview window maximum
+	.previewNumber(preview_number),		// Preview window number
+	.previewUpdate(preview_update),		// Toggles at the end of each preview window
+	.statsReadData(stats_readData),		// RF statistics read data
+	.triggered(trigger_triggered),		// 1 = Trigger condition met
+	.triggerIndex(trigger_firstSampleIndex),	// Index of the first sample passed on
+	.analyzerStatus(analyzer_status),	// Logic analyzer status
+	.analyzerReadEntry(analyzer_readEntry),	// Logic analyzer entry being read
+	.captureLengthStatus(capture_status),	// Capture length status
+	.markerIndex(marker_index),			// Sample index of the last input marker
+	.markerChanged(marker_changed),		// Input lines that changed
+	.markerLevels(marker_levels),			// Input line levels after the change
+	.markerUpdate(marker_update),			// Toggles when an input marker is recorded
+	.markerClear(!sample_nReset),			// 1 = Empty the input marker FIFO
+	.pipelineClocks(pipeline_clocks),	// Pipeline statistics (see pipelineStats.v)
+	.pipelineBusWords(pipeline_busWords),
+	.pipelineStallMax(pipeline_stallMax),
+	.pipelineStallTotal(pipeline_stallTotal),
+	.pipelineStatus(pipeline_status),
+	.buildFeatures(buildFeatures),		// Build options
+	
+	// Outputs
+	.miso(fx3_registerMiso),				// Register interface data to FX3
+	.control(fx3_controlRegister),		// Control register
+	.syncRole(sync_role),					// Sync role
+	.syncStart(sync_startRequest),		// Toggles to send a start strobe
+	.statsHold(stats_hold),					// 1 = Hold the RF statistics snapshot
+	.statsAddress(stats_address),			// RF statistics register address
+	.triggerControl(trigger_control),	// Armed capture control register
+	.triggerHoldCount(trigger_holdCount),	// Samples the trigger condition must hold for
+	.triggerPreTrigger(trigger_preTrigger),	// Pre-trigger history in samples
+	.analyzerControl(analyzer_control),	// Logic analyzer control register
+	.analyzerArm(analyzer_arm),			// Strobe to start a logic analyzer capture
+	.analyzerReadAddress(analyzer_readAddress),	// Logic analyzer entry being read
+	.packetLimit(capture_packetLimit),		// Capture length in packets
+	.packetSize(fx3_packetSize)				// Packet size
 );
 
-// Status LED control
+// Status LED health display (see statusLED.v for the meaning of each LED)
 statusLED statusLED0 (
 	// Inputs
 	.nReset(fx3_nReset),
 	.clock(fx3_clock),
+	.collectData(fx3_collectData),		// 1 = Host is collecting data
+	.testMode(fx3_testMode),				// 1 = Test mode on
+	.bufferError(fx3_bufferError),		// Set if samples are dropped
+	.sendingPacket(fx3_sendingPacket),	// 1 = Sending a packet
+	.writeBank(bufferWriteBank),			// Bank being written
+	.readBank(bufferReadBank),				// Bank being read
 	
 	// Outputs
 	.leds(LED)
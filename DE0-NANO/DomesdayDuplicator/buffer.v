@@ -15,166 +15,472 @@ module buffer (
 	input readClock,
 	input isReading,
 	input [15:0] dataIn,
+	input dataValid,
+	input testMode,
+	input soakMode,
+	input decimationMode,
+	input twoChannelMode,
+	input [1:0] packetSize,
+	input framePacked,
+	input frameHeader,
+	input frameCompressed,
+	input [47:0] frameSampleIndex,
+	input [3:0] lineChanged,
+`ifdef SDRAM_FIFO
+	input [31:0] upstreamOverflowCount,
+	input upstreamOverflowUpdate,
+`endif
 	
+	output writeReady,
 	output reg bufferOverflow,
+	output reg [31:0] overflowCount,
+	output reg [47:0] overflowIndex,
+	output reg overflowUpdate,
 	output reg dataAvailable,
+	output packetHeaderEnable,
+	output [127:0] packetHeader,
+	output [1:0] currentWriteBank,
+	output [1:0] currentReadBank,
+`ifdef GPIF_32BIT
+	output [31:0] dataOut
+`else
 	output [15:0] dataOut
+`endif
 );
 
-// FIFO buffer size in words
-// Note: The size of this buffer must match the buffer size used
-// by the FX3 (which is set to 8192 16-bit words per buffer) as this
-// must match the size of the USB3 end-point which is 16Kbytes
-//
-localparam bufferSize = 14'd8191; // 0 - 8191 = 8192 words
-
-// "Ping-pong" buffer storing 8192 16-bit words per buffer
-reg currentWriteBuffer; // 0 = write to ping buffer read from pong,
-								// 1 = write to pong buffer read from ping
-
-// Define various buffer signals and values
-
-// Buffer signals (write clock sync'd)
-wire pingAsyncClear_wr;
-wire pongAsyncClear_wr;
-wire pingEmptyFlag_wr;
-wire pongEmptyFlag_wr;
-wire [13:0] pingUsedWords_wr;
-wire [13:0] pongUsedWords_wr;
-
-// Buffer signals (read clock sync'd)
-wire pingEmptyFlag_rd;
-wire pongEmptyFlag_rd;
-wire [13:0] pingUsedWords_rd;
-wire [13:0] pongUsedWords_rd;
-
-// Data out buses
-wire [15:0] pingdataOut;
-wire [15:0] pongdataOut;
-
-// Define the ping buffer (0) - 8192 16-bit words
-IPfifo pingBuffer (
-	.aclr(pingAsyncClear_wr),
-	.data(pingDataIn),				// 16-bit [15:0]
-	.rdclk(readClock),
-	.rdreq(pingReadRequest),
-	.wrclk(writeClock),
-	.wrreq(pingWriteRequest),
-	.q(pingdataOut),					// 16-bit [15:0]
-	.rdempty(pingEmptyFlag_rd),
-	.rdusedw(pingUsedWords_rd),	// 14-bit [13:0]
-	.wrempty(pingEmptyFlag_wr),
-	.wrusedw(pingUsedWords_wr)		// 14-bit [13:0]
-);
+// Bank size in words
+// Note: The size of each bank must match the buffer size used
+// by the FX3.  Each bank holds a 16 Kbyte packet; packetSize
+// (from the register interface) selects a shorter packet of
+// 8 Kbytes (1) or 4 Kbytes (2), which fills only the start of each
+// bank.  packetSize must only be changed whilst the sample path is
+// held in reset (data collection is stopped).
+//
+// In 32-bit GPIF mode each bank holds 4096 32-bit words, each
+// word carrying two consecutive 16-bit samples (the first sample
+// in the lower 16 bits), so the byte stream seen by the host is
+// identical to 16-bit mode.
+//
+// When a frame carries a packet header (see samplePacker.v) the
+// bank only holds the frame's 8184 16-bit words of data and the
+// FX3 state-machine sends the 8 word (16 byte) header first.
+//
+// In SDRAM FIFO builds (SDRAM_FIFO defined) the data comes from the
+// SDRAM FIFO, which holds the samples whilst the FX3 is not reading.
+// The buffer then never overflows; instead writeReady is cleared
+// (stopping the flow of data from the SDRAM FIFO) when the current
+// write bank is nearly full and the next bank has not been read.
+// overflowCount is unused and the packet header carries the SDRAM
+// FIFO's overflow count instead.
+`ifdef GPIF_32BIT
+localparam busWidth = 32;
+localparam usedWidth = 13;
+localparam fullBufferSize = 13'd4095; // 0 - 4095 = 4096 words
+localparam headerSize = 13'd4; // 4 x 32-bit header words
+`else
+localparam busWidth = 16;
+localparam usedWidth = 14;
+localparam fullBufferSize = 14'd8191; // 0 - 8191 = 8192 words
+localparam headerSize = 14'd8; // 8 x 16-bit header words
+`endif
 
-// Define the pong buffer (1) - 8192 16-bit words
-IPfifo pongBuffer (
-	.aclr(pongAsyncClear_wr),
-	.data(pongDataIn),				// 16-bit [15:0]
-	.rdclk(readClock),
-	.rdreq(pongReadRequest),
-	.wrclk(writeClock),
-	.wrreq(pongWriteRequest),
-	.q(pongdataOut),					// 16-bit [15:0]
-	.rdempty(pongEmptyFlag_rd),
-	.rdusedw(pongUsedWords_rd),	// 14-bit [13:0]
-	.wrempty(pongEmptyFlag_wr),
-	.wrusedw(pongUsedWords_wr)		// 14-bit [13:0]
-);
+// Last word of a packet (fullBufferSize for 16 Kbyte packets)
+wire [usedWidth-1:0] bufferSize = fullBufferSize >> packetSize;
+
+// Bank ring
+//
+// The buffer is a ring of bankCount banks (FIFOs) of one packet each.
+// The write side fills the banks in turn and the read side empties
+// them in the same order, so up to bankCount - 1 complete packets can
+// wait for the FX3 whilst the next is written.  Each bank is a whole
+// packet of the largest size (the FX3 DMA buffer size), so the banks
+// cannot be made smaller: each bank takes 16 M9K blocks, so the default
+// of 3 banks takes 48 of the DE0-Nano's 66 blocks.  The rest of the
+// block RAM is the armed capture pre-trigger history (8 blocks by
+// default, see captureTrigger.v), the logic analyzer ring (2 blocks,
+// LOGIC_ANALYZER builds) and the SDRAM FIFO's two FIFOs (4 blocks,
+// SDRAM_FIFO builds), so the default build uses 56 blocks and a build
+// with every option 62.  (These are counted from the memories in the
+// design; the fitter report should be checked after adding one.)
+// Defining BUFFER_BANKS (see DomesdayDuplicator.qsf) sets the number
+// of banks (2 or 3).
+`ifdef BUFFER_BANKS
+localparam bankCount = `BUFFER_BANKS;
+`else
+localparam bankCount = 3;
+`endif
+localparam bankBits = 2;
+
+// Bank being written and bank being read
+reg [bankBits-1:0] writeBank;	// Write clock domain
+reg [bankBits-1:0] readBank;	// Read clock domain
+
+wire [bankBits-1:0] nextWriteBank = (writeBank == bankCount - 1) ? {bankBits{1'b0}} : writeBank + 1'b1;
+wire [bankBits-1:0] nextReadBank = (readBank == bankCount - 1) ? {bankBits{1'b0}} : readBank + 1'b1;
+
+// Set whilst the frame being written is discarded (all the other
+// banks are waiting to be read)
+reg writeDiscard;
+
+// Bank handshake
+//
+// The write side counts the banks it has completed and the read side
+// counts the banks it has read.  Each count is passed to the other
+// clock domain Gray coded (only one bit changes per count, so the
+// synchronised value is always either the old or the new count) through
+// a two stage synchroniser.  The number of banks waiting to be read is
+// the difference between the counts; with at most 3 banks a 3-bit
+// count cannot wrap between the two sides.
+//
+// The read side flags a complete packet as soon as the count arrives
+// rather than waiting for the FIFO's used words, which pass through
+// the FIFO's own (longer) synchroniser.  The FIFO has then not yet
+// updated its read side for the last words of the bank, but they are
+// not read until the rest of the packet has been.
+localparam countBits = 3;
+
+function [countBits-1:0] toGray;
+	input [countBits-1:0] binary;
+	toGray = binary ^ (binary >> 1);
+endfunction
+
+function [countBits-1:0] fromGray;
+	input [countBits-1:0] gray;
+	fromGray = {gray[2], gray[2] ^ gray[1], gray[2] ^ gray[1] ^ gray[0]};
+endfunction
+
+reg [countBits-1:0] banksWritten;			// Write clock domain
+reg [countBits-1:0] banksWrittenGray;
+reg [countBits-1:0] banksRead;				// Read clock domain
+reg [countBits-1:0] banksReadGray;
+
+reg [countBits-1:0] banksWrittenGray_sync0;	// Read clock domain
+reg [countBits-1:0] banksWrittenGray_sync1;
+reg [countBits-1:0] banksReadGray_sync0;		// Write clock domain
+reg [countBits-1:0] banksReadGray_sync1;
+
+always @ (posedge readClock, negedge nReset) begin
+	if (!nReset) begin
+		banksWrittenGray_sync0 <= {countBits{1'b0}};
+		banksWrittenGray_sync1 <= {countBits{1'b0}};
+	end else begin
+		banksWrittenGray_sync0 <= banksWrittenGray;
+		banksWrittenGray_sync1 <= banksWrittenGray_sync0;
+	end
+end
+
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		banksReadGray_sync0 <= {countBits{1'b0}};
+		banksReadGray_sync1 <= {countBits{1'b0}};
+	end else begin
+		banksReadGray_sync0 <= banksReadGray;
+		banksReadGray_sync1 <= banksReadGray_sync0;
+	end
+end
+
+// Banks waiting to be read (as seen by each side)
+wire [countBits-1:0] banksReady_rd = fromGray(banksWrittenGray_sync1) - banksRead;
+wire [countBits-1:0] banksFull_wr = banksWritten - fromGray(banksReadGray_sync1);
+
+// The write side can move on to the next bank at the end of the frame
+// if, counting the bank being completed, at least one bank is free
+wire [countBits-1:0] banksFullAtSwitch = banksFull_wr + (writeDiscard ? 1'b0 : 1'b1);
+wire nextBankFree = (banksFullAtSwitch < bankCount);
+
+// Form the words written to the banks
+//
+// In 16-bit mode every valid input word is written as it arrives.  In
+// 32-bit mode the first word of each pair is held and the pair is
+// written with the second word.
+wire [busWidth-1:0] writeData;
+wire writeEnable;
 
+`ifdef GPIF_32BIT
+reg [15:0] lowerSample;
+reg upperSamplePhase;
+
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		lowerSample <= 16'd0;
+		upperSamplePhase <= 1'b0;
+	end else begin
+		if (dataValid) begin
+			if (!upperSamplePhase) lowerSample <= dataIn;
+			upperSamplePhase <= !upperSamplePhase;
+		end
+	end
+end
 
-// Route the control signals according to the currently selected write buffer
-wire [15:0] pingDataIn;
-wire [15:0] pongDataIn;
-wire pingReadRequest;
-wire pongReadRequest;
-wire pingWriteRequest;
-wire pongWriteRequest;
+assign writeData = {dataIn, lowerSample};
+assign writeEnable = dataValid && upperSamplePhase;
+`else
+assign writeData = dataIn;
+assign writeEnable = dataValid;
+`endif
 
-// if current write buffer = ping then send data to ping buffer
-// else send data to pong buffer
-assign pingDataIn = currentWriteBuffer ? 16'd0 : dataIn;
-assign pongDataIn = currentWriteBuffer ? dataIn : 16'd0;
+// Bank data out buses
+wire [busWidth-1:0] bankDataOut [0:bankCount-1];
 
-// if current write buffer = ping then dataOut = pong buffer else dataOut = pingBuffer
-assign dataOut = currentWriteBuffer ? pingdataOut : pongdataOut;
+// Define the banks - 16Kbytes each
+// Note: the banks are only cleared on reset, and the FIFO flags are
+// not used (see the bank handshake above)
+genvar bank;
 
-// If current write buffer = ping then read from pong else read from ping
-assign pingReadRequest = currentWriteBuffer ? isReading : 1'b0;
-assign pongReadRequest = currentWriteBuffer ? 1'b0 : isReading;
+generate
+	for (bank = 0; bank < bankCount; bank = bank + 1) begin : banks
+`ifdef GPIF_32BIT
+		IPfifo32 bankBuffer (
+`else
+		IPfifo bankBuffer (
+`endif
+			.aclr(!nReset),
+			.data(writeData),
+			.rdclk(readClock),
+			.rdreq(isReading && (readBank == bank)),
+			.wrclk(writeClock),
+			.wrreq(writeEnable && !writeDiscard && (writeBank == bank)),
+			.q(bankDataOut[bank]),
+			.rdempty(),
+			.rdusedw(),
+			.wrempty(),
+			.wrusedw()
+		);
+	end
+endgenerate
 
-// if current write buffer = ping then write to ping else write to pong
-assign pingWriteRequest = currentWriteBuffer ? 1'b0 : 1'b1;
-assign pongWriteRequest = currentWriteBuffer ? 1'b1 : 1'b0;
+// The data out is from the bank being read
+assign dataOut = bankDataOut[readBank];
 
-// Define registers for the async clear flags and map to registers
-// Note: the async clear flag can cause the empty flag to glitch when
-// asserted, so we have to sync it with the nReset signal to avoid
-// issues on reset.
-reg pingAsyncClear_reg;
-reg pongAsyncClear_reg;
-assign pingAsyncClear_wr = pingAsyncClear_reg | !nReset;
-assign pongAsyncClear_wr = pongAsyncClear_reg | !nReset;
+// The banks in use (for the logic analyzer; currentWriteBank is in the
+// write clock domain)
+assign currentWriteBank = writeBank;
+assign currentReadBank = readBank;
 
 // Register to track activation of the overflow flag (0-1024 10-bit)
 reg [9:0] bufferOverflowHold;
 
-// FIFO Write-side logic (controls switching between ping and pong buffers)
+// Overflow event tracking
+//
+// overflowCount is a free-running count of overflow events and
+// overflowIndex is the stream position (in 16-bit words from reset)
+// of the first word of the frame discarded by the last overflow.
+// Both are in the write clock domain; overflowUpdate toggles each
+// time they change so they can be sampled safely from the read
+// clock domain (overflows are always at least one frame apart).
+reg [47:0] streamWordCount;		// Index of the word on dataIn
+
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		streamWordCount <= 48'd0;
+	end else begin
+		if (dataValid) streamWordCount <= streamWordCount + 48'd1;
+	end
+end
+
+// Overflow count carried in the packet header
+`ifdef SDRAM_FIFO
+// Capture the SDRAM FIFO's overflow count in the write clock domain
+// (the count is stable for many clocks after the update toggles)
+reg [2:0] upstreamOverflowUpdate_sync;
+reg [31:0] headerOverflowCount;
+
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		upstreamOverflowUpdate_sync <= 3'b000;
+		headerOverflowCount <= 32'd0;
+	end else begin
+		upstreamOverflowUpdate_sync <= {upstreamOverflowUpdate_sync[1:0], upstreamOverflowUpdate};
+		if (upstreamOverflowUpdate_sync[2] != upstreamOverflowUpdate_sync[1]) begin
+			headerOverflowCount <= upstreamOverflowCount;
+		end
+	end
+end
+`else
+wire [31:0] headerOverflowCount = overflowCount;
+`endif
+
+// Packet header information
+//
+// The header information for each bank is captured when the write
+// side starts filling it.  It is then static until the bank has
+// been read, so the read clock domain can use it directly.
+reg testMode_sync0;
+reg testMode_sync1;
+reg decimationMode_sync0;
+reg decimationMode_sync1;
+reg soakMode_sync0;
+reg soakMode_sync1;
+reg twoChannelMode_sync0;
+reg twoChannelMode_sync1;
+
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		testMode_sync0 <= 1'b0;
+		testMode_sync1 <= 1'b0;
+		decimationMode_sync0 <= 1'b0;
+		decimationMode_sync1 <= 1'b0;
+		soakMode_sync0 <= 1'b0;
+		soakMode_sync1 <= 1'b0;
+		twoChannelMode_sync0 <= 1'b0;
+		twoChannelMode_sync1 <= 1'b0;
+	end else begin
+		testMode_sync0 <= testMode;
+		testMode_sync1 <= testMode_sync0;
+		decimationMode_sync0 <= decimationMode;
+		decimationMode_sync1 <= decimationMode_sync0;
+		soakMode_sync0 <= soakMode;
+		soakMode_sync1 <= soakMode_sync0;
+		twoChannelMode_sync0 <= twoChannelMode;
+		twoChannelMode_sync1 <= twoChannelMode_sync0;
+	end
+end
+
+reg [15:0] packetSequence;			// Sequence number of the frame being written
+reg writeFrameHeader;				// 1 = Frame being written has a packet header
+reg bankHeader [0:bankCount-1];
+reg [7:0] bankFlags [0:bankCount-1];
+reg [3:0] bankLines [0:bankCount-1];
+reg [3:0] writeLines;				// Input lines changed during the frame being written
+reg [47:0] bankSampleIndex [0:bankCount-1];
+reg [31:0] bankOverflowCount [0:bankCount-1];
+reg [15:0] bankSequence [0:bankCount-1];
+integer i;
+
+// Packet header flags:
+// Bit 0 - Test mode
+// Bit 1 - Packed mode
+// Bit 2 - Packet header present (always 1)
+// Bit 3 - Decimation mode (see decimationFilter.v)
+// Bit 4 - Compressed mode (see samplePacker.v)
+// Bit 5 - Soak mode (the packet ends with its CRC, see fx3StateMachine.v)
+// Bit 6 - Words 5 and 6 are the previous packet's CRC (set as the header
+//         is sent, see fx3StateMachine.v)
+// Bit 7 - Two-channel mode (even sample indexes are channel A, odd
+//         indexes channel B, see channelInterleave.v)
+wire [7:0] frameFlags = {twoChannelMode_sync1, 1'b0, soakMode_sync1, frameCompressed, decimationMode_sync1, frameHeader, framePacked, testMode_sync1};
+
+// Header for the bank being read (8 16-bit words, first word in
+// the least significant bits):
+//
+//   Word 0     - 0xDD10 (packet header marker and format)
+//   Word 1     - Flags (bits 7-0) and the input lines that changed
+//                whilst the packet was written (bits 11-8, see
+//                inputMarkers.v)
+//   Word 2 - 4 - 48-bit index of the first sample in the packet
+//   Word 5 - 6 - 32-bit overflow count before the packet (replaced by
+//                fx3StateMachine.v in packet CRC mode)
+//   Word 7     - 16-bit packet sequence number
+//
+// The sequence number counts every frame, so frames discarded by an
+// overflow show as a gap in the sequence.
+//
+// The input line bits are set from lineChanged as the frame's words
+// are written, so a change within a few samples of the end of a frame
+// can be flagged in the frame either side of it (the exact index is
+// recorded by inputMarkers.v).  Changes whilst a frame is discarded
+// are carried into the next frame.  In SDRAM FIFO builds the samples
+// reach the buffer long after the lines changed, so lineChanged is
+// tied low and the bits are always 0.
+assign packetHeaderEnable = bankHeader[readBank];
+assign packetHeader = {bankSequence[readBank], bankOverflowCount[readBank],
+	bankSampleIndex[readBank], 4'd0, bankLines[readBank], bankFlags[readBank], 16'hDD10};
+
+// Last word of the frame being written and of the bank being read
+wire [usedWidth-1:0] writeBufferLast = writeFrameHeader ? (bufferSize - headerSize) : bufferSize;
+wire [usedWidth-1:0] readBufferLast = packetHeaderEnable ? (bufferSize - headerSize) : bufferSize;
+
+// Number of words written to the current frame
+//
+// The banks are switched on this count rather than on the FIFO's
+// used words (which lags the writes and is only valid when there is
+// a write on every clock).
+reg [usedWidth-1:0] writeCount;
+
+// Back-pressure for the SDRAM FIFO
+//
+// Data arriving at dataIn lags writeReady by a clock, so writeReady is
+// cleared 2 words before the last word of the bank.  The banks
+// then switch as soon as the next bank has been read.
+assign writeReady = !((writeCount >= writeBufferLast - 2) && !nextBankFree);
+
+// FIFO Write-side logic (controls switching between the banks)
+//
+// At the end of each frame the write side moves on to the next bank
+// if it has been read.  Otherwise every other bank is waiting to
+// be read and the next frame is discarded (the banks keep the oldest
+// data, so a short delay in reading costs one frame).  The decision
+// is made again at the end of the discarded frame.
 always @ (posedge writeClock, negedge nReset) begin
 	if (!nReset) begin
 		// Clear all registers on reset
-		currentWriteBuffer <= 1'b0;
+		writeBank <= {bankBits{1'b0}};
+		writeDiscard <= 1'b0;
+		banksWritten <= {countBits{1'b0}};
+		banksWrittenGray <= {countBits{1'b0}};
 		bufferOverflow <= 1'b0;
 		bufferOverflowHold <= 10'd0;
-		pingAsyncClear_reg <= 1'b0;
-		pongAsyncClear_reg <= 1'b0;
+		writeCount <= {usedWidth{1'b0}};
+		overflowCount <= 32'd0;
+		overflowIndex <= 48'd0;
+		overflowUpdate <= 1'b0;
+		packetSequence <= 16'd0;
+		writeFrameHeader <= 1'b0;
+		writeLines <= 4'd0;
+		for (i = 0; i < bankCount; i = i + 1) begin
+			bankHeader[i] <= 1'b0;
+			bankFlags[i] <= 8'd0;
+			bankLines[i] <= 4'd0;
+			bankSampleIndex[i] <= 48'd0;
+			bankOverflowCount[i] <= 32'd0;
+			bankSequence[i] <= 16'd0;
+		end
 	end else begin
-		// Which buffer is being written to?
-		if (currentWriteBuffer) begin
-			// Current write buffer is pong
-			
-			// Is the pong buffer nearly full?
-			if (pongUsedWords_wr == bufferSize - 2) begin
-				// Check that the ping buffer has been emptied...
-				if (!pingEmptyFlag_wr) begin
-					// Flag an overflow error
-					bufferOverflow <= 1'b1;
-					
-					// Set the ping buffer async clear (empty the ping buffer)
-					pingAsyncClear_reg <= 1'b1;
+		writeLines <= writeLines | lineChanged;
+		
+		if (writeEnable) begin
+			// Is this the last word of the current frame?
+			if (writeCount == writeBufferLast) begin
+				writeCount <= {usedWidth{1'b0}};
+				
+				// Capture the header information for the next frame
+				// Note: samplePacker has already moved on to the next frame
+				packetSequence <= packetSequence + 16'd1;
+				writeFrameHeader <= frameHeader;
+				
+				// Pass the completed bank to the read side
+				if (!writeDiscard) begin
+					banksWritten <= banksWritten + 1'b1;
+					banksWrittenGray <= toGray(banksWritten + 1'b1);
+					bankLines[writeBank] <= writeLines | lineChanged;
+					writeLines <= 4'd0;
 				end
-			end
-			
-			// Is the pong buffer 1 word from full?
-			if (pongUsedWords_wr == bufferSize - 1) begin
-				// Reset the ping buffer async clear
-				pingAsyncClear_reg <= 1'b0;
 				
-				// Switch to the ping buffer
-				currentWriteBuffer <= 1'b0;
-			end
-		end else begin
-			// Current write buffer is ping
-			
-			// Is the ping buffer nearly full?
-			if (pingUsedWords_wr == bufferSize - 2) begin
-				// Check that the pong buffer has been emptied...
-				if (!pongEmptyFlag_wr) begin
-					// Flag an overflow error
+`ifndef SDRAM_FIFO
+				if (!nextBankFree) begin
+					// Discard the next frame and flag an overflow error
+					writeDiscard <= 1'b1;
 					bufferOverflow <= 1'b1;
 					
-					// Set the pong buffer async clear (empty the pong buffer)
-					pongAsyncClear_reg <= 1'b1;
+					// Record the overflow event
+					overflowCount <= overflowCount + 32'd1;
+					overflowIndex <= streamWordCount + 48'd1;
+					overflowUpdate <= !overflowUpdate;
+				end else
+`endif
+				begin
+					// Switch to the next bank
+					writeBank <= nextWriteBank;
+					writeDiscard <= 1'b0;
+					
+					bankHeader[nextWriteBank] <= frameHeader;
+					bankFlags[nextWriteBank] <= frameFlags;
+					bankSampleIndex[nextWriteBank] <= frameSampleIndex;
+					bankOverflowCount[nextWriteBank] <= headerOverflowCount;
+					bankSequence[nextWriteBank] <= packetSequence + 16'd1;
 				end
-			end
-			
-			// Is the ping buffer 1 word from full?
-			if (pingUsedWords_wr == bufferSize - 1) begin
-				// Reset the pong buffer async clear
-				pongAsyncClear_reg <= 1'b0;
-
-				// Switch to the pong buffer
-				currentWriteBuffer <= 1'b1;
+			end else begin
+				writeCount <= writeCount + 1'b1;
 			end
 		end
 	
@@ -189,6 +495,9 @@ always @ (posedge writeClock, negedge nReset) begin
 			if (bufferOverflowHold > 10'd1000) begin
 				bufferOverflow <= 1'b0;
 			end
+		end else begin
+			// Restart the hold period for the next overflow
+			bufferOverflowHold <= 10'd0;
 		end
 	end
 end
@@ -196,38 +505,37 @@ end
 // FIFO read-side logic
 // Control the data available flag (on the read side)
 // Note: This is responsible for setting the flag when
-// data is available and clearing the flag once all
-// the available data has been read.
+// a complete packet is waiting and clearing the flag
+// once the packet has been read.
+//
+// The flag is cleared as the last word of the bank is read and the
+// read side moves on to the next bank, so the GPIF never sees a
+// stale flag when it checks for the next packet.  If the next bank
+// is already complete the flag is set again on the following clock.
+reg [usedWidth-1:0] readCount;		// Words read from the current read bank
+
 always @ (posedge readClock, negedge nReset) begin
 	if (!nReset) begin
 		// On reset default to data unavailable
 		dataAvailable <= 1'b0;
+		readCount <= {usedWidth{1'b0}};
+		readBank <= {bankBits{1'b0}};
+		banksRead <= {countBits{1'b0}};
+		banksReadGray <= {countBits{1'b0}};
 	end else begin
-		// Which buffer is being read from to?
-		if (currentWriteBuffer) begin
-			// Reading from ping buffer
-			
-			// Is the ping buffer full?
-			if (pingUsedWords_rd == bufferSize) begin
-				dataAvailable <= 1'b1;
-			end else begin
-				// Is the ping buffer empty?
-				if (pingEmptyFlag_rd) begin
-					dataAvailable <= 1'b0;
-				end
-			end
+		if (isReading && (readCount == readBufferLast)) begin
+			// The last word of the bank is being read; pass the bank
+			// back to the write side
+			dataAvailable <= 1'b0;
+			readCount <= {usedWidth{1'b0}};
+			readBank <= nextReadBank;
+			banksRead <= banksRead + 1'b1;
+			banksReadGray <= toGray(banksRead + 1'b1);
 		end else begin
-			// Reading from pong buffer
+			if (isReading) readCount <= readCount + 1'b1;
 			
-			// Is the pong buffer full?
-			if (pongUsedWords_rd == bufferSize) begin
-				dataAvailable <= 1'b1;
-			end else begin
-				// Is the pong buffer empty?
-				if (pongEmptyFlag_rd) begin
-					dataAvailable <= 1'b0;
-				end
-			end
+			// Is a complete packet waiting?
+			dataAvailable <= (banksReady_rd != {countBits{1'b0}});
 		end
 	end
 end
@@ -0,0 +1,64 @@
+/************************************************************************
+
+	captureLength.v
+	Capture length (automatic stop) module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module captureLength (
+	input nReset,
+	input clock,
+	input [29:0] packetLimit,
+	input dataAvailableIn,
+	input packetStart,
+	input sendingPacket,
+
+	// Outputs
+	output dataAvailableOut,
+	output [31:0] status
+);
+
+// Stops data collection after exactly packetLimit packets (of the
+// packet size in use, see buffer.v) have been sent to the FX3
+// (0 = no limit).
+//
+// The packets started are counted, and once packetLimit packets have
+// been started dataAvailable is held low towards the FX3, exactly as
+// if the buffer had run empty; the GPIF then stops requesting packets
+// after the last one.  The samples that follow are still written to
+// the buffer (and may overflow it), but they are never sent.
+//
+// done is set once the last packet has been sent in full, so the FX3
+// can stop collection without losing any of it:
+//
+//   Bits 29-0 - Packets sent since data collection started
+//   Bit 31    - Done (packetLimit packets have been sent)
+//
+// The module is reset with the sample path, so the count restarts when
+// data collection is started.  packetLimit (from the register
+// interface, on the same clock) must only be changed whilst data
+// collection is stopped.
+reg [29:0] packetsStarted;
+
+wire limitReached = (packetLimit != 30'd0) && (packetsStarted == packetLimit);
+wire done = limitReached && !sendingPacket;
+
+// The packet being sent is not counted until it is complete
+wire [29:0] packetsSent = sendingPacket ? (packetsStarted - 30'd1) : packetsStarted;
+
+assign dataAvailableOut = dataAvailableIn && !limitReached;
+assign status = {done, 1'b0, packetsSent};
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		packetsStarted <= 30'd0;
+	end else begin
+		if (packetStart) packetsStarted <= packetsStarted + 30'd1;
+	end
+end
+
+endmodule
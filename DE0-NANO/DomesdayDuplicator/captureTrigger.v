@@ -0,0 +1,215 @@
+/************************************************************************
+
+	captureTrigger.v
+	Armed (triggered) capture module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module captureTrigger #(
+	parameter historyBits = 12		// Pre-trigger history of 2^historyBits samples (0 = none)
+) (
+	input nReset,
+	input clock,
+	input armedMode,
+	input activityMode,
+	input [9:0] level,
+	input [23:0] holdCount,
+	input [11:0] preTrigger,
+	input [15:0] dataIn,
+	input dataInValid,
+
+	// Outputs
+	output reg [15:0] dataOut,
+	output reg dataValid,
+	output reg triggered,
+	output reg [47:0] firstSampleIndex
+);
+
+// When armedMode is off the samples are passed straight through.
+//
+// When armedMode is on no samples are passed on until the trigger
+// condition has held for holdCount consecutive samples (0 is treated
+// as 1).  The samples are then passed on starting preTrigger samples
+// before the sample that met the condition, so the start of the
+// signal is not lost.  The trigger condition is:
+//
+//   - Level mode (activityMode off): the 10-bit sample is at or
+//     above level
+//   - Activity mode (activityMode on): a sample at least level away
+//     from mid-scale (512) has been seen within the last 16 samples.
+//     The RF carrier crosses mid-scale every few samples, so the hold
+//     keeps the condition met whilst the signal is present
+//
+// Once triggered the module passes every sample on until it is reset
+// (when data collection is stopped).  The pre-trigger history is a
+// 2^historyBits entry circular buffer which delays the samples by
+// preTrigger samples whilst armed; if the condition is met before
+// preTrigger samples have been received the output starts with the
+// first sample.  A preTrigger larger than the history is treated as
+// the largest the history holds.
+//
+// The history takes 2^historyBits x 16 bits of block RAM: 8 M9K blocks
+// with the default of 12 bits (4096 samples), halving with each bit
+// less.  With historyBits 0 there is no history and armed mode starts
+// with the sample that met the condition (see TRIGGER_HISTORY_BITS in
+// DomesdayDuplicator.qsf).
+//
+// triggered is set with the first sample passed on, and
+// firstSampleIndex is then the index (from reset) of that sample; it
+// is stable until the module is reset.  The packet header sample
+// index counts the samples passed on, so adding firstSampleIndex gives
+// the position in the input stream.
+//
+// The configuration must only be changed whilst data collection is
+// stopped (the module is held in reset).
+localparam [11:0] preTriggerMax = (historyBits == 0) ? 12'd0 : ((1 << historyBits) - 1);
+
+// Synchronise the configuration to the clock domain (the values are
+// static whilst the module is out of reset)
+reg armedMode_sync0;
+reg armedMode_sync1;
+reg activityMode_sync0;
+reg activityMode_sync1;
+reg [9:0] level_sync0;
+reg [9:0] level_sync1;
+reg [23:0] holdCount_sync0;
+reg [23:0] holdCount_sync1;
+reg [11:0] preTrigger_sync0;
+reg [11:0] preTrigger_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		armedMode_sync0 <= 1'b0;
+		armedMode_sync1 <= 1'b0;
+		activityMode_sync0 <= 1'b0;
+		activityMode_sync1 <= 1'b0;
+		level_sync0 <= 10'd0;
+		level_sync1 <= 10'd0;
+		holdCount_sync0 <= 24'd0;
+		holdCount_sync1 <= 24'd0;
+		preTrigger_sync0 <= 12'd0;
+		preTrigger_sync1 <= 12'd0;
+	end else begin
+		armedMode_sync0 <= armedMode;
+		armedMode_sync1 <= armedMode_sync0;
+		activityMode_sync0 <= activityMode;
+		activityMode_sync1 <= activityMode_sync0;
+		level_sync0 <= level;
+		level_sync1 <= level_sync0;
+		holdCount_sync0 <= holdCount;
+		holdCount_sync1 <= holdCount_sync0;
+		preTrigger_sync0 <= preTrigger;
+		preTrigger_sync1 <= preTrigger_sync0;
+	end
+end
+
+// Pre-trigger samples used (limited to the history)
+wire [11:0] preTriggerSamples = (preTrigger_sync1 > preTriggerMax) ? preTriggerMax : preTrigger_sync1;
+
+// Trigger condition for the sample on dataIn
+wire [9:0] sample = dataIn[9:0];
+wire [9:0] deviation = sample[9] ? (sample - 10'd512) : (10'd512 - sample);
+wire activeSample = (deviation >= level_sync1);
+
+reg [3:0] activityHold;
+wire conditionMet = activityMode_sync1 ? (activeSample || (activityHold != 4'd0)) :
+	(sample >= level_sync1);
+
+// Consecutive samples meeting the condition (including this sample)
+reg [23:0] conditionCount;
+reg conditionHeld;					// Set once the condition has held
+wire [23:0] holdTarget = (holdCount_sync1 == 24'd0) ? 24'd1 : holdCount_sync1;
+wire fire = armedMode_sync1 && !conditionHeld && conditionMet &&
+	((conditionCount + 24'd1) >= holdTarget);
+
+// Number of samples received (the index of the sample on dataIn)
+reg [47:0] sampleCount;
+
+// The sample delayed by preTrigger samples is available once
+// preTrigger samples have been received
+wire historyFull = (sampleCount >= {36'd0, preTriggerSamples});
+wire passSample = !armedMode_sync1 || ((conditionHeld || fire) && historyFull);
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		activityHold <= 4'd0;
+		conditionCount <= 24'd0;
+		conditionHeld <= 1'b0;
+		sampleCount <= 48'd0;
+		triggered <= 1'b0;
+		firstSampleIndex <= 48'd0;
+	end else begin
+		if (dataInValid) begin
+			sampleCount <= sampleCount + 48'd1;
+
+			if (activeSample) activityHold <= 4'd15;
+			else if (activityHold != 4'd0) activityHold <= activityHold - 4'd1;
+
+			if (!conditionMet) conditionCount <= 24'd0;
+			else if (conditionCount != 24'hFFFFFF) conditionCount <= conditionCount + 24'd1;
+
+			// The first sample passed on is the sample preTrigger samples
+			// before the trigger, or the first sample received
+			if (fire) begin
+				conditionHeld <= 1'b1;
+				if (historyFull) firstSampleIndex <= sampleCount - {36'd0, preTriggerSamples};
+				else firstSampleIndex <= 48'd0;
+			end
+
+			// Flag the trigger with the first sample passed on
+			if (armedMode_sync1 && passSample) triggered <= 1'b1;
+		end
+	end
+end
+
+// Pre-trigger history
+//
+// Each sample is written to the history and the sample written
+// preTrigger samples earlier is read in the same clock.  With no
+// pre-trigger history the input sample is used directly.
+reg [15:0] historyOut;
+reg [15:0] directOut;
+reg stageValid;
+
+generate
+	if (historyBits != 0) begin : historyBuffer
+		reg [15:0] history [0:(1 << historyBits)-1];
+		reg [historyBits-1:0] writeAddress;
+
+		always @ (posedge clock) begin
+			if (dataInValid) begin
+				history[writeAddress] <= dataIn;
+				historyOut <= history[writeAddress - preTriggerSamples[historyBits-1:0]];
+			end
+		end
+
+		always @ (posedge clock, negedge nReset) begin
+			if (!nReset) writeAddress <= {historyBits{1'b0}};
+			else if (dataInValid) writeAddress <= writeAddress + 1'b1;
+		end
+	end else begin : noHistoryBuffer
+		// Not used (preTriggerSamples is always 0)
+		always @ (*) historyOut = directOut;
+	end
+endgenerate
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		directOut <= 16'd0;
+		stageValid <= 1'b0;
+		dataOut <= 16'd0;
+		dataValid <= 1'b0;
+	end else begin
+		directOut <= dataIn;
+		stageValid <= dataInValid && passSample;
+
+		dataOut <= (armedMode_sync1 && (preTriggerSamples != 12'd0)) ? historyOut : directOut;
+		dataValid <= stageValid;
+	end
+end
+
+endmodule
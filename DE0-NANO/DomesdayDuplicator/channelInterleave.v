@@ -0,0 +1,89 @@
+/************************************************************************
+
+	channelInterleave.v
+	Two-channel interleave module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module channelInterleave (
+	input nReset,
+	input clock,
+	input twoChannelMode,
+	input [15:0] dataInA,
+	input dataInValidA,
+	input [15:0] dataInB,
+	input dataInValidB,
+
+	// Outputs
+	output reg [15:0] dataOut,
+	output reg dataValid
+);
+
+// Merges the samples from the two ADC channels into a single stream
+// (DUAL_ADC builds only, see DomesdayDuplicator.v).
+//
+// When twoChannelMode is off the channel A samples are passed
+// straight through (one clock later) and channel B is ignored.
+//
+// When twoChannelMode is on both channels have been decimated 2:1 by
+// their decimation filters, which run in step, so a sample from each
+// channel arrives together on every second clock.  The channel A
+// sample is passed on first and the channel B sample on the next
+// clock (the free slot), so the stream carries as many samples as a
+// single channel at the full sampling rate:
+//
+//   A0 B0 A1 B1 A2 B2 ...
+//
+// The channel of a sample is therefore given by its position in the
+// stream: even sample indexes (as counted by the packet header, see
+// samplePacker.v) are channel A and odd indexes channel B.  The pairs
+// always start on an even index, as the sample path is reset when data
+// collection is started and armed capture is not available in
+// two-channel mode (it could start the stream part way through a pair).
+//
+// twoChannelMode is from the FX3 clock domain and is synchronised here
+// (the decimation filters synchronise their copies the same way).  It
+// must only be changed whilst data collection is stopped.
+reg twoChannelMode_sync0;
+reg twoChannelMode_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		twoChannelMode_sync0 <= 1'b0;
+		twoChannelMode_sync1 <= 1'b0;
+	end else begin
+		twoChannelMode_sync0 <= twoChannelMode;
+		twoChannelMode_sync1 <= twoChannelMode_sync0;
+	end
+end
+
+// Channel B sample waiting for the free slot
+reg [15:0] heldB;
+reg heldValidB;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		dataOut <= 16'd0;
+		dataValid <= 1'b0;
+		heldB <= 16'd0;
+		heldValidB <= 1'b0;
+	end else begin
+		if (twoChannelMode_sync1 && heldValidB) begin
+			// Free slot: pass on the held channel B sample
+			dataOut <= heldB;
+			dataValid <= 1'b1;
+			heldValidB <= 1'b0;
+		end else begin
+			dataOut <= dataInA;
+			dataValid <= dataInValidA;
+			heldB <= dataInB;
+			heldValidB <= twoChannelMode_sync1 && dataInValidA && dataInValidB;
+		end
+	end
+end
+
+endmodule
@@ -0,0 +1,113 @@
+/************************************************************************
+
+	clockSelect.v
+	Sampling clock selection module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module clockSelect (
+	input statusClock,
+	input [1:0] select,
+	input clock0,
+	input clock1,
+	input clock2,
+	input clock3,
+	input clock3Valid,
+
+	output clockOut,
+	output reg [2:0] activeClock
+);
+
+// Glitch-free selection between four clocks
+//
+// select chooses clock 0, 1, 2 or 3 and may change at any time.  Each
+// clock has an enable which is synchronised to that clock and changes
+// on its falling edge.  An enable is only set once the enables of the
+// other clocks are clear, so the output never carries a runt pulse; it
+// is held low for a few clocks of the old and new clocks during a
+// change.
+//
+// Clocks 0 to 2 are free-running.  Clock 3 comes from outside the
+// FPGA (see syncControl.v) and may stop: clock3Valid (asynchronous)
+// must only be set whilst it is running.  When clock3Valid is clear
+// clock 3 cannot be selected and its enable is cleared immediately,
+// so a lost clock does not stop the selection of another.
+//
+// The enables are not reset, as the sampling clock has to keep running
+// whilst the FX3 holds the rest of the FPGA in reset.  They power-up
+// clear and the selected clock starts a few clocks after
+// configuration.
+//
+// activeClock is the clock currently selected on the output
+// (synchronised to statusClock; 4 whilst the clock is changing).
+reg [1:0] clock0Sync;
+reg [1:0] clock1Sync;
+reg [1:0] clock2Sync;
+reg [1:0] clock3Sync;
+reg clock0Enable;
+reg clock1Enable;
+reg clock2Enable;
+reg clock3Enable;
+
+// Clock 0
+always @ (posedge clock0) begin
+	clock0Sync <= {clock0Sync[0], (select == 2'd0) && !clock1Enable && !clock2Enable && !clock3Enable};
+end
+
+always @ (negedge clock0) begin
+	clock0Enable <= clock0Sync[1];
+end
+
+// Clock 1
+always @ (posedge clock1) begin
+	clock1Sync <= {clock1Sync[0], (select == 2'd1) && !clock0Enable && !clock2Enable && !clock3Enable};
+end
+
+always @ (negedge clock1) begin
+	clock1Enable <= clock1Sync[1];
+end
+
+// Clock 2
+always @ (posedge clock2) begin
+	clock2Sync <= {clock2Sync[0], (select == 2'd2) && !clock0Enable && !clock1Enable && !clock3Enable};
+end
+
+always @ (negedge clock2) begin
+	clock2Enable <= clock2Sync[1];
+end
+
+// Clock 3
+always @ (posedge clock3, negedge clock3Valid) begin
+	if (!clock3Valid) clock3Sync <= 2'b00;
+	else clock3Sync <= {clock3Sync[0], (select == 2'd3) && !clock0Enable && !clock1Enable && !clock2Enable};
+end
+
+always @ (negedge clock3, negedge clock3Valid) begin
+	if (!clock3Valid) clock3Enable <= 1'b0;
+	else clock3Enable <= clock3Sync[1];
+end
+
+assign clockOut = (clock0 & clock0Enable) | (clock1 & clock1Enable) | (clock2 & clock2Enable) | (clock3 & clock3Enable);
+
+// Report the active clock
+reg [3:0] enableSync0;
+reg [3:0] enableSync1;
+
+always @ (posedge statusClock) begin
+	enableSync0 <= {clock3Enable, clock2Enable, clock1Enable, clock0Enable};
+	enableSync1 <= enableSync0;
+
+	case (enableSync1)
+		4'b0001: activeClock <= 3'd0;
+		4'b0010: activeClock <= 3'd1;
+		4'b0100: activeClock <= 3'd2;
+		4'b1000: activeClock <= 3'd3;
+		default: activeClock <= 3'd4;
+	endcase
+end
+
+endmodule
@@ -0,0 +1,68 @@
+/************************************************************************
+
+	crc32c.v
+	CRC-32C (Castagnoli) module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module crc32c #(
+	parameter width = 16
+) (
+	input nReset,
+	input clock,
+	input clear,
+	input dataValid,
+	input [width-1:0] dataIn,
+
+	// Outputs
+	output [31:0] crc,
+	output [31:0] crcNext
+);
+
+// Calculates the CRC-32C (polynomial 0x1EDC6F41, reflected, initial
+// value and final XOR 0xFFFFFFFF) of the words on dataIn, one word on
+// each clock that dataValid is set.  The bits of each word are taken
+// least significant bit first, so the CRC is that of the words sent
+// as little-endian bytes, which is what the host sees (and what the
+// SSE4.2 and ARMv8 CRC32C instructions calculate).
+//
+// clear starts a new CRC from the next clock (a word on dataIn with
+// clear set is not included).  crc is the finished CRC of the words
+// since the last clear, and crcNext is the finished CRC including the
+// word on dataIn (whether or not dataValid is set).
+localparam polynomial = 32'h82F63B78; // 0x1EDC6F41 reflected
+
+reg [31:0] remainder;
+
+assign crc = ~remainder;
+assign crcNext = ~nextRemainder(remainder, dataIn);
+
+// Add a word to the remainder (a bit at a time, which synthesises to a
+// single level of XOR trees)
+function [31:0] nextRemainder;
+	input [31:0] current;
+	input [width-1:0] data;
+	integer i;
+	begin
+		nextRemainder = current;
+		for (i = 0; i < width; i = i + 1) begin
+			if (nextRemainder[0] ^ data[i]) nextRemainder = (nextRemainder >> 1) ^ polynomial;
+			else nextRemainder = nextRemainder >> 1;
+		end
+	end
+endfunction
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		remainder <= 32'hFFFFFFFF;
+	end else begin
+		if (clear) remainder <= 32'hFFFFFFFF;
+		else if (dataValid) remainder <= nextRemainder(remainder, dataIn);
+	end
+end
+
+endmodule
@@ -14,6 +14,8 @@ module dataGenerator (
 	input clock,
 	input [9:0] adc_databus,
 	input testModeFlag,
+	input soakModeFlag,
+	input restart,
 	
 	// Outputs
 	output [15:0] dataOut
@@ -25,15 +27,32 @@ reg [9:0] adcData;
 // Register to store test data values
 reg [9:0] testData;
 
+// Register to store the soak test pattern generator state
+reg [30:0] prbsState;
+
 // Register to store the sequence number counter
 reg [21:0] sequenceCount;
 
 // The top 6 bits of the output are the sequence number
 assign dataOut[15:10] = sequenceCount[21:16];
 
-// If we are in test-mode use test data,
-// otherwise use the actual ADC data
-assign dataOut[9:0] = testModeFlag ? testData : adcData;
+// In soak mode use the PRBS, if we are in test-mode use test
+// data, otherwise use the actual ADC data
+assign dataOut[9:0] = soakModeFlag ? prbsState[9:0] :
+	testModeFlag ? testData : adcData;
+
+// Move the PRBS-31 generator (x^31 + x^28 + 1) on by 10 bits, so
+// every sample is 10 new bits of the sequence
+function [30:0] nextPrbs;
+	input [30:0] state;
+	integer i;
+	begin
+		nextPrbs = state;
+		for (i = 0; i < 10; i = i + 1) begin
+			nextPrbs = {nextPrbs[29:0], nextPrbs[30] ^ nextPrbs[27]};
+		end
+	end
+endfunction
 
 // Read the ADC data and increment the counters on the
 // negative edge of the clock
@@ -43,23 +62,42 @@ assign dataOut[9:0] = testModeFlag ? testData : adcData;
 //
 // The sequence number counts from 0 to 62 repeatedly, with each
 // number being attached to 65536 samples.
+//
+// In soak mode (see fx3StateMachine.v) the samples are a PRBS-31
+// sequence instead, which exercises every bit of the data path with
+// a pattern that does not repeat for days.
+//
+// The counters restart from 0 on the clock after restart is set (the
+// start strobe from syncControl.v), so synchronised devices carry the
+// same sequence numbers.
 always @ (posedge clock, negedge nReset) begin
 	if (!nReset) begin
 		adcData <= 10'd0;
 		testData <= 10'd0;
+		prbsState <= 31'h7FFFFFFF;
 		sequenceCount <= 22'd0;
 	end else begin
 		// Read the ADC data
 		adcData <= adc_databus;
 		
 		// Test mode data generation
-		if (testData == 10'd1021 - 1)
+		if (restart)
+			testData <= 10'd0;
+		else if (testData == 10'd1021 - 1)
 			testData <= 10'd0;
 		else
 			testData <= testData + 10'd1;
 		
+		// Soak test pattern generation
+		if (restart)
+			prbsState <= 31'h7FFFFFFF;
+		else
+			prbsState <= nextPrbs(prbsState);
+		
 		// Sequence number generation
-		if (sequenceCount == (6'd63 << 16) - 1)
+		if (restart)
+			sequenceCount <= 22'd0;
+		else if (sequenceCount == (6'd63 << 16) - 1)
 			sequenceCount <= 22'd0;
 		else
 			sequenceCount <= sequenceCount + 22'd1;
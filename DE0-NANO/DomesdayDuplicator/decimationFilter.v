@@ -0,0 +1,139 @@
+/************************************************************************
+
+	decimationFilter.v
+	2:1 low-pass decimation filter module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module decimationFilter (
+	input nReset,
+	input clock,
+	input decimationMode,
+	input [15:0] dataIn,
+
+	// Outputs
+	output reg [15:0] dataOut,
+	output reg dataValid
+);
+
+// When decimationMode is off the samples are passed straight through
+// (one per clock).
+//
+// When decimationMode is on the samples are low-pass filtered by an
+// 11-tap half-band FIR filter and every second filtered sample is
+// output, halving the sample rate (and the USB data rate).  The
+// filter coefficients (/512) are:
+//
+//   3, 0, -25, 0, 150, 256, 150, 0, -25, 0, 3
+//
+// The response is flat (within 0.1 dB) to 0.1 x the input sample rate,
+// 6 dB down at 0.25 x and at least 24 dB down above 0.35 x.  At 40 MSPS
+// the output (20 MSPS) is flat from DC to 4 MHz.
+//
+// The filtered samples are rounded and clipped to 10 bits, and keep
+// the sequence number (dataIn bits 15-10) of the centre input sample.
+// The mode should only be changed whilst data collection is stopped,
+// as the change takes effect immediately (not at a frame boundary).
+
+// Synchronise the mode input to the clock domain
+reg decimationMode_sync0;
+reg decimationMode_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		decimationMode_sync0 <= 1'b0;
+		decimationMode_sync1 <= 1'b0;
+	end else begin
+		decimationMode_sync0 <= decimationMode;
+		decimationMode_sync1 <= decimationMode_sync0;
+	end
+end
+
+// Filter delay line (tap 0 is the newest sample)
+reg [9:0] tap [0:10];
+reg [5:0] sequenceDelay [0:5];
+reg decimationPhase;
+
+// Pipeline stage 1 - add the symmetric taps
+reg [10:0] sumOuter;		// Taps 0 and 10
+reg [10:0] sumMiddle;		// Taps 2 and 8
+reg [10:0] sumInner;		// Taps 4 and 6
+reg [9:0] centre;			// Tap 5
+reg [5:0] sequence1;
+reg valid1;
+
+// Pipeline stage 2 - multiply by the coefficients (shift and add)
+reg signed [20:0] productOuter;
+reg signed [20:0] productMiddle;
+reg signed [20:0] productInner;
+reg signed [20:0] productCentre;
+reg [5:0] sequence2;
+reg valid2;
+
+// Pipeline stage 3 - accumulate, round and clip
+wire signed [20:0] filterSum = productOuter - productMiddle + productInner + productCentre + 21'sd256;
+wire signed [11:0] filterResult = filterSum[20:9];
+
+integer i;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		for (i = 0; i < 11; i = i + 1) tap[i] <= 10'd0;
+		for (i = 0; i < 6; i = i + 1) sequenceDelay[i] <= 6'd0;
+		decimationPhase <= 1'b0;
+		sumOuter <= 11'd0;
+		sumMiddle <= 11'd0;
+		sumInner <= 11'd0;
+		centre <= 10'd0;
+		sequence1 <= 6'd0;
+		valid1 <= 1'b0;
+		productOuter <= 21'sd0;
+		productMiddle <= 21'sd0;
+		productInner <= 21'sd0;
+		productCentre <= 21'sd0;
+		sequence2 <= 6'd0;
+		valid2 <= 1'b0;
+		dataOut <= 16'd0;
+		dataValid <= 1'b0;
+	end else begin
+		// Shift the new sample into the delay line
+		tap[0] <= dataIn[9:0];
+		for (i = 1; i < 11; i = i + 1) tap[i] <= tap[i - 1];
+		sequenceDelay[0] <= dataIn[15:10];
+		for (i = 1; i < 6; i = i + 1) sequenceDelay[i] <= sequenceDelay[i - 1];
+		decimationPhase <= !decimationPhase;
+
+		// Stage 1
+		sumOuter <= tap[0] + tap[10];
+		sumMiddle <= tap[2] + tap[8];
+		sumInner <= tap[4] + tap[6];
+		centre <= tap[5];
+		sequence1 <= sequenceDelay[5];
+		valid1 <= decimationPhase;
+
+		// Stage 2 (x3, x25, x150 and x256)
+		productOuter <= $signed({10'd0, sumOuter}) * 21'sd3;
+		productMiddle <= $signed({10'd0, sumMiddle}) * 21'sd25;
+		productInner <= $signed({10'd0, sumInner}) * 21'sd150;
+		productCentre <= $signed({11'd0, centre}) * 21'sd256;
+		sequence2 <= sequence1;
+		valid2 <= valid1;
+
+		// Stage 3 (or pass the sample straight through)
+		if (decimationMode_sync1) begin
+			if (filterResult < 12'sd0) dataOut <= {sequence2, 10'd0};
+			else if (filterResult > 12'sd1023) dataOut <= {sequence2, 10'd1023};
+			else dataOut <= {sequence2, filterResult[9:0]};
+			dataValid <= valid2;
+		end else begin
+			dataOut <= dataIn;
+			dataValid <= 1'b1;
+		end
+	end
+end
+
+endmodule
@@ -13,8 +13,26 @@ module fx3StateMachine (
 	input nReset,
 	input fx3_clock,
 	input readData,
+	input headerEnable,
+	input [127:0] header,
+	input crcEnable,
+	input headerCrcEnable,
+	input [1:0] packetSize,
+`ifdef GPIF_32BIT
+	input [31:0] dataIn,
 	
-	output fx3isReading
+	output [31:0] dataOut,
+`else
+	input [15:0] dataIn,
+	
+	output [15:0] dataOut,
+`endif
+	output fx3isReading,
+	
+	// Handshake state (for the logic analyzer, see logicAnalyzer.v)
+	output sendingPacket,
+	output packetStart,
+	output reg [15:0] wordCounter
 );
 
 // State machine logic ---------------------------------------------------
@@ -48,23 +66,127 @@ always @(posedge fx3_clock, negedge nReset) begin
 end
 
 // Counter for the sendPacket state
-// Here we should send 8192 words to the FX3
-reg [15:0] wordCounter;
+// Here we should send 16Kbytes to the FX3 (8192 16-bit words or
+// 4096 32-bit words), or the shorter packet selected by packetSize:
+// 8 Kbytes (1) or 4 Kbytes (2).  The size must match the FX3 DMA
+// buffer size and must only be changed whilst data collection is
+// stopped.
+`ifdef GPIF_32BIT
+localparam busWidth = 32;
+localparam fullLastWord = 16'd4095;
+localparam headerWords = 16'd4;
+localparam crcWords = 16'd1;
+`else
+localparam busWidth = 16;
+localparam fullLastWord = 16'd8191;
+localparam headerWords = 16'd8;
+localparam crcWords = 16'd2;
+`endif
+
+wire [15:0] lastWord = fullLastWord >> packetSize;
+
+// Back-to-back packets
+//
+// A request from the GPIF is accepted on the last word of a packet as
+// well as whilst waiting, so the next packet can start on the very
+// next clock without returning through state_waitForRequest (the word
+// counter is restarted as each packet starts).
+wire startPacket = (readData_flag == 1'b1) &&
+	((sm_currentState == state_waitForRequest) || (wordCounter == lastWord));
+
+always @(posedge fx3_clock, negedge nReset) begin
+	if (!nReset) begin
+		wordCounter <= 16'd0;
+	end else begin
+		if (startPacket) begin
+			wordCounter <= 16'd0;
+		end else if (sm_currentState == state_sendPacket) begin
+			wordCounter <= wordCounter + 16'd1;
+		end
+	end
+end
+
+assign sendingPacket = (sm_currentState == state_sendPacket);
+assign packetStart = startPacket;
+
+// Is the packet header being sent?
+// Note: the header is only sent if the buffer being read was written
+// with a packet header (the buffer then holds headerWords fewer words)
+wire sendingHeader = headerEnable && (wordCounter < headerWords);
+
+// Generate fx3isReading flag (the buffer is not read whilst sending the header)
+assign fx3isReading = ((sm_currentState == state_sendPacket) && !sendingHeader) ? 1'b1 : 1'b0;
+
+// Packet CRC (soak mode)
+//
+// With crcEnable set the last 4 bytes of each packet are replaced by
+// the CRC-32C of the rest of the packet as sent (including any packet
+// header), least significant byte first.  The buffer is still read for
+// those words, so it stays in step.  crcEnable must only be changed
+// whilst data collection is stopped.
+wire sendingCrc = crcEnable && (wordCounter > lastWord - crcWords);
+wire [31:0] packetCrc;
+wire [busWidth-1:0] packetData;
+
+crc32c #(
+	.width(busWidth)
+) crc32c0 (
+	.nReset(nReset),
+	.clock(fx3_clock),
+	.clear(startPacket),
+	.dataValid(sendingPacket && !sendingCrc),
+	.dataIn(packetData),
+	.crc(packetCrc)
+);
+
+// Previous packet CRC (packet CRC mode)
+//
+// With headerCrcEnable set the CRC-32C of each whole packet as sent
+// (the whole packet, including its header) is carried in the packet
+// header of the next packet, in place of the overflow count (words 5
+// and 6), and bit 6 of the flags word is set.  The first packet after
+// data collection starts has no previous packet, so its flag is clear.
+// Unlike soak mode no data is replaced, so this can be used for real
+// captures.  headerCrcEnable must only be changed whilst data
+// collection is stopped.
+reg [31:0] lastPacketCrc;
+reg lastPacketCrcValid;
+wire [31:0] sentPacketCrc;
+
+crc32c #(
+	.width(busWidth)
+) crc32c1 (
+	.nReset(nReset),
+	.clock(fx3_clock),
+	.clear(startPacket),
+	.dataValid(sendingPacket),
+	.dataIn(dataOut),
+	.crcNext(sentPacketCrc)
+);
 
 always @(posedge fx3_clock, negedge nReset) begin
 	if (!nReset) begin
-		wordCounter = 16'd0;
+		lastPacketCrc <= 32'd0;
+		lastPacketCrcValid <= 1'b0;
 	end else begin
-		if (sm_currentState == state_sendPacket) begin
-			wordCounter = wordCounter + 16'd1;
-		end else begin
-			wordCounter = 16'd0;
+		if (sendingPacket && (wordCounter == lastWord)) begin
+			lastPacketCrc <= sentPacketCrc;
+			lastPacketCrcValid <= 1'b1;
 		end
 	end
 end
 
-// Generate fx3isReading flag
-assign fx3isReading = (sm_currentState == state_sendPacket) ? 1'b1 : 1'b0;
+wire [127:0] sentHeader = headerCrcEnable ?
+	{header[127:112], lastPacketCrc, header[79:23], lastPacketCrcValid, header[21:0]} : header;
+
+// Select the header, the buffer data or the CRC
+`ifdef GPIF_32BIT
+assign packetData = sendingHeader ? sentHeader[wordCounter[1:0] * 32 +: 32] : dataIn;
+assign dataOut = sendingCrc ? packetCrc : packetData;
+`else
+assign packetData = sendingHeader ? sentHeader[wordCounter[2:0] * 16 +: 16] : dataIn;
+assign dataOut = sendingCrc ? (wordCounter[0] ? packetCrc[31:16] : packetCrc[15:0]) : packetData;
+`endif
 
 // State machine transition logic
 always @(*)begin
@@ -75,7 +197,7 @@ always @(*)begin
 		// state_waitForRequest (waits for the FX3 to request a packet)
 		state_waitForRequest:begin
 			// Is the GPIF reading data?
-			if (readData_flag == 1'b1 && wordCounter == 16'd0) begin
+			if (startPacket) begin
 				sm_nextState = state_sendPacket;
 			end else begin
 				// GPIF not ready... wait
@@ -83,11 +205,13 @@ always @(*)begin
 			end
 		end
 		
-		// state_sendPacket (sends a packet of 8192 words to the FX3)
+		// state_sendPacket (sends a packet to the FX3)
 		state_sendPacket:begin
-			if (wordCounter == 16'd8191) begin
-				// Packet send, go back to waiting
-				sm_nextState = state_waitForRequest;
+			if (wordCounter == lastWord) begin
+				// Packet sent; start the next packet if it has already
+				// been requested, otherwise go back to waiting
+				if (startPacket) sm_nextState = state_sendPacket;
+				else sm_nextState = state_waitForRequest;
 			end else begin
 				// Continue sending packet
 				sm_nextState = state_sendPacket;
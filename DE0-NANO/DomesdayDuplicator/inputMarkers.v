@@ -0,0 +1,114 @@
+/************************************************************************
+
+	inputMarkers.v
+	Input line marker module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module inputMarkers (
+	input nReset,
+	input clock,
+	input [3:0] lines,
+	input sampleValid,
+
+	// Outputs
+	output [3:0] lineChanged,
+	output reg [47:0] markerIndex,
+	output reg [3:0] markerChanged,
+	output reg [3:0] markerLevels,
+	output reg markerUpdate
+);
+
+// Records the sample index at which each of the FPGA to FX3 input
+// lines changes, so a change can be placed exactly in the sample
+// stream (the FX3 only sees the change some time after the samples
+// around it have left the FPGA):
+//
+//   Bit 0 - FX3 GPIO 20 (buffer error)
+//   Bit 1 - FX3 GPIO 21 (register interface data; never recorded)
+//   Bit 2 - FX3 GPIO 28 (spare; held low, reserved for player control)
+//   Bit 3 - FX3 GPIO 29 (spare; held low, reserved for player control)
+//
+// The lines are synchronised to the clock and the samples passed on
+// (sampleValid) are counted, exactly as the packet header sample index
+// counts them (see samplePacker.v), so markerIndex is the index of the
+// first sample passed on after the change was seen.  The synchroniser
+// delays the change by 2 to 3 clocks.
+//
+// markerUpdate toggles when a new marker is recorded; markerIndex,
+// markerChanged (the lines that changed) and markerLevels (the levels
+// after the change) are then stable for at least holdClocks clocks
+// so they can be sampled in the FX3 clock domain (see
+// registerInterface.v).  Changes seen during that time are merged
+// into the next marker, which carries the index of the first of them.
+//
+// lineChanged is set for a clock whenever a line changes (without the
+// hold), for the packet header flags (see buffer.v).
+//
+// The module is reset with the sample path, so the index restarts
+// when data collection is started.
+localparam holdClocks = 4'd8;
+
+// Synchronise the lines to the clock domain
+reg [3:0] lines_sync0;
+reg [3:0] lines_sync1;
+reg [3:0] lines_last;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		lines_sync0 <= 4'd0;
+		lines_sync1 <= 4'd0;
+		lines_last <= 4'd0;
+	end else begin
+		lines_sync0 <= lines & 4'b1101;
+		lines_sync1 <= lines_sync0;
+		lines_last <= lines_sync1;
+	end
+end
+
+assign lineChanged = lines_sync1 ^ lines_last;
+
+// Number of samples passed on (the index of the next sample)
+reg [47:0] sampleIndex;
+
+// Changes waiting to be recorded
+reg [3:0] pendingChanged;
+reg [47:0] pendingIndex;
+reg [3:0] holdCount;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		sampleIndex <= 48'd0;
+		pendingChanged <= 4'd0;
+		pendingIndex <= 48'd0;
+		holdCount <= 4'd0;
+		markerIndex <= 48'd0;
+		markerChanged <= 4'd0;
+		markerLevels <= 4'd0;
+		markerUpdate <= 1'b0;
+	end else begin
+		if (sampleValid) sampleIndex <= sampleIndex + 48'd1;
+
+		if (holdCount != 4'd0) holdCount <= holdCount - 4'd1;
+
+		if (holdCount == 4'd0 && (pendingChanged != 4'd0 || lineChanged != 4'd0)) begin
+			// Record the marker
+			markerIndex <= (pendingChanged != 4'd0) ? pendingIndex : sampleIndex;
+			markerChanged <= pendingChanged | lineChanged;
+			markerLevels <= lines_sync1;
+			markerUpdate <= !markerUpdate;
+			pendingChanged <= 4'd0;
+			holdCount <= holdClocks;
+		end else if (lineChanged != 4'd0) begin
+			// Hold the change until the current marker has been sampled
+			if (pendingChanged == 4'd0) pendingIndex <= sampleIndex;
+			pendingChanged <= pendingChanged | lineChanged;
+		end
+	end
+end
+
+endmodule
@@ -0,0 +1,204 @@
+/************************************************************************
+
+	logicAnalyzer.v
+	GPIF handshake logic analyzer module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module logicAnalyzer (
+	input nReset,
+	input clock,
+
+	// Signals recorded (see below)
+	input readData,
+	input fx3isReading,
+	input dataAvailable,
+	input bufferOverflow,
+	input sendingPacket,
+	input startPacket,
+	input collectData,
+	input [1:0] readBank,
+	input [1:0] writeBank,
+	input [15:0] wordCounter,
+
+	// Control (from the register interface)
+	input arm,
+	input enable,
+	input [6:0] triggerMask,
+	input [6:0] triggerValue,
+	input [8:0] postTrigger,
+
+	// Read port
+	input [8:0] readAddress,
+	output reg [31:0] readEntry,
+
+	// Outputs
+	output [31:0] status
+);
+
+// Records the FX3 GPIF handshake into a 512 entry block RAM ring, so
+// handshake problems can be found on a production unit without a JTAG
+// SignalTap session.  The FX3 arms the capture and reads the ring back
+// through the register interface (see registerInterface.v).
+//
+// Every clock the module samples 7 signals and the buffer banks:
+//
+//   Bit 0 - readData (the GPIF is requesting data)
+//   Bit 1 - fx3isReading (the FPGA is reading the buffer)
+//   Bit 2 - dataAvailable (a complete packet is waiting)
+//   Bit 3 - Buffer overflow flag
+//   Bit 4 - FX3 state-machine is sending a packet
+//   Bit 5 - A packet is starting
+//   Bit 6 - collectData (the host is collecting data)
+//
+// An entry is only written when any of these (or either bank) changes,
+// so the ring covers far more than 512 clocks.  Each entry holds the
+// number of clocks since the previous entry; if nothing changes for
+// 255 clocks an entry is written anyway, so no time is lost:
+//
+//   Bits 6-0   - Signals (as above)
+//   Bits 8-7   - Bank being read
+//   Bits 10-9  - Bank being written
+//   Bits 23-11 - FX3 state-machine word counter (bits 12-0)
+//   Bits 31-24 - Clocks since the previous entry (0 for the first)
+//
+// The word counter moves on every clock whilst a packet is sent, so
+// its value between entries follows from the clock counts.
+//
+// arm (a single clock pulse) clears the ring and starts recording
+// whilst enable is set.  The trigger is the first clock on which the
+// signals, under triggerMask, equal triggerValue (a mask of 0
+// triggers at once).  The trigger entry is always written, followed
+// by postTrigger (0 to 511) more entries; recording then stops with
+// the done flag set, and the entries before the trigger entry are the
+// pre-trigger history.  Clearing enable stops recording at any time.
+//
+// Status:
+//
+//   Bits 8-0   - Address of the next entry to be written (once the
+//                ring has wrapped, the oldest entry)
+//   Bits 24-16 - Address of the trigger entry
+//   Bit 27     - Recording
+//   Bit 28     - The ring has wrapped (all 512 entries are valid)
+//   Bit 29     - Done (the post-trigger entries have been recorded)
+//   Bit 30     - Triggered
+//   Bit 31     - 1 (the logic analyzer is present)
+//
+// The module is reset with the FX3 rather than the sample path, so the
+// capture survives data collection being stopped.  bufferOverflow,
+// writeBank and collectData are from other clock domains and are
+// synchronised here; writeBank can show a transitional value for a
+// clock as it changes.
+localparam entryCount = 512;
+
+// Synchronise the asynchronous signals to the clock domain
+reg [1:0] bufferOverflow_sync;
+reg [1:0] collectData_sync;
+reg [1:0] writeBank_sync0;
+reg [1:0] writeBank_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		bufferOverflow_sync <= 2'b00;
+		collectData_sync <= 2'b00;
+		writeBank_sync0 <= 2'd0;
+		writeBank_sync1 <= 2'd0;
+	end else begin
+		bufferOverflow_sync <= {bufferOverflow_sync[0], bufferOverflow};
+		collectData_sync <= {collectData_sync[0], collectData};
+		writeBank_sync0 <= writeBank;
+		writeBank_sync1 <= writeBank_sync0;
+	end
+end
+
+wire [6:0] signals = {collectData_sync[1], startPacket, sendingPacket,
+	bufferOverflow_sync[1], dataAvailable, fx3isReading, readData};
+wire [10:0] key = {writeBank_sync1, readBank, signals};
+
+// Recording
+reg recording;
+reg triggered;
+reg done;
+reg wrapped;
+reg firstEntry;
+reg [10:0] lastKey;
+reg [7:0] clocksSinceEntry;
+reg [8:0] postRemaining;
+reg [8:0] triggerAddress;
+reg [8:0] writeAddress;
+
+wire triggerCondition = ((signals & triggerMask) == (triggerValue & triggerMask));
+wire triggerNow = recording && !triggered && triggerCondition;
+wire writeNow = recording && enable && !arm &&
+	(firstEntry || triggerNow || (key != lastKey) || (clocksSinceEntry == 8'd255));
+wire [31:0] entry = {clocksSinceEntry, wordCounter[12:0], key};
+
+assign status = {1'b1, triggered, done, wrapped, recording, 2'd0, triggerAddress,
+	7'd0, writeAddress};
+
+// Block RAM ring
+reg [31:0] ring [0:entryCount-1];
+
+always @ (posedge clock) begin
+	if (writeNow) ring[writeAddress] <= entry;
+	readEntry <= ring[readAddress];
+end
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		recording <= 1'b0;
+		triggered <= 1'b0;
+		done <= 1'b0;
+		wrapped <= 1'b0;
+		firstEntry <= 1'b0;
+		lastKey <= 11'd0;
+		clocksSinceEntry <= 8'd0;
+		postRemaining <= 9'd0;
+		triggerAddress <= 9'd0;
+		writeAddress <= 9'd0;
+	end else begin
+		if (arm) begin
+			// Clear the ring and start recording
+			recording <= enable;
+			triggered <= 1'b0;
+			done <= 1'b0;
+			wrapped <= 1'b0;
+			firstEntry <= 1'b1;
+			clocksSinceEntry <= 8'd0;
+			postRemaining <= postTrigger;
+			triggerAddress <= 9'd0;
+			writeAddress <= 9'd0;
+		end else if (!enable) begin
+			recording <= 1'b0;
+		end else if (writeNow) begin
+			writeAddress <= writeAddress + 9'd1;
+			if (writeAddress == entryCount - 1) wrapped <= 1'b1;
+			firstEntry <= 1'b0;
+			lastKey <= key;
+			clocksSinceEntry <= 8'd1;
+
+			if (triggerNow) begin
+				triggered <= 1'b1;
+				triggerAddress <= writeAddress;
+				if (postRemaining == 9'd0) begin
+					recording <= 1'b0;
+					done <= 1'b1;
+				end
+			end else if (triggered) begin
+				postRemaining <= postRemaining - 9'd1;
+				if (postRemaining == 9'd1) begin
+					recording <= 1'b0;
+					done <= 1'b1;
+				end
+			end
+		end else if (recording) begin
+			clocksSinceEntry <= clocksSinceEntry + 8'd1;
+		end
+	end
+end
+
+endmodule
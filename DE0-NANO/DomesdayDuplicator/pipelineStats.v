@@ -0,0 +1,113 @@
+/************************************************************************
+
+	pipelineStats.v
+	Buffer to FX3 pipeline statistics module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module pipelineStats (
+	input nReset,
+	input clock,
+	input dataAvailable,
+	input sendingPacket,
+	input packetStart,
+	input fx3isReading,
+	input [1:0] writeBank,
+	input [1:0] readBank,
+
+	// Outputs
+	output reg [31:0] clocks,
+	output reg [31:0] busWords,
+	output reg [31:0] stallMax,
+	output reg [31:0] stallTotal,
+	output [31:0] status
+);
+
+// Measures how well the FX3 keeps up with the buffer, so changes to the
+// ping-pong buffer or the GPIF handshake can be judged from a normal
+// capture:
+//
+//   clocks     - Clocks since data collection started
+//   busWords   - Words the FX3 has read from the data bus (clocks with
+//                fx3isReading set); busWords / clocks is the sustained
+//                bus words per cycle
+//   stallMax   - Longest service stall in clocks: the time a complete
+//                packet waited (dataAvailable set) before the FX3
+//                started reading it
+//   stallTotal - All the service stall clocks added together
+//   status     - Bits 1-0  - Most banks waiting to be read
+//                Bits 11-8 - Number of buffer banks
+//
+// The buffer overflows if the oldest waiting bank has not been read by
+// the time the write side fills the last free bank, so the longest stall
+// the stream can tolerate is (number of banks - 1) packet times less the
+// time taken to read a packet (see buffer.v and sim/buffer_tb.v).  The
+// counters wrap; whilst the stream is running they are read as
+// differences.
+//
+// The module is reset with the sample path, so the statistics restart
+// when data collection is started.  writeBank is from the write clock
+// domain and is synchronised here (a transitional value seen as it
+// changes is ignored if out of range, as in statusLED.v).
+
+// Number of buffer banks (must match buffer.v)
+`ifdef BUFFER_BANKS
+localparam bankCount = `BUFFER_BANKS;
+`else
+localparam bankCount = 3;
+`endif
+localparam [3:0] bankCountField = bankCount;
+
+reg [1:0] writeBank_sync0;
+reg [1:0] writeBank_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		writeBank_sync0 <= 2'd0;
+		writeBank_sync1 <= 2'd0;
+	end else begin
+		writeBank_sync0 <= writeBank;
+		writeBank_sync1 <= writeBank_sync0;
+	end
+end
+
+// Banks written ahead of the read side (0 to bankCount - 1)
+wire [1:0] banksWaiting = (writeBank_sync1 >= readBank) ? (writeBank_sync1 - readBank) :
+	(writeBank_sync1 + bankCount - readBank);
+
+reg [31:0] stallClocks;
+reg [1:0] peakWaiting;
+
+assign status = {20'd0, bankCountField, 6'd0, peakWaiting};
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		clocks <= 32'd0;
+		busWords <= 32'd0;
+		stallMax <= 32'd0;
+		stallTotal <= 32'd0;
+		stallClocks <= 32'd0;
+		peakWaiting <= 2'd0;
+	end else begin
+		clocks <= clocks + 32'd1;
+		if (fx3isReading) busWords <= busWords + 32'd1;
+
+		// A stall runs from the packet becoming available to the start
+		// of the packet
+		if (packetStart) begin
+			stallClocks <= 32'd0;
+		end else if (dataAvailable && !sendingPacket) begin
+			stallClocks <= stallClocks + 32'd1;
+			stallTotal <= stallTotal + 32'd1;
+			if (stallClocks >= stallMax) stallMax <= stallClocks + 32'd1;
+		end
+
+		if ((writeBank_sync1 < bankCount) && (banksWaiting > peakWaiting)) peakWaiting <= banksWaiting;
+	end
+end
+
+endmodule
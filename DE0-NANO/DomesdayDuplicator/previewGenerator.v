@@ -0,0 +1,69 @@
+/************************************************************************
+
+	previewGenerator.v
+	Low-rate signal envelope (preview) module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module previewGenerator (
+	input nReset,
+	input clock,
+	input [9:0] dataIn,
+
+	// Outputs
+	output reg [9:0] windowMin,
+	output reg [9:0] windowMax,
+	output reg [10:0] windowNumber,
+	output reg windowUpdate
+);
+
+// The preview is the envelope of the signal: the smallest and largest
+// 10-bit sample in each window of 2^18 samples (6.6 ms at 40 MSPS,
+// about 150 windows per second).  The FX3 reads the windows through
+// the register interface (see registerInterface.v) and passes them
+// to the host, so the signal can be monitored without collecting the
+// full sample stream.
+//
+// windowUpdate toggles at the end of each window.  windowMin,
+// windowMax and windowNumber are then stable until the end of the
+// next window, so they can be sampled in another clock domain once
+// the synchronised toggle changes.
+localparam windowBits = 18;
+
+reg [windowBits-1:0] sampleCount;
+reg [9:0] currentMin;
+reg [9:0] currentMax;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		sampleCount <= {windowBits{1'b0}};
+		currentMin <= 10'h3FF;
+		currentMax <= 10'h000;
+		windowMin <= 10'd0;
+		windowMax <= 10'd0;
+		windowNumber <= 11'd0;
+		windowUpdate <= 1'b0;
+	end else begin
+		sampleCount <= sampleCount + 1'b1;
+
+		if (sampleCount == {windowBits{1'b1}}) begin
+			// End of the window (including the last sample)
+			windowMin <= (dataIn < currentMin) ? dataIn : currentMin;
+			windowMax <= (dataIn > currentMax) ? dataIn : currentMax;
+			windowNumber <= windowNumber + 11'd1;
+			windowUpdate <= !windowUpdate;
+
+			currentMin <= 10'h3FF;
+			currentMax <= 10'h000;
+		end else begin
+			if (dataIn < currentMin) currentMin <= dataIn;
+			if (dataIn > currentMax) currentMax <= dataIn;
+		end
+	end
+end
+
+endmodule
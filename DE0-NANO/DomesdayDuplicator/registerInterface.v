@@ -0,0 +1,519 @@
+/************************************************************************
+
+	registerInterface.v
+	FX3 register interface module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module registerInterface (
+	input nReset,
+	input clock,
+
+	// Serial interface from the FX3 (asynchronous)
+	input nCS,
+	input sclk,
+	input mosi,
+	output reg miso,
+
+	// Control register
+	output reg [31:0] control,
+
+	// Overflow status (from the buffer write clock domain)
+	input [31:0] overflowCount,
+	input [47:0] overflowIndex,
+	input overflowUpdate,
+	input overflowClear,
+
+	// Sampling rate in Hz (synchronised to clock)
+	input [31:0] sampleRate,
+
+	// Multi-device synchronisation (see syncControl.v)
+	output reg [1:0] syncRole,
+	output reg syncStart,
+	input [31:0] syncStatus,
+
+	// Signal preview windows (from the sample clock domain, see
+	// previewGenerator.v)
+	input [9:0] previewMin,
+	input [9:0] previewMax,
+	input [10:0] previewNumber,
+	input previewUpdate,
+
+	// RF statistics (see rfStatistics.v)
+	output reg statsHold,
+	output [6:0] statsAddress,
+	input [31:0] statsReadData,
+
+	// Armed capture (see captureTrigger.v; the status is from the
+	// sample clock domain)
+	output reg [31:0] triggerControl,
+	output reg [23:0] triggerHoldCount,
+	output reg [11:0] triggerPreTrigger,
+	input triggered,
+	input [47:0] triggerIndex,
+
+	// Logic analyzer (see logicAnalyzer.v)
+	output reg [31:0] analyzerControl,
+	output reg analyzerArm,
+	output reg [8:0] analyzerReadAddress,
+	input [31:0] analyzerStatus,
+	input [31:0] analyzerReadEntry,
+
+	// Capture length (see captureLength.v)
+	output reg [29:0] packetLimit,
+
+	// Packet size (see buffer.v)
+	output reg [1:0] packetSize,
+	input [31:0] captureLengthStatus,
+
+	// Input line markers (from the sample clock domain, see
+	// inputMarkers.v)
+	input [47:0] markerIndex,
+	input [3:0] markerChanged,
+	input [3:0] markerLevels,
+	input markerUpdate,
+	input markerClear,
+
+	// Pipeline statistics (see pipelineStats.v)
+	input [31:0] pipelineClocks,
+	input [31:0] pipelineBusWords,
+	input [31:0] pipelineStallMax,
+	input [31:0] pipelineStallTotal,
+	input [31:0] pipelineStatus,
+
+	// Build options (constant, see DomesdayDuplicator.v)
+	input [31:0] buildFeatures
+);
+
+// The FX3 accesses the registers using a simple SPI (mode 0) style
+// interface which it drives from GPIOs.  Each transaction is 40 bits
+// sent MSB first while nCS is low:
+//
+//   Bits 39-32 - Command: bit 7 = 1 for read, 0 for write
+//                         bits 6-0 = register address
+//   Bits 31-0  - Data (write data from the FX3 on mosi, or read
+//                data from the FPGA on miso)
+//
+// mosi is sampled on the rising edge of sclk and miso changes after
+// the falling edge of sclk.  The first read data bit is available
+// after the falling edge of the 8th clock.  A write is performed
+// when nCS returns high after exactly 40 clocks.
+//
+// All inputs are synchronised to the local clock, so sclk must be
+// much slower than the clock (the FX3 GPIOs are far slower).
+//
+// Register map:
+//
+//   0x00 R  - Interface ID (0xDD000002)
+//   0x01 R  - Buffer overflow event count
+//   0x02 R  - Stream word index of the last overflow (bits 31-0)
+//   0x03 R  - Stream word index of the last overflow (bits 47-32)
+//   0x04 RW - Scratch register (for testing the interface)
+//   0x05 RW - Control register (the FX3 0xB6 configuration bits, all
+//             loaded together when the write completes):
+//             Bit 0 - Test mode (see dataGenerator.v)
+//             Bit 1 - Packed mode (see samplePacker.v)
+//             Bit 2 - Packet header mode (see samplePacker.v)
+//             Bits 3-4 - Sampling rate: 0 = 40 MHz, 1 = 28.636 MHz,
+//                        2 = 20 MHz, 3 = reserved (40 MHz)
+//             Bit 5 - Decimation mode (see decimationFilter.v)
+//             Bit 6 - Compressed mode (see samplePacker.v)
+//             Bit 7 - Soak mode (see dataGenerator.v and
+//                     fx3StateMachine.v)
+//             Bit 8 - Packet CRC mode (see fx3StateMachine.v)
+//             Bit 9 - Two-channel mode (DUAL_ADC builds, see
+//                     channelInterleave.v)
+//   0x06 R  - Current sampling rate in Hz (0 whilst changing)
+//   0x07 RW - Sync control register:
+//             Bits 0-1 - Role: 0 = stand-alone, 1 = master, 2 = slave
+//             Bit 2 - Write 1 to send a start strobe (master only;
+//                     reads as 0)
+//   0x08 R  - Sync status register (see syncControl.v)
+//   0x09 R  - Preview FIFO (see previewGenerator.v).  Reading the
+//             register removes the oldest window from the FIFO:
+//             Bit 31 - 1 = Window valid (0 = FIFO empty)
+//             Bits 30-20 - Window number (counts windows, including
+//                          any lost because the FIFO was full)
+//             Bits 19-10 - Largest sample in the window
+//             Bits 9-0 - Smallest sample in the window
+//   0x0A RW - RF statistics control register:
+//             Bit 0 - Hold the statistics snapshot (set whilst reading
+//                     registers 0x0B to 0x0F and 0x40 to 0x7F)
+//   0x0B-0x0F R - RF statistics (see rfStatistics.v)
+//   0x10 RW - Armed capture control register (only change whilst data
+//             collection is stopped):
+//             Bit 0 - Armed mode (see captureTrigger.v)
+//             Bit 1 - Trigger condition: 0 = level, 1 = activity
+//             Bits 11-2 - Trigger level
+//   0x11 RW - Trigger hold count: samples the condition must hold for
+//             (bits 23-0, 0 = 1 sample)
+//   0x12 RW - Pre-trigger history in samples (bits 11-0)
+//   0x13 R  - Armed capture status register:
+//             Bit 0 - Triggered (samples are being passed on)
+//   0x14 R  - Index of the first sample passed on (bits 31-0)
+//   0x15 R  - Index of the first sample passed on (bits 47-32)
+//   0x16 RW - Logic analyzer control register (see logicAnalyzer.v):
+//             Bits 6-0 - Trigger mask
+//             Bits 14-8 - Trigger value
+//             Bits 24-16 - Entries recorded after the trigger entry
+//             Bit 31 - Enable: writing 1 clears the ring and starts
+//                      a capture, writing 0 stops the capture
+//   0x17 R  - Logic analyzer status register (0 if the FPGA is built
+//             without LOGIC_ANALYZER)
+//   0x18 RW - Logic analyzer read address (bits 8-0)
+//   0x19 R  - Logic analyzer entry at the read address.  Reading the
+//             register moves the read address on by one
+//   0x1A RW - Capture length in packets (bits 29-0, 0 = no
+//             limit; only change whilst data collection is stopped)
+//   0x1B R  - Capture length status (see captureLength.v):
+//             Bits 29-0 - Packets sent since collection started
+//             Bit 31 - Done (the capture length has been sent)
+//   0x1C R  - Input marker FIFO head (see inputMarkers.v):
+//             Bit 31 - 1 = Marker valid (0 = FIFO empty)
+//             Bits 27-24 - Input lines that changed
+//             Bits 23-20 - Input line levels after the change
+//             Bits 15-0 - Sample index of the marker (bits 47-32)
+//   0x1D R  - Sample index of the head marker (bits 31-0).  Reading
+//             the register removes the marker from the FIFO
+//   0x1E R  - Input markers lost because the FIFO was full
+//   0x1F R  - Pipeline statistics: clocks since collection started
+//             (see pipelineStats.v).  Reading the register takes a
+//             snapshot of registers 0x20 to 0x23 at the same clock
+//   0x20 R  - Pipeline statistics: bus words read by the FX3
+//   0x21 R  - Pipeline statistics: longest service stall in clocks
+//   0x22 R  - Pipeline statistics: total service stall clocks
+//   0x23 R  - Pipeline statistics status:
+//             Bits 1-0 - Most banks waiting to be read
+//             Bits 11-8 - Number of buffer banks
+//   0x24 R  - Build features (the options the FPGA was built with):
+//             Bit 0 - DUAL_ADC (second ADC and two-channel mode)
+//             Bit 1 - SDRAM_FIFO
+//             Bit 2 - LOGIC_ANALYZER
+//             Bit 3 - GPIF_32BIT
+//             Bit 4 - FX3_CLOCK_80MHZ
+//             Bit 5 - Packet size register (0x25)
+//   0x25 RW - Packet size (only change whilst data collection is
+//             stopped; it must match the FX3 DMA buffer size):
+//             Bits 1-0 - 0 = 16 Kbytes, 1 = 8 Kbytes, 2 = 4 Kbytes
+//                        (3 is stored as 0)
+//   0x40-0x7F R - RF statistics histogram (see rfStatistics.v)
+localparam interfaceId = 32'hDD000002;
+
+// Synchronise the serial interface inputs to the clock domain
+reg [2:0] nCS_sync;
+reg [2:0] sclk_sync;
+reg [1:0] mosi_sync;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		nCS_sync <= 3'b111;
+		sclk_sync <= 3'b000;
+		mosi_sync <= 2'b00;
+	end else begin
+		nCS_sync <= {nCS_sync[1:0], nCS};
+		sclk_sync <= {sclk_sync[1:0], sclk};
+		mosi_sync <= {mosi_sync[0], mosi};
+	end
+end
+
+wire nCS_active = !nCS_sync[1];
+wire nCS_released = nCS_sync[1] && !nCS_sync[2];
+wire sclk_rising = sclk_sync[1] && !sclk_sync[2];
+wire sclk_falling = !sclk_sync[1] && sclk_sync[2];
+
+// Capture the overflow status in this clock domain
+//
+// The overflow values only change when overflowUpdate toggles and
+// are stable for many clocks afterwards, so they are sampled once
+// the synchronised toggle changes.  They are cleared whilst
+// overflowClear is set (the sample path is held in reset).
+reg [2:0] overflowUpdate_sync;
+reg [31:0] overflowCount_reg;
+reg [47:0] overflowIndex_reg;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		overflowUpdate_sync <= 3'b000;
+		overflowCount_reg <= 32'd0;
+		overflowIndex_reg <= 48'd0;
+	end else begin
+		overflowUpdate_sync <= {overflowUpdate_sync[1:0], overflowUpdate};
+
+		if (overflowClear) begin
+			overflowCount_reg <= 32'd0;
+			overflowIndex_reg <= 48'd0;
+		end else if (overflowUpdate_sync[2] != overflowUpdate_sync[1]) begin
+			overflowCount_reg <= overflowCount;
+			overflowIndex_reg <= overflowIndex;
+		end
+	end
+end
+
+// Capture the armed capture status in this clock domain
+//
+// The trigger index is set with the triggered flag and is then stable
+// until the sample path is reset, so it is sampled once the
+// synchronised flag is set.
+reg [2:0] triggered_sync;
+reg [47:0] triggerIndex_reg;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		triggered_sync <= 3'b000;
+		triggerIndex_reg <= 48'd0;
+	end else begin
+		triggered_sync <= {triggered_sync[1:0], triggered};
+		if (triggered_sync[1] && !triggered_sync[2]) triggerIndex_reg <= triggerIndex;
+	end
+end
+
+// Capture the preview windows in this clock domain
+//
+// The windows are queued in a 16 entry FIFO (about 100 ms at 40 MSPS)
+// and removed by reads of register 0x09.  If the FIFO is full the new
+// window is discarded.
+reg [2:0] previewUpdate_sync;
+reg [30:0] previewFifo [0:15];
+reg [4:0] previewWritePointer;
+reg [4:0] previewReadPointer;
+reg previewPop;
+
+wire previewEmpty = (previewWritePointer == previewReadPointer);
+wire previewFull = (previewWritePointer[3:0] == previewReadPointer[3:0]) &&
+	(previewWritePointer[4] != previewReadPointer[4]);
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		previewUpdate_sync <= 3'b000;
+		previewWritePointer <= 5'd0;
+		previewReadPointer <= 5'd0;
+	end else begin
+		previewUpdate_sync <= {previewUpdate_sync[1:0], previewUpdate};
+
+		if ((previewUpdate_sync[2] != previewUpdate_sync[1]) && !previewFull) begin
+			previewFifo[previewWritePointer[3:0]] <= {previewNumber, previewMax, previewMin};
+			previewWritePointer <= previewWritePointer + 5'd1;
+		end
+
+		if (previewPop && !previewEmpty) previewReadPointer <= previewReadPointer + 5'd1;
+	end
+end
+
+// Capture the input markers in this clock domain
+//
+// The markers are queued in a 16 entry FIFO, read through registers
+// 0x1C and 0x1D (which removes the marker).  If the FIFO is full the
+// new marker is discarded and counted.  The FIFO is emptied whilst
+// markerClear is set (the sample path is held in reset).
+reg [2:0] markerUpdate_sync;
+reg [55:0] markerFifo [0:15];
+reg [4:0] markerWritePointer;
+reg [4:0] markerReadPointer;
+reg [31:0] markersLost;
+reg markerPop;
+
+wire markerEmpty = (markerWritePointer == markerReadPointer);
+wire markerFull = (markerWritePointer[3:0] == markerReadPointer[3:0]) &&
+	(markerWritePointer[4] != markerReadPointer[4]);
+wire [55:0] markerHead = markerFifo[markerReadPointer[3:0]];
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		markerUpdate_sync <= 3'b000;
+		markerWritePointer <= 5'd0;
+		markerReadPointer <= 5'd0;
+		markersLost <= 32'd0;
+	end else begin
+		markerUpdate_sync <= {markerUpdate_sync[1:0], markerUpdate};
+
+		if (markerClear) begin
+			markerWritePointer <= 5'd0;
+			markerReadPointer <= 5'd0;
+			markersLost <= 32'd0;
+		end else begin
+			if (markerUpdate_sync[2] != markerUpdate_sync[1]) begin
+				if (markerFull) begin
+					markersLost <= markersLost + 32'd1;
+				end else begin
+					markerFifo[markerWritePointer[3:0]] <= {markerChanged, markerLevels, markerIndex};
+					markerWritePointer <= markerWritePointer + 5'd1;
+				end
+			end
+
+			if (markerPop && !markerEmpty) markerReadPointer <= markerReadPointer + 5'd1;
+		end
+	end
+end
+
+// Serial interface shift registers
+reg [39:0] shiftIn;
+reg [31:0] shiftOut;
+reg [5:0] bitCount;
+
+// Pipeline statistics snapshot, taken when register 0x1F is read so the
+// statistics can be compared with each other
+reg [31:0] pipelineBusWords_reg;
+reg [31:0] pipelineStallMax_reg;
+reg [31:0] pipelineStallTotal_reg;
+reg [31:0] pipelineStatus_reg;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		pipelineBusWords_reg <= 32'd0;
+		pipelineStallMax_reg <= 32'd0;
+		pipelineStallTotal_reg <= 32'd0;
+		pipelineStatus_reg <= 32'd0;
+	end else begin
+		if (nCS_active && sclk_falling && (bitCount == 6'd8) && (shiftIn[6:0] == 7'h1F)) begin
+			pipelineBusWords_reg <= pipelineBusWords;
+			pipelineStallMax_reg <= pipelineStallMax;
+			pipelineStallTotal_reg <= pipelineStallTotal;
+			pipelineStatus_reg <= pipelineStatus;
+		end
+	end
+end
+
+// Registers
+reg [31:0] scratch;
+
+// Read data multiplexer
+reg [31:0] readValue;
+
+// The RF statistics are read through their own multiplexer
+assign statsAddress = shiftIn[6:0];
+
+always @ (*) begin
+	case (shiftIn[6:0])
+		7'h00: readValue = interfaceId;
+		7'h01: readValue = overflowCount_reg;
+		7'h02: readValue = overflowIndex_reg[31:0];
+		7'h03: readValue = {16'd0, overflowIndex_reg[47:32]};
+		7'h04: readValue = scratch;
+		7'h05: readValue = control;
+		7'h06: readValue = sampleRate;
+		7'h07: readValue = {30'd0, syncRole};
+		7'h08: readValue = syncStatus;
+		7'h09: readValue = previewEmpty ? 32'd0 : {1'b1, previewFifo[previewReadPointer[3:0]]};
+		7'h0A: readValue = {31'd0, statsHold};
+		7'h0B, 7'h0C, 7'h0D, 7'h0E, 7'h0F: readValue = statsReadData;
+		7'h10: readValue = triggerControl;
+		7'h11: readValue = {8'd0, triggerHoldCount};
+		7'h12: readValue = {20'd0, triggerPreTrigger};
+		7'h13: readValue = {31'd0, triggered_sync[2]};
+		7'h14: readValue = triggerIndex_reg[31:0];
+		7'h15: readValue = {16'd0, triggerIndex_reg[47:32]};
+		7'h16: readValue = analyzerControl;
+		7'h17: readValue = analyzerStatus;
+		7'h18: readValue = {23'd0, analyzerReadAddress};
+		7'h19: readValue = analyzerReadEntry;
+		7'h1A: readValue = {2'd0, packetLimit};
+		7'h1B: readValue = captureLengthStatus;
+		7'h1C: readValue = markerEmpty ? 32'd0 : {1'b1, 3'd0, markerHead[55:48], 4'd0, markerHead[47:32]};
+		7'h1D: readValue = markerHead[31:0];
+		7'h1E: readValue = markersLost;
+		7'h1F: readValue = pipelineClocks;
+		7'h20: readValue = pipelineBusWords_reg;
+		7'h21: readValue = pipelineStallMax_reg;
+		7'h22: readValue = pipelineStallTotal_reg;
+		7'h23: readValue = pipelineStatus_reg;
+		7'h24: readValue = buildFeatures;
+		7'h25: readValue = {30'd0, packetSize};
+		default: readValue = shiftIn[6] ? statsReadData : 32'd0;
+	endcase
+end
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		shiftIn <= 40'd0;
+		shiftOut <= 32'd0;
+		bitCount <= 6'd0;
+		miso <= 1'b0;
+		scratch <= 32'd0;
+		control <= 32'd0;
+		syncRole <= 2'd0;
+		syncStart <= 1'b0;
+		previewPop <= 1'b0;
+		markerPop <= 1'b0;
+		statsHold <= 1'b0;
+		triggerControl <= 32'd0;
+		triggerHoldCount <= 24'd0;
+		triggerPreTrigger <= 12'd0;
+		analyzerControl <= 32'd0;
+		analyzerArm <= 1'b0;
+		analyzerReadAddress <= 9'd0;
+		packetLimit <= 30'd0;
+		packetSize <= 2'd0;
+	end else begin
+		// Remove the preview window at the end of a complete read of
+		// register 0x09
+		previewPop <= nCS_released && (bitCount == 6'd40) &&
+			shiftIn[39] && (shiftIn[38:32] == 7'h09);
+
+		// Remove the input marker at the end of a complete read of
+		// register 0x1D
+		markerPop <= nCS_released && (bitCount == 6'd40) &&
+			shiftIn[39] && (shiftIn[38:32] == 7'h1D);
+
+		// Move on to the next logic analyzer entry at the end of a
+		// complete read of register 0x19
+		if (nCS_released && (bitCount == 6'd40) && shiftIn[39] && (shiftIn[38:32] == 7'h19)) begin
+			analyzerReadAddress <= analyzerReadAddress + 9'd1;
+		end
+
+		// The arm strobe is a single clock
+		analyzerArm <= 1'b0;
+
+		if (nCS_active) begin
+			// Shift in on the rising edge of sclk
+			if (sclk_rising) begin
+				shiftIn <= {shiftIn[38:0], mosi_sync[1]};
+				if (bitCount != 6'd63) bitCount <= bitCount + 6'd1;
+			end
+
+			// Shift out on the falling edge of sclk
+			if (sclk_falling) begin
+				if (bitCount == 6'd8) begin
+					// Command received; load the read data
+					miso <= readValue[31];
+					shiftOut <= {readValue[30:0], 1'b0};
+				end else begin
+					miso <= shiftOut[31];
+					shiftOut <= {shiftOut[30:0], 1'b0};
+				end
+			end
+		end else begin
+			// Perform a write at the end of a complete write transaction
+			if (nCS_released && (bitCount == 6'd40) && !shiftIn[39]) begin
+				case (shiftIn[38:32])
+					7'h04: scratch <= shiftIn[31:0];
+					7'h05: control <= shiftIn[31:0];
+					7'h07: begin
+						syncRole <= shiftIn[1:0];
+						if (shiftIn[2]) syncStart <= !syncStart;
+					end
+					7'h0A: statsHold <= shiftIn[0];
+					7'h10: triggerControl <= {20'd0, shiftIn[11:0]};
+					7'h11: triggerHoldCount <= shiftIn[23:0];
+					7'h12: triggerPreTrigger <= shiftIn[11:0];
+					7'h16: begin
+						analyzerControl <= shiftIn[31:0] & 32'h81FF7F7F;
+						analyzerArm <= shiftIn[31];
+					end
+					7'h18: analyzerReadAddress <= shiftIn[8:0];
+					7'h1A: packetLimit <= shiftIn[29:0];
+					7'h25: packetSize <= (shiftIn[1:0] == 2'd3) ? 2'd0 : shiftIn[1:0];
+					default: ;
+				endcase
+			end
+
+			bitCount <= 6'd0;
+			miso <= 1'b0;
+		end
+	end
+end
+
+endmodule
@@ -0,0 +1,145 @@
+/************************************************************************
+
+	rfStatistics.v
+	RF level and clipping statistics module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module rfStatistics (
+	input nReset,
+	input clock,
+	input [9:0] dataIn,
+
+	// Register interface (asynchronous, see registerInterface.v)
+	input hold,
+	input [6:0] readAddress,
+
+	// Outputs
+	output reg [31:0] readData
+);
+
+// The statistics are accumulated over windows of 2^20 samples (26 ms
+// at 40 MSPS).  At the end of each window the accumulators are copied
+// to the snapshot registers, which the FX3 reads through the register
+// interface:
+//
+//   0x0B - Window number (counts from the reset)
+//   0x0C - Bits 19-10 = largest sample, bits 9-0 = smallest sample
+//   0x0D - Sum of the samples (the mean is sum / 2^20)
+//   0x0E - Number of samples clipped low (0)
+//   0x0F - Number of samples clipped high (1023)
+//   0x40-0x7F - Histogram: register 0x40 + n counts the samples from
+//               n x 16 to n x 16 + 15
+//
+// Whilst hold is set the snapshot is not updated, so all of the
+// registers can be read from the same window.  hold is synchronised
+// to this clock domain, and the snapshot is only read (from the other
+// clock domain) whilst it is held.
+localparam windowBits = 20;
+
+// Synchronise the hold input to the clock domain
+reg [1:0] hold_sync;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) hold_sync <= 2'b00;
+	else hold_sync <= {hold_sync[0], hold};
+end
+
+// Accumulators
+reg [windowBits-1:0] sampleCount;
+reg [9:0] currentMin;
+reg [9:0] currentMax;
+reg [31:0] currentSum;
+reg [windowBits:0] currentClipLow;
+reg [windowBits:0] currentClipHigh;
+reg [windowBits:0] currentBin [0:63];
+
+// Snapshot
+reg [31:0] windowNumber;
+reg [9:0] snapshotMin;
+reg [9:0] snapshotMax;
+reg [31:0] snapshotSum;
+reg [windowBits:0] snapshotClipLow;
+reg [windowBits:0] snapshotClipHigh;
+reg [windowBits:0] snapshotBin [0:63];
+
+wire windowEnd = (sampleCount == {windowBits{1'b1}});
+integer bin;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		sampleCount <= {windowBits{1'b0}};
+		currentMin <= 10'h3FF;
+		currentMax <= 10'h000;
+		currentSum <= 32'd0;
+		currentClipLow <= {(windowBits+1){1'b0}};
+		currentClipHigh <= {(windowBits+1){1'b0}};
+		windowNumber <= 32'd0;
+		snapshotMin <= 10'd0;
+		snapshotMax <= 10'd0;
+		snapshotSum <= 32'd0;
+		snapshotClipLow <= {(windowBits+1){1'b0}};
+		snapshotClipHigh <= {(windowBits+1){1'b0}};
+		for (bin = 0; bin < 64; bin = bin + 1) begin
+			currentBin[bin] <= {(windowBits+1){1'b0}};
+			snapshotBin[bin] <= {(windowBits+1){1'b0}};
+		end
+	end else begin
+		sampleCount <= sampleCount + 1'b1;
+
+		if (windowEnd) begin
+			// Copy the window (including the last sample) to the
+			// snapshot, unless it is being read
+			if (!hold_sync[1]) begin
+				windowNumber <= windowNumber + 32'd1;
+				snapshotMin <= (dataIn < currentMin) ? dataIn : currentMin;
+				snapshotMax <= (dataIn > currentMax) ? dataIn : currentMax;
+				snapshotSum <= currentSum + dataIn;
+				snapshotClipLow <= currentClipLow + (dataIn == 10'd0);
+				snapshotClipHigh <= currentClipHigh + (dataIn == 10'd1023);
+				for (bin = 0; bin < 64; bin = bin + 1) begin
+					snapshotBin[bin] <= currentBin[bin] + (dataIn[9:4] == bin);
+				end
+			end
+
+			// Start the next window
+			currentMin <= 10'h3FF;
+			currentMax <= 10'h000;
+			currentSum <= 32'd0;
+			currentClipLow <= {(windowBits+1){1'b0}};
+			currentClipHigh <= {(windowBits+1){1'b0}};
+			for (bin = 0; bin < 64; bin = bin + 1) begin
+				currentBin[bin] <= {(windowBits+1){1'b0}};
+			end
+		end else begin
+			if (dataIn < currentMin) currentMin <= dataIn;
+			if (dataIn > currentMax) currentMax <= dataIn;
+			currentSum <= currentSum + dataIn;
+			if (dataIn == 10'd0) currentClipLow <= currentClipLow + 1'b1;
+			if (dataIn == 10'd1023) currentClipHigh <= currentClipHigh + 1'b1;
+			currentBin[dataIn[9:4]] <= currentBin[dataIn[9:4]] + 1'b1;
+		end
+	end
+end
+
+// Read data multiplexer (the snapshot is static whilst it is read)
+always @ (*) begin
+	if (readAddress[6]) begin
+		readData = snapshotBin[readAddress[5:0]];
+	end else begin
+		case (readAddress)
+			7'h0B: readData = windowNumber;
+			7'h0C: readData = {12'd0, snapshotMax, snapshotMin};
+			7'h0D: readData = snapshotSum;
+			7'h0E: readData = snapshotClipLow;
+			7'h0F: readData = snapshotClipHigh;
+			default: readData = 32'd0;
+		endcase
+	end
+end
+
+endmodule
@@ -0,0 +1,381 @@
+/************************************************************************
+
+	samplePacker.v
+	10-bit sample packing and compression module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module samplePacker (
+	input nReset,
+	input clock,
+	input packedMode,
+	input headerMode,
+	input compressionMode,
+	input [1:0] packetSize,
+	input [15:0] dataIn,
+	input dataInValid,
+
+	// Outputs
+	output reg [15:0] dataOut,
+	output reg dataValid,
+	output reg framePacked,
+	output reg frameHeader,
+	output reg frameCompressed,
+	output reg [47:0] frameSampleIndex
+);
+
+// The output is divided into frames; each frame is exactly one USB
+// packet.  buffer.v switches between the banks of its buffer ring at
+// the end of each frame (it uses frameHeader to select the length),
+// so frames stay aligned with the banks.
+//
+// Without the packet header (headerMode off) a frame is 8192 16-bit
+// words.  With the packet header the FX3 state-machine inserts 8
+// header words at the start of each packet, so a frame is 8184
+// words.  The sizes given below are for 16 Kbyte packets; packetSize
+// selects 8 Kbyte (1) or 4 Kbyte (2) packets, which have frames of
+// 4096 or 2048 words less the header words (see the table at the
+// end of this description).  packetSize must only be changed whilst
+// the packer is held in reset.
+//
+// In unpacked mode each frame word is one sample as produced by the
+// data generator (10-bit sample plus 6-bit sequence number).
+//
+// In packed mode without the packet header each frame is 2 header
+// words followed by 8190 words of packed sample data:
+//
+//   Word 0 - 0xDD01 (frame marker and format)
+//   Word 1 - 16-bit frame sequence number
+//   Word 2 to 8191 - 13104 10-bit samples packed LSB first into a
+//                    continuous bit-stream (sample n occupies bits
+//                    10n to 10n+9 of the payload)
+//
+// 13104 x 10 bits is exactly 8190 words, so every frame starts on a
+// sample boundary.  The data rate is reduced from 80 MB/s to 50 MB/s
+// at 40 MSPS.
+//
+// In packed mode with the packet header (which carries the sample
+// index and the sequence information) the whole frame is packed
+// data: 13094 samples in 8184 words, with the top 4 bits of the last
+// word set to zero so that every frame starts on a sample boundary.
+//
+// In compressed mode (which overrides packed mode) the samples are
+// losslessly compressed into a bit-stream, LSB first, which is
+// framed in the same way as packed mode: without the packet header
+// each frame is 2 header words (0xDD02 then the frame sequence
+// number) followed by 8190 payload words; with the packet header the
+// whole frame (8184 words) is payload.  Each frame's payload can be
+// decoded on its own:
+//
+//   - The first sample of the frame is sent raw (10 bits)
+//   - The remaining samples are sent in blocks of 16.  The first
+//     block of the frame is sent raw; each following block uses the
+//     mode chosen at the end of the block before it
+//   - Raw samples are the 10-bit sample value
+//   - Rice coded samples (mode k = 0 to 7) code the difference from
+//     the previous sample, d = (sample - previous) modulo 1024 as a
+//     signed 10-bit value, mapped to u = 2d (d >= 0) or -2d-1 (d < 0).
+//     With q = u >> k, a sample is q one bits, a zero bit and then
+//     the k low bits of u (q < 5), or, if q >= 5, five one bits
+//     followed by the 10 bits of u (15 bits)
+//   - The mode for the next block is the k (lowest first) that would
+//     have coded the block just sent in the fewest bits, or raw if no
+//     k would have used fewer than 160 bits.  Both ends can work this
+//     out, so the mode is not sent
+//   - When the next sample's code does not fit in the frame, the rest
+//     of the payload is padded with one bits and the sample becomes
+//     the first sample of the next frame.  The padding is never a
+//     complete code, so the decoder stops at the first incomplete code
+//
+// No sample takes more than 15 bits, so the compressed stream never
+// needs more than one word per sample.
+//
+// Packed samples per frame (the bits of the last word that carry
+// sample data, the rest being zero):
+//
+//   Packet    No packet header         Packet header
+//   16 KB     13104 (last word 16)     13094 (last word 12)
+//    8 KB      6550 (last word 12)      6540 (last word 8)
+//    4 KB      3273 (last word 10)      3264 (last word 16)
+//
+// The modes are only changed at a frame boundary.  When leaving
+// packed mode the (up to 4) samples already held in the bit buffer
+// are discarded; the same applies to the compressed samples held for
+// the next frame when leaving compressed mode or changing the header
+// mode whilst compressed.
+//
+// frameSampleIndex is the index (from reset) of the first sample
+// carried by the frame; it is valid from the frame's first word.
+//
+// A new sample is taken from dataIn on each clock that dataInValid is
+// set; otherwise the packer holds its state.  The sample index counts
+// the samples received, so when the samples come from the SDRAM FIFO
+// (which can drop samples, see sdramFifo.v) it is the index of the
+// delivered samples.
+localparam fullLastFrameWord = 13'd8191;
+localparam packetHeaderWords = 13'd8;
+localparam packedHeaderWords = 13'd2;
+localparam rawBlockBits = 8'd160; // 16 x 10
+localparam modeRaw = 4'd8;
+
+// Synchronise the mode inputs to the clock domain
+reg packedMode_sync0;
+reg packedMode_sync1;
+reg headerMode_sync0;
+reg headerMode_sync1;
+reg compressionMode_sync0;
+reg compressionMode_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		packedMode_sync0 <= 1'b0;
+		packedMode_sync1 <= 1'b0;
+		headerMode_sync0 <= 1'b0;
+		headerMode_sync1 <= 1'b0;
+		compressionMode_sync0 <= 1'b0;
+		compressionMode_sync1 <= 1'b0;
+	end else begin
+		packedMode_sync0 <= packedMode;
+		packedMode_sync1 <= packedMode_sync0;
+		headerMode_sync0 <= headerMode;
+		headerMode_sync1 <= headerMode_sync0;
+		compressionMode_sync0 <= compressionMode;
+		compressionMode_sync1 <= compressionMode_sync0;
+	end
+end
+
+// Frame sizes for the packet size
+//
+// The frame payload is a whole number of words, so after the last
+// whole packed sample the last word of a packed frame has
+// (payload words x 16) mod 10 bits of padding.
+wire [12:0] lastFrameWord = fullLastFrameWord >> packetSize;
+wire [12:0] lastFrameWordHeader = lastFrameWord - packetHeaderWords;
+wire [16:0] compressedFrameBits = {lastFrameWord + 13'd1 - packedHeaderWords, 4'd0};
+wire [16:0] compressedFrameBitsHeader = {lastFrameWordHeader + 13'd1, 4'd0};
+
+reg [6:0] lastWordBits;
+
+always @ (*) begin
+	case ({packetSize, frameHeader})
+		3'b000: lastWordBits = 7'd16; // 8190 x 16 = 13104 x 10
+		3'b001: lastWordBits = 7'd12; // 8184 x 16 = 13094 x 10 + 4
+		3'b010: lastWordBits = 7'd12; // 4094 x 16 = 6550 x 10 + 4
+		3'b011: lastWordBits = 7'd8;  // 4088 x 16 = 6540 x 10 + 8
+		3'b100: lastWordBits = 7'd10; // 2046 x 16 = 3273 x 10 + 6
+		default: lastWordBits = 7'd16; // 2040 x 16 = 3264 x 10
+	endcase
+end
+
+// Sample data bits of the last word of a packed frame
+wire [15:0] lastWordMask = ~(16'hFFFF << lastWordBits);
+
+// Frame state
+reg [12:0] frameWordCount;		// Words output in the current frame
+reg [15:0] frameSequence;		// Packed frame sequence number
+reg [47:0] sampleIndex;			// Index of the sample on dataIn
+
+// Bit buffer for packing
+// Note: the buffer peaks at 45 bits in packed mode and at around 75
+// bits in compressed mode when the two frame header words are being
+// output (no data is drained for 2 clocks)
+reg [79:0] bitBuffer;
+reg [6:0] bitCount;
+
+// Packed or compressed frame (the payload is a bit-stream)
+wire bitMode = framePacked || frameCompressed;
+
+// Is a packed data word output on this clock?
+//
+// In packed mode the last word of a frame can carry fewer than 16 bits
+// of sample data (lastWordBits).
+wire lastWord = (frameWordCount == (frameHeader ? lastFrameWordHeader : lastFrameWord));
+wire headerWord = bitMode && !frameHeader && (frameWordCount < packedHeaderWords);
+wire [6:0] drainBits = (lastWord && framePacked) ? lastWordBits : 7'd16;
+wire packedWord = bitMode && !headerWord && (bitCount >= drainBits);
+wire wordOut = !bitMode || headerWord || packedWord;
+
+// Compressor state
+reg [16:0] frameBitsLeft;			// Payload bits not yet used in the frame
+reg frameStart;					// Next sample is the first of the frame
+reg [9:0] previousSample;
+reg [3:0] blockMode;				// 0-7 = Rice parameter k, 8 = raw
+reg [3:0] blockSampleCount;		// Samples sent in the current block
+reg [7:0] blockCost [0:7];		// Bits the block would take with each k
+reg [47:0] nextFrameSampleIndex;	// Index of the first sample of the next frame
+
+// Mapped difference from the previous sample
+wire [9:0] sampleDifference = dataIn[9:0] - previousSample;
+wire [9:0] mappedDifference = {sampleDifference[8:0], 1'b0} ^ {10{sampleDifference[9]}};
+
+// Rice code for the current block mode
+wire [2:0] riceK = blockMode[2:0];
+wire [9:0] riceQ = mappedDifference >> riceK;
+wire riceEscape = (riceQ >= 10'd5);
+wire [14:0] riceCode = riceEscape ? {mappedDifference, 5'b11111} :
+	(((15'd1 << riceQ[2:0]) - 15'd1) | (({5'd0, mappedDifference} & ((15'd1 << riceK) - 15'd1)) << (riceQ[2:0] + 3'd1)));
+wire [3:0] riceLength = riceEscape ? 4'd15 : (riceQ[3:0] + riceK + 4'd1);
+
+// The code for the sample (padding the frame first if it does not fit)
+wire blockRaw = (blockMode == modeRaw);
+wire framePad = !frameStart && ((blockRaw ? 17'd10 : {13'd0, riceLength}) > frameBitsLeft);
+wire sendRaw = frameStart || framePad || blockRaw;
+wire [14:0] sampleCode = sendRaw ? {5'd0, dataIn[9:0]} : riceCode;
+wire [3:0] sampleCodeLength = sendRaw ? 4'd10 : riceLength;
+wire [3:0] padBits = framePad ? frameBitsLeft[3:0] : 4'd0;
+
+// Block costs including the current sample and the best mode for
+// the next block
+reg [7:0] blockCostNext [0:7];
+reg [3:0] bestMode;
+reg [7:0] bestCost;
+reg [9:0] costQ;
+integer k;
+integer i;
+
+always @ (*) begin
+	bestMode = modeRaw;
+	bestCost = rawBlockBits;
+	for (k = 0; k < 8; k = k + 1) begin
+		costQ = mappedDifference >> k;
+		blockCostNext[k] = blockCost[k] + ((costQ >= 10'd5) ? 8'd15 : (costQ[7:0] + k + 8'd1));
+		if (blockCostNext[k] < bestCost) begin
+			bestCost = blockCostNext[k];
+			bestMode = k;
+		end
+	end
+end
+
+// Bit buffer after draining any word output on this clock
+wire [79:0] bitBufferDrained = packedWord ? (bitBuffer >> drainBits) : bitBuffer;
+wire [6:0] bitCountDrained = packedWord ? (bitCount - drainBits) : bitCount;
+
+// Bit buffer after adding the incoming sample (and any padding)
+wire [28:0] paddedCode = ({14'd0, sampleCode} << padBits) | ((29'd1 << padBits) - 29'd1);
+wire [28:0] insertCode = frameCompressed ? paddedCode : {19'd0, dataIn[9:0]};
+wire [4:0] insertLength = frameCompressed ? (padBits + sampleCodeLength) : 5'd10;
+wire [79:0] bitBufferNext = bitMode ? (bitBufferDrained | ({51'd0, insertCode} << bitCountDrained)) : 80'd0;
+wire [6:0] bitCountNext = bitMode ? (bitCountDrained + insertLength) : 7'd0;
+
+// Number of whole samples held in the bit buffer (packed mode)
+wire [2:0] bufferedSamples =
+	(bitCountNext >= 7'd40) ? 3'd4 :
+	(bitCountNext >= 7'd30) ? 3'd3 :
+	(bitCountNext >= 7'd20) ? 3'd2 :
+	(bitCountNext >= 7'd10) ? 3'd1 : 3'd0;
+
+// Modes of the next frame
+wire nextPacked = packedMode_sync1 && !compressionMode_sync1;
+wire nextCompressed = compressionMode_sync1;
+
+// Keep the bits for the next frame if its format is unchanged
+// Note: the compressor pads each frame assuming the next frame has
+// the same header mode
+wire keepBits = (framePacked && nextPacked) ||
+	(frameCompressed && nextCompressed && (headerMode_sync1 == frameHeader));
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		dataOut <= 16'd0;
+		dataValid <= 1'b0;
+		framePacked <= 1'b0;
+		frameHeader <= 1'b0;
+		frameCompressed <= 1'b0;
+		frameSampleIndex <= 48'd0;
+		frameWordCount <= 13'd0;
+		frameSequence <= 16'd0;
+		sampleIndex <= 48'd0;
+		bitBuffer <= 80'd0;
+		bitCount <= 7'd0;
+		frameBitsLeft <= 17'd0;
+		frameStart <= 1'b0;
+		previousSample <= 10'd0;
+		blockMode <= modeRaw;
+		blockSampleCount <= 4'd0;
+		for (i = 0; i < 8; i = i + 1) blockCost[i] <= 8'd0;
+		nextFrameSampleIndex <= 48'd0;
+	end else if (dataInValid) begin
+		sampleIndex <= sampleIndex + 48'd1;
+
+		// Output the next word of the frame
+		if (!bitMode) begin
+			dataOut <= dataIn;
+		end else if (headerWord) begin
+			if (frameWordCount == 13'd0) dataOut <= frameCompressed ? 16'hDD02 : 16'hDD01;
+			else dataOut <= frameSequence;
+		end else if (lastWord && framePacked) begin
+			dataOut <= bitBuffer[15:0] & lastWordMask;
+		end else begin
+			dataOut <= bitBuffer[15:0];
+		end
+		dataValid <= wordOut;
+
+		// Add the incoming sample to the bit buffer (packed and
+		// compressed modes only)
+		bitBuffer <= bitBufferNext;
+		bitCount <= bitCountNext;
+
+		// Update the compressor
+		if (frameCompressed) begin
+			previousSample <= dataIn[9:0];
+
+			if (frameStart || framePad) begin
+				// First sample of a frame; the first block is raw
+				frameBitsLeft <= (framePad ? (frameHeader ? compressedFrameBitsHeader : compressedFrameBits) : frameBitsLeft) - 17'd10;
+				frameStart <= 1'b0;
+				blockMode <= modeRaw;
+				blockSampleCount <= 4'd0;
+				for (i = 0; i < 8; i = i + 1) blockCost[i] <= 8'd0;
+				if (framePad) nextFrameSampleIndex <= sampleIndex;
+			end else begin
+				frameBitsLeft <= frameBitsLeft - sampleCodeLength;
+				blockSampleCount <= blockSampleCount + 4'd1;
+
+				// Select the mode for the next block
+				if (blockSampleCount == 4'd15) begin
+					blockMode <= bestMode;
+					for (i = 0; i < 8; i = i + 1) blockCost[i] <= 8'd0;
+				end else begin
+					for (i = 0; i < 8; i = i + 1) blockCost[i] <= blockCostNext[i];
+				end
+			end
+		end
+
+		// Count the frame words and select the modes at the end of each frame
+		if (wordOut) begin
+			if (lastWord) begin
+				frameWordCount <= 13'd0;
+				if (bitMode) frameSequence <= frameSequence + 16'd1;
+				framePacked <= nextPacked;
+				frameHeader <= headerMode_sync1;
+				frameCompressed <= nextCompressed;
+
+				// Discard any left-over bits when the format changes and
+				// restart the compressor with the next sample
+				if (!keepBits) begin
+					bitBuffer <= 80'd0;
+					bitCount <= 7'd0;
+					frameBitsLeft <= headerMode_sync1 ? compressedFrameBitsHeader : compressedFrameBits;
+					frameStart <= 1'b1;
+				end
+
+				// The next frame starts with the samples held in the bit buffer
+				// or with the next sample
+				if (keepBits && framePacked) frameSampleIndex <= sampleIndex + 48'd1 - bufferedSamples;
+				else if (keepBits) frameSampleIndex <= framePad ? sampleIndex : nextFrameSampleIndex;
+				else frameSampleIndex <= sampleIndex + 48'd1;
+			end else begin
+				frameWordCount <= frameWordCount + 13'd1;
+			end
+		end
+	end else begin
+		// No new sample on this clock
+		dataValid <= 1'b0;
+	end
+end
+
+endmodule
@@ -0,0 +1,419 @@
+/************************************************************************
+
+	sdramFifo.v
+	SDRAM elastic FIFO module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module sdramFifo (
+	input nReset,
+	input writeClock,
+	input readClock,
+	input sdramClock,
+
+	// Write side
+	input [15:0] dataIn,
+	input dataInValid,
+
+	// Read side (show-ahead; dataOut is valid when dataValid is set
+	// and dataRead removes it)
+	input dataRead,
+	output [15:0] dataOut,
+	output dataValid,
+
+	// Overflow status (write clock domain)
+	output reg bufferOverflow,
+	output reg [31:0] overflowCount,
+	output reg [47:0] overflowIndex,
+	output reg overflowUpdate,
+
+	// SDRAM interface
+	output reg [12:0] sdramAddress,
+	output reg [1:0] sdramBank,
+	output sdramCke,
+	output sdramNCs,
+	output sdramNRas,
+	output sdramNCas,
+	output sdramNWe,
+	output reg [1:0] sdramDqm,
+	inout [15:0] sdramDq
+);
+
+// The FIFO uses the DE0-Nano's 32 MByte SDRAM (ISSI IS42S16160, 4 banks
+// of 8192 rows x 512 columns x 16 bits) as a 16M word ring buffer,
+// which is around 420 ms of samples at 40 MSPS.
+//
+// The samples are passed to the SDRAM clock domain through a small
+// input FIFO and are written to the SDRAM in 256 word blocks.  Blocks
+// are read back into a small output FIFO whenever it has room for a
+// complete block.  At 120 MHz the SDRAM can transfer around 114M
+// words/s (including the refresh and bank activation overheads), so
+// there is plenty of bandwidth for the 40M words/s in and out.
+//
+// The read side is elastic.  If the reader stops (for example whilst
+// the FX3 is waiting for the host) the samples are held in the SDRAM
+// until it restarts.  Samples are only dropped when the whole ring is
+// full; the drop is then reported in the same way as a buffer.v
+// overflow, with overflowIndex holding the index (from reset) of the
+// first sample dropped.
+//
+// Each 256 word block is half of an SDRAM row; consecutive blocks are
+// spread across the four banks:
+//
+//   Block number bit 0     - Column address bit 8
+//   Block number bits 2-1  - Bank
+//   Block number bits 15-3 - Row
+localparam blockSize = 9'd256;
+
+// Output FIFO level below which a block can be read from the SDRAM
+// Note: This leaves room for a complete block plus the words still
+// in the read pipeline from the previous block
+localparam outputFifoThreshold = 11'd704;
+
+// SDRAM commands {nCS, nRAS, nCAS, nWE}
+localparam cmdNop = 4'b0111;
+localparam cmdActive = 4'b0011;
+localparam cmdRead = 4'b0101;
+localparam cmdWrite = 4'b0100;
+localparam cmdBurstStop = 4'b0110;
+localparam cmdPrecharge = 4'b0010;
+localparam cmdRefresh = 4'b0001;
+localparam cmdLoadMode = 4'b0000;
+
+// SDRAM mode register: full-page sequential bursts, CAS latency 3
+localparam modeRegister = 13'b000_0_00_011_0_111;
+
+// SDRAM timing in sdramClock cycles (120 MHz, 8.33 ns) from one
+// command to the next
+localparam tInit = 14'd12000;	// 100 us power-up delay
+localparam tRP = 14'd3;			// Precharge to active/refresh (20 ns)
+localparam tRC = 14'd8;			// Refresh to active/refresh (63 ns)
+localparam tMRD = 14'd2;		// Load mode to active
+localparam tRCD = 14'd3;		// Active to read/write (20 ns)
+localparam tWR = 14'd2;			// Burst stop (write) to precharge
+
+// Refresh interval
+// Note: 8192 refreshes are required every 64 ms (7.8 us each).  A
+// refresh can be delayed by a burst in progress (up to 270 cycles), so
+// it is requested every 5.3 us.
+localparam refreshInterval = 10'd640;
+
+// Read latency from the READ command to the data being available in
+// the input register (CAS latency plus the output and input
+// registers)
+// Note: This depends on the phase of the SDRAM clock (see IPpllSdram)
+localparam readLatency = 5;
+
+// Input FIFO (write clock to SDRAM clock) --------------------------------
+
+wire inputFifoFull;
+wire inputFifoRead;
+wire [15:0] inputFifoData;
+wire [10:0] inputFifoUsedWords;
+
+IPfifoSdram inputFifo (
+	.aclr(!nReset),
+	.data(dataIn),
+	.rdclk(sdramClock),
+	.rdreq(inputFifoRead),
+	.wrclk(writeClock),
+	.wrreq(dataInValid && !inputFifoFull),
+	.q(inputFifoData),
+	.rdempty(),
+	.rdusedw(inputFifoUsedWords),
+	.wrempty(),
+	.wrfull(inputFifoFull),
+	.wrusedw()
+);
+
+// Output FIFO (SDRAM clock to read clock) --------------------------------
+
+reg [15:0] sdramDataIn;
+reg [readLatency-1:0] readPipe;
+wire [10:0] outputFifoUsedWords;
+wire outputFifoEmpty;
+
+IPfifoSdram outputFifo (
+	.aclr(!nReset),
+	.data(sdramDataIn),
+	.rdclk(readClock),
+	.rdreq(dataRead),
+	.wrclk(sdramClock),
+	.wrreq(readPipe[readLatency-1]),
+	.q(dataOut),
+	.rdempty(outputFifoEmpty),
+	.rdusedw(),
+	.wrempty(),
+	.wrfull(),
+	.wrusedw(outputFifoUsedWords)
+);
+
+assign dataValid = !outputFifoEmpty;
+
+// Overflow tracking (write clock domain) ---------------------------------
+
+// Register to track activation of the overflow flag (0-1024 10-bit)
+reg [9:0] bufferOverflowHold;
+
+reg [47:0] sampleIndex;		// Index of the next valid sample on dataIn
+reg droppingSamples;
+
+// Overflow events are always at least one SDRAM block apart, so
+// overflowCount and overflowIndex are stable for many clocks after
+// overflowUpdate toggles.
+always @ (posedge writeClock, negedge nReset) begin
+	if (!nReset) begin
+		bufferOverflow <= 1'b0;
+		bufferOverflowHold <= 10'd0;
+		overflowCount <= 32'd0;
+		overflowIndex <= 48'd0;
+		overflowUpdate <= 1'b0;
+		sampleIndex <= 48'd0;
+		droppingSamples <= 1'b0;
+	end else begin
+		if (dataInValid) begin
+			sampleIndex <= sampleIndex + 48'd1;
+
+			// The sample on dataIn is dropped if the input FIFO is full
+			if (inputFifoFull) begin
+				if (!droppingSamples) begin
+					bufferOverflow <= 1'b1;
+					overflowCount <= overflowCount + 32'd1;
+					overflowIndex <= sampleIndex;
+					overflowUpdate <= !overflowUpdate;
+				end
+				droppingSamples <= 1'b1;
+			end else begin
+				droppingSamples <= 1'b0;
+			end
+		end
+
+		// Track and clear the buffer overflow flag
+		// Note: This holds the error signal high
+		// for 1000 write clock cycles
+		if (bufferOverflow == 1'b1) begin
+			bufferOverflowHold <= bufferOverflowHold + 10'd1;
+			if (bufferOverflowHold > 10'd1000) begin
+				bufferOverflow <= 1'b0;
+			end
+		end else begin
+			bufferOverflowHold <= 10'd0;
+		end
+	end
+end
+
+// SDRAM controller (SDRAM clock domain) ----------------------------------
+
+// Controller states
+localparam stateWait = 4'd0;
+localparam stateInitPrecharge = 4'd1;
+localparam stateInitRefresh = 4'd2;
+localparam stateInitMode = 4'd3;
+localparam stateIdle = 4'd4;
+localparam stateBurstStart = 4'd5;
+localparam stateWriteBurst = 4'd6;
+localparam stateReadBurst = 4'd7;
+localparam stateBurstStop = 4'd8;
+localparam statePrecharge = 4'd9;
+
+reg [3:0] state;
+reg [3:0] nextState;		// State to enter at the end of stateWait
+reg [13:0] timer;			// Cycles until the next command (stateWait)
+reg [3:0] initRefreshCount;
+
+reg [3:0] sdramCommand;
+reg [15:0] sdramDataOut;
+reg sdramDataOutEnable;
+
+assign sdramCke = 1'b1;
+assign {sdramNCs, sdramNRas, sdramNCas, sdramNWe} = sdramCommand;
+assign sdramDq = sdramDataOutEnable ? sdramDataOut : 16'bZ;
+
+// Ring buffer block pointers
+// Note: the extra bit distinguishes a full ring from an empty one
+reg [16:0] writeBlock;
+reg [16:0] readBlock;
+wire [16:0] usedBlocks = writeBlock - readBlock;
+
+reg [15:0] burstBlock;		// Block being transferred
+reg burstIsWrite;
+reg [7:0] burstCount;		// Words transferred in the current burst
+reg readWord;				// A word is being read on this cycle
+
+reg [9:0] refreshTimer;
+reg refreshDue;
+
+// A block can be written when the input FIFO holds a complete block
+// and the ring is not full; a block can be read when the ring is not
+// empty and the output FIFO has room for it
+wire writePending = (inputFifoUsedWords >= blockSize) && !usedBlocks[16];
+wire readPending = (usedBlocks != 17'd0) && (outputFifoUsedWords < outputFifoThreshold);
+
+// Block to be transferred next (written blocks take priority)
+wire [15:0] nextBlock = writePending ? writeBlock[15:0] : readBlock[15:0];
+
+// The input FIFO is show-ahead, so each word is removed as it is
+// placed on the SDRAM data bus
+assign inputFifoRead = ((state == stateBurstStart) && burstIsWrite) || (state == stateWriteBurst);
+
+always @ (posedge sdramClock, negedge nReset) begin
+	if (!nReset) begin
+		state <= stateWait;
+		nextState <= stateInitPrecharge;
+		timer <= tInit;
+		initRefreshCount <= 4'd0;
+		sdramCommand <= cmdNop;
+		sdramAddress <= 13'd0;
+		sdramBank <= 2'd0;
+		sdramDqm <= 2'b11;
+		sdramDataOut <= 16'd0;
+		sdramDataOutEnable <= 1'b0;
+		writeBlock <= 17'd0;
+		readBlock <= 17'd0;
+		burstBlock <= 16'd0;
+		burstIsWrite <= 1'b0;
+		burstCount <= 8'd0;
+		readWord <= 1'b0;
+		refreshTimer <= 10'd0;
+		refreshDue <= 1'b0;
+	end else begin
+		// Default to no operation
+		sdramCommand <= cmdNop;
+		readWord <= 1'b0;
+
+		// Request a refresh at regular intervals
+		if (refreshTimer == refreshInterval) begin
+			refreshTimer <= 10'd0;
+			refreshDue <= 1'b1;
+		end else begin
+			refreshTimer <= refreshTimer + 10'd1;
+		end
+
+		case (state)
+			// Wait between commands
+			stateWait: begin
+				timer <= timer - 14'd1;
+				if (timer == 14'd1) state <= nextState;
+			end
+
+			// Initialisation: precharge all banks, 8 refreshes and
+			// then set the mode register
+			stateInitPrecharge: begin
+				sdramCommand <= cmdPrecharge;
+				sdramAddress <= 13'b0_0100_0000_0000; // A10 = all banks
+				initRefreshCount <= 4'd8;
+				timer <= tRP - 14'd1;
+				nextState <= stateInitRefresh;
+				state <= stateWait;
+			end
+
+			stateInitRefresh: begin
+				sdramCommand <= cmdRefresh;
+				initRefreshCount <= initRefreshCount - 4'd1;
+				timer <= tRC - 14'd1;
+				nextState <= (initRefreshCount == 4'd1) ? stateInitMode : stateInitRefresh;
+				state <= stateWait;
+			end
+
+			stateInitMode: begin
+				sdramCommand <= cmdLoadMode;
+				sdramAddress <= modeRegister;
+				sdramBank <= 2'd0;
+				sdramDqm <= 2'b00;
+				timer <= tMRD - 14'd1;
+				nextState <= stateIdle;
+				state <= stateWait;
+			end
+
+			// Select the next operation
+			stateIdle: begin
+				if (refreshDue) begin
+					sdramCommand <= cmdRefresh;
+					refreshDue <= 1'b0;
+					timer <= tRC - 14'd1;
+					nextState <= stateIdle;
+					state <= stateWait;
+				end else if (writePending || readPending) begin
+					// Activate the row holding the block
+					sdramCommand <= cmdActive;
+					sdramAddress <= nextBlock[15:3];
+					sdramBank <= nextBlock[2:1];
+					burstBlock <= nextBlock;
+					burstIsWrite <= writePending;
+					timer <= tRCD - 14'd1;
+					nextState <= stateBurstStart;
+					state <= stateWait;
+				end
+			end
+
+			// Start the burst (full-page burst from the start of the block)
+			stateBurstStart: begin
+				sdramAddress <= {4'b0000, burstBlock[0], 8'd0};
+				burstCount <= 8'd1;
+
+				if (burstIsWrite) begin
+					sdramCommand <= cmdWrite;
+					sdramDataOut <= inputFifoData;
+					sdramDataOutEnable <= 1'b1;
+					state <= stateWriteBurst;
+				end else begin
+					sdramCommand <= cmdRead;
+					readWord <= 1'b1;
+					state <= stateReadBurst;
+				end
+			end
+
+			stateWriteBurst: begin
+				sdramDataOut <= inputFifoData;
+				burstCount <= burstCount + 8'd1;
+				if (burstCount == 8'd255) state <= stateBurstStop;
+			end
+
+			stateReadBurst: begin
+				readWord <= 1'b1;
+				burstCount <= burstCount + 8'd1;
+				if (burstCount == 8'd255) state <= stateBurstStop;
+			end
+
+			// Terminate the burst after 256 words
+			stateBurstStop: begin
+				sdramCommand <= cmdBurstStop;
+				sdramDataOutEnable <= 1'b0;
+				if (burstIsWrite) writeBlock <= writeBlock + 17'd1;
+				else readBlock <= readBlock + 17'd1;
+
+				timer <= tWR - 14'd1;
+				nextState <= statePrecharge;
+				state <= stateWait;
+			end
+
+			// Close the row
+			statePrecharge: begin
+				sdramCommand <= cmdPrecharge;
+				sdramAddress <= 13'd0; // A10 = selected bank only
+				timer <= tRP - 14'd1;
+				nextState <= stateIdle;
+				state <= stateWait;
+			end
+
+			default: state <= stateIdle;
+		endcase
+	end
+end
+
+// Capture the read data from the SDRAM
+always @ (posedge sdramClock, negedge nReset) begin
+	if (!nReset) begin
+		sdramDataIn <= 16'd0;
+		readPipe <= {readLatency{1'b0}};
+	end else begin
+		sdramDataIn <= sdramDq;
+		readPipe <= {readPipe[readLatency-2:0], readWord};
+	end
+end
+
+endmodule
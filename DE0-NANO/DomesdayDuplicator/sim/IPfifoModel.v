@@ -0,0 +1,153 @@
+/************************************************************************
+
+	IPfifoModel.v
+	Behavioural FIFO models for simulation
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// The bank FIFOs (IPfifo.v and IPfifo32.v) are Quartus dcfifo
+// megafunctions, which need the Altera simulation libraries.  The
+// testbenches use these models instead.  They have the same ports and
+// the same show-ahead behaviour: q is the oldest word, and rdreq
+// removes it on the read clock.
+//
+// The used word counts and the empty flags are not passed through a
+// synchroniser as they are in the dcfifo, and a word can be read on the
+// read clock after it was written.  buffer.v does not use the flags
+// (see the bank handshake in buffer.v), and it only reads a bank once
+// the handshake has passed it over, so this does not hide a timing
+// problem in the buffer.
+//
+// A write to a full FIFO or a read from an empty one means the bank
+// handshake has gone wrong; the models ignore it (as the dcfifo does
+// with overflow and underflow checking on) and report an error.
+
+module fifoModel #(
+	parameter width = 16,
+	parameter widthu = 14			// Used word bits (one more than the address)
+) (
+	input aclr,
+	input [width-1:0] data,
+	input rdclk,
+	input rdreq,
+	input wrclk,
+	input wrreq,
+	output [width-1:0] q,
+	output rdempty,
+	output [widthu-1:0] rdusedw,
+	output wrempty,
+	output [widthu-1:0] wrusedw
+);
+
+localparam depth = 1 << (widthu - 1);
+
+reg [width-1:0] memory [0:depth-1];
+reg [widthu-1:0] writePointer;
+reg [widthu-1:0] readPointer;
+
+wire [widthu-1:0] usedWords = writePointer - readPointer;
+
+assign q = memory[readPointer[widthu-2:0]];
+assign rdempty = (usedWords == {widthu{1'b0}});
+assign wrempty = rdempty;
+assign rdusedw = usedWords;
+assign wrusedw = usedWords;
+
+always @ (posedge wrclk, posedge aclr) begin
+	if (aclr) begin
+		writePointer <= {widthu{1'b0}};
+	end else if (wrreq) begin
+		if (usedWords == depth) begin
+			$display("ERROR: %m: write to a full FIFO at %0t", $time);
+		end else begin
+			memory[writePointer[widthu-2:0]] <= data;
+			writePointer <= writePointer + 1'b1;
+		end
+	end
+end
+
+always @ (posedge rdclk, posedge aclr) begin
+	if (aclr) begin
+		readPointer <= {widthu{1'b0}};
+	end else if (rdreq) begin
+		if (rdempty) begin
+			$display("ERROR: %m: read from an empty FIFO at %0t", $time);
+		end else begin
+			readPointer <= readPointer + 1'b1;
+		end
+	end
+end
+
+endmodule
+
+// 8192 x 16-bit bank FIFO (IPfifo.v)
+module IPfifo (
+	input aclr,
+	input [15:0] data,
+	input rdclk,
+	input rdreq,
+	input wrclk,
+	input wrreq,
+	output [15:0] q,
+	output rdempty,
+	output [13:0] rdusedw,
+	output wrempty,
+	output [13:0] wrusedw
+);
+
+fifoModel #(
+	.width(16),
+	.widthu(14)
+) fifo (
+	.aclr(aclr),
+	.data(data),
+	.rdclk(rdclk),
+	.rdreq(rdreq),
+	.wrclk(wrclk),
+	.wrreq(wrreq),
+	.q(q),
+	.rdempty(rdempty),
+	.rdusedw(rdusedw),
+	.wrempty(wrempty),
+	.wrusedw(wrusedw)
+);
+
+endmodule
+
+// 4096 x 32-bit bank FIFO (IPfifo32.v)
+module IPfifo32 (
+	input aclr,
+	input [31:0] data,
+	input rdclk,
+	input rdreq,
+	input wrclk,
+	input wrreq,
+	output [31:0] q,
+	output rdempty,
+	output [12:0] rdusedw,
+	output wrempty,
+	output [12:0] wrusedw
+);
+
+fifoModel #(
+	.width(32),
+	.widthu(13)
+) fifo (
+	.aclr(aclr),
+	.data(data),
+	.rdclk(rdclk),
+	.rdreq(rdreq),
+	.wrclk(wrclk),
+	.wrreq(wrreq),
+	.q(q),
+	.rdempty(rdempty),
+	.rdusedw(rdusedw),
+	.wrempty(wrempty),
+	.wrusedw(wrusedw)
+);
+
+endmodule
@@ -0,0 +1,460 @@
+/************************************************************************
+
+	buffer_tb.v
+	Data buffer and FX3 interface testbench
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+`timescale 1ns / 1ps
+
+// Runs the test mode data path from the buffer to the FX3, as wired in
+// DomesdayDuplicator.v: dataGenerator.v writes a sample on every 40 MHz
+// clock into buffer.v, and fx3StateMachine.v sends the banks to the
+// GPIF model (fx3GpifModel.v) on the 60 MHz (or 80 MHz) GPIF clock,
+// with pipelineStats.v measuring the handshake.
+//
+// 1. Sustained stream: with the GPIF model's service latency and
+//    jitter the stream must run without an overflow, every word must
+//    reach the GPIF in order, and the bus words per cycle must match
+//    the sample rate (667 per 1000 clocks for the 16-bit bus at 60 MHz).
+//
+// 2. Stall sweep: a single stall is added to the GPIF service latency
+//    after a few packets, and the longest stall that does not overflow
+//    the buffer is found by bisection.  The longest wait that the
+//    buffer absorbed (stallMax from pipelineStats.v) must be close to
+//    (banks - 1) bank fill times less the time taken to read a packet:
+//    the oldest waiting bank has to be read by the time the write side
+//    completes the last free bank.
+//
+// 3. Overflow: a stall just over the limit must overflow the buffer
+//    once, discarding a single frame, after which the stream carries on
+//    from the next frame.
+//
+// The macros used by the FPGA build (GPIF_32BIT, BUFFER_BANKS and
+// FX3_CLOCK_80MHZ) select the same variants here; see the Makefile.
+
+module buffer_tb;
+
+`ifdef GPIF_32BIT
+localparam busWidth = 32;
+localparam fullPacketWords = 16'd4096;
+localparam samplesPerWord = 2;
+`else
+localparam busWidth = 16;
+localparam fullPacketWords = 16'd8192;
+localparam samplesPerWord = 1;
+`endif
+
+`ifdef BUFFER_BANKS
+localparam bankCount = `BUFFER_BANKS;
+`else
+localparam bankCount = 3;
+`endif
+
+// Clock periods in ns
+localparam real writePeriod = 25.0;
+`ifdef FX3_CLOCK_80MHZ
+localparam real readPeriod = 12.5;
+`else
+localparam real readPeriod = 50.0 / 3.0;
+`endif
+
+// Test settings
+parameter PACKET_SIZE = 0;			// packetSize (0 = 16 Kbytes)
+parameter GPIF_LATENCY = 20;		// Service latency after each packet (GPIF clocks)
+parameter GPIF_JITTER = 10;			// Extra random latency (0 to GPIF_JITTER clocks)
+parameter SEED = 1;
+parameter SUSTAINED_PACKETS = 24;	// Packets read in the sustained test
+
+localparam [15:0] gpifLatency = GPIF_LATENCY;
+localparam [15:0] gpifJitter = GPIF_JITTER;
+localparam [1:0] packetSize = PACKET_SIZE;
+localparam [15:0] packetWords = fullPacketWords >> packetSize;
+
+// Packets read before the stall is added
+localparam warmUpPackets = 4;
+
+reg nReset;
+reg writeClock;
+reg readClock;
+
+initial writeClock = 1'b0;
+always #(writePeriod / 2.0) writeClock = !writeClock;
+
+initial readClock = 1'b0;
+always #(readPeriod / 2.0) readClock = !readClock;
+
+// Write side ------------------------------------------------------------
+
+wire [15:0] sampleData;
+
+dataGenerator dataGenerator0 (
+	.nReset(nReset),
+	.clock(writeClock),
+	.adc_databus(10'd0),
+	.testModeFlag(1'b1),
+	.soakModeFlag(1'b0),
+	.restart(1'b0),
+	.dataOut(sampleData)
+);
+
+// Buffer ----------------------------------------------------------------
+
+wire fx3isReading;
+wire writeReady;
+wire bufferOverflow;
+wire [31:0] overflowCount;
+wire [47:0] overflowIndex;
+wire overflowUpdate;
+wire dataAvailable;
+wire packetHeaderEnable;
+wire [127:0] packetHeader;
+wire [1:0] currentWriteBank;
+wire [1:0] currentReadBank;
+wire [busWidth-1:0] bufferData;
+
+buffer buffer0 (
+	.nReset(nReset),
+	.writeClock(writeClock),
+	.readClock(readClock),
+	.isReading(fx3isReading),
+	.dataIn(sampleData),
+	.dataValid(1'b1),
+	.testMode(1'b1),
+	.soakMode(1'b0),
+	.decimationMode(1'b0),
+	.twoChannelMode(1'b0),
+	.packetSize(packetSize),
+	.framePacked(1'b0),
+	.frameHeader(1'b0),
+	.frameCompressed(1'b0),
+	.frameSampleIndex(48'd0),
+	.lineChanged(4'd0),
+	.writeReady(writeReady),
+	.bufferOverflow(bufferOverflow),
+	.overflowCount(overflowCount),
+	.overflowIndex(overflowIndex),
+	.overflowUpdate(overflowUpdate),
+	.dataAvailable(dataAvailable),
+	.packetHeaderEnable(packetHeaderEnable),
+	.packetHeader(packetHeader),
+	.currentWriteBank(currentWriteBank),
+	.currentReadBank(currentReadBank),
+	.dataOut(bufferData)
+);
+
+// Read side -------------------------------------------------------------
+
+wire readData;
+wire [busWidth-1:0] fx3Data;
+wire sendingPacket;
+wire packetStart;
+wire [15:0] wordCounter;
+
+fx3StateMachine fx3StateMachine0 (
+	.nReset(nReset),
+	.fx3_clock(readClock),
+	.readData(readData),
+	.headerEnable(packetHeaderEnable),
+	.header(packetHeader),
+	.crcEnable(1'b0),
+	.headerCrcEnable(1'b0),
+	.packetSize(packetSize),
+	.dataIn(bufferData),
+	.dataOut(fx3Data),
+	.fx3isReading(fx3isReading),
+	.sendingPacket(sendingPacket),
+	.packetStart(packetStart),
+	.wordCounter(wordCounter)
+);
+
+wire [31:0] statsClocks;
+wire [31:0] statsBusWords;
+wire [31:0] statsStallMax;
+wire [31:0] statsStallTotal;
+wire [31:0] statsStatus;
+
+pipelineStats pipelineStats0 (
+	.nReset(nReset),
+	.clock(readClock),
+	.dataAvailable(dataAvailable),
+	.sendingPacket(sendingPacket),
+	.packetStart(packetStart),
+	.fx3isReading(fx3isReading),
+	.writeBank(currentWriteBank),
+	.readBank(currentReadBank),
+	.clocks(statsClocks),
+	.busWords(statsBusWords),
+	.stallMax(statsStallMax),
+	.stallTotal(statsStallTotal),
+	.status(statsStatus)
+);
+
+wire [busWidth-1:0] word;
+wire wordValid;
+wire [31:0] packetsRead;
+wire [31:0] wordsRead;
+wire [31:0] waitClocks;
+
+fx3GpifModel #(
+	.busWidth(busWidth),
+	.seed(SEED)
+) gpif (
+	.nReset(nReset),
+	.clock(readClock),
+	.dataAvailable(dataAvailable),
+	.dataBus(fx3Data),
+	.packetWords(packetWords),
+	.latency(gpifLatency),
+	.jitter(gpifJitter),
+	.backToBack(1'b0),
+	.readData(readData),
+	.word(word),
+	.wordValid(wordValid),
+	.packetsRead(packetsRead),
+	.wordsRead(wordsRead),
+	.waitClocks(waitClocks)
+);
+
+// Data checker ----------------------------------------------------------
+
+// Expected test mode sample (see dataGenerator.v)
+function [15:0] testSample;
+	input integer index;
+	reg [5:0] sequenceNumber;
+	reg [9:0] data;
+	begin
+		sequenceNumber = (index / 65536) % 63;
+		data = index % 1021;
+		testSample = {sequenceNumber, data};
+	end
+endfunction
+
+// Expected bus word (the first sample in the lower 16 bits)
+function [busWidth-1:0] testWord;
+	input integer index;
+	begin
+`ifdef GPIF_32BIT
+		testWord = {testSample((index * 2) + 1), testSample(index * 2)};
+`else
+		testWord = testSample(index);
+`endif
+	end
+endfunction
+
+integer errors;
+integer wordIndex;			// Stream index of the next word expected
+integer position;			// Word of the packet being read
+integer framesSkipped;		// Discarded frames found in the stream
+
+always @ (posedge readClock) begin
+	if (nReset && wordValid) begin
+		// A frame discarded by an overflow shows as a jump of one
+		// packet at the start of a packet
+		if ((position == 0) && (word !== testWord(wordIndex)) &&
+				(framesSkipped < overflowCount) && (word === testWord(wordIndex + packetWords))) begin
+			wordIndex = wordIndex + packetWords;
+			framesSkipped = framesSkipped + 1;
+		end
+
+		if (word !== testWord(wordIndex)) begin
+			if (errors < 10) $display("ERROR: stream word %0d (packet %0d word %0d) is %h, expected %h",
+				wordIndex, packetsRead, position, word, testWord(wordIndex));
+			errors = errors + 1;
+		end
+
+		wordIndex = wordIndex + 1;
+		position = (position == packetWords - 1) ? 0 : position + 1;
+	end
+end
+
+// Tests -----------------------------------------------------------------
+
+// Bank fill time and packet read time in GPIF clocks
+localparam real fillClocks = packetWords * samplesPerWord * writePeriod / readPeriod;
+localparam real readClocks = packetWords;
+
+// Longest wait the buffer should absorb
+localparam real expectedStall = ((bankCount - 1) * fillClocks) - readClocks;
+
+// Expected bus words per 1000 clocks
+localparam real expectedWordsPerKiloClock = 1000.0 * readPeriod / (writePeriod * samplesPerWord);
+
+// Start the stream from reset
+task startStream;
+	begin
+		nReset = 1'b0;
+		wordIndex = 0;
+		position = 0;
+		framesSkipped = 0;
+		repeat (4) @ (posedge writeClock);
+		#1 nReset = 1'b1;
+	end
+endtask
+
+// Wait until the GPIF has read the given number of packets (gives up
+// after timeout GPIF clocks, or on an overflow if stopOnOverflow)
+task waitForPackets;
+	input integer packets;
+	input integer timeout;
+	input stopOnOverflow;
+	integer clocks;
+	begin
+		clocks = 0;
+		while ((packetsRead < packets) && (clocks < timeout) && !(stopOnOverflow && (overflowCount != 0))) begin
+			@ (posedge readClock);
+			clocks = clocks + 1;
+		end
+	end
+endtask
+
+// Run the stream with a single stall added to the GPIF service latency
+// after warmUpPackets packets; returns the stall the buffer absorbed and
+// whether it overflowed
+reg trialOverflow;
+integer trialStallMax;
+
+task stallTrial;
+	input integer stallClocks;
+	integer timeout;
+	begin
+		startStream;
+		waitForPackets(warmUpPackets - 1, (warmUpPackets + 2) * fillClocks, 1'b0);
+		gpif.addStall(stallClocks);
+
+		// The buffer overflows within bankCount packets of the stall if
+		// it is going to
+		timeout = stallClocks + ((bankCount + 4) * fillClocks);
+		waitForPackets(warmUpPackets + bankCount + 1, timeout, 1'b1);
+
+		trialOverflow = (overflowCount != 0);
+		trialStallMax = statsStallMax;
+		if (!trialOverflow && (packetsRead < warmUpPackets + bankCount + 1)) begin
+			$display("ERROR: stream stopped after %0d packets with a %0d clock stall", packetsRead, stallClocks);
+			errors = errors + 1;
+		end
+	end
+endtask
+
+integer startClocks;
+integer startWords;
+integer wordsPerKiloClock;
+integer low;
+integer high;
+integer middle;
+integer survivedStall;
+integer overflowPackets;
+
+initial begin
+	errors = 0;
+	nReset = 1'b0;
+	wordIndex = 0;
+	position = 0;
+	framesSkipped = 0;
+
+	$display("buffer: %0d banks, %0d-bit bus, %0d word packets, %.1f MHz GPIF clock, latency %0d + 0-%0d clocks",
+		bankCount, busWidth, packetWords, 1000.0 / readPeriod, GPIF_LATENCY, GPIF_JITTER);
+
+	// 1. Sustained stream
+	startStream;
+	waitForPackets(warmUpPackets, (warmUpPackets + 2) * fillClocks, 1'b0);
+	startClocks = statsClocks;
+	startWords = statsBusWords;
+	waitForPackets(SUSTAINED_PACKETS, (SUSTAINED_PACKETS + 2) * fillClocks, 1'b0);
+
+	if (packetsRead < SUSTAINED_PACKETS) begin
+		$display("ERROR: only %0d of %0d packets read", packetsRead, SUSTAINED_PACKETS);
+		errors = errors + 1;
+	end
+	if (overflowCount != 0) begin
+		$display("ERROR: %0d overflows in the sustained stream", overflowCount);
+		errors = errors + 1;
+	end
+
+	wordsPerKiloClock = ((statsBusWords - startWords) * 1000.0) / (statsClocks - startClocks);
+	$display("buffer: sustained %0d words per 1000 clocks (expected %.1f), longest wait %0d clocks (%.2f us), peak %0d banks waiting",
+		wordsPerKiloClock, expectedWordsPerKiloClock, statsStallMax, statsStallMax * readPeriod / 1000.0, statsStatus[1:0]);
+	if ((wordsPerKiloClock < expectedWordsPerKiloClock * 0.99) || (wordsPerKiloClock > expectedWordsPerKiloClock * 1.01)) begin
+		$display("ERROR: sustained rate does not match the sample rate");
+		errors = errors + 1;
+	end
+	if (statsStatus[11:8] != bankCount) begin
+		$display("ERROR: pipelineStats reports %0d banks", statsStatus[11:8]);
+		errors = errors + 1;
+	end
+
+	// 2. Stall sweep
+	low = 0;
+	high = bankCount * fillClocks + readClocks;
+
+	stallTrial(high);
+	if (!trialOverflow) begin
+		$display("ERROR: a %0d clock stall did not overflow the buffer", high);
+		errors = errors + 1;
+	end
+
+	stallTrial(low);
+	if (trialOverflow) begin
+		$display("ERROR: the buffer overflowed with no stall");
+		errors = errors + 1;
+	end
+	survivedStall = trialStallMax;
+
+	while (high - low > 16) begin
+		middle = (low + high) / 2;
+		stallTrial(middle);
+		if (trialOverflow) begin
+			high = middle;
+		end else begin
+			low = middle;
+			survivedStall = trialStallMax;
+		end
+	end
+
+	$display("buffer: longest added stall without an overflow %0d clocks, longest wait absorbed %0d clocks (%.2f us)",
+		low, survivedStall, survivedStall * readPeriod / 1000.0);
+	$display("buffer: expected (banks - 1) x fill time - read time = %.0f clocks (%.2f us)",
+		expectedStall, expectedStall * readPeriod / 1000.0);
+	if ((survivedStall < expectedStall - 96) || (survivedStall > expectedStall + 16)) begin
+		$display("ERROR: the longest wait absorbed does not match the bank ring");
+		errors = errors + 1;
+	end
+
+	// 3. Overflow just over the limit
+	stallTrial(high + 256);
+	if (!trialOverflow) begin
+		$display("ERROR: a %0d clock stall did not overflow the buffer", high + 256);
+		errors = errors + 1;
+	end else begin
+		// The stream carries on after the discarded frame
+		overflowPackets = packetsRead;
+		waitForPackets(overflowPackets + bankCount + 2, (bankCount + 4) * fillClocks, 1'b0);
+		if (packetsRead < overflowPackets + bankCount + 2) begin
+			$display("ERROR: stream stopped after the overflow");
+			errors = errors + 1;
+		end
+		if (overflowCount != 1) begin
+			$display("ERROR: %0d overflows, expected 1", overflowCount);
+			errors = errors + 1;
+		end
+		if (framesSkipped != 1) begin
+			$display("ERROR: %0d frames missing from the stream after the overflow, expected 1", framesSkipped);
+			errors = errors + 1;
+		end
+		if ((overflowIndex % (packetWords * samplesPerWord)) != 0) begin
+			$display("ERROR: overflow index %0d is not the start of a frame", overflowIndex);
+			errors = errors + 1;
+		end
+		$display("buffer: %0d clock stall overflowed once, frame at sample %0d discarded", high + 256, overflowIndex);
+	end
+
+	if (errors == 0) $display("PASS: buffer");
+	else $display("FAIL: buffer (%0d errors)", errors);
+	$finish;
+end
+
+endmodule
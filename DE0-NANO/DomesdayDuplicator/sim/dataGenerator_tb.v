@@ -0,0 +1,196 @@
+/************************************************************************
+
+	dataGenerator_tb.v
+	Data generation testbench
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+`timescale 1ns / 1ps
+
+// Checks the samples from dataGenerator.v:
+//
+// - ADC mode passes the ADC data through a clock later.
+// - Test mode is the 0 to 1020 ramp, with a sequence number that
+//   counts from 0 to 62 with 65536 samples each and then wraps (this
+//   runs for just over 63 x 65536 samples).
+// - Soak mode is the PRBS-31 sequence: starting from all ones, and
+//   every bit of it following g(n) = g(n - 31) ^ g(n - 28).
+// - restart takes all the counters back to 0 on the next clock.
+
+module dataGenerator_tb;
+
+reg nReset;
+reg clock;
+reg [9:0] adcData;
+reg testModeFlag;
+reg soakModeFlag;
+reg restart;
+
+wire [15:0] dataOut;
+
+dataGenerator dataGenerator0 (
+	.nReset(nReset),
+	.clock(clock),
+	.adc_databus(adcData),
+	.testModeFlag(testModeFlag),
+	.soakModeFlag(soakModeFlag),
+	.restart(restart),
+	.dataOut(dataOut)
+);
+
+// 40 MHz sampling clock
+initial clock = 1'b0;
+always #12.5 clock = !clock;
+
+integer errors;
+integer sample;
+
+// Check a sample against its expected value
+task checkSample;
+	input [15:0] expected;
+	input [8*16-1:0] mode;
+	begin
+		if (dataOut !== expected) begin
+			if (errors < 10) $display("ERROR: %0s sample %0d is %h, expected %h", mode, sample, dataOut, expected);
+			errors = errors + 1;
+		end
+	end
+endtask
+
+// Reset the generator with the modes given; sample 0 is on dataOut
+// when this returns (samples are read on the falling edge)
+task startGenerator;
+	input testMode;
+	input soakMode;
+	begin
+		nReset = 1'b0;
+		testModeFlag = testMode;
+		soakModeFlag = soakMode;
+		restart = 1'b0;
+		repeat (2) @ (negedge clock);
+		nReset = 1'b1;
+		sample = 0;
+	end
+endtask
+
+// Move on to the next sample
+task nextSample;
+	begin
+		@ (negedge clock);
+		sample = sample + 1;
+	end
+endtask
+
+// Form a sample from its sequence number and data
+function [15:0] sampleWord;
+	input [5:0] sequenceNumber;
+	input [9:0] data;
+	begin
+		sampleWord = {sequenceNumber, data};
+	end
+endfunction
+
+// Expected test mode sample
+function [15:0] testSample;
+	input integer index;
+	begin
+		testSample = sampleWord((index / 65536) % 63, index % 1021);
+	end
+endfunction
+
+// PRBS bit history: bit 0 is the newest
+reg [30:0] history;
+reg nextBit;
+integer i;
+integer ones;
+
+initial begin
+	errors = 0;
+	adcData = 10'd0;
+
+	// ADC mode
+	startGenerator(1'b0, 1'b0);
+	for (i = 0; i < 1000; i = i + 1) begin
+		adcData = (i * 37) & 10'h3FF;
+		nextSample;
+		checkSample(sampleWord(sample / 65536, (i * 37) & 10'h3FF), "ADC");
+	end
+	$display("dataGenerator: ADC mode checked");
+
+	// Test mode, through the sequence number wrap
+	startGenerator(1'b1, 1'b0);
+	checkSample(testSample(0), "test");
+	while (sample < (63 * 65536) + 5000) begin
+		nextSample;
+		checkSample(testSample(sample), "test");
+	end
+	$display("dataGenerator: test mode checked for %0d samples (sequence number wrapped)", sample);
+
+	// Restart part way through
+	for (i = 0; i < 12345; i = i + 1) nextSample;
+	restart = 1'b1;
+	nextSample;
+	restart = 1'b0;
+	sample = 0;
+	checkSample(testSample(0), "restarted test");
+	for (i = 0; i < 70000; i = i + 1) begin
+		nextSample;
+		checkSample(testSample(sample), "restarted test");
+	end
+	$display("dataGenerator: restart checked");
+
+	// Soak mode: the first samples are fixed by the start value
+	startGenerator(1'b0, 1'b1);
+	checkSample(16'h03FF, "soak");
+	nextSample;
+	checkSample(16'h0000, "soak");
+	nextSample;
+	checkSample(16'h0000, "soak");
+	nextSample;
+	checkSample(16'h0003, "soak");
+
+	// Every bit follows the PRBS-31 recurrence (the history starts from
+	// the first 31 bits, all ones)
+	startGenerator(1'b0, 1'b1);
+	history = 31'h7FFFFFFF;
+	ones = 0;
+	while (sample < 200000) begin
+		nextSample;
+		for (i = 9; i >= 0; i = i - 1) begin
+			nextBit = history[30] ^ history[27];
+			if (dataOut[i] !== nextBit) begin
+				if (errors < 10) $display("ERROR: soak sample %0d bit %0d is %b, not the PRBS-31 sequence", sample, i, dataOut[i]);
+				errors = errors + 1;
+			end
+			history = {history[29:0], dataOut[i]};
+			if (dataOut[i]) ones = ones + 1;
+		end
+		if (dataOut[15:10] !== ((sample / 65536) % 63)) begin
+			if (errors < 10) $display("ERROR: soak sample %0d has sequence number %0d", sample, dataOut[15:10]);
+			errors = errors + 1;
+		end
+	end
+
+	// Half of the bits should be ones
+	if ((ones < 990000) || (ones > 1010000)) begin
+		$display("ERROR: %0d ones in 2000000 soak bits", ones);
+		errors = errors + 1;
+	end
+
+	// Restart takes the PRBS back to all ones
+	restart = 1'b1;
+	nextSample;
+	restart = 1'b0;
+	checkSample(16'h03FF, "restarted soak");
+	$display("dataGenerator: soak mode checked for %0d samples", sample);
+
+	if (errors == 0) $display("PASS: dataGenerator");
+	else $display("FAIL: dataGenerator (%0d errors)", errors);
+	$finish;
+end
+
+endmodule
@@ -0,0 +1,139 @@
+/************************************************************************
+
+	fx3GpifModel.v
+	Behavioural model of the FX3 GPIF for simulation
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// Models the FX3 side of the GPIF handshake (see fx3StateMachine.v):
+//
+// - When the model is ready for a packet and dataAvailable is set it
+//   pulses readData for one clock.
+// - The FPGA registers readData and starts the packet on the next
+//   clock, so the first word is on the bus two clocks after the
+//   request and the packet's packetWords words follow on consecutive
+//   clocks.  Each word is passed out on word with wordValid set.
+// - After the last word the model waits for its service latency before
+//   it is ready for the next packet.  The latency is latency plus a
+//   random 0 to jitter clocks (standing in for the DMA buffer commit and
+//   the USB host), plus any stall added with addStall().
+//
+// With backToBack set the next packet is requested whilst the current
+// one is being sent (whenever dataAvailable is set at that point), so
+// the packets follow without a gap.  The service latency is then
+// ignored.
+//
+// dataAvailable is cleared by the buffer as the last word is read, and
+// the model does not look at it again until the clock after that, so a
+// stale flag is never taken as a new packet.
+//
+// All times are in GPIF clocks.  The jitter sequence restarts from seed
+// on reset.
+
+module fx3GpifModel #(
+	parameter busWidth = 16,
+	parameter seed = 1
+) (
+	input nReset,
+	input clock,
+	input dataAvailable,
+	input [busWidth-1:0] dataBus,
+	input [15:0] packetWords,		// Words per packet
+	input [15:0] latency,			// Service latency after each packet
+	input [15:0] jitter,			// Extra random latency (0 to jitter)
+	input backToBack,
+
+	// Outputs
+	output reg readData,
+	output reg [busWidth-1:0] word,
+	output reg wordValid,
+	output reg [31:0] packetsRead,	// Packets read since reset
+	output reg [31:0] wordsRead,	// Words read since reset
+	output reg [31:0] waitClocks	// Clocks spent waiting for dataAvailable
+);
+
+integer randomState;
+
+// Request pipeline: the first word of a packet is on the bus two clocks
+// after the request
+reg [1:0] requestPipe;
+
+// Words still to come from the packets requested
+reg [31:0] wordsDue;
+
+// Service latency left before the next request
+reg [31:0] delay;
+
+// Stall added to the next service latency
+reg [31:0] pendingStall;
+
+// Words due once this clock's word has been taken
+wire [31:0] wordsDueNext = wordsDue + (requestPipe[1] ? packetWords : 32'd0);
+wire takeWord = (wordsDueNext != 32'd0);
+wire lastWord = takeWord && (wordsDueNext == 32'd1);
+
+// Waiting for the current packets to finish
+wire busy = takeWord || (requestPipe != 2'b00) || readData;
+
+// Add a one-off stall to the latency after the current packet (called
+// from the testbench)
+task addStall;
+	input [31:0] clocks;
+	begin
+		pendingStall = pendingStall + clocks;
+	end
+endtask
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		readData <= 1'b0;
+		word <= {busWidth{1'b0}};
+		wordValid <= 1'b0;
+		packetsRead <= 32'd0;
+		wordsRead <= 32'd0;
+		waitClocks <= 32'd0;
+		requestPipe <= 2'b00;
+		wordsDue <= 32'd0;
+		delay <= 32'd0;
+		pendingStall = 32'd0;
+		randomState = seed;
+	end else begin
+		requestPipe <= {requestPipe[0], readData};
+		readData <= 1'b0;
+
+		// Take the word on the bus
+		wordValid <= takeWord;
+		if (takeWord) begin
+			word <= dataBus;
+			wordsRead <= wordsRead + 32'd1;
+			wordsDue <= wordsDueNext - 32'd1;
+		end else begin
+			wordsDue <= wordsDueNext;
+		end
+
+		if (lastWord) begin
+			// Packet complete; start the service latency
+			packetsRead <= packetsRead + 32'd1;
+			delay <= latency + pendingStall +
+				((jitter == 16'd0) ? 32'd0 : ({$random(randomState)} % (jitter + 32'd1)));
+			pendingStall = 32'd0;
+		end else if (backToBack && takeWord && (wordsDueNext == 32'd3) && !requestPipe[0] && !readData) begin
+			// Request the next packet so it follows the last word
+			if (dataAvailable) readData <= 1'b1;
+		end else if (!busy) begin
+			if (delay != 32'd0) begin
+				delay <= delay - 32'd1;
+			end else if (dataAvailable) begin
+				readData <= 1'b1;
+			end else begin
+				waitClocks <= waitClocks + 32'd1;
+			end
+		end
+	end
+end
+
+endmodule
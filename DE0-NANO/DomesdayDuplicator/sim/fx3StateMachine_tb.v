@@ -0,0 +1,275 @@
+/************************************************************************
+
+	fx3StateMachine_tb.v
+	FX3 State-Machine testbench
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+`timescale 1ns / 1ps
+
+// Drives fx3StateMachine.v from the GPIF model (fx3GpifModel.v) with a
+// buffer that always has data, and checks every word the model reads:
+//
+// - Each packet is 8192, 4096 or 2048 words (packetSize 0, 1 and 2; half
+//   that with GPIF_32BIT).
+// - The packet header is sent before the data, with the buffer not
+//   read whilst it is sent.
+// - The buffer data follows in order, with no words lost or repeated
+//   between packets.
+// - In soak mode (crcEnable) the packet ends with the CRC-32C of the
+//   rest of the packet.
+// - In packet CRC mode (headerCrcEnable) the header carries the CRC-32C
+//   of the previous packet and its flag.
+// - Back-to-back requests are accepted on the last word of a packet, so
+//   the next packet follows without a gap.
+//
+// The CRCs are checked against a bit at a time reference here rather
+// than against crc32c.v.
+
+module fx3StateMachine_tb;
+
+`ifdef GPIF_32BIT
+localparam busWidth = 32;
+localparam fullPacketWords = 16'd4096;
+localparam headerWords = 4;
+localparam crcWords = 1;
+`else
+localparam busWidth = 16;
+localparam fullPacketWords = 16'd8192;
+localparam headerWords = 8;
+localparam crcWords = 2;
+`endif
+
+// Service latency of the GPIF model (clocks)
+parameter GPIF_LATENCY = 5;
+parameter GPIF_JITTER = 3;
+parameter SEED = 1;
+
+localparam [15:0] gpifLatency = GPIF_LATENCY;
+localparam [15:0] gpifJitter = GPIF_JITTER;
+
+localparam [127:0] header = 128'h7007_6006_5005_4004_3003_2002_0024_DD10;
+
+reg nReset;
+reg clock;
+reg headerEnable;
+reg crcEnable;
+reg headerCrcEnable;
+reg [1:0] packetSize;
+reg backToBack;
+
+wire [15:0] packetWords = fullPacketWords >> packetSize;
+
+// Buffer stand-in: a show-ahead source of incrementing words
+reg [busWidth-1:0] sourceWord;
+
+wire [busWidth-1:0] dataOut;
+wire fx3isReading;
+wire sendingPacket;
+wire packetStart;
+wire [15:0] wordCounter;
+
+wire readData;
+wire [busWidth-1:0] word;
+wire wordValid;
+wire [31:0] packetsRead;
+wire [31:0] wordsRead;
+wire [31:0] waitClocks;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) sourceWord <= {busWidth{1'b0}};
+	else if (fx3isReading) sourceWord <= sourceWord + 1'b1;
+end
+
+fx3StateMachine fx3StateMachine0 (
+	.nReset(nReset),
+	.fx3_clock(clock),
+	.readData(readData),
+	.headerEnable(headerEnable),
+	.header(header),
+	.crcEnable(crcEnable),
+	.headerCrcEnable(headerCrcEnable),
+	.packetSize(packetSize),
+	.dataIn(sourceWord),
+	.dataOut(dataOut),
+	.fx3isReading(fx3isReading),
+	.sendingPacket(sendingPacket),
+	.packetStart(packetStart),
+	.wordCounter(wordCounter)
+);
+
+fx3GpifModel #(
+	.busWidth(busWidth),
+	.seed(SEED)
+) gpif (
+	.nReset(nReset),
+	.clock(clock),
+	.dataAvailable(1'b1),
+	.dataBus(dataOut),
+	.packetWords(packetWords),
+	.latency(gpifLatency),
+	.jitter(gpifJitter),
+	.backToBack(backToBack),
+	.readData(readData),
+	.word(word),
+	.wordValid(wordValid),
+	.packetsRead(packetsRead),
+	.wordsRead(wordsRead),
+	.waitClocks(waitClocks)
+);
+
+// 60 MHz GPIF clock
+initial clock = 1'b0;
+always #8.333 clock = !clock;
+
+// Reference CRC-32C (reflected, least significant bit first)
+function [31:0] crcWord;
+	input [31:0] crc;
+	input [busWidth-1:0] data;
+	integer b;
+	begin
+		crcWord = crc;
+		for (b = 0; b < busWidth; b = b + 1) begin
+			crcWord = (crcWord[0] ^ data[b]) ? ((crcWord >> 1) ^ 32'h82F63B78) : (crcWord >> 1);
+		end
+	end
+endfunction
+
+// Checker state
+integer errors;
+integer position;					// Word of the packet being read
+reg [busWidth-1:0] expectedSource;	// Next buffer word expected
+reg [31:0] soakCrc;					// CRC of the packet before its CRC words
+reg [31:0] packetCrc;				// CRC of the whole packet
+reg [31:0] lastCrc;					// CRC of the previous packet
+reg lastCrcValid;
+reg started;
+integer targetPackets;
+
+reg [127:0] expectedHeader;
+reg [31:0] finalCrc;
+reg [busWidth-1:0] expected;
+
+always @ (posedge clock) begin
+	if (nReset && wordValid) begin
+		started = 1'b1;
+		expectedHeader = headerCrcEnable ?
+			{header[127:112], lastCrc, header[79:23], lastCrcValid, header[21:0]} : header;
+		finalCrc = ~soakCrc;
+
+		if (headerEnable && (position < headerWords)) begin
+			expected = expectedHeader[position * busWidth +: busWidth];
+		end else if (crcEnable && (position >= packetWords - crcWords)) begin
+			expected = finalCrc[(position - (packetWords - crcWords)) * busWidth +: busWidth];
+			expectedSource = expectedSource + 1'b1;
+		end else begin
+			expected = expectedSource;
+			expectedSource = expectedSource + 1'b1;
+		end
+
+		if (word !== expected) begin
+			if (errors < 10) $display("ERROR: packet %0d word %0d is %h, expected %h", packetsRead, position, word, expected);
+			errors = errors + 1;
+		end
+
+		if (!(crcEnable && (position >= packetWords - crcWords))) soakCrc = crcWord(soakCrc, word);
+		packetCrc = crcWord(packetCrc, word);
+
+		position = position + 1;
+		if (position == packetWords) begin
+			position = 0;
+			lastCrc = ~packetCrc;
+			lastCrcValid = 1'b1;
+			soakCrc = 32'hFFFFFFFF;
+			packetCrc = 32'hFFFFFFFF;
+		end
+	end
+
+	// Back-to-back packets must follow without a gap
+	if (nReset && backToBack && started && !wordValid && (packetsRead < targetPackets)) begin
+		if (errors < 10) $display("ERROR: gap between back-to-back packets after packet %0d", packetsRead);
+		errors = errors + 1;
+	end
+end
+
+// Run one test: read the given number of packets with the settings
+// given, then reset
+task runTest;
+	input [1:0] testPacketSize;
+	input testHeader;
+	input testCrc;
+	input testHeaderCrc;
+	input testBackToBack;
+	input integer packets;
+	integer timeout;
+	begin
+		nReset = 1'b0;
+		packetSize = testPacketSize;
+		headerEnable = testHeader;
+		crcEnable = testCrc;
+		headerCrcEnable = testHeaderCrc;
+		backToBack = testBackToBack;
+		targetPackets = packets;
+		position = 0;
+		expectedSource = {busWidth{1'b0}};
+		soakCrc = 32'hFFFFFFFF;
+		packetCrc = 32'hFFFFFFFF;
+		lastCrc = 32'd0;
+		lastCrcValid = 1'b0;
+		started = 1'b0;
+		repeat (4) @ (posedge clock);
+		#1 nReset = 1'b1;
+
+		timeout = 0;
+		while ((packetsRead < packets) && (timeout < packets * (packetWords + 1000))) begin
+			@ (posedge clock);
+			timeout = timeout + 1;
+		end
+		@ (negedge clock);
+
+		if (packetsRead < packets) begin
+			$display("ERROR: timed out after %0d of %0d packets", packetsRead, packets);
+			errors = errors + 1;
+		end
+
+		$display("fx3StateMachine: packetSize %0d, header %0d, soak CRC %0d, header CRC %0d, back-to-back %0d: %0d packets of %0d words (%0d errors so far)",
+			testPacketSize, testHeader, testCrc, testHeaderCrc, testBackToBack, packetsRead, packetWords, errors);
+	end
+endtask
+
+initial begin
+	errors = 0;
+	nReset = 1'b0;
+	targetPackets = 0;
+	started = 1'b0;
+
+	// Packet lengths, with and without the header
+	runTest(2'd0, 1'b0, 1'b0, 1'b0, 1'b0, 3);
+	runTest(2'd1, 1'b0, 1'b0, 1'b0, 1'b0, 3);
+	runTest(2'd2, 1'b0, 1'b0, 1'b0, 1'b0, 3);
+	runTest(2'd0, 1'b1, 1'b0, 1'b0, 1'b0, 3);
+	runTest(2'd1, 1'b1, 1'b0, 1'b0, 1'b0, 3);
+	runTest(2'd2, 1'b1, 1'b0, 1'b0, 1'b0, 3);
+
+	// Soak mode CRC
+	runTest(2'd0, 1'b0, 1'b1, 1'b0, 1'b0, 3);
+	runTest(2'd2, 1'b1, 1'b1, 1'b0, 1'b0, 3);
+
+	// Packet CRC mode (with and without soak mode)
+	runTest(2'd0, 1'b1, 1'b0, 1'b1, 1'b0, 4);
+	runTest(2'd1, 1'b1, 1'b1, 1'b1, 1'b0, 4);
+
+	// Back-to-back packets
+	runTest(2'd0, 1'b0, 1'b0, 1'b0, 1'b1, 4);
+	runTest(2'd2, 1'b1, 1'b1, 1'b1, 1'b1, 6);
+
+	if (errors == 0) $display("PASS: fx3StateMachine");
+	else $display("FAIL: fx3StateMachine (%0d errors)", errors);
+	$finish;
+end
+
+endmodule
@@ -1,68 +1,136 @@
 /************************************************************************
-	
+
 	statusLED.v
 	Status LED control module
-	
+
 	Domesday Duplicator - LaserDisc RF sampler
 	SPDX-FileCopyrightText: 2018-2025 Simon Inns
 	SPDX-License-Identifier: GPL-3.0-or-later
-	
+
 ************************************************************************/
 
 module statusLED (
 	input nReset,
 	input clock,
-	
+	input collectData,
+	input testMode,
+	input bufferError,
+	input sendingPacket,
+	input [1:0] writeBank,
+	input [1:0] readBank,
+
 	// Outputs
 	output reg [7:0] leds
 );
 
 // Control the status LEDs
+//
+// The LEDs show the state of the unit, so one that is close to
+// overflowing can be seen without a host tool:
+//
+//   LED 0     - On whilst collecting data (flashes once a second
+//               whilst idle)
+//   LED 1     - Test mode
+//   LED 2     - Buffer overflow (latched until data collection is
+//               next started)
+//   LED 3     - A packet was sent to the FX3 in the last period
+//   LED 4 - 7 - Buffer fill: the most banks waiting to be read in
+//               the last period, as a bar (all 4 lit when every other
+//               bank is full and the next frame would be discarded,
+//               see buffer.v)
+//
+// The display is updated every 66 ms (timerPeriod clocks).  LED 3
+// and the bar hold the peak of each period, so short bursts show.
+// collectData, bufferError and writeBank are from other clock domains
+// and are synchronised here; writeBank can show a transitional value
+// for a clock as it changes, which is ignored if out of range.
+`ifdef FX3_CLOCK_80MHZ
+localparam timerPeriod = 32'd5333333;
+`else
+localparam timerPeriod = 32'd4000000;
+`endif
+
+// Idle flash period in display updates (about 1 second)
+localparam flashPeriod = 4'd15;
+
+// Number of buffer banks (must match buffer.v)
+`ifdef BUFFER_BANKS
+localparam bankCount = `BUFFER_BANKS;
+`else
+localparam bankCount = 3;
+`endif
+
+// Synchronise the asynchronous signals to the clock domain
+reg [1:0] collectData_sync;
+reg [1:0] bufferError_sync;
+reg [1:0] writeBank_sync0;
+reg [1:0] writeBank_sync1;
+
+always @ (posedge clock, negedge nReset) begin
+	if (!nReset) begin
+		collectData_sync <= 2'b00;
+		bufferError_sync <= 2'b00;
+		writeBank_sync0 <= 2'd0;
+		writeBank_sync1 <= 2'd0;
+	end else begin
+		collectData_sync <= {collectData_sync[0], collectData};
+		bufferError_sync <= {bufferError_sync[0], bufferError};
+		writeBank_sync0 <= writeBank;
+		writeBank_sync1 <= writeBank_sync0;
+	end
+end
+
+// Banks written ahead of the read side (0 to bankCount - 1)
+wire [1:0] banksWaiting = (writeBank_sync1 >= readBank) ? (writeBank_sync1 - readBank) :
+	(writeBank_sync1 + bankCount - readBank);
+
 reg [31:0] timer;
-reg direction;
-reg [3:0] position; // 4-bit value 0-15
+reg [3:0] flashCount;
+reg overflowLatch;
+reg sentPacket;
+reg [1:0] peakWaiting;
+reg collecting_last;
+
+// Bar for the peak number of banks waiting
+wire [3:0] fillBar = (peakWaiting == 2'd0) ? 4'b0000 :
+	(peakWaiting >= bankCount - 1) ? 4'b1111 : 4'b0011;
 
 always @ (posedge clock, negedge nReset) begin
 	if (!nReset) begin
-		leds <= 8'b00000001;
-		timer <= 16'd0;
-		direction <= 1'b1;
-		position <= 4'd0;
+		leds <= 8'b00000000;
+		timer <= 32'd0;
+		flashCount <= 4'd0;
+		overflowLatch <= 1'b0;
+		sentPacket <= 1'b0;
+		peakWaiting <= 2'd0;
+		collecting_last <= 1'b0;
 	end else begin
+		collecting_last <= collectData_sync[1];
+
+		// The overflow latch is cleared when data collection starts
+		if (collectData_sync[1] && !collecting_last) overflowLatch <= 1'b0;
+		else if (bufferError_sync[1]) overflowLatch <= 1'b1;
+
+		// Record the peaks for the period
+		if (sendingPacket) sentPacket <= 1'b1;
+		if ((writeBank_sync1 < bankCount) && (banksWaiting > peakWaiting)) peakWaiting <= banksWaiting;
+
 		timer <= timer + 32'd1;
 		// Wait for the timer to elapse before updating LEDs
-		if (timer >= 32'd4000000) begin
-			case(position)
-				4'd0:leds <= 8'b00000001;
-				4'd1:leds <= 8'b00000010;
-				4'd2:leds <= 8'b00000100;
-				4'd3:leds <= 8'b00001000;
-				4'd4:leds <= 8'b00010000;
-				4'd5:leds <= 8'b00100000;
-				4'd6:leds <= 8'b01000000;
-				4'd7:leds <= 8'b10000000;
-			endcase
-		
-			if (direction) begin
-				if (position == 4'd7) begin
-					position <= 4'd6;
-					direction <= 1'b0;
-				end else begin
-					position <= position + 4'd1;
-				end
-			end else begin
-				if (position == 4'd0) begin
-					position <= 4'd1;
-					direction <= 1'b1;
-				end else begin
-					position <= position - 4'd1;
-				end
-			end
-			
+		if (timer >= timerPeriod) begin
+			flashCount <= (flashCount == flashPeriod) ? 4'd0 : flashCount + 4'd1;
+
+			leds <= {fillBar, sentPacket, overflowLatch, testMode,
+				collectData_sync[1] || (flashCount == 4'd0)};
+
+			// Start the next period
+			sentPacket <= 1'b0;
+			peakWaiting <= 2'd0;
+
 			// Reset timer
-			timer <= 16'd0;
+			timer <= 32'd0;
 		end
 	end
 end
 
-endmodule
\ No newline at end of file
+endmodule
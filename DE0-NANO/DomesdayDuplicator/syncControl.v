@@ -0,0 +1,180 @@
+/************************************************************************
+
+	syncControl.v
+	Multi-device synchronisation module
+
+	Domesday Duplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+module syncControl (
+	input nReset,
+	input statusClock,
+	input sampleClock,
+
+	// Control (statusClock domain)
+	input [1:0] role,
+	input startRequest,
+
+	// Sync connector
+	input syncClockIn,
+	input nSyncStartIn,
+	output reg nSyncStartOut,
+
+	// Outputs
+	output reg sequenceRestart,				// sampleClock domain
+	output reg syncClockPresent,			// statusClock domain
+	output reg syncClockSelect,			// statusClock domain
+	output reg [31:0] syncClockRate,		// statusClock domain
+	output reg syncStarted					// statusClock domain
+);
+
+// Several Duplicators can sample from the same clock and start their
+// sequence numbers on the same edge.  One device (the master) drives
+// its sampling clock and a start strobe onto the sync connector; the
+// others (the slaves) sample from the master's clock (selected by
+// clockSelect.v whilst it is present) and take the start strobe from
+// it.
+//
+// The start strobe is sent by the master when startRequest (a toggle)
+// changes.  It is active low (the connector pins have pull-ups) and
+// is driven for one clock from the falling edge of the sampling clock,
+// half a clock away from the edges used by the master and by the
+// slaves (whose clock is delayed by the connection), so every device
+// captures it on the same clock edge and restarts its sequence counter
+// (sequenceRestart) on the edge after.
+//
+// syncClockSelect is set on a slave whilst the sync clock is present,
+// to select it as the sampling clock.
+//
+// syncStarted is set once a start strobe has been sent (master) or
+// received (slave) since the role was last changed.
+//
+// The sync clock input is monitored from statusClock (60 MHz, or
+// 80 MHz with FX3_CLOCK_80MHZ); it is present when it has been running
+// in the last 1 us or so, and its rate is measured to 1 kHz every 4 ms.
+localparam roleMaster = 2'd1;
+localparam roleSlave = 2'd2;
+
+// statusClock cycles in the 4 ms rate measurement window
+`ifdef FX3_CLOCK_80MHZ
+localparam rateWindow = 19'd320000;
+`else
+localparam rateWindow = 19'd240000;
+`endif
+
+// Synchronise the control inputs to the sampling clock domain
+reg [1:0] role_sync0;
+reg [1:0] role_sync1;
+reg [2:0] startRequest_sync;
+
+always @ (posedge sampleClock, negedge nReset) begin
+	if (!nReset) begin
+		role_sync0 <= 2'd0;
+		role_sync1 <= 2'd0;
+		startRequest_sync <= 3'b000;
+	end else begin
+		role_sync0 <= role;
+		role_sync1 <= role_sync0;
+		startRequest_sync <= {startRequest_sync[1:0], startRequest};
+	end
+end
+
+// Start strobe --------------------------------------------------------------
+
+reg startPending;
+reg startCapture;
+reg restartToggle;
+
+always @ (posedge sampleClock, negedge nReset) begin
+	if (!nReset) begin
+		startPending <= 1'b0;
+		startCapture <= 1'b0;
+		sequenceRestart <= 1'b0;
+		restartToggle <= 1'b0;
+	end else begin
+		startPending <= (startRequest_sync[2] != startRequest_sync[1]) && (role_sync1 == roleMaster);
+
+		// Capture the strobe (from the connector on a slave) and restart
+		// on the next clock
+		startCapture <= (role_sync1 == roleSlave) ? !nSyncStartIn : !nSyncStartOut;
+		sequenceRestart <= startCapture;
+		if (startCapture) restartToggle <= !restartToggle;
+	end
+end
+
+always @ (negedge sampleClock, negedge nReset) begin
+	if (!nReset) nSyncStartOut <= 1'b1;
+	else nSyncStartOut <= !startPending;
+end
+
+// Sync status (statusClock domain) ------------------------------------------
+
+reg [2:0] restartToggle_sync;
+reg [1:0] lastRole;
+
+always @ (posedge statusClock, negedge nReset) begin
+	if (!nReset) begin
+		restartToggle_sync <= 3'b000;
+		lastRole <= 2'd0;
+		syncStarted <= 1'b0;
+	end else begin
+		restartToggle_sync <= {restartToggle_sync[1:0], restartToggle};
+		lastRole <= role;
+
+		if (role != lastRole) syncStarted <= 1'b0;
+		else if (restartToggle_sync[2] != restartToggle_sync[1]) syncStarted <= 1'b1;
+	end
+end
+
+// Sync clock monitor --------------------------------------------------------
+
+// Divide the sync clock by 8 (not reset, as the clock may not be
+// running)
+reg [2:0] syncClockDivider;
+
+always @ (posedge syncClockIn) begin
+	syncClockDivider <= syncClockDivider + 3'd1;
+end
+
+reg [2:0] syncClockDivider_sync;
+reg [5:0] syncClockTimeout;
+reg [18:0] rateTimer;
+reg [16:0] rateCount;
+
+// Each edge of the divided clock is 4 sync clocks
+wire syncClockEdge = syncClockDivider_sync[2] != syncClockDivider_sync[1];
+
+always @ (posedge statusClock, negedge nReset) begin
+	if (!nReset) begin
+		syncClockDivider_sync <= 3'b000;
+		syncClockTimeout <= 6'd63;
+		syncClockPresent <= 1'b0;
+		syncClockSelect <= 1'b0;
+		syncClockRate <= 32'd0;
+		rateTimer <= 19'd0;
+		rateCount <= 17'd0;
+	end else begin
+		syncClockDivider_sync <= {syncClockDivider_sync[1:0], syncClockDivider[2]};
+
+		// The clock is lost if there is no edge for 63 clocks
+		if (syncClockEdge) syncClockTimeout <= 6'd0;
+		else if (syncClockTimeout != 6'd63) syncClockTimeout <= syncClockTimeout + 6'd1;
+		syncClockPresent <= (syncClockTimeout != 6'd63);
+		syncClockSelect <= (syncClockTimeout != 6'd63) && (role == roleSlave);
+
+		// Count the edges in each window; each edge in 4 ms is 1 kHz
+		if (rateTimer == rateWindow - 19'd1) begin
+			rateTimer <= 19'd0;
+			rateCount <= {16'd0, syncClockEdge};
+			syncClockRate <= syncClockPresent ? (rateCount * 32'd1000) : 32'd0;
+		end else begin
+			rateTimer <= rateTimer + 19'd1;
+			if (syncClockEdge) rateCount <= rateCount + 17'd1;
+		end
+	end
+end
+
+endmodule
@@ -0,0 +1,698 @@
+/*
+ * dd-capture.c - Domesday Duplicator capture library
+ *
+ * See dd-capture.h.  Threads:
+ *
+ * - The caller's thread runs the libusb event loop (dd_capture_poll).
+ *   The transfer callback updates the statistics and hands the
+ *   transfer to the writer thread (or submits it again straight away
+ *   when there is nothing else to do with the data).
+ * - The writer thread calls the data callback, writes the buffer at
+ *   the next file offset and submits the transfer again.
+ *
+ * libusb completes the transfers on an end-point in the order they were
+ * submitted, so the writer queue (and the file) is in stream order.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <libusb-1.0/libusb.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "dd-capture.h"
+
+#define USB_TIMEOUT_MS          5000
+#define DIRECT_ALIGNMENT        4096
+
+struct dd_capture {
+    libusb_context *ctx;
+    libusb_device_handle *handle;
+    dd_capture_config_t config;
+    size_t transfer_size;
+
+    struct libusb_transfer *transfers[DD_QUEUE_DEPTH_MAX];
+    int dev_mem[DD_QUEUE_DEPTH_MAX];        /* Buffer from libusb_dev_mem_alloc */
+    int in_flight;
+    int stopping;
+    int device_lost;
+
+    /* Writer thread and its queue of completed transfers */
+    int fd;
+    int direct;
+    off_t write_offset;
+    int writer_active;
+    int writer_exit;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct libusb_transfer *queue[DD_QUEUE_DEPTH_MAX];
+    int queue_head;
+    int queue_count;
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    int ring_ready;
+#endif
+
+    /* Statistics (protected by lock) */
+    dd_capture_stats_t stats;
+    struct timespec first_completion;
+    struct timespec last_completion;
+    uint64_t interval_count;
+    double interval_mean;
+    double interval_m2;
+    int sequence_valid;
+    uint16_t last_sequence;
+};
+
+static double timespec_diff_us(const struct timespec *a, const struct timespec *b) {
+    return (double)(a->tv_sec - b->tv_sec) * 1e6 + (double)(a->tv_nsec - b->tv_nsec) / 1e3;
+}
+
+static uint16_t get_word(const uint8_t *data, int word) {
+    return (uint16_t)(data[word * 2] | (data[word * 2 + 1] << 8));
+}
+
+static uint32_t get_long(const uint8_t *data, int offset) {
+    return (uint32_t)data[offset] | ((uint32_t)data[offset + 1] << 8) |
+           ((uint32_t)data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+}
+
+/* Check the sequence number of each packet (packet header mode or packed/compressed framing) */
+static void check_sequence(dd_capture_t *cap, const uint8_t *data, size_t length) {
+    for (size_t offset = 0; offset + cap->config.packet_size <= length; offset += cap->config.packet_size) {
+        const uint8_t *packet = data + offset;
+        uint16_t marker = get_word(packet, 0);
+        uint16_t sequence;
+
+        if (marker == 0xDD10) {
+            sequence = get_word(packet, 7);
+            if (!(get_word(packet, 1) & DD_HEADER_FLAG_PACKET_CRC)) {
+                cap->stats.overflow_count = get_word(packet, 5) | ((uint32_t)get_word(packet, 6) << 16);
+            }
+        } else if ((marker == 0xDD01) || (marker == 0xDD02)) {
+            sequence = get_word(packet, 1);
+        } else {
+            continue;
+        }
+
+        cap->stats.framed_packets++;
+        if (cap->sequence_valid && (sequence != (uint16_t)(cap->last_sequence + 1))) {
+            cap->stats.sequence_gaps++;
+            cap->stats.packets_lost += (uint16_t)(sequence - (uint16_t)(cap->last_sequence + 1));
+        }
+        cap->last_sequence = sequence;
+        cap->sequence_valid = 1;
+    }
+}
+
+/* Submit a transfer (lock held) */
+static void submit_transfer(dd_capture_t *cap, struct libusb_transfer *transfer) {
+    if (cap->stopping) {
+        return;
+    }
+
+    int r = libusb_submit_transfer(transfer);
+    if (r == 0) {
+        cap->in_flight++;
+    } else {
+        fprintf(stderr, "Error: libusb_submit_transfer failed: %s\n", libusb_error_name(r));
+        if (r == LIBUSB_ERROR_NO_DEVICE) {
+            cap->device_lost = 1;
+        }
+        cap->stats.failed_transfers++;
+    }
+}
+
+/* Count the data in a transfer and pass it to the writer, or submit it again (lock held) */
+static void receive_data(dd_capture_t *cap, struct libusb_transfer *transfer) {
+    cap->stats.bytes += transfer->actual_length;
+    cap->stats.packets += transfer->actual_length / cap->config.packet_size;
+    check_sequence(cap, transfer->buffer, transfer->actual_length);
+
+    if (cap->writer_active && !cap->stopping) {
+        int tail = (cap->queue_head + cap->queue_count) % DD_QUEUE_DEPTH_MAX;
+        cap->queue[tail] = transfer;
+        cap->queue_count++;
+        pthread_cond_signal(&cap->cond);
+    } else {
+        submit_transfer(cap, transfer);
+    }
+}
+
+static void LIBUSB_CALL transfer_callback(struct libusb_transfer *transfer) {
+    dd_capture_t *cap = transfer->user_data;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&cap->lock);
+    cap->in_flight--;
+
+    switch (transfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED:
+        if (cap->stats.transfers == 0) {
+            cap->first_completion = now;
+        } else {
+            /* Running mean and variance of the completion interval (Welford) */
+            double interval = timespec_diff_us(&now, &cap->last_completion);
+            double delta = interval - cap->interval_mean;
+
+            cap->interval_count++;
+            cap->interval_mean += delta / (double)cap->interval_count;
+            cap->interval_m2 += delta * (interval - cap->interval_mean);
+            if ((cap->interval_count == 1) || (interval < cap->stats.interval_min_us)) {
+                cap->stats.interval_min_us = interval;
+            }
+            if (interval > cap->stats.interval_max_us) {
+                cap->stats.interval_max_us = interval;
+            }
+        }
+        cap->last_completion = now;
+
+        cap->stats.transfers++;
+        if (transfer->actual_length != transfer->length) {
+            cap->stats.short_transfers++;
+        }
+        receive_data(cap, transfer);
+        break;
+
+    case LIBUSB_TRANSFER_CANCELLED:
+        break;
+
+    case LIBUSB_TRANSFER_NO_DEVICE:
+        cap->device_lost = 1;
+        cap->stats.failed_transfers++;
+        break;
+
+    default:
+        /* Timed out or failed; the data that did arrive is kept so the file has no hole */
+        cap->stats.failed_transfers++;
+        if (transfer->actual_length > 0) {
+            cap->stats.failed_bytes += transfer->actual_length;
+            receive_data(cap, transfer);
+        } else {
+            submit_transfer(cap, transfer);
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&cap->lock);
+}
+
+/* Stop using O_DIRECT (for a write the file system cannot take directly) */
+static void drop_direct(dd_capture_t *cap) {
+    int flags = fcntl(cap->fd, F_GETFL);
+
+    if (flags >= 0 && fcntl(cap->fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+        fprintf(stderr, "Warning: unaligned transfer, O_DIRECT turned off\n");
+    }
+    cap->direct = 0;
+}
+
+/* Account for a finished write and submit the transfer again (lock held) */
+static void write_done(dd_capture_t *cap, struct libusb_transfer *transfer, ssize_t result) {
+    if (result == transfer->actual_length) {
+        cap->stats.bytes_written += result;
+    } else {
+        cap->stats.write_errors++;
+    }
+    submit_transfer(cap, transfer);
+}
+
+/* Take the next transfer from the writer queue (lock held) */
+static struct libusb_transfer *queue_pop(dd_capture_t *cap) {
+    struct libusb_transfer *transfer = cap->queue[cap->queue_head];
+
+    cap->queue_head = (cap->queue_head + 1) % DD_QUEUE_DEPTH_MAX;
+    cap->queue_count--;
+    return transfer;
+}
+
+/* Offset in the output file for a transfer (aligned transfers keep O_DIRECT usable) */
+static off_t next_offset(dd_capture_t *cap, struct libusb_transfer *transfer) {
+    off_t offset = cap->write_offset;
+
+    if (cap->direct && (transfer->actual_length % DIRECT_ALIGNMENT) != 0) {
+        drop_direct(cap);
+    }
+    cap->write_offset += transfer->actual_length;
+    return offset;
+}
+
+static void *writer_thread_pwrite(void *arg) {
+    dd_capture_t *cap = arg;
+
+    pthread_mutex_lock(&cap->lock);
+    for (;;) {
+        while (cap->queue_count == 0 && !cap->writer_exit) {
+            pthread_cond_wait(&cap->cond, &cap->lock);
+        }
+        if (cap->queue_count == 0) {
+            break;
+        }
+
+        struct libusb_transfer *transfer = queue_pop(cap);
+        off_t offset = (cap->fd >= 0) ? next_offset(cap, transfer) : 0;
+        pthread_mutex_unlock(&cap->lock);
+
+        if (cap->config.data_cb) {
+            cap->config.data_cb(transfer->buffer, transfer->actual_length, cap->config.data_cb_user);
+        }
+
+        ssize_t result = transfer->actual_length;
+        if (cap->fd >= 0) {
+            result = pwrite(cap->fd, transfer->buffer, transfer->actual_length, offset);
+        }
+
+        pthread_mutex_lock(&cap->lock);
+        write_done(cap, transfer, result);
+    }
+    pthread_mutex_unlock(&cap->lock);
+    return NULL;
+}
+
+#ifdef HAVE_LIBURING
+static void *writer_thread_uring(void *arg) {
+    dd_capture_t *cap = arg;
+    struct io_uring_cqe *cqe;
+    int pending = 0;
+
+    pthread_mutex_lock(&cap->lock);
+    for (;;) {
+        while (cap->queue_count == 0 && pending == 0 && !cap->writer_exit) {
+            pthread_cond_wait(&cap->cond, &cap->lock);
+        }
+        if (cap->queue_count == 0 && pending == 0) {
+            break;
+        }
+
+        /* Queue a write for each completed transfer */
+        int queued = 0;
+        while (cap->queue_count > 0) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&cap->ring);
+            if (!sqe) {
+                break;
+            }
+
+            struct libusb_transfer *transfer = queue_pop(cap);
+            off_t offset = next_offset(cap, transfer);
+            pthread_mutex_unlock(&cap->lock);
+
+            if (cap->config.data_cb) {
+                cap->config.data_cb(transfer->buffer, transfer->actual_length, cap->config.data_cb_user);
+            }
+            io_uring_prep_write(sqe, cap->fd, transfer->buffer, transfer->actual_length, offset);
+            io_uring_sqe_set_data(sqe, transfer);
+            queued++;
+
+            pthread_mutex_lock(&cap->lock);
+        }
+        pthread_mutex_unlock(&cap->lock);
+
+        if (queued > 0) {
+            io_uring_submit(&cap->ring);
+            pending += queued;
+        }
+
+        /* Wait for a write if there is nothing new to queue */
+        int wait = (queued == 0);
+        while (pending > 0) {
+            int r = wait ? io_uring_wait_cqe(&cap->ring, &cqe) : io_uring_peek_cqe(&cap->ring, &cqe);
+            if (r != 0) {
+                break;
+            }
+            wait = 0;
+
+            struct libusb_transfer *transfer = io_uring_cqe_get_data(cqe);
+            ssize_t result = cqe->res;
+            io_uring_cqe_seen(&cap->ring, cqe);
+            pending--;
+
+            pthread_mutex_lock(&cap->lock);
+            write_done(cap, transfer, result);
+            pthread_mutex_unlock(&cap->lock);
+        }
+
+        pthread_mutex_lock(&cap->lock);
+    }
+    pthread_mutex_unlock(&cap->lock);
+    return NULL;
+}
+#endif
+
+static int vendor_command(dd_capture_t *cap, uint8_t request, uint16_t value) {
+    int r = libusb_control_transfer(cap->handle, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
+                                    request, value, 0, NULL, 0, USB_TIMEOUT_MS);
+    if (r < 0) {
+        fprintf(stderr, "Error: vendor request 0x%02X failed: %s\n", request, libusb_error_name(r));
+        return -1;
+    }
+    return 0;
+}
+
+/* Read the FPGA pipeline statistics (the firmware's derived fields are not used) */
+int dd_capture_get_pipeline_stats(dd_capture_t *cap, dd_pipeline_stats_t *stats) {
+    uint8_t data[36];
+    int r = libusb_control_transfer(cap->handle, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_IN,
+                                    DD_VREQ_GET_PIPELINE_STATS, 0, 0, data, sizeof(data), USB_TIMEOUT_MS);
+    if (r < (int)sizeof(data)) {
+        return -1;
+    }
+
+    stats->version = get_word(data, 0);
+    stats->bank_count = data[2];
+    stats->peak_banks_waiting = data[3];
+    stats->clock_hz = get_long(data, 4);
+    stats->clocks = get_long(data, 8);
+    stats->bus_words = get_long(data, 12);
+    stats->packets = get_long(data, 16);
+    stats->stall_max = get_long(data, 20);
+    stats->stall_total = get_long(data, 24);
+    return 0;
+}
+
+void dd_capture_default_config(dd_capture_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->queue_depth = DD_QUEUE_DEPTH_DEFAULT;
+    config->transfer_packets = DD_TRANSFER_PACKETS_DEFAULT;
+    config->packet_size = DD_PACKET_SIZE;
+    config->use_direct = 1;
+}
+
+/* Open the device_index'th Domesday Duplicator and allocate the transfers */
+int dd_capture_open(dd_capture_t **capture, const dd_capture_config_t *config, int device_index) {
+    libusb_device **list;
+    ssize_t count;
+    int found = 0;
+    int r;
+
+    if (config->queue_depth < 1 || config->queue_depth > DD_QUEUE_DEPTH_MAX || config->transfer_packets < 1) {
+        fprintf(stderr, "Error: invalid queue depth or transfer size\n");
+        return -1;
+    }
+    if (config->packet_size != DD_PACKET_SIZE && config->packet_size != DD_PACKET_SIZE / 2 &&
+        config->packet_size != DD_PACKET_SIZE_MIN) {
+        fprintf(stderr, "Error: invalid packet size\n");
+        return -1;
+    }
+
+    dd_capture_t *cap = calloc(1, sizeof(*cap));
+    if (!cap) {
+        return -1;
+    }
+    cap->config = *config;
+    cap->transfer_size = (size_t)config->transfer_packets * config->packet_size;
+    cap->fd = -1;
+    pthread_mutex_init(&cap->lock, NULL);
+    pthread_cond_init(&cap->cond, NULL);
+
+    if (libusb_init(&cap->ctx) < 0) {
+        fprintf(stderr, "Failed to initialize libusb\n");
+        free(cap);
+        return -1;
+    }
+
+    count = libusb_get_device_list(cap->ctx, &list);
+    for (ssize_t i = 0; i < count && !cap->handle; i++) {
+        struct libusb_device_descriptor desc;
+
+        if (libusb_get_device_descriptor(list[i], &desc) != 0) {
+            continue;
+        }
+        if (desc.idVendor != DD_VENDOR_ID || desc.idProduct != DD_PRODUCT_ID) {
+            continue;
+        }
+        if (found++ == device_index) {
+            r = libusb_open(list[i], &cap->handle);
+            if (r != 0) {
+                fprintf(stderr, "Error: failed to open device: %s\n", libusb_error_name(r));
+            }
+        }
+    }
+    if (count >= 0) {
+        libusb_free_device_list(list, 1);
+    }
+
+    if (!cap->handle) {
+        if (found <= device_index) {
+            fprintf(stderr, "Error: Domesday Duplicator %d not found\n", device_index);
+        }
+        dd_capture_close(cap);
+        return -1;
+    }
+
+    r = libusb_claim_interface(cap->handle, 0);
+    if (r != 0) {
+        fprintf(stderr, "Error: failed to claim interface: %s\n", libusb_error_name(r));
+        dd_capture_close(cap);
+        return -1;
+    }
+
+    /* Allocate the transfers; usbfs memory (when available) avoids a kernel copy */
+    for (int i = 0; i < config->queue_depth; i++) {
+        uint8_t *buffer = NULL;
+
+        cap->transfers[i] = libusb_alloc_transfer(0);
+        if (!cap->transfers[i]) {
+            dd_capture_close(cap);
+            return -1;
+        }
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+        buffer = libusb_dev_mem_alloc(cap->handle, cap->transfer_size);
+        cap->dev_mem[i] = (buffer != NULL);
+#endif
+        if (!buffer && posix_memalign((void **)&buffer, DIRECT_ALIGNMENT, cap->transfer_size) != 0) {
+            buffer = NULL;
+        }
+        if (!buffer) {
+            fprintf(stderr, "Error: failed to allocate transfer buffers\n");
+            dd_capture_close(cap);
+            return -1;
+        }
+
+        libusb_fill_bulk_transfer(cap->transfers[i], cap->handle, DD_DATA_ENDPOINT, buffer,
+                                  (int)cap->transfer_size, transfer_callback, cap, 0);
+    }
+
+    *capture = cap;
+    return 0;
+}
+
+/* Configure the device, open the output and start collecting */
+int dd_capture_start(dd_capture_t *cap) {
+    dd_capture_config_t *config = &cap->config;
+    void *(*writer)(void *) = writer_thread_pwrite;
+
+    if (config->packet_limit > DD_CAPTURE_LENGTH_MAX) {
+        fprintf(stderr, "Error: capture length is too long\n");
+        return -1;
+    }
+
+    /* The capture length is sent every time, so a limit from an earlier capture is cleared */
+    if (vendor_command(cap, DD_VREQ_COLLECT_DATA, 0) != 0 ||
+        vendor_command(cap, DD_VREQ_CONFIGURATION, config->configuration) != 0 ||
+        vendor_command(cap, DD_VREQ_PACKET_SIZE, (uint16_t)(config->packet_size / 1024)) != 0 ||
+        vendor_command(cap, DD_VREQ_CAPTURE_LENGTH, config->packet_limit & 0x7FFF) != 0 ||
+        vendor_command(cap, DD_VREQ_CAPTURE_LENGTH, 0x8000 | ((config->packet_limit >> 15) & 0x7FFF)) != 0) {
+        return -1;
+    }
+    libusb_clear_halt(cap->handle, DD_DATA_ENDPOINT);
+
+    if (config->output_path) {
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+        cap->direct = config->use_direct;
+        cap->fd = open(config->output_path, flags | (cap->direct ? O_DIRECT : 0), 0644);
+        if (cap->fd < 0 && cap->direct && errno == EINVAL) {
+            fprintf(stderr, "Warning: O_DIRECT not supported on %s\n", config->output_path);
+            cap->direct = 0;
+            cap->fd = open(config->output_path, flags, 0644);
+        }
+        if (cap->fd < 0) {
+            perror("Failed to open output file");
+            return -1;
+        }
+    }
+
+#ifdef HAVE_LIBURING
+    if (config->use_io_uring && cap->fd >= 0) {
+        int r = io_uring_queue_init(config->queue_depth, &cap->ring, 0);
+        if (r < 0) {
+            fprintf(stderr, "Warning: io_uring_queue_init failed (%s), using pwrite\n", strerror(-r));
+        } else {
+            cap->ring_ready = 1;
+            writer = writer_thread_uring;
+        }
+    }
+#else
+    if (config->use_io_uring) {
+        fprintf(stderr, "Warning: built without liburing, using pwrite\n");
+    }
+#endif
+
+    /* The writer thread is only needed if something is done with the data */
+    if (cap->fd >= 0 || config->data_cb) {
+        cap->writer_active = 1;
+        if (pthread_create(&cap->writer, NULL, writer, cap) != 0) {
+            fprintf(stderr, "Error: failed to start the writer thread\n");
+            cap->writer_active = 0;
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&cap->lock);
+    for (int i = 0; i < config->queue_depth; i++) {
+        submit_transfer(cap, cap->transfers[i]);
+    }
+    pthread_mutex_unlock(&cap->lock);
+
+    if (vendor_command(cap, DD_VREQ_COLLECT_DATA, 1) != 0) {
+        return -1;
+    }
+
+    /* An FPGA without the packet size register only sends 16 KB packets (the
+     * firmware then falls back to that size) */
+    if (config->packet_size != DD_PACKET_SIZE) {
+        uint8_t data[16];
+        int r = libusb_control_transfer(cap->handle, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_IN,
+                                        DD_VREQ_GET_BUFFER_CONFIG, 0, 0, data, sizeof(data), USB_TIMEOUT_MS);
+        if (r >= 4 && get_long(data, 0) != config->packet_size) {
+            fprintf(stderr, "Error: the device is using %u KB packets (the FPGA cannot change the packet size)\n",
+                    get_long(data, 0) / 1024);
+            vendor_command(cap, DD_VREQ_COLLECT_DATA, 0);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Run the libusb event loop; returns -1 once the device has gone */
+int dd_capture_poll(dd_capture_t *cap, int timeout_ms) {
+    struct timeval tv = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+
+    libusb_handle_events_timeout_completed(cap->ctx, &tv, NULL);
+    return cap->device_lost ? -1 : 0;
+}
+
+/* Stop collecting, wait for the transfers and writes to finish */
+int dd_capture_stop(dd_capture_t *cap) {
+    int in_flight;
+
+    if (!cap->device_lost) {
+        vendor_command(cap, DD_VREQ_COLLECT_DATA, 0);
+    }
+
+    pthread_mutex_lock(&cap->lock);
+    cap->stopping = 1;
+    in_flight = cap->in_flight;
+    pthread_mutex_unlock(&cap->lock);
+
+    if (in_flight > 0) {
+        for (int i = 0; i < cap->config.queue_depth; i++) {
+            libusb_cancel_transfer(cap->transfers[i]);
+        }
+    }
+
+    for (int tries = 0; tries < 100; tries++) {
+        pthread_mutex_lock(&cap->lock);
+        in_flight = cap->in_flight;
+        pthread_mutex_unlock(&cap->lock);
+        if (in_flight == 0) {
+            break;
+        }
+        dd_capture_poll(cap, 10);
+    }
+
+    if (cap->writer_active) {
+        pthread_mutex_lock(&cap->lock);
+        cap->writer_exit = 1;
+        pthread_cond_signal(&cap->cond);
+        pthread_mutex_unlock(&cap->lock);
+        pthread_join(cap->writer, NULL);
+        cap->writer_active = 0;
+    }
+
+#ifdef HAVE_LIBURING
+    if (cap->ring_ready) {
+        io_uring_queue_exit(&cap->ring);
+        cap->ring_ready = 0;
+    }
+#endif
+
+    if (cap->fd >= 0) {
+        if (close(cap->fd) != 0) {
+            perror("Failed to close output file");
+            cap->stats.write_errors++;
+        }
+        cap->fd = -1;
+    }
+
+    return (in_flight == 0) ? 0 : -1;
+}
+
+void dd_capture_get_stats(dd_capture_t *cap, dd_capture_stats_t *stats) {
+    struct timespec now;
+
+    pthread_mutex_lock(&cap->lock);
+    *stats = cap->stats;
+    if (cap->stats.transfers > 0) {
+        if (cap->stopping) {
+            now = cap->last_completion;
+        } else {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        }
+        stats->elapsed_s = timespec_diff_us(&now, &cap->first_completion) / 1e6;
+    }
+    stats->interval_mean_us = cap->interval_mean;
+    stats->interval_stddev_us = (cap->interval_count > 1) ?
+        sqrt(cap->interval_m2 / (double)(cap->interval_count - 1)) : 0.0;
+    pthread_mutex_unlock(&cap->lock);
+}
+
+void dd_capture_close(dd_capture_t *cap) {
+    if (!cap) {
+        return;
+    }
+
+    for (int i = 0; i < DD_QUEUE_DEPTH_MAX; i++) {
+        struct libusb_transfer *transfer = cap->transfers[i];
+
+        if (!transfer) {
+            continue;
+        }
+        if (transfer->buffer) {
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+            if (cap->dev_mem[i]) {
+                libusb_dev_mem_free(cap->handle, transfer->buffer, cap->transfer_size);
+            } else
+#endif
+            free(transfer->buffer);
+        }
+        libusb_free_transfer(transfer);
+    }
+
+    if (cap->handle) {
+        libusb_release_interface(cap->handle, 0);
+        libusb_close(cap->handle);
+    }
+    if (cap->ctx) {
+        libusb_exit(cap->ctx);
+    }
+    pthread_cond_destroy(&cap->cond);
+    pthread_mutex_destroy(&cap->lock);
+    free(cap);
+}
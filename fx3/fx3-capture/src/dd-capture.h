@@ -0,0 +1,118 @@
+/*
+ * dd-capture.h - Domesday Duplicator capture library
+ *
+ * Receives the RF sample stream from the Domesday Duplicator bulk IN
+ * end-point (0x81) with a queue of asynchronous libusb transfers and
+ * writes it to a file straight from the transfer buffers.
+ *
+ * Each transfer buffer is a whole number of packets (the FX3 DMA
+ * buffer size, 16 KB unless the host selects 8 or 4 KB).  When a transfer completes its buffer is passed
+ * to a writer thread, written (O_DIRECT, or through io_uring when built
+ * with liburing) and the transfer is then submitted again, so the data
+ * is never copied.  The transfers themselves form the buffer ring.
+ */
+
+#ifndef DD_CAPTURE_H
+#define DD_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DD_VENDOR_ID            0x1d50
+#define DD_PRODUCT_ID           0x603b
+#define DD_DATA_ENDPOINT        0x81
+
+#define DD_PACKET_SIZE          16384   /* Bytes per FPGA packet by default (and at most, CY_FX_DMA_BUF_SIZE) */
+#define DD_PACKET_SIZE_MIN      4096    /* Smallest packet size (DD_VREQ_PACKET_SIZE) */
+
+#define DD_VREQ_COLLECT_DATA    0xB5    /* Start (wValue = 1) or stop (wValue = 0) collection */
+#define DD_VREQ_CONFIGURATION   0xB6    /* FPGA configuration bits in wValue */
+#define DD_VREQ_GET_BUFFER_CONFIG 0xB7  /* DMA buffer configuration (word 0 = packet size in use) */
+#define DD_VREQ_CAPTURE_LENGTH  0xD1    /* Capture length in packets, in two halves (bit 15 = bits 29-15) */
+#define DD_VREQ_GET_PIPELINE_STATS 0xD5 /* FPGA buffer to FX3 pipeline statistics */
+#define DD_VREQ_PACKET_SIZE     0xD6    /* Packet size in Kbytes (4, 8 or 16), applied at the next start */
+
+#define DD_CAPTURE_LENGTH_MAX   0x3FFFFFFF  /* Longest capture length in packets */
+
+/* Configuration bits (DD_VREQ_CONFIGURATION wValue) */
+#define DD_CONFIG_TEST_MODE     0x01
+#define DD_CONFIG_PACKED        0x02
+#define DD_CONFIG_HEADER        0x04
+#define DD_CONFIG_DECIMATION    0x20
+#define DD_CONFIG_COMPRESSED    0x40
+#define DD_CONFIG_SOAK          0x80    /* PRBS samples and a CRC-32C at the end of each packet */
+#define DD_CONFIG_PACKET_CRC    0x100   /* Each packet header carries the CRC-32C of the previous packet */
+#define DD_CONFIG_TWO_CHANNEL   0x200   /* Both ADCs decimated and interleaved (A, B, A, B, ...; DUAL_ADC FPGAs only) */
+
+/* Packet header flags (word 1) */
+#define DD_HEADER_FLAG_PACKET_CRC 0x0040 /* Words 5-6 are the previous packet's CRC (not the overflow count) */
+#define DD_HEADER_FLAG_TWO_CHANNEL 0x0080 /* Even sample indexes are channel A, odd indexes channel B */
+
+#define DD_QUEUE_DEPTH_DEFAULT  64
+#define DD_QUEUE_DEPTH_MAX      256
+#define DD_TRANSFER_PACKETS_DEFAULT 4
+
+typedef struct dd_capture dd_capture_t;
+
+/* Called from the writer thread for each transfer before it is written */
+typedef void (*dd_capture_data_cb)(const uint8_t *data, size_t length, void *user);
+
+typedef struct {
+    int queue_depth;            /* Transfers in flight */
+    int transfer_packets;       /* Packets per transfer */
+    uint32_t packet_size;       /* Bytes per packet (DD_PACKET_SIZE, 8192 or DD_PACKET_SIZE_MIN) */
+    uint16_t configuration;     /* DD_VREQ_CONFIGURATION value sent before starting */
+    uint32_t packet_limit;      /* Packets the device sends before stopping (0 = no limit) */
+    const char *output_path;    /* File to write (NULL to discard the data) */
+    int use_io_uring;           /* Write through io_uring (if built with liburing) */
+    int use_direct;             /* Open the output with O_DIRECT */
+    dd_capture_data_cb data_cb; /* Optional data callback (NULL for none) */
+    void *data_cb_user;
+} dd_capture_config_t;
+
+typedef struct {
+    uint64_t bytes;             /* Bytes received */
+    uint64_t transfers;         /* Transfers completed */
+    uint64_t packets;           /* Packets received */
+    uint64_t short_transfers;   /* Transfers shorter than requested */
+    uint64_t failed_transfers;  /* Transfers completed with an error */
+    uint64_t failed_bytes;      /* Bytes received by failed transfers (kept in the output) */
+    uint64_t bytes_written;     /* Bytes written to the output */
+    uint64_t write_errors;      /* Failed writes */
+    uint64_t framed_packets;    /* Packets carrying a sequence number */
+    uint64_t sequence_gaps;     /* Sequence number discontinuities */
+    uint64_t packets_lost;      /* Packets missing according to the sequence numbers */
+    uint32_t overflow_count;    /* FPGA overflow count from the last packet header */
+    double elapsed_s;           /* Time since the first transfer completed */
+    double interval_min_us;     /* Time between transfer completions */
+    double interval_max_us;
+    double interval_mean_us;
+    double interval_stddev_us;  /* Completion jitter */
+} dd_capture_stats_t;
+
+/* FPGA buffer to FX3 pipeline statistics (DD_VREQ_GET_PIPELINE_STATS)
+ *
+ * The counts restart when collection is started and wrap, so rates are
+ * worked out from the differences between two reads. */
+typedef struct {
+    uint16_t version;
+    uint8_t bank_count;         /* FPGA buffer banks (0 = no pipeline statistics) */
+    uint8_t peak_banks_waiting; /* Most banks waiting to be read by the FX3 */
+    uint32_t clock_hz;          /* GPIF clock (the unit of the clock counts) */
+    uint32_t clocks;            /* Clocks since collection started */
+    uint32_t bus_words;         /* Words read by the FX3 */
+    uint32_t packets;           /* Packets sent */
+    uint32_t stall_max;         /* Longest time a packet waited for the FX3 (clocks) */
+    uint32_t stall_total;       /* All the packet waiting time (clocks) */
+} dd_pipeline_stats_t;
+
+void dd_capture_default_config(dd_capture_config_t *config);
+int dd_capture_open(dd_capture_t **capture, const dd_capture_config_t *config, int device_index);
+int dd_capture_start(dd_capture_t *capture);
+int dd_capture_poll(dd_capture_t *capture, int timeout_ms);
+int dd_capture_stop(dd_capture_t *capture);
+void dd_capture_get_stats(dd_capture_t *capture, dd_capture_stats_t *stats);
+int dd_capture_get_pipeline_stats(dd_capture_t *capture, dd_pipeline_stats_t *stats);
+void dd_capture_close(dd_capture_t *capture);
+
+#endif /* DD_CAPTURE_H */
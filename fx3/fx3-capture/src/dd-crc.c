@@ -0,0 +1,105 @@
+/*
+ * dd-crc.c - CRC-32C for the Domesday Duplicator packet CRCs
+ *
+ * See dd-crc.h.  The instructions take the reflected CRC a word at a
+ * time, which is the same calculation as the table a byte at a time.
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_CRC32
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#include "dd-crc.h"
+
+#define CRC32C_POLYNOMIAL       0x82F63B78  /* 0x1EDC6F41 reflected */
+
+typedef uint32_t (*crc_fn)(uint32_t crc, const uint8_t *data, size_t length);
+
+static crc_fn crc_update;
+static uint32_t crc_table[256];
+static const char *implementation = "table";
+
+static uint32_t crc_update_table(uint32_t crc, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef HAVE_X86_CRC32
+__attribute__((target("sse4.2")))
+static uint32_t crc_update_sse42(uint32_t crc, const uint8_t *data, size_t length) {
+    uint64_t crc64 = crc;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+
+        memcpy(&word, data + i, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+    for (; i < length; i++) {
+        crc = _mm_crc32_u8(crc, data[i]);
+    }
+    return crc;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+static uint32_t crc_update_armv8(uint32_t crc, const uint8_t *data, size_t length) {
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+
+        memcpy(&word, data + i, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; i < length; i++) {
+        crc = __crc32cb(crc, data[i]);
+    }
+    return crc;
+}
+#endif
+
+/* Select the fastest implementation the CPU supports */
+static void select_implementation(void) {
+    if (crc_update) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+
+    crc_update = crc_update_table;
+#ifdef HAVE_X86_CRC32
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc_update = crc_update_sse42;
+        implementation = "sse4.2";
+    }
+#elif defined(__ARM_FEATURE_CRC32)
+    crc_update = crc_update_armv8;
+    implementation = "armv8";
+#endif
+}
+
+uint32_t dd_crc32c(const uint8_t *data, size_t length) {
+    select_implementation();
+    return ~crc_update(0xFFFFFFFF, data, length);
+}
+
+const char *dd_crc32c_implementation(void) {
+    select_implementation();
+    return implementation;
+}
@@ -0,0 +1,23 @@
+/*
+ * dd-crc.h - CRC-32C for the Domesday Duplicator packet CRCs
+ *
+ * The FPGA ends each packet with the CRC-32C (Castagnoli polynomial
+ * 0x1EDC6F41, reflected, initial value and final XOR 0xFFFFFFFF) of
+ * the rest of the packet in soak mode.  The CRC is calculated with the
+ * SSE4.2 (selected at run-time) or ARMv8 CRC32C instructions, falling
+ * back to a table.
+ */
+
+#ifndef DD_CRC_H
+#define DD_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC-32C of length bytes */
+uint32_t dd_crc32c(const uint8_t *data, size_t length);
+
+/* Name of the implementation in use ("sse4.2", "armv8" or "table") */
+const char *dd_crc32c_implementation(void);
+
+#endif /* DD_CRC_H */
@@ -0,0 +1,356 @@
+/*
+ * dd-validate.c - Domesday Duplicator sample stream validator
+ *
+ * See dd-validate.h.  The validator keeps the expected ramp value and
+ * sequence number of the next sample.  Between events (the ramp
+ * wrapping from 1020 to 0 and the sequence number changing) the
+ * expected samples are simply
+ *
+ *   (sequence << 10) | (ramp + n)
+ *
+ * so a span of samples up to the next event is compared a vector at a
+ * time against an incrementing expected vector.  The events themselves
+ * (and any sample that does not match) are checked one sample at a
+ * time.
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "dd-validate.h"
+#include "dd-capture.h"
+#include "dd-crc.h"
+
+#define RAMP_LENGTH             1021    /* Test ramp counts 0 to 1020 */
+#define SEQUENCE_COUNT          63      /* Sequence number counts 0 to 62 */
+#define SEQUENCE_LENGTH         65536   /* Samples per sequence number */
+#define HEADER_MARKER           0xDD10
+#define HEADER_BYTES            16
+#define CRC_BYTES               4
+
+/*
+ * Compare up to span samples (a multiple of the vector width) against
+ * base + step * n under mask; returns the number of samples (a multiple of
+ * the width) before the first vector that does not match.
+ */
+typedef size_t (*compare_fn)(const uint16_t *samples, size_t span,
+                             uint16_t base, uint16_t step, uint16_t mask);
+
+static compare_fn compare_blocks;
+static size_t compare_width;
+static const char *implementation = "scalar";
+
+static size_t compare_scalar(const uint16_t *samples, size_t span,
+                             uint16_t base, uint16_t step, uint16_t mask) {
+    for (size_t i = 0; i < span; i++) {
+        if ((samples[i] & mask) != (uint16_t)(base + step * i)) {
+            return i;
+        }
+    }
+    return span;
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("sse2")))
+static size_t compare_sse2(const uint16_t *samples, size_t span,
+                           uint16_t base, uint16_t step, uint16_t mask) {
+    const __m128i vmask = _mm_set1_epi16((short)mask);
+    const __m128i increment = _mm_set1_epi16((short)(step * 8));
+    __m128i expected = _mm_add_epi16(_mm_set1_epi16((short)base),
+                                     _mm_mullo_epi16(_mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7),
+                                                     _mm_set1_epi16((short)step)));
+    size_t i;
+
+    for (i = 0; i < span; i += 8) {
+        __m128i data = _mm_and_si128(_mm_loadu_si128((const __m128i *)(samples + i)), vmask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(data, expected)) != 0xFFFF) {
+            break;
+        }
+        expected = _mm_add_epi16(expected, increment);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t compare_avx2(const uint16_t *samples, size_t span,
+                           uint16_t base, uint16_t step, uint16_t mask) {
+    const __m256i vmask = _mm256_set1_epi16((short)mask);
+    const __m256i increment = _mm256_set1_epi16((short)(step * 16));
+    __m256i expected = _mm256_add_epi16(_mm256_set1_epi16((short)base),
+                                        _mm256_mullo_epi16(_mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7,
+                                                                             8, 9, 10, 11, 12, 13, 14, 15),
+                                                           _mm256_set1_epi16((short)step)));
+    size_t i;
+
+    for (i = 0; i < span; i += 16) {
+        __m256i data = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(samples + i)), vmask);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi16(data, expected)) != -1) {
+            break;
+        }
+        expected = _mm256_add_epi16(expected, increment);
+    }
+    return i;
+}
+#elif defined(__ARM_NEON)
+static size_t compare_neon(const uint16_t *samples, size_t span,
+                           uint16_t base, uint16_t step, uint16_t mask) {
+    static const uint16_t lanes[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    const uint16x8_t vmask = vdupq_n_u16(mask);
+    const uint16x8_t increment = vdupq_n_u16((uint16_t)(step * 8));
+    uint16x8_t expected = vmlaq_n_u16(vdupq_n_u16(base), vld1q_u16(lanes), step);
+    size_t i;
+
+    for (i = 0; i < span; i += 8) {
+        uint16x8_t data = vandq_u16(vld1q_u16(samples + i), vmask);
+        uint64x2_t match = vreinterpretq_u64_u16(vceqq_u16(data, expected));
+        if ((vgetq_lane_u64(match, 0) & vgetq_lane_u64(match, 1)) != ~0ULL) {
+            break;
+        }
+        expected = vaddq_u16(expected, increment);
+    }
+    return i;
+}
+#endif
+
+/* Select the widest implementation the CPU supports */
+static void select_implementation(void) {
+    if (compare_blocks) {
+        return;
+    }
+
+    compare_blocks = compare_scalar;
+    compare_width = 8;
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        compare_blocks = compare_avx2;
+        compare_width = 16;
+        implementation = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        compare_blocks = compare_sse2;
+        implementation = "sse2";
+    }
+#elif defined(__ARM_NEON)
+    compare_blocks = compare_neon;
+    implementation = "neon";
+#endif
+}
+
+static void record_error(dd_validator_t *v, int ramp_error, int sequence_error) {
+    if (v->errors == 0) {
+        v->first_error = v->samples;
+    }
+    v->errors++;
+    if (ramp_error) {
+        v->ramp_errors++;
+    }
+    if (sequence_error) {
+        v->sequence_errors++;
+    }
+}
+
+/* Move the expected values on by count samples */
+static void advance(dd_validator_t *v, size_t count) {
+    v->samples += count;
+    v->ramp = (uint32_t)((v->ramp + count) % RAMP_LENGTH);
+    if (v->sequence_locked) {
+        v->sequence_position += (uint32_t)count;
+        if (v->sequence_position >= SEQUENCE_LENGTH) {
+            v->sequence_position -= SEQUENCE_LENGTH;
+            v->sequence = (v->sequence + 1) % SEQUENCE_COUNT;
+        }
+    }
+}
+
+/* Check a single sample (at an event, or after a vector failed to match) */
+static void check_sample(dd_validator_t *v, uint16_t sample) {
+    uint32_t ramp = sample & 0x3FF;
+    uint32_t sequence = sample >> 10;
+
+    if (v->locked) {
+        int ramp_error = (v->flags & DD_VALIDATE_RAMP) && (ramp != v->ramp);
+        int sequence_error = 0;
+
+        if (sequence != v->sequence) {
+            if (!v->sequence_locked && sequence == (v->sequence + 1) % SEQUENCE_COUNT) {
+                /* First sequence number change; the position is now known */
+                v->sequence = sequence;
+                v->sequence_position = 0;
+                v->sequence_locked = 1;
+            } else {
+                sequence_error = 1;
+            }
+        }
+
+        if (!ramp_error && !sequence_error) {
+            advance(v, 1);
+            return;
+        }
+        record_error(v, ramp_error, sequence_error);
+    }
+
+    /* Lock on to this sample */
+    v->locked = 1;
+    v->sequence_locked = 0;
+    v->ramp = ramp;
+    v->sequence = sequence;
+    advance(v, 1);
+}
+
+/* Samples that can be compared as vectors before the next event */
+static size_t vector_span(const dd_validator_t *v, size_t remaining) {
+    size_t span = remaining;
+
+    if (!v->locked) {
+        return 0;
+    }
+    if (v->sequence_locked && span > SEQUENCE_LENGTH - v->sequence_position) {
+        span = SEQUENCE_LENGTH - v->sequence_position;
+    }
+    if ((v->flags & DD_VALIDATE_RAMP) && span > RAMP_LENGTH - v->ramp) {
+        span = RAMP_LENGTH - v->ramp;
+    }
+    return span - span % compare_width;
+}
+
+static void validate_samples(dd_validator_t *v, const uint16_t *samples, size_t count) {
+    int ramp = (v->flags & DD_VALIDATE_RAMP) != 0;
+    uint16_t step = ramp ? 1 : 0;
+    uint16_t mask = ramp ? 0xFFFF : 0xFC00;
+    size_t i = 0;
+
+    while (i < count) {
+        size_t span = vector_span(v, count - i);
+
+        if (span > 0) {
+            uint16_t base = (uint16_t)((v->sequence << 10) | (ramp ? v->ramp : 0));
+            size_t matched = compare_blocks(samples + i, span, base, step, mask);
+
+            advance(v, matched);
+            i += matched;
+            if (matched == span) {
+                continue;
+            }
+        }
+
+        /* Event or mismatch: check the next vector's worth one at a time */
+        size_t end = (count - i < compare_width) ? count : i + compare_width;
+        while (i < end) {
+            check_sample(v, samples[i++]);
+        }
+    }
+}
+
+/* Check the CRC at the end of each whole packet (soak mode) */
+static void validate_crc(dd_validator_t *v, const uint8_t *data, size_t length) {
+    for (size_t offset = 0; offset + v->packet_size <= length; offset += v->packet_size) {
+        const uint8_t *packet = data + offset;
+        const uint8_t *stored = packet + v->packet_size - CRC_BYTES;
+        uint32_t crc = (uint32_t)stored[0] | ((uint32_t)stored[1] << 8) |
+                       ((uint32_t)stored[2] << 16) | ((uint32_t)stored[3] << 24);
+
+        if (v->flags & DD_VALIDATE_HEADER) {
+            if ((packet[0] | (packet[1] << 8)) == HEADER_MARKER) {
+                v->packets++;
+            } else {
+                v->header_errors++;
+            }
+        }
+
+        if (dd_crc32c(packet, v->packet_size - CRC_BYTES) != crc) {
+            if (v->crc_errors == 0) {
+                v->first_crc_error = v->crc_packets;
+            }
+            v->crc_errors++;
+        }
+        v->crc_packets++;
+    }
+}
+
+/* Check each whole packet against the CRC in the next packet's header (packet CRC mode) */
+static void validate_packet_crc(dd_validator_t *v, const uint8_t *data, size_t length) {
+    for (size_t offset = 0; offset + v->packet_size <= length; offset += v->packet_size) {
+        const uint8_t *packet = data + offset;
+        uint16_t flags = (uint16_t)(packet[2] | (packet[3] << 8));
+        uint16_t sequence = (uint16_t)(packet[14] | (packet[15] << 8));
+        uint32_t crc = (uint32_t)packet[10] | ((uint32_t)packet[11] << 8) |
+                       ((uint32_t)packet[12] << 16) | ((uint32_t)packet[13] << 24);
+
+        if ((packet[0] | (packet[1] << 8)) != HEADER_MARKER) {
+            v->previous_valid = 0;
+            continue;
+        }
+
+        if (v->previous_valid && (flags & DD_HEADER_FLAG_PACKET_CRC) &&
+            sequence == (uint16_t)(v->previous_sequence + 1)) {
+            if (crc != v->previous_crc) {
+                v->packet_crc_errors++;
+            }
+            v->packet_crc_packets++;
+        }
+
+        v->previous_crc = dd_crc32c(packet, v->packet_size);
+        v->previous_sequence = sequence;
+        v->previous_valid = 1;
+    }
+}
+
+void dd_validate_init(dd_validator_t *validator, int flags) {
+    select_implementation();
+    dd_crc32c_implementation();
+    memset(validator, 0, sizeof(*validator));
+    validator->flags = flags;
+    validator->packet_size = DD_PACKET_SIZE;
+}
+
+void dd_validate_set_packet_size(dd_validator_t *validator, size_t packet_size) {
+    validator->packet_size = packet_size;
+}
+
+void dd_validate(dd_validator_t *v, const uint8_t *data, size_t length) {
+    if (v->flags & DD_VALIDATE_PACKET_CRC) {
+        validate_packet_crc(v, data, length);
+    }
+    if (v->flags & DD_VALIDATE_CRC) {
+        validate_crc(v, data, length);
+        return;
+    }
+    if (v->flags & DD_VALIDATE_NO_SAMPLES) {
+        return;
+    }
+    if (!(v->flags & DD_VALIDATE_HEADER)) {
+        validate_samples(v, (const uint16_t *)data, length / 2);
+        return;
+    }
+
+    /* Skip the packet header at the start of each packet */
+    for (size_t offset = 0; offset < length; offset += v->packet_size) {
+        size_t packet_length = length - offset;
+        const uint8_t *packet = data + offset;
+
+        if (packet_length > v->packet_size) {
+            packet_length = v->packet_size;
+        }
+        if (packet_length < HEADER_BYTES) {
+            break;
+        }
+
+        if ((packet[0] | (packet[1] << 8)) == HEADER_MARKER) {
+            v->packets++;
+        } else {
+            v->header_errors++;
+        }
+        validate_samples(v, (const uint16_t *)(packet + HEADER_BYTES), (packet_length - HEADER_BYTES) / 2);
+    }
+}
+
+const char *dd_validate_implementation(void) {
+    select_implementation();
+    return implementation;
+}
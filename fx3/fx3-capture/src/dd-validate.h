@@ -0,0 +1,90 @@
+/*
+ * dd-validate.h - Domesday Duplicator sample stream validator
+ *
+ * Checks unpacked (16-bit) sample data from the FPGA data generator:
+ * - The 6-bit sequence number in bits 15-10, which counts 0 to 62 with
+ *   each number attached to 65536 samples
+ * - The test mode ramp in bits 9-0, which counts 0 to 1020 (optional)
+ *
+ * The validator locks on to the first sample, so a capture can start
+ * anywhere in the pattern.  The position within a sequence number is
+ * only known after the first change of sequence number has been seen.
+ * After a discontinuity the validator locks on again from the sample
+ * that failed.
+ *
+ * The comparison runs on blocks of samples with SSE2, AVX2 (selected
+ * at run-time) or NEON, falling back to one sample at a time only
+ * around the ramp wrap, the sequence number changes and errors.
+ *
+ * In soak mode the samples are a PRBS and each packet ends with
+ * the CRC-32C of the rest of the packet; with DD_VALIDATE_CRC only the
+ * CRC (and the packet header marker) of each packet is checked, so any
+ * sample format can be validated.
+ *
+ * In packet CRC mode each packet header carries the CRC-32C of the
+ * previous packet; with DD_VALIDATE_PACKET_CRC each packet is checked
+ * against the header of the packet that follows it (when their
+ * sequence numbers are consecutive), as well as any sample checks.
+ */
+
+#ifndef DD_VALIDATE_H
+#define DD_VALIDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Validator flags */
+#define DD_VALIDATE_RAMP        0x01    /* Check the test mode ramp (bits 9-0) */
+#define DD_VALIDATE_HEADER      0x02    /* Each packet starts with a packet header */
+#define DD_VALIDATE_CRC         0x04    /* Each packet ends with its CRC-32C (soak mode) */
+#define DD_VALIDATE_PACKET_CRC  0x08    /* Each packet header carries the previous packet's CRC-32C */
+#define DD_VALIDATE_NO_SAMPLES  0x10    /* Only check the packet CRCs (any sample format) */
+
+typedef struct {
+    int flags;
+    size_t packet_size;         /* Bytes per packet (DD_PACKET_SIZE unless set) */
+
+    /* Expected values for the next sample */
+    int locked;                 /* The validator has a previous sample */
+    int sequence_locked;        /* The position within the sequence number is known */
+    uint32_t ramp;
+    uint32_t sequence;
+    uint32_t sequence_position;
+
+    /* Results */
+    uint64_t samples;           /* Samples checked */
+    uint64_t packets;           /* Packet headers skipped */
+    uint64_t header_errors;     /* Packets without a packet header marker */
+    uint64_t errors;            /* Discontinuities */
+    uint64_t ramp_errors;       /* Discontinuities in the ramp */
+    uint64_t sequence_errors;   /* Discontinuities in the sequence number */
+    uint64_t first_error;       /* Sample number of the first discontinuity */
+    uint64_t crc_packets;       /* Packet CRCs checked */
+    uint64_t crc_errors;        /* Packets with the wrong CRC */
+    uint64_t first_crc_error;   /* Packet number of the first wrong CRC */
+
+    /* Packet CRC mode (the previous packet is checked against each header) */
+    int previous_valid;         /* previous_crc and previous_sequence are known */
+    uint32_t previous_crc;
+    uint16_t previous_sequence;
+    uint64_t packet_crc_packets; /* Packets whose CRC was checked against the next header */
+    uint64_t packet_crc_errors; /* Packets that did not match the next header */
+} dd_validator_t;
+
+void dd_validate_init(dd_validator_t *validator, int flags);
+
+/* Set the packet size (DD_VREQ_PACKET_SIZE) of the data to be checked */
+void dd_validate_set_packet_size(dd_validator_t *validator, size_t packet_size);
+
+/*
+ * Check a buffer of samples.  With DD_VALIDATE_HEADER or
+ * DD_VALIDATE_CRC each call must start on a packet boundary (as
+ * transfers and file reads of whole packets do); a partial packet at
+ * the end is not checked for its CRC.
+ */
+void dd_validate(dd_validator_t *validator, const uint8_t *data, size_t length);
+
+/* Name of the implementation in use ("avx2", "sse2", "neon" or "scalar") */
+const char *dd_validate_implementation(void);
+
+#endif /* DD_VALIDATE_H */
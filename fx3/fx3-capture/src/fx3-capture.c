@@ -0,0 +1,447 @@
+/*
+ * fx3-capture.c - Domesday Duplicator capture and USB throughput benchmark
+ *
+ * Captures the RF sample stream to a file (or discards it, to measure
+ * the USB path alone) and reports:
+ * - Sustained throughput in MB/s
+ * - Transfer completion jitter
+ * - Sequence number gaps (packet header mode or packed/compressed framing)
+ *
+ * The 16-bit sample stream can also be checked (sequence number and test
+ * ramp) during the capture, or later from a file.  In soak mode the CRC
+ * at the end of every packet is checked instead.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "dd-capture.h"
+#include "dd-crc.h"
+#include "dd-validate.h"
+
+#define MB                  (1000.0 * 1000.0)
+#define READ_SIZE           (256 * DD_PACKET_SIZE)  /* Whole packets of any size */
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Print the statistics at the end of the capture */
+static void print_report(const dd_capture_stats_t *stats) {
+    double rate = (stats->elapsed_s > 0.0) ? (double)stats->bytes / MB / stats->elapsed_s : 0.0;
+
+    printf("\nCapture summary:\n");
+    printf("  Duration:            %.2f s\n", stats->elapsed_s);
+    printf("  Received:            %.1f MB (%llu transfers, %llu packets)\n",
+           (double)stats->bytes / MB, (unsigned long long)stats->transfers,
+           (unsigned long long)stats->packets);
+    printf("  Throughput:          %.1f MB/s\n", rate);
+    printf("  Written:             %.1f MB (%llu write errors)\n",
+           (double)stats->bytes_written / MB, (unsigned long long)stats->write_errors);
+    printf("  Short transfers:     %llu\n", (unsigned long long)stats->short_transfers);
+    printf("  Failed transfers:    %llu (%llu bytes received before failing)\n",
+           (unsigned long long)stats->failed_transfers, (unsigned long long)stats->failed_bytes);
+    printf("  Completion interval: mean %.1f us, stddev %.1f us, min %.1f us, max %.1f us\n",
+           stats->interval_mean_us, stats->interval_stddev_us,
+           stats->interval_min_us, stats->interval_max_us);
+    if (stats->framed_packets > 0) {
+        printf("  Sequence gaps:       %llu (%llu packets lost of %llu framed)\n",
+               (unsigned long long)stats->sequence_gaps, (unsigned long long)stats->packets_lost,
+               (unsigned long long)stats->framed_packets);
+        printf("  FPGA overflows:      %u\n", stats->overflow_count);
+    } else {
+        printf("  Sequence gaps:       not checked (enable -H or -P framing)\n");
+    }
+}
+
+/* Print the FPGA pipeline statistics from the last two reads
+ *
+ * The rates are from the differences, so the counters wrapping does not
+ * matter.  The buffer absorbs a stall of up to (banks - 1) packet times less
+ * the time taken to read a packet (one clock per bus word). */
+static void print_pipeline(const dd_pipeline_stats_t *previous, const dd_pipeline_stats_t *last) {
+    uint32_t clocks = last->clocks - previous->clocks;
+    uint32_t words = last->bus_words - previous->bus_words;
+    uint32_t packets = last->packets - previous->packets;
+    double clock_us = 1e6 / (double)last->clock_hz;
+
+    if (clocks == 0 || packets == 0) {
+        return;
+    }
+
+    printf("  FPGA bus words:      %.3f per clock\n", (double)words / (double)clocks);
+    printf("  FPGA service stall:  longest %.1f us, tolerated %.1f us, peak %u of %u banks waiting\n",
+           (double)last->stall_max * clock_us,
+           (((double)clocks * (double)(last->bank_count - 1) - (double)words) / (double)packets) * clock_us,
+           last->peak_banks_waiting, last->bank_count);
+}
+
+static void validate_callback(const uint8_t *data, size_t length, void *user) {
+    dd_validate(user, data, length);
+}
+
+static void print_validation(const dd_validator_t *validator) {
+    if (validator->flags & DD_VALIDATE_PACKET_CRC) {
+        printf("  Header CRCs:         %llu packets checked (%s), %llu wrong\n",
+               (unsigned long long)validator->packet_crc_packets, dd_crc32c_implementation(),
+               (unsigned long long)validator->packet_crc_errors);
+    }
+    if (validator->flags & DD_VALIDATE_NO_SAMPLES) {
+        return;
+    }
+    if (validator->flags & DD_VALIDATE_CRC) {
+        printf("  Packet CRCs:         %llu checked (%s), %llu wrong\n",
+               (unsigned long long)validator->crc_packets, dd_crc32c_implementation(),
+               (unsigned long long)validator->crc_errors);
+        if (validator->flags & DD_VALIDATE_HEADER) {
+            printf("  Packet headers:      %llu (%llu missing)\n", (unsigned long long)validator->packets,
+                   (unsigned long long)validator->header_errors);
+        }
+        if (validator->crc_errors > 0) {
+            printf("  First wrong CRC:     packet %llu\n", (unsigned long long)validator->first_crc_error);
+        }
+        return;
+    }
+
+    printf("  Validated samples:   %llu (%s%s, %s)\n", (unsigned long long)validator->samples,
+           "sequence", (validator->flags & DD_VALIDATE_RAMP) ? " and test ramp" : "",
+           dd_validate_implementation());
+    if (validator->flags & DD_VALIDATE_HEADER) {
+        printf("  Packet headers:      %llu (%llu missing)\n", (unsigned long long)validator->packets,
+               (unsigned long long)validator->header_errors);
+    }
+    printf("  Discontinuities:     %llu (%llu ramp, %llu sequence)\n",
+           (unsigned long long)validator->errors, (unsigned long long)validator->ramp_errors,
+           (unsigned long long)validator->sequence_errors);
+    if (validator->errors > 0) {
+        printf("  First discontinuity: sample %llu\n", (unsigned long long)validator->first_error);
+    }
+}
+
+/* Check a capture file */
+static int validate_file(const char *path, int flags, uint32_t packet_size) {
+    dd_validator_t validator;
+    uint8_t *buffer;
+    ssize_t length;
+    uint64_t total = 0;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open capture file");
+        return 1;
+    }
+    if (posix_memalign((void **)&buffer, 4096, READ_SIZE) != 0) {
+        fprintf(stderr, "Failed to allocate memory for the file buffer\n");
+        close(fd);
+        return 1;
+    }
+
+    dd_validate_init(&validator, flags);
+    dd_validate_set_packet_size(&validator, packet_size);
+    double start = monotonic_seconds();
+
+    /* Reads are whole packets (as the packet headers need) until the end of the file */
+    while ((length = read(fd, buffer, READ_SIZE)) > 0) {
+        dd_validate(&validator, buffer, (size_t)length);
+        total += (uint64_t)length;
+    }
+    if (length < 0) {
+        perror("Failed to read capture file");
+    }
+
+    double elapsed = monotonic_seconds() - start;
+    free(buffer);
+    close(fd);
+
+    printf("Validation of %s:\n", path);
+    printf("  Read:                %.1f MB in %.2f s (%.1f MB/s)\n", (double)total / MB, elapsed,
+           (elapsed > 0.0) ? (double)total / MB / elapsed : 0.0);
+    print_validation(&validator);
+
+    return (length < 0 || validator.errors > 0 || validator.header_errors > 0 ||
+            validator.crc_errors > 0 || validator.packet_crc_errors > 0) ? 1 : 0;
+}
+
+/* Print usage information */
+void print_usage(const char *prog) {
+    printf("Domesday Duplicator Capture\n\n");
+    printf("Usage: %s [OPTIONS]\n\n", prog);
+    printf("Options:\n");
+    printf("  -d DEVICE_IDX      Target device index (default: 0)\n");
+    printf("  -o FILE            Write the capture to FILE (default: discard)\n");
+    printf("  -q DEPTH           Transfers in flight (default: %d, max: %d)\n",
+           DD_QUEUE_DEPTH_DEFAULT, DD_QUEUE_DEPTH_MAX);
+    printf("  -k PACKETS         Packets per transfer (default: %d)\n", DD_TRANSFER_PACKETS_DEFAULT);
+    printf("  -p KBYTES          Packet size: 4, 8 or 16 KB (default: %d)\n", DD_PACKET_SIZE / 1024);
+    printf("  -t                 FPGA test mode (ramp data)\n");
+    printf("  -P                 10-bit packed samples\n");
+    printf("  -H                 Packet header mode\n");
+    printf("  -S                 Soak mode (PRBS data with a CRC per packet, with packet headers)\n");
+    printf("  -C                 Packet CRC mode (each header carries the previous packet's CRC)\n");
+    printf("  -2                 Two-channel mode (second ADC; both channels decimated and interleaved)\n");
+    printf("  -c VALUE           Raw configuration value (overrides -t, -P, -H, -S, -C and -2)\n");
+    printf("  -s SECONDS         Stop after SECONDS\n");
+    printf("  -n MBYTES          Stop after MBYTES have been received\n");
+    printf("  -N PACKETS         The device stops after exactly PACKETS packets\n");
+    printf("  -u                 Write through io_uring\n");
+    printf("  -D                 Do not open the output with O_DIRECT\n");
+    printf("  -Q                 Quiet (no per-second progress)\n");
+    printf("  -v                 Validate the samples during the capture\n");
+    printf("  -V FILE            Validate the samples in a capture file (with -t, -H, -S, -C and -p as captured)\n");
+    printf("  -h                 Show this help message\n\n");
+    printf("Examples:\n");
+    printf("  %s -t -H -s 30                 Benchmark the USB path for 30 seconds\n", prog);
+    printf("  %s -t -H -N 61035              Benchmark a fixed 1000 MB (61035 packets)\n", prog);
+    printf("  %s -H -o capture.raw           Capture to a file until Ctrl-C\n", prog);
+    printf("  %s -q 128 -k 8 -o capture.raw  Capture with a deeper transfer queue\n", prog);
+    printf("  %s -t -H -p 4 -k 16 -s 30      Benchmark with 4 KB packets (64 KB transfers)\n", prog);
+    printf("  %s -t -v -s 60                 Test mode soak with validation\n", prog);
+    printf("  %s -t -V capture.raw           Validate a test mode capture\n", prog);
+    printf("  %s -S -v -s 28800              Overnight soak checking every packet CRC\n", prog);
+    printf("  %s -C -v -o capture.raw        Capture checking every packet CRC\n", prog);
+    printf("\n");
+    printf("Notes:\n");
+    printf("  - Validation needs 16-bit samples (not packed, decimated, compressed or two-channel),\n");
+    printf("    except in soak mode (-S), where only the packet CRCs are checked\n");
+    printf("  - With -C and other sample formats only the packet CRCs are checked\n");
+    printf("  - The test ramp is only checked in test mode (-t)\n");
+    printf("  - With -2 the samples alternate between the channels, starting with channel A\n");
+    printf("    (the FPGA must be built with DUAL_ADC, otherwise the firmware ignores -2)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int opt, device_idx = 0, ret = 0;
+    int config_set = 0;
+    int quiet = 0;
+    int validate = 0;
+    const char *validate_path = NULL;
+    double duration = 0.0;
+    double limit_mb = 0.0;
+    uint32_t packet_limit = 0;
+    uint16_t configuration = 0;
+    dd_capture_config_t config;
+    dd_capture_t *cap;
+    dd_capture_stats_t stats;
+    dd_validator_t validator;
+
+    dd_capture_default_config(&config);
+
+    /* Parse command line arguments */
+    while ((opt = getopt(argc, argv, "d:o:q:k:p:tPHSC2c:s:n:N:uDQvV:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            device_idx = atoi(optarg);
+            break;
+        case 'o':
+            config.output_path = optarg;
+            break;
+        case 'q':
+            config.queue_depth = atoi(optarg);
+            break;
+        case 'k':
+            config.transfer_packets = atoi(optarg);
+            break;
+        case 'p':
+            config.packet_size = (uint32_t)atoi(optarg) * 1024;
+            break;
+        case 't':
+            configuration |= DD_CONFIG_TEST_MODE;
+            break;
+        case 'P':
+            configuration |= DD_CONFIG_PACKED;
+            break;
+        case 'H':
+            configuration |= DD_CONFIG_HEADER;
+            break;
+        case 'S':
+            configuration |= DD_CONFIG_SOAK | DD_CONFIG_HEADER;
+            break;
+        case 'C':
+            configuration |= DD_CONFIG_PACKET_CRC | DD_CONFIG_HEADER;
+            break;
+        case '2':
+            configuration |= DD_CONFIG_TWO_CHANNEL;
+            break;
+        case 'c':
+            config.configuration = (uint16_t)strtoul(optarg, NULL, 0);
+            config_set = 1;
+            break;
+        case 's':
+            duration = atof(optarg);
+            break;
+        case 'n':
+            limit_mb = atof(optarg);
+            break;
+        case 'N':
+            packet_limit = (uint32_t)strtoul(optarg, NULL, 0);
+            config.packet_limit = packet_limit;
+            break;
+        case 'u':
+            config.use_io_uring = 1;
+            break;
+        case 'D':
+            config.use_direct = 0;
+            break;
+        case 'Q':
+            quiet = 1;
+            break;
+        case 'v':
+            validate = 1;
+            break;
+        case 'V':
+            validate_path = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            fprintf(stderr, "Unknown option: -%c\n", opt);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!config_set) {
+        config.configuration = configuration;
+    }
+    if (config.packet_size != DD_PACKET_SIZE && config.packet_size != DD_PACKET_SIZE / 2 &&
+        config.packet_size != DD_PACKET_SIZE_MIN) {
+        fprintf(stderr, "Error: the packet size must be 4, 8 or 16 KB\n");
+        return 1;
+    }
+
+    if (validate || validate_path) {
+        int flags = 0;
+
+        if (config.configuration & DD_CONFIG_PACKET_CRC) {
+            flags |= DD_VALIDATE_PACKET_CRC;
+        }
+        if (config.configuration & DD_CONFIG_SOAK) {
+            flags |= DD_VALIDATE_CRC;
+        } else if ((config.configuration & (DD_CONFIG_PACKED | DD_CONFIG_DECIMATION | DD_CONFIG_COMPRESSED | DD_CONFIG_TWO_CHANNEL)) &&
+                   (flags & DD_VALIDATE_PACKET_CRC)) {
+            flags |= DD_VALIDATE_NO_SAMPLES;
+        } else if (config.configuration & (DD_CONFIG_PACKED | DD_CONFIG_DECIMATION | DD_CONFIG_COMPRESSED | DD_CONFIG_TWO_CHANNEL)) {
+            fprintf(stderr, "Error: validation needs 16-bit samples (not packed, decimated, compressed or two-channel)\n");
+            return 1;
+        }
+        if (config.configuration & DD_CONFIG_TEST_MODE) {
+            flags |= DD_VALIDATE_RAMP;
+        }
+        if (config.configuration & DD_CONFIG_HEADER) {
+            flags |= DD_VALIDATE_HEADER;
+        }
+
+        if (validate_path) {
+            return validate_file(validate_path, flags, config.packet_size);
+        }
+
+        dd_validate_init(&validator, flags);
+        dd_validate_set_packet_size(&validator, config.packet_size);
+        config.data_cb = validate_callback;
+        config.data_cb_user = &validator;
+    }
+
+    if (dd_capture_open(&cap, &config, device_idx) != 0) {
+        return 1;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    printf("Capturing %s (%d transfers of %u KB in flight, %u KB packets, configuration 0x%02X)\n",
+           config.output_path ? config.output_path : "to nowhere",
+           config.queue_depth, (unsigned)config.transfer_packets * config.packet_size / 1024,
+           config.packet_size / 1024, config.configuration);
+
+    if (dd_capture_start(cap) != 0) {
+        dd_capture_stop(cap);
+        dd_capture_close(cap);
+        return 1;
+    }
+
+    double start = monotonic_seconds();
+    double last_report = start;
+    uint64_t last_bytes = 0;
+    dd_pipeline_stats_t pipeline, pipeline_previous, pipeline_last;
+    int pipeline_reads = 0;
+
+    while (!stop_requested) {
+        if (dd_capture_poll(cap, 100) != 0) {
+            fprintf(stderr, "Error: device disconnected\n");
+            ret = 1;
+            break;
+        }
+
+        double now = monotonic_seconds();
+        dd_capture_get_stats(cap, &stats);
+
+        if (now - last_report >= 1.0) {
+            /* The FPGA statistics are reset when collection stops, so they
+             * are read whilst the capture runs */
+            if (dd_capture_get_pipeline_stats(cap, &pipeline) == 0 &&
+                pipeline.bank_count != 0 && pipeline.clocks != 0) {
+                pipeline_previous = (pipeline_reads > 0) ? pipeline_last : pipeline;
+                pipeline_last = pipeline;
+                pipeline_reads++;
+            }
+
+            if (!quiet) {
+                printf("  %6.1f s  %7.1f MB/s  %8.1f MB  gaps %llu\n", now - start,
+                       (double)(stats.bytes - last_bytes) / MB / (now - last_report),
+                       (double)stats.bytes / MB, (unsigned long long)stats.sequence_gaps);
+                fflush(stdout);
+            }
+            last_bytes = stats.bytes;
+            last_report = now;
+        }
+
+        if (duration > 0.0 && now - start >= duration) {
+            break;
+        }
+        if (limit_mb > 0.0 && (double)stats.bytes >= limit_mb * MB) {
+            break;
+        }
+        if (packet_limit > 0 && stats.packets >= packet_limit) {
+            break;
+        }
+    }
+
+    if (dd_capture_stop(cap) != 0) {
+        fprintf(stderr, "Warning: not all transfers finished\n");
+    }
+
+    dd_capture_get_stats(cap, &stats);
+    print_report(&stats);
+    if (pipeline_reads > 1) {
+        print_pipeline(&pipeline_previous, &pipeline_last);
+    }
+    if (validate) {
+        print_validation(&validator);
+    }
+    dd_capture_close(cap);
+
+    if (stats.write_errors > 0 ||
+        (validate && (validator.errors > 0 || validator.crc_errors > 0 || validator.packet_crc_errors > 0))) {
+        ret = 1;
+    }
+    return ret;
+}
@@ -0,0 +1,289 @@
+/************************************************************************
+
+	benchmark.c
+
+	FX3 Firmware throughput benchmark (benchmark firmware only)
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "benchmark.h"
+#include "telemetry.h"
+#include "command-queue.h"
+#include "trace.h"
+
+// The benchmark measures the sustained throughput for every combination of
+// USB 3 burst length and DMA buffer count, from one of two sources:
+//
+// - GPIF: the FPGA test pattern through the P-port, GPIF threads and DMA
+//   multi-channel (the capture data path), measured from the telemetry
+//   counters as for the self-test
+// - Internal: the FX3 CPU commits DMA buffers straight to the USB consumer
+//   socket, without the GPIF or the FPGA.  The buffers are filled once with a
+//   packet header (see buffer.v) and the test ramp; after that only the
+//   sample index and the sequence number in the header are updated, so the
+//   host can check for lost packets with the packet header sequence numbers
+//   but the samples do not follow on from one packet to the next
+//
+// Comparing the two tells FPGA and GPIF limits apart from FX3, USB and host
+// limits.  The host must keep reading the bulk end-point for the whole
+// benchmark (about CY_FX_BENCHMARK_POINTS x 0.6 seconds).
+//
+// The results are written by the command thread and read by the USB set-up
+// callback, so all access is made with the interrupts disabled.
+static domDupBenchmark_t glBenchmark = {
+	CY_FX_BENCHMARK_VERSION, CY_FX_BENCHMARK_IDLE, CY_FX_BENCHMARK_SOURCE_GPIF,
+	CY_FX_BENCHMARK_POINTS, CY_FX_BENCHMARK_NO_POINT
+};
+
+static const uint16_t glBenchmarkBurstLengths[CY_FX_BENCHMARK_BURST_LENGTHS] = { 1, 2, 4, 8, 16 };
+static const uint16_t glBenchmarkBufferCounts[CY_FX_BENCHMARK_BUFFER_COUNTS] = { 2, 3, 4, CY_FX_STREAM_BUF_COUNT_MAX };
+
+// Set the benchmark state
+static void domDupBenchmarkSetState(uint8_t state, uint8_t source)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glBenchmark.state = state;
+	glBenchmark.source = source;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Stream the FPGA test pattern through the GPIF and measure the throughput
+static CyU3PReturnStatus_t domDupBenchmarkGpif(const domDupStreamProfile_t *settings, domDupBenchmarkResult_t *result)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	domDupTelemetry_t start;
+	domDupTelemetry_t end;
+
+	apiReturnStatus = domDupSetStreamSettings(settings);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 1);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	// Let the host's transfers get going before measuring
+	CyU3PThreadSleep(CY_FX_BENCHMARK_SETTLE_MS);
+	domDupTelemetrySnapshot(&start);
+	CyU3PThreadSleep(CY_FX_BENCHMARK_MEASURE_MS);
+	domDupTelemetrySnapshot(&end);
+
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0);
+
+	result->durationMs = end.uptimeMs - start.uptimeMs;
+	if (result->durationMs != 0) {
+		result->throughputKBps = (uint32_t)((end.consumedBytes - start.consumedBytes) / result->durationMs);
+	}
+	result->errors = (end.pibErrors - start.pibErrors) + (end.overflowEvents - start.overflowEvents);
+
+	return apiReturnStatus;
+}
+
+// Fill a DMA buffer with a packet header and the test ramp
+static void domDupBenchmarkFillBuffer(uint8_t *buffer)
+{
+	uint16_t *words = (uint16_t *)buffer;
+	uint16_t sample = 0;
+	uint32_t i;
+
+	words[0] = 0xDD10;							// Packet header marker
+	words[1] = 0x0005;							// Flags: header present, test mode
+	for (i = 2; i < 8; i++) words[i] = 0;
+	for (i = 8; i < (CY_FX_DMA_BUF_SIZE / 2); i++) {
+		words[i] = sample;
+		sample = (sample == 1020) ? 0 : sample + 1;
+	}
+}
+
+// Commit DMA buffers from the CPU to the USB end-point and measure the
+// throughput
+//
+// The channel has as many buffers as the multi-channel would have for both
+// producer sockets, so the DMA pools are the same size.  The throughput is
+// measured from the buffers committed; once the pool is full a buffer can only
+// be committed after one has been consumed, so this is the USB rate.
+static CyU3PReturnStatus_t domDupBenchmarkInternal(const domDupStreamProfile_t *settings, domDupBenchmarkResult_t *result)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	CyU3PDmaChannelConfig_t dmaConfig;
+	CyU3PDmaChannel dmaChHandle;
+	CyU3PDmaBuffer_t buffer;
+	uint32_t bufferCount = settings->bufferCount * CY_FX_DMA_PRODUCER_SOCKETS;
+	uint32_t filled = 0;
+	uint32_t startTime;
+	uint32_t now;
+	uint64_t bytes = 0;
+	uint64_t sampleIndex = 0;
+	uint16_t sequence = 0;
+	uint16_t *words;
+
+	// The FPGA is not used
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	apiReturnStatus = domDupConfigureConsumerEp(settings->burstLength);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	CyU3PMemSet((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size = CY_FX_DMA_BUF_SIZE;
+	dmaConfig.count = bufferCount;
+	dmaConfig.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId = CY_FX_EP_CONSUMER_SOCKET;
+	dmaConfig.dmaMode = CY_U3P_DMA_MODE_BYTE;
+
+	apiReturnStatus = CyU3PDmaChannelCreate(&dmaChHandle, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupBenchmarkInternal(): CyU3PDmaChannelCreate failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
+	}
+
+	apiReturnStatus = CyU3PDmaChannelSetXfer(&dmaChHandle, 0);
+	startTime = CyU3PGetTime();
+	now = startTime;
+
+	while ((apiReturnStatus == CY_U3P_SUCCESS) &&
+		((now - startTime) < (CY_FX_BENCHMARK_SETTLE_MS + CY_FX_BENCHMARK_MEASURE_MS))) {
+		apiReturnStatus = CyU3PDmaChannelGetBuffer(&dmaChHandle, &buffer, CY_FX_BENCHMARK_BUFFER_WAIT_MS);
+		if (apiReturnStatus != CY_U3P_SUCCESS) {
+			// The host isn't reading (or the device has been disconnected)
+			result->errors++;
+			break;
+		}
+
+		// Fill each buffer the first time round the ring, then just update
+		// the sample index and the sequence number
+		words = (uint16_t *)buffer.buffer;
+		if (filled < bufferCount) {
+			domDupBenchmarkFillBuffer(buffer.buffer);
+			filled++;
+		}
+		words[2] = (uint16_t)sampleIndex;
+		words[3] = (uint16_t)(sampleIndex >> 16);
+		words[4] = (uint16_t)(sampleIndex >> 32);
+		words[7] = sequence++;
+		sampleIndex += (CY_FX_DMA_BUF_SIZE / 2) - 8;
+
+		apiReturnStatus = CyU3PDmaChannelCommitBuffer(&dmaChHandle, CY_FX_DMA_BUF_SIZE, 0);
+
+		now = CyU3PGetTime();
+		if ((now - startTime) >= CY_FX_BENCHMARK_SETTLE_MS) bytes += CY_FX_DMA_BUF_SIZE;
+	}
+
+	if ((now - startTime) > CY_FX_BENCHMARK_SETTLE_MS) {
+		result->durationMs = (now - startTime) - CY_FX_BENCHMARK_SETTLE_MS;
+		result->throughputKBps = (uint32_t)(bytes / result->durationMs);
+	}
+
+	CyU3PDmaChannelDestroy(&dmaChHandle);
+	CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+	return apiReturnStatus;
+}
+
+// Run the benchmark (called from the command thread)
+//
+// Data collection is stopped when the benchmark completes, and the stream
+// profile and the configuration the host selected are restored.
+CyU3PReturnStatus_t domDupBenchmarkRun(uint16_t source)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t restoreStatus;
+	domDupBenchmarkResult_t result;
+	domDupStreamProfile_t savedSettings;
+	domDupStreamProfile_t settings;
+	uint16_t savedConfiguration;
+	uint16_t burst;
+	uint16_t count;
+	uint16_t point;
+	uint32_t bestThroughput = 0;
+	uint32_t intMask;
+
+	if (source >= CY_FX_BENCHMARK_SOURCES) return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	domDupGetStreamProfileSettings(domDupGetStreamProfile(), &savedSettings);
+	savedConfiguration = domDupGetRequestedConfiguration();
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemSet((uint8_t *)glBenchmark.result, 0, sizeof(glBenchmark.result));
+	glBenchmark.bestPoint = CY_FX_BENCHMARK_NO_POINT;
+	CyU3PVicEnableInterrupts(intMask);
+	domDupBenchmarkSetState(CY_FX_BENCHMARK_RUNNING, (uint8_t)source);
+
+	// Stop collection and switch the FPGA to the test pattern (with packet
+	// headers, so both sources send the same format)
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0);
+	if (apiReturnStatus == CY_U3P_SUCCESS) {
+		apiReturnStatus = domDupApplyConfiguration(CY_FX_CONFIG_TEST_MODE | CY_FX_CONFIG_PACKET_HEADER);
+	}
+	if ((apiReturnStatus == CY_U3P_SUCCESS) && (source == CY_FX_BENCHMARK_SOURCE_INTERNAL)) domDupReleaseDataPath();
+
+	for (point = 0; (point < CY_FX_BENCHMARK_POINTS) && (apiReturnStatus == CY_U3P_SUCCESS); point++) {
+		burst = point / CY_FX_BENCHMARK_BUFFER_COUNTS;
+		count = point % CY_FX_BENCHMARK_BUFFER_COUNTS;
+
+		settings.burstLength = glBenchmarkBurstLengths[burst];
+		settings.bufferCount = glBenchmarkBufferCounts[count];
+		if (settings.bufferCount == CY_FX_STREAM_BUF_COUNT_MAX) settings.bufferCount = CY_FX_DMA_BUF_COUNT_MAX;
+
+		// Skip buffer counts the heap can't hold (or already measured as the maximum)
+		if ((settings.bufferCount > CY_FX_DMA_BUF_COUNT_MAX) ||
+			((glBenchmarkBufferCounts[count] != CY_FX_STREAM_BUF_COUNT_MAX) &&
+			(settings.bufferCount == CY_FX_DMA_BUF_COUNT_MAX))) continue;
+
+		CyU3PMemSet((uint8_t *)&result, 0, sizeof(result));
+		result.burstLength = settings.burstLength;
+		result.bufferCount = settings.bufferCount;
+
+		if (source == CY_FX_BENCHMARK_SOURCE_GPIF) {
+			apiReturnStatus = domDupBenchmarkGpif(&settings, &result);
+		} else {
+			apiReturnStatus = domDupBenchmarkInternal(&settings, &result);
+		}
+		domDupTrace(CY_FX_TRACE_BENCHMARK, (source << 16) | (settings.burstLength << 8) | settings.bufferCount,
+			result.throughputKBps);
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupBenchmarkRun(): Source %d, burst %d, %d buffers: %d KB/s, %d errors\r\n",
+			source, settings.burstLength, settings.bufferCount, result.throughputKBps, result.errors);
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glBenchmark.result[point], (uint8_t *)&result, sizeof(result));
+		if ((apiReturnStatus == CY_U3P_SUCCESS) && (result.errors == 0) &&
+			(result.throughputKBps > bestThroughput)) {
+			bestThroughput = result.throughputKBps;
+			glBenchmark.bestPoint = point;
+		}
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	// Restore the host's settings (unless the application has been stopped)
+	if (domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0) == CY_U3P_SUCCESS) {
+		restoreStatus = domDupSetStreamSettings(&savedSettings);
+		if (restoreStatus != CY_U3P_SUCCESS) domDupErrorHandler(restoreStatus);
+		domDupApplyConfiguration(savedConfiguration);
+	}
+
+	domDupBenchmarkSetState((apiReturnStatus == CY_U3P_SUCCESS) ? CY_FX_BENCHMARK_DONE : CY_FX_BENCHMARK_ABORTED,
+		(uint8_t)source);
+	return apiReturnStatus;
+}
+
+// Copy the benchmark results (for sending to the host)
+void domDupBenchmarkGetResults(domDupBenchmark_t *results)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)results, (uint8_t *)&glBenchmark, sizeof(glBenchmark));
+	CyU3PVicEnableInterrupts(intMask);
+}
@@ -0,0 +1,76 @@
+/************************************************************************
+
+	benchmark.h
+
+	FX3 Firmware throughput benchmark (benchmark firmware only)
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+#include "domesday-duplicator.h"
+
+// Version of the domDupBenchmark_t structure returned to the host
+#define CY_FX_BENCHMARK_VERSION         (1)
+
+// Data sources (CY_FX_VREQ_BENCHMARK wValue)
+#define CY_FX_BENCHMARK_SOURCE_GPIF     (0) // FPGA test pattern through the GPIF (P-port to USB)
+#define CY_FX_BENCHMARK_SOURCE_INTERNAL (1) // FX3 CPU producer socket (socket to USB only)
+#define CY_FX_BENCHMARK_SOURCES         (2)
+
+// Burst lengths and DMA buffer counts (per producer socket) measured; every
+// combination is measured, burst length first
+#define CY_FX_BENCHMARK_BURST_LENGTHS   (5) // 1, 2, 4, 8 and 16
+#define CY_FX_BENCHMARK_BUFFER_COUNTS   (4) // 2, 3, 4 and CY_FX_DMA_BUF_COUNT_MAX
+#define CY_FX_BENCHMARK_POINTS          (CY_FX_BENCHMARK_BURST_LENGTHS * CY_FX_BENCHMARK_BUFFER_COUNTS)
+
+// Time each combination streams for before (settle) and whilst (measure) the
+// throughput is measured
+#define CY_FX_BENCHMARK_SETTLE_MS       (100)
+#define CY_FX_BENCHMARK_MEASURE_MS      (500)
+
+// Longest wait for a free DMA buffer (internal source) before giving up
+#define CY_FX_BENCHMARK_BUFFER_WAIT_MS  (1000)
+
+// Benchmark states
+#define CY_FX_BENCHMARK_IDLE            (0) // Not run since power-on
+#define CY_FX_BENCHMARK_RUNNING         (1) // Running (the results are incomplete)
+#define CY_FX_BENCHMARK_DONE            (2) // Completed
+#define CY_FX_BENCHMARK_ABORTED         (3) // Stopped early (device disconnected, or the host stopped reading)
+
+// bestPoint when no combination streamed without errors
+#define CY_FX_BENCHMARK_NO_POINT        (0xFFFF)
+
+// Benchmark result for one burst length and buffer count
+typedef struct {
+	uint16_t burstLength;			// USB 3 end-point burst length
+	uint16_t bufferCount;			// DMA buffers per producer socket (0 = not measured)
+	uint32_t durationMs;			// Measurement time in milliseconds
+	uint32_t throughputKBps;		// Sustained throughput in Kbytes (1000 bytes) per second
+	uint32_t errors;				// PIB/GPIF errors and FPGA overflows (GPIF), or DMA buffer timeouts (internal)
+} domDupBenchmarkResult_t;
+
+// Response to CY_FX_VREQ_GET_BENCHMARK (little-endian)
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_BENCHMARK_VERSION)
+	uint8_t state;					// Benchmark state (CY_FX_BENCHMARK_*)
+	uint8_t source;					// Data source (CY_FX_BENCHMARK_SOURCE_*)
+	uint16_t pointCount;			// Number of entries in result
+	uint16_t bestPoint;				// Fastest entry without errors (or CY_FX_BENCHMARK_NO_POINT)
+	domDupBenchmarkResult_t result[CY_FX_BENCHMARK_POINTS];
+} domDupBenchmark_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupBenchmarkRun(uint16_t source);
+void domDupBenchmarkGetResults(domDupBenchmark_t *results);
+
+#include <cyu3externcend.h>
+
+#endif // _BENCHMARK_H_
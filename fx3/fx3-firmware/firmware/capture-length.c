@@ -0,0 +1,171 @@
+/************************************************************************
+
+	capture-length.c
+
+	FX3 Firmware capture length (automatic stop)
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "capture-length.h"
+#include "command-queue.h"
+#include "fpga-registers.h"
+#include "trace.h"
+
+// The host sets the capture length in packets (CY_FX_VREQ_CAPTURE_LENGTH)
+// before starting data collection.  The FPGA stops sending packets to the GPIF
+// once that many have been sent (see captureLength.v), so the capture ends on
+// exactly the requested packet whatever the host's reaction time.  Whilst the
+// capture is running the application thread checks the FPGA status; once the
+// last packet has been sent it queues CY_FX_COMMAND_CAPTURE_COMPLETE and the
+// command thread stops data collection as if the host had sent a stop.  The
+// packets already in the DMA buffers are still sent to the host, followed by
+// a zero length packet which ends the host's partly filled transfer (the end
+// of the stream).  The host can also check CY_FX_VREQ_GET_CAPTURE_LENGTH.
+//
+// The state is changed by both the command and the application threads and
+// copied by the USB set-up callback, so all access is made with the interrupts
+// disabled.  The capture number tells the threads apart from a capture that
+// has been stopped and started again in the meantime.
+static domDupCaptureLength_t glCaptureLength;
+static CyBool_t glCompletePosted = CyFalse;
+static uint32_t glLastPollTime = 0;
+
+// Carry out CY_FX_VREQ_CAPTURE_LENGTH (called from the command thread whilst
+// data collection is stopped)
+CyU3PReturnStatus_t domDupCaptureLengthCommand(uint16_t value)
+{
+	uint32_t packetLimit = glCaptureLength.packetLimit;
+	uint32_t setting = value & CY_FX_CAPTURE_SET_MASK;
+	uint32_t intMask;
+
+	if (value & CY_FX_CAPTURE_SET_HIGH) {
+		packetLimit = (packetLimit & CY_FX_CAPTURE_SET_MASK) | (setting << 15);
+	} else {
+		packetLimit = (packetLimit & ~CY_FX_CAPTURE_SET_MASK) | setting;
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glCaptureLength.packetLimit = packetLimit;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_CAPTURE_LENGTH, packetLimit);
+}
+
+// Data collection has been started (called from the command thread once the
+// FPGA sample path has been reset)
+void domDupCaptureLengthStart(void)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glCaptureLength.captureNumber++;
+	glCaptureLength.packetsSent = 0;
+	glCaptureLength.state = (glCaptureLength.packetLimit != 0) ? CY_FX_CAPTURE_RUNNING : CY_FX_CAPTURE_UNLIMITED;
+	glCompletePosted = CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Data collection is being stopped by the host, a suspend or a reset
+//
+// With readStatus set (from the command thread) the final count is read from
+// the FPGA, so this must be called before collectData is lowered (which clears
+// the count).  The USB event callback can't wait for the register interface,
+// so it leaves the count as last polled.
+void domDupCaptureLengthStop(CyBool_t readStatus)
+{
+	uint32_t status = 0;
+	uint32_t intMask;
+
+	if (glCaptureLength.state != CY_FX_CAPTURE_RUNNING) return;
+	if (readStatus && (domDupFpgaRegisterRead(CY_FX_FPGA_REG_CAPTURE_STATUS, &status) != CY_U3P_SUCCESS)) status = 0;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (glCaptureLength.state == CY_FX_CAPTURE_RUNNING) {
+		if (status != 0) glCaptureLength.packetsSent = status & CY_FX_FPGA_CAPTURE_SENT_MASK;
+		glCaptureLength.state = (status & CY_FX_FPGA_CAPTURE_DONE) ? CY_FX_CAPTURE_COMPLETE : CY_FX_CAPTURE_STOPPED;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Check a running capture (called from the main application loop)
+void domDupCaptureLengthUpdate(void)
+{
+	uint32_t captureNumber;
+	uint32_t status;
+	uint32_t intMask;
+	uint32_t now;
+
+	// Queue the stop again if the command queue was full
+	if ((glCaptureLength.state == CY_FX_CAPTURE_COMPLETE) && !glCompletePosted) {
+		glCompletePosted = domDupCommandPost(CY_FX_COMMAND_CAPTURE_COMPLETE, (uint16_t)glCaptureLength.captureNumber);
+		return;
+	}
+	if (glCaptureLength.state != CY_FX_CAPTURE_RUNNING) return;
+
+	now = CyU3PGetTime();
+	if ((now - glLastPollTime) < CY_FX_CAPTURE_LENGTH_POLL_MS) return;
+	glLastPollTime = now;
+
+	captureNumber = glCaptureLength.captureNumber;
+	if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_CAPTURE_STATUS, &status) != CY_U3P_SUCCESS) return;
+
+	// Discard the status if the capture was stopped whilst it was read
+	intMask = CyU3PVicDisableAllInterrupts();
+	if ((captureNumber != glCaptureLength.captureNumber) || (glCaptureLength.state != CY_FX_CAPTURE_RUNNING)) {
+		CyU3PVicEnableInterrupts(intMask);
+		return;
+	}
+	glCaptureLength.packetsSent = status & CY_FX_FPGA_CAPTURE_SENT_MASK;
+	if (status & CY_FX_FPGA_CAPTURE_DONE) glCaptureLength.state = CY_FX_CAPTURE_COMPLETE;
+	CyU3PVicEnableInterrupts(intMask);
+
+	if (status & CY_FX_FPGA_CAPTURE_DONE) {
+		domDupTrace(CY_FX_TRACE_CAPTURE_COMPLETE, captureNumber, status & CY_FX_FPGA_CAPTURE_SENT_MASK);
+		glCompletePosted = domDupCommandPost(CY_FX_COMMAND_CAPTURE_COMPLETE, (uint16_t)captureNumber);
+	}
+}
+
+// Check whether the capture queued by CY_FX_COMMAND_CAPTURE_COMPLETE is still
+// the current one (called from the command thread)
+CyBool_t domDupCaptureLengthIsComplete(uint16_t captureNumber)
+{
+	return ((glCaptureLength.state == CY_FX_CAPTURE_COMPLETE) &&
+			((uint16_t)glCaptureLength.captureNumber == captureNumber)) ? CyTrue : CyFalse;
+}
+
+// Mark the end of a completed capture with a zero length packet (called from
+// the command thread once data collection has been stopped)
+//
+// The multi-channel consumes the producer sockets in turn from socket 0, so
+// the buffer after the last packet is on the socket that would have received
+// the next packet.  Wrapping that buffer up whilst it is empty commits it with
+// no data, which the consumer end-point sends as a zero length packet once
+// the packets before it have been sent.
+CyU3PReturnStatus_t domDupCaptureLengthEndStream(CyU3PDmaMultiChannel *handle)
+{
+	return CyU3PDmaMultiChannelSetWrapUp(handle, glCaptureLength.packetsSent % CY_FX_DMA_PRODUCER_SOCKETS);
+}
+
+// Copy the capture length state (called from the USB set-up callback)
+void domDupCaptureLengthSnapshot(domDupCaptureLength_t *snapshot)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)snapshot, (uint8_t *)&glCaptureLength, sizeof(glCaptureLength));
+	CyU3PVicEnableInterrupts(intMask);
+
+	snapshot->version = CY_FX_CAPTURE_LENGTH_VERSION;
+	snapshot->reserved = 0;
+}
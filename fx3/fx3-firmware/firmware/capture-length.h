@@ -0,0 +1,60 @@
+/************************************************************************
+
+	capture-length.h
+
+	FX3 Firmware capture length (automatic stop)
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _CAPTURE_LENGTH_H_
+#define _CAPTURE_LENGTH_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+#include "cyu3dma.h"
+
+// Version of the domDupCaptureLength_t structure returned to the host
+#define CY_FX_CAPTURE_LENGTH_VERSION    (1)
+
+// Interval between checks of the FPGA status whilst a capture with a length
+// is running (10 ms is about 50 packets at 40 MSPS)
+#define CY_FX_CAPTURE_LENGTH_POLL_MS    (10)
+
+// CY_FX_VREQ_CAPTURE_LENGTH wValue: bit 15 selects which half of the length
+// (in packets) bits 14-0 are written to
+#define CY_FX_CAPTURE_SET_HIGH          (0x8000) // Bits 29-15 of the length (otherwise bits 14-0)
+#define CY_FX_CAPTURE_SET_MASK          (0x7FFF)
+#define CY_FX_CAPTURE_LENGTH_MAX        (0x3FFFFFFF)
+
+// Capture states
+#define CY_FX_CAPTURE_UNLIMITED         (0) // No length set (the host stops the capture)
+#define CY_FX_CAPTURE_RUNNING           (1) // Collecting, the length has not been reached
+#define CY_FX_CAPTURE_COMPLETE          (2) // Stopped automatically once the length was sent
+#define CY_FX_CAPTURE_STOPPED           (3) // Stopped before the length was reached
+
+// Response to CY_FX_VREQ_GET_CAPTURE_LENGTH (little-endian)
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_CAPTURE_LENGTH_VERSION)
+	uint8_t state;					// State of the last capture (CY_FX_CAPTURE_*)
+	uint8_t reserved;
+	uint32_t packetLimit;			// Capture length in packets (0 = no limit)
+	uint32_t packetsSent;			// Packets sent by the FPGA in the last capture (with a length set)
+	uint32_t captureNumber;			// Captures started since power-on
+} domDupCaptureLength_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupCaptureLengthCommand(uint16_t value);
+void domDupCaptureLengthStart(void);
+void domDupCaptureLengthStop(CyBool_t readStatus);
+void domDupCaptureLengthUpdate(void);
+CyBool_t domDupCaptureLengthIsComplete(uint16_t captureNumber);
+CyU3PReturnStatus_t domDupCaptureLengthEndStream(CyU3PDmaMultiChannel *handle);
+void domDupCaptureLengthSnapshot(domDupCaptureLength_t *snapshot);
+
+#include <cyu3externcend.h>
+
+#endif // _CAPTURE_LENGTH_H_
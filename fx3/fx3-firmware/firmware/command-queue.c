@@ -0,0 +1,142 @@
+/************************************************************************
+
+	command-queue.c
+
+	FX3 Firmware vendor command queue
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "command-queue.h"
+#include "trace.h"
+#include "fpga-status.h"
+
+// Host to device vendor commands are not carried out in the USB set-up
+// callback (which runs in the USB driver thread and holds up EP0 until it
+// returns).  The callback only adds the command to the queue and ACKs the
+// request; the command thread then carries the commands out in order.  The
+// host reads the result back with CY_FX_VREQ_GET_COMMAND_STATUS.
+static CyU3PThread glCommandThread;
+static CyU3PQueue glCommandQueue;
+static uint32_t glCommandQueueStorage[CY_FX_COMMAND_QUEUE_LENGTH];
+
+// The status is updated from the command thread and the USB driver thread, so
+// all access is made with the interrupts disabled
+static domDupCommandStatus_t glCommandStatus;
+
+// Create the command queue and start the command thread (call once before the
+// USB is started)
+void domDupCommandInitialise(void)
+{
+	void *ptr = NULL;
+	uint32_t returnCode = CY_U3P_SUCCESS;
+
+	CyU3PMemSet((uint8_t *)&glCommandStatus, 0, sizeof(glCommandStatus));
+
+	returnCode = CyU3PQueueCreate(&glCommandQueue, sizeof(domDupCommand_t) / sizeof(uint32_t),
+		glCommandQueueStorage, sizeof(glCommandQueueStorage));
+	if (returnCode != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCommandInitialise(): CyU3PQueueCreate failed, Error code = %d\r\n", returnCode);
+		domDupErrorHandler(returnCode);
+	}
+
+	// Allocate the memory for the thread
+	ptr = CyU3PMemAlloc(CY_FX_COMMAND_THREAD_STACK);
+	if (ptr == NULL) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCommandInitialise(): CyU3PMemAlloc failed\r\n");
+		domDupErrorHandler(CY_U3P_ERROR_MEMORY_ERROR);
+	}
+
+	returnCode = CyU3PThreadCreate(
+		&glCommandThread,					// Command thread structure
+		"29:domDupCmd",						// Thread ID and thread name
+		domDupCommandThread,				// Command thread entry function
+		0,									// No input parameter to thread
+		ptr,								// Pointer to the allocated thread stack
+		CY_FX_COMMAND_THREAD_STACK,			// Command thread stack size
+		CY_FX_COMMAND_THREAD_PRIORITY,		// Command thread priority
+		CY_FX_COMMAND_THREAD_PRIORITY,		// Command thread priority
+		CYU3P_NO_TIME_SLICE,				// No time slice for the command thread
+		CYU3P_AUTO_START					// Start the thread immediately
+		);
+	if (returnCode != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCommandInitialise(): CyU3PThreadCreate failed, Error code = %d\r\n", returnCode);
+		domDupErrorHandler(returnCode);
+	}
+}
+
+// Add a command to the queue (called from the USB set-up callback)
+//
+// Does not wait; returns CyFalse if the queue is full (the request should be
+// stalled so the host knows the command was not accepted).
+CyBool_t domDupCommandPost(uint8_t request, uint16_t value)
+{
+	domDupCommand_t command;
+	uint32_t intMask;
+	CyBool_t accepted;
+
+	command.request = request;
+	command.reserved = 0;
+	command.value = value;
+
+	accepted = (CyU3PQueueSend(&glCommandQueue, &command, CYU3P_NO_WAIT) == CY_U3P_SUCCESS);
+	if (!accepted) domDupTrace(CY_FX_TRACE_COMMAND_REJECTED, request, value);
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (accepted) glCommandStatus.accepted++;
+	else glCommandStatus.rejected++;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return accepted;
+}
+
+// Copy the current command status (for sending to the host)
+void domDupCommandGetStatus(domDupCommandStatus_t *status)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)status, (uint8_t *)&glCommandStatus, sizeof(glCommandStatus));
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Command thread: carry out the queued commands in order
+void domDupCommandThread(uint32_t input)
+{
+	domDupCommand_t command;
+	CyU3PReturnStatus_t commandStatus;
+	uint32_t intMask;
+
+	while (1) {
+		if (CyU3PQueueReceive(&glCommandQueue, &command, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS) continue;
+
+		commandStatus = domDupRunCommand(command.request, command.value);
+
+		// Read the FPGA status again before the command is reported as
+		// complete (see fpga-status.c)
+		domDupFpgaStatusUpdate(CyTrue);
+		domDupTrace(CY_FX_TRACE_COMMAND, command.request | ((uint32_t)command.value << 16), commandStatus);
+		if (commandStatus != CY_U3P_SUCCESS) {
+			domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCommandThread(): Command 0x%x (wValue = 0x%x) failed, Error code = %d\r\n",
+				command.request, command.value, commandStatus);
+		}
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		glCommandStatus.completed++;
+		if (commandStatus != CY_U3P_SUCCESS) glCommandStatus.failed++;
+		glCommandStatus.lastStatus = commandStatus;
+		glCommandStatus.lastValue = command.value;
+		glCommandStatus.lastRequest = command.request;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+}
@@ -0,0 +1,66 @@
+/************************************************************************
+
+	command-queue.h
+
+	FX3 Firmware vendor command queue
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _COMMAND_QUEUE_H_
+#define _COMMAND_QUEUE_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+
+// The command thread runs at a higher priority than the application thread
+// so that queued commands are not delayed by the main application loop
+#define CY_FX_COMMAND_THREAD_STACK      (0x0800) // Command thread stack size
+#define CY_FX_COMMAND_THREAD_PRIORITY   (7)      // Command thread priority
+
+// Number of host to device vendor commands that can be waiting in the queue
+#define CY_FX_COMMAND_QUEUE_LENGTH      (8)
+
+// Commands queued by the firmware itself (bRequest values below 0x80 are not
+// used by the vendor requests)
+#define CY_FX_COMMAND_RECOVER_ENDPOINT  (0x01) // Recover from a consumer end-point halt
+#define CY_FX_COMMAND_CAPTURE_COMPLETE  (0x02) // Stop the capture that reached its length (wValue = capture number)
+
+// A queued vendor command (one 32-bit message word)
+typedef struct {
+	uint8_t request;				// bRequest of the vendor request
+	uint8_t reserved;
+	uint16_t value;					// wValue of the vendor request
+} domDupCommand_t;
+
+// Response to CY_FX_VREQ_GET_COMMAND_STATUS (little-endian)
+//
+// The counters are cumulative from power-on.  A command sent by the host has
+// been carried out once 'completed' has reached the number of commands the
+// host has sent (accepted - completed commands are still in the queue).
+typedef struct {
+	uint32_t accepted;				// Commands added to the queue
+	uint32_t completed;				// Commands carried out (including failed commands)
+	uint32_t failed;				// Commands that returned an error
+	uint32_t rejected;				// Commands stalled because the queue was full
+	uint32_t lastStatus;			// Result of the last command (CyU3PReturnStatus_t)
+	uint16_t lastValue;				// wValue of the last command
+	uint8_t lastRequest;			// bRequest of the last command
+	uint8_t reserved;
+} domDupCommandStatus_t;
+
+// Function prototypes
+void domDupCommandInitialise(void);
+CyBool_t domDupCommandPost(uint8_t request, uint16_t value);
+void domDupCommandGetStatus(domDupCommandStatus_t *status);
+void domDupCommandThread(uint32_t input);
+
+// Carries out a command (called from the command thread; defined by the application)
+CyU3PReturnStatus_t domDupRunCommand(uint8_t request, uint16_t value);
+
+#include <cyu3externcend.h>
+
+#endif // _COMMAND_QUEUE_H_
@@ -0,0 +1,153 @@
+/************************************************************************
+
+	cpu-load.c
+
+	FX3 Firmware CPU load measurement
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "cpu-load.h"
+
+// The ARM926 has no cycle counter, so DOMDUP_CPU_IDLE_STATS builds measure
+// the idle time with a thread at the lowest priority which does nothing but
+// count.  It only runs when every other thread is waiting, so the count over
+// each CY_FX_CPU_LOAD_WINDOW_MS is proportional to the idle time.  The
+// highest count rate seen is taken as 100% idle (the firmware is close to
+// idle whilst it waits for the host to start collecting data, so the
+// calibration settles within a few seconds of power-on).
+//
+// The thread keeps the CPU busy when it would otherwise wait for an interrupt,
+// so the FX3 runs slightly warmer; the option is off by default.
+//
+// Profile builds (linked with the SDK profiling libraries) also report the
+// average load since power-on measured by ThreadX.  If the idle thread is
+// running its share is not counted as load.
+static domDupCpuLoad_t glCpuLoad;
+
+#ifdef DOMDUP_CPU_IDLE_STATS
+static CyU3PThread glCpuIdleThread;
+static volatile uint32_t glIdleCount;
+static uint32_t glLastIdleCount;
+static uint32_t glMaxIdleRate;		// Highest idle count per second seen
+#endif
+static uint32_t glLastWindowTime;
+
+#ifdef DOMDUP_CPU_IDLE_STATS
+// Idle measurement thread
+static void domDupCpuIdleThread(uint32_t input)
+{
+	while (1) {
+		glIdleCount++;
+	}
+}
+#endif
+
+// Initialise the CPU load measurement (call once from the application thread)
+void domDupCpuLoadInitialise(void)
+{
+#ifdef DOMDUP_CPU_IDLE_STATS
+	CyU3PReturnStatus_t returnCode;
+	void *ptr;
+#endif
+
+	glCpuLoad.cpuIdle = CY_FX_CPU_LOAD_UNKNOWN;
+	glCpuLoad.cpuIdleMin = CY_FX_CPU_LOAD_UNKNOWN;
+	glCpuLoad.cpuLoadAverage = CY_FX_CPU_LOAD_UNKNOWN;
+	glCpuLoad.driverLoadAverage = CY_FX_CPU_LOAD_UNKNOWN;
+	glLastWindowTime = CyU3PGetTime();
+
+#ifdef DOMDUP_CPU_IDLE_STATS
+	glIdleCount = 0;
+	glLastIdleCount = 0;
+	glMaxIdleRate = 0;
+
+	// Allocate the memory for the thread
+	ptr = CyU3PMemAlloc(CY_FX_CPU_IDLE_THREAD_STACK);
+	if (ptr == NULL) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCpuLoadInitialise(): CyU3PMemAlloc failed\r\n");
+		domDupErrorHandler(CY_U3P_ERROR_MEMORY_ERROR);
+	}
+
+	returnCode = CyU3PThreadCreate(
+		&glCpuIdleThread,					// Idle measurement thread structure
+		"30:domDupIdle",					// Thread ID and thread name
+		domDupCpuIdleThread,				// Idle measurement thread entry function
+		0,									// No input parameter to thread
+		ptr,								// Pointer to the allocated thread stack
+		CY_FX_CPU_IDLE_THREAD_STACK,		// Idle measurement thread stack size
+		CY_FX_CPU_IDLE_THREAD_PRIORITY,		// Idle measurement thread priority
+		CY_FX_CPU_IDLE_THREAD_PRIORITY,		// Idle measurement thread priority
+		CYU3P_NO_TIME_SLICE,				// No time slice for the idle measurement thread
+		CYU3P_AUTO_START					// Start the thread immediately
+		);
+	if (returnCode != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCpuLoadInitialise(): CyU3PThreadCreate failed, Error code = %d\r\n", returnCode);
+		domDupErrorHandler(returnCode);
+	}
+#endif
+}
+
+// Update the CPU load figures (called from the main application loop)
+//
+// collecting is true whilst the host is collecting data; the minimum idle
+// time is only recorded then.
+void domDupCpuLoadUpdate(CyBool_t collecting)
+{
+	uint32_t now;
+	uint32_t elapsed;
+#ifdef DOMDUP_CPU_IDLE_STATS
+	uint32_t count;
+	uint32_t rate;
+	uint32_t idle;
+#endif
+
+	now = CyU3PGetTime();
+	elapsed = now - glLastWindowTime;
+	if (elapsed < CY_FX_CPU_LOAD_WINDOW_MS) return;
+	glLastWindowTime = now;
+
+#ifdef DOMDUP_CPU_IDLE_STATS
+	// Idle count per second over the window
+	count = glIdleCount;
+	rate = (uint32_t)(((uint64_t)(count - glLastIdleCount) * 1000) / elapsed);
+	glLastIdleCount = count;
+
+	if (rate > glMaxIdleRate) glMaxIdleRate = rate;
+	idle = (glMaxIdleRate == 0) ? 0 : (uint32_t)(((uint64_t)rate * 1000) / glMaxIdleRate);
+
+	glCpuLoad.cpuIdle = idle;
+	if (collecting && (glCpuLoad.cpuIdleMin == CY_FX_CPU_LOAD_UNKNOWN || idle < glCpuLoad.cpuIdleMin)) {
+		glCpuLoad.cpuIdleMin = idle;
+	}
+#endif
+
+#ifdef CYU3P_PROFILE_EN
+	glCpuLoad.cpuLoadAverage = CyU3PDeviceGetCpuLoad();
+#ifdef DOMDUP_CPU_IDLE_STATS
+	glCpuLoad.cpuLoadAverage -= CyU3PDeviceGetThreadLoad(&glCpuIdleThread);
+#endif
+	glCpuLoad.driverLoadAverage = CyU3PDeviceGetDriverLoad();
+#endif
+}
+
+// Get the CPU load figures (CY_FX_CPU_LOAD_UNKNOWN for those not measured by
+// this build)
+void domDupCpuLoadGet(domDupCpuLoad_t *load)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)load, (uint8_t *)&glCpuLoad, sizeof(glCpuLoad));
+	CyU3PVicEnableInterrupts(intMask);
+}
@@ -0,0 +1,44 @@
+/************************************************************************
+
+	cpu-load.h
+
+	FX3 Firmware CPU load measurement
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _CPU_LOAD_H_
+#define _CPU_LOAD_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Time over which the CPU idle time is measured
+#define CY_FX_CPU_LOAD_WINDOW_MS        (1000)
+
+// Reported when a figure is not measured by this build
+#define CY_FX_CPU_LOAD_UNKNOWN          (0xFFFFFFFF)
+
+// Idle measurement thread (DOMDUP_CPU_IDLE_STATS builds; runs whenever no
+// other thread is ready)
+#define CY_FX_CPU_IDLE_THREAD_STACK     (0x0200) // Idle measurement thread stack size
+#define CY_FX_CPU_IDLE_THREAD_PRIORITY  (31)     // Idle measurement thread priority (the lowest ThreadX priority)
+
+// CPU load figures (part of domDupTelemetry_t)
+typedef struct {
+	uint32_t cpuIdle;				// CPU idle over the last window in 0.1% units (DOMDUP_CPU_IDLE_STATS builds)
+	uint32_t cpuIdleMin;			// Lowest cpuIdle whilst data was being collected (DOMDUP_CPU_IDLE_STATS builds)
+	uint32_t cpuLoadAverage;		// Average CPU load since power-on in % (profile builds)
+	uint32_t driverLoadAverage;		// Average CPU load of the SDK driver threads since power-on in % (profile builds)
+} domDupCpuLoad_t;
+
+// Function prototypes
+void domDupCpuLoadInitialise(void);
+void domDupCpuLoadUpdate(CyBool_t collecting);
+void domDupCpuLoadGet(domDupCpuLoad_t *load);
+
+#include <cyu3externcend.h>
+
+#endif // _CPU_LOAD_H_
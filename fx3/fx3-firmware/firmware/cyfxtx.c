@@ -28,26 +28,10 @@
 #include <cyu3os.h>
 #include <cyu3error.h>
 
-/*
-   The MEM heap is a Memory byte pool which is used to allocate OS objects
-   such as thread stacks and memory for message queues. The Cypress FX3
-   libraries require a Mem heap size of at least 32 KB.
- */
-#define CY_U3P_MEM_HEAP_BASE         ((uint8_t *)0x40038000)
-#define CY_U3P_MEM_HEAP_SIZE         (0x8000)
-
-/* The last 32 KB of RAM is reserved for 2-stage boot operation. This value can be changed to
-   0x40080000 if 2-stage boot is not used by the application. */
-#define CY_U3P_SYS_MEM_TOP           (0x40078000)
-
-/*
-   The buffer heap is used to obtain data buffers for DMA transfers in or out of
-   the FX3 device. The reference implementation of the buffer allocator makes use
-   of a reserved area in the SYSTEM RAM and ensures that all allocated DMA buffers
-   are aligned to cache lines.
- */
-#define CY_U3P_BUFFER_HEAP_BASE      (((uint32_t)(CY_U3P_MEM_HEAP_BASE) + (CY_U3P_MEM_HEAP_SIZE)))
-#define CY_U3P_BUFFER_HEAP_SIZE      ((CY_U3P_SYS_MEM_TOP) - (CY_U3P_BUFFER_HEAP_BASE))
+/* The MEM heap, buffer heap and top of system memory are defined in
+   memory-map.h so that the application can size its DMA buffer pool from
+   the same layout. */
+#include "memory-map.h"
 
 #define CY_U3P_BUFFER_ALLOC_TIMEOUT  (10)
 #define CY_U3P_MEM_ALLOC_TIMEOUT     (10)
@@ -237,6 +221,47 @@ CyU3PMemCmp (
     return 0;
 }
 
+/* Returns the number of bytes free in the MEM heap. The free space may be
+ * split into fragments, so the largest allocation can be smaller. */
+uint32_t
+domDupMemHeapFree (
+        void)
+{
+    if (!glMemPoolInit)
+    {
+        return 0;
+    }
+
+    return glMemBytePool.tx_byte_pool_available;
+}
+
+/* Returns the number of bytes free in the buffer heap (every 32 byte block
+ * not marked as used). */
+uint32_t
+domDupBufferHeapFree (
+        void)
+{
+    uint32_t freeBlocks = 0;
+    uint32_t index, used;
+
+    if (glBufferManager.usedStatus == 0)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < glBufferManager.statusSize; index++)
+    {
+        used = glBufferManager.usedStatus[index];
+        while (used != 0xFFFFFFFF)
+        {
+            freeBlocks++;
+            used |= (used + 1);
+        }
+    }
+
+    return (freeBlocks * 32);
+}
+
 /* This function shall be invoked by the API library
  * and should not be explicitly invoked.
  * If other buffer sizes are required by the application code, this function must
@@ -0,0 +1,150 @@
+/************************************************************************
+
+	dma-latency.c
+
+	FX3 Firmware DMA buffer latency statistics
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3gpio.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "dma-latency.h"
+
+#ifdef DOMDUP_DMA_LATENCY_STATS
+
+// Largest number of buffers in the DMA pool (for any stream profile)
+#define CY_FX_DMA_LATENCY_POOL_BUFFERS  (CY_FX_DMA_BUF_COUNT_MAX * CY_FX_DMA_PRODUCER_SOCKETS)
+
+// The multi-channel is created with producer and consumer event notification,
+// so the DMA callback sees every buffer committed by the GPIF and every buffer
+// sent to the host.  The GPIF alternates between the two threads and the
+// channel consumes the sockets in the same order, so the buffers are consumed
+// in the order they were produced: the commit time of each buffer is kept in a
+// FIFO (one entry per pool buffer) and taken off when the buffer is consumed.
+//
+// The FIFO is allocated from the OS heap (the largest pool size is not a
+// compile-time constant).
+static domDupDmaLatency_t glDmaLatency;
+static uint32_t *glCommitTime = NULL;
+static CyBool_t glTimerValid = CyFalse;
+
+// Read the latency timer (GPIO fast clock counts)
+static uint32_t domDupDmaLatencyTime(void)
+{
+	uint32_t count = 0;
+
+	if (glTimerValid) CyU3PGpioComplexSampleNow(CY_FX_DMA_LATENCY_TIMER_GPIO, &count);
+	return count;
+}
+
+// Start the latency timer and clear the statistics (call once after the GPIO
+// block has been initialised)
+void domDupDmaLatencyInitialise(void)
+{
+	CyU3PGpioComplexConfig_t timerConfig;
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+	glCommitTime = CyU3PMemAlloc(CY_FX_DMA_LATENCY_POOL_BUFFERS * sizeof(uint32_t));
+	if (glCommitTime == NULL) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupDmaLatencyInitialise(): CyU3PMemAlloc failed\r\n");
+		return;
+	}
+
+	// Free running timer; the pin is not driven or sampled
+	CyU3PMemSet((uint8_t *)&timerConfig, 0, sizeof(timerConfig));
+	timerConfig.outValue = CyFalse;
+	timerConfig.driveLowEn = CyFalse;
+	timerConfig.driveHighEn = CyFalse;
+	timerConfig.inputEn = CyFalse;
+	timerConfig.pinMode = CY_U3P_GPIO_MODE_STATIC;
+	timerConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	timerConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+	timerConfig.timer = 0;
+	timerConfig.period = 0xFFFFFFFF;
+	timerConfig.threshold = 0xFFFFFFFF;
+
+	apiReturnStatus = CyU3PGpioSetComplexConfig(CY_FX_DMA_LATENCY_TIMER_GPIO, &timerConfig);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupDmaLatencyInitialise(): CyU3PGpioSetComplexConfig failed, Error code = %d\r\n", apiReturnStatus);
+	} else {
+		glTimerValid = CyTrue;
+	}
+
+	domDupDmaLatencyReset();
+}
+
+// Clear the statistics (called when the DMA channel is created or reset)
+void domDupDmaLatencyReset(void)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemSet((uint8_t *)&glDmaLatency, 0, sizeof(glDmaLatency));
+	glDmaLatency.version = CY_FX_DMA_LATENCY_VERSION;
+	glDmaLatency.poolBuffers = domDupGetDmaBufferCount() * CY_FX_DMA_PRODUCER_SOCKETS;
+	glDmaLatency.bucket0Us = CY_FX_DMA_LATENCY_BUCKET0_US;
+	glDmaLatency.bucketCount = CY_FX_DMA_LATENCY_BUCKETS;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Copy the current statistics (for sending to the host)
+void domDupDmaLatencySnapshot(domDupDmaLatency_t *snapshot)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)snapshot, (uint8_t *)&glDmaLatency, sizeof(glDmaLatency));
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Call back functions ----------------------------------------------------------------------------------
+
+// DMA multi-channel producer/consumer event callback
+void domDupDmaLatencyCB(CyU3PDmaMultiChannel *handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t *input)
+{
+	uint32_t now;
+	uint32_t latencyUs;
+	uint32_t bucket;
+	uint32_t intMask;
+
+	if (glCommitTime == NULL) return;
+	now = domDupDmaLatencyTime();
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (type == CY_U3P_DMA_CB_PROD_EVENT) {
+		glCommitTime[glDmaLatency.producedBuffers % CY_FX_DMA_LATENCY_POOL_BUFFERS] = now;
+		glDmaLatency.producedBuffers++;
+	}
+
+	if ((type == CY_U3P_DMA_CB_CONS_EVENT) && (glDmaLatency.consumedBuffers != glDmaLatency.producedBuffers)) {
+		// Unsigned subtraction handles the timer wrap
+		latencyUs = CY_FX_DMA_LATENCY_COUNTS_TO_US(now -
+			glCommitTime[glDmaLatency.consumedBuffers % CY_FX_DMA_LATENCY_POOL_BUFFERS]);
+		glDmaLatency.consumedBuffers++;
+
+		for (bucket = 0; bucket < (CY_FX_DMA_LATENCY_BUCKETS - 1); bucket++) {
+			if (latencyUs < (CY_FX_DMA_LATENCY_BUCKET0_US << bucket)) break;
+		}
+		glDmaLatency.histogram[bucket]++;
+		if (latencyUs > glDmaLatency.maxLatencyUs) glDmaLatency.maxLatencyUs = latencyUs;
+	}
+
+	glDmaLatency.occupiedBuffers = glDmaLatency.producedBuffers - glDmaLatency.consumedBuffers;
+	if (glDmaLatency.occupiedBuffers > glDmaLatency.peakOccupiedBuffers) {
+		glDmaLatency.peakOccupiedBuffers = glDmaLatency.occupiedBuffers;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+#endif // DOMDUP_DMA_LATENCY_STATS
@@ -0,0 +1,68 @@
+/************************************************************************
+
+	dma-latency.h
+
+	FX3 Firmware DMA buffer latency statistics
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _DMA_LATENCY_H_
+#define _DMA_LATENCY_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3dma.h"
+
+// The statistics are only collected when the firmware is built with
+// DOMDUP_DMA_LATENCY_STATS (the DMA callbacks add an interrupt for every
+// buffer produced and consumed).
+
+// Version of the domDupDmaLatency_t structure returned to the host
+#define CY_FX_DMA_LATENCY_VERSION       (1)
+
+// Complex GPIO whose timer is used to time the buffers (the pin itself is not
+// used, but no other complex GPIO may use the same timer: pin modulo 8)
+#define CY_FX_DMA_LATENCY_TIMER_GPIO    (50)
+
+// GPIO fast clock (SYS_CLK / gpioClock.fastClkDiv) is 201.6 MHz; the timer
+// counts are converted to microseconds as (counts / 8) * 5 / 126
+#define CY_FX_DMA_LATENCY_COUNTS_TO_US(c) ((((c) / 8) * 5) / 126)
+
+// Histogram of the time each buffer spends between the GPIF commit and the
+// USB transfer completing.  Bucket 0 counts buffers under 64 us and bucket n
+// counts buffers from (32 << n) us to under (64 << n) us; the last bucket
+// also counts anything longer.
+#define CY_FX_DMA_LATENCY_BUCKETS       (12)
+#define CY_FX_DMA_LATENCY_BUCKET0_US    (64)
+
+// DMA latency statistics (returned to the host little-endian)
+//
+// The statistics are cleared when the DMA channel is created or reset (when
+// data collection is started).
+typedef struct {
+	uint32_t version;						// Structure version (CY_FX_DMA_LATENCY_VERSION)
+	uint32_t poolBuffers;					// Number of buffers in the DMA pool (all sockets)
+	uint32_t bucket0Us;						// Upper limit of histogram bucket 0 in microseconds
+	uint32_t bucketCount;					// Number of histogram buckets
+	uint32_t histogram[CY_FX_DMA_LATENCY_BUCKETS];	// Buffer latency histogram
+	uint32_t producedBuffers;				// Buffers committed by the GPIF
+	uint32_t consumedBuffers;				// Buffers sent to the host
+	uint32_t occupiedBuffers;				// Buffers currently waiting for the host
+	uint32_t peakOccupiedBuffers;			// Most buffers waiting for the host
+	uint32_t maxLatencyUs;					// Longest buffer latency in microseconds
+} domDupDmaLatency_t;
+
+// Function prototypes
+void domDupDmaLatencyInitialise(void);
+void domDupDmaLatencyReset(void);
+void domDupDmaLatencySnapshot(domDupDmaLatency_t *snapshot);
+
+// Callback function prototypes
+void domDupDmaLatencyCB(CyU3PDmaMultiChannel *handle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t *input);
+
+#include <cyu3externcend.h>
+
+#endif // _DMA_LATENCY_H_
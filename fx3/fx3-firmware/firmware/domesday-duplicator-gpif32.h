@@ -0,0 +1,178 @@
+/*
+ * Project Name: DomesdayDuplicator.cyfx
+ * Time : 08/15/2018 15:11:41
+ * Device Type: FX3
+ * Project Type: GPIF2
+ *
+ *
+ *
+ *
+ * 32-bit data bus variant of domesday-duplicator-gpif.h
+ *
+ * This file was derived from the GPIF II Designer output for the 16-bit
+ * interface; the state machine is identical and only the following
+ * registers differ:
+ *
+ *   CY_U3P_PIB_GPIF_BUS_CONFIG       0x67 -> 0x6C (47-pin interface, 32-bit DQ)
+ *   CY_U3P_PIB_GPIF_DATA_COUNT_LIMIT 0x2000 -> 0x1000 (4096 32-bit words
+ *                                    per 16Kbyte DMA buffer)
+ *
+ * This file need to be included only once in the firmware
+ * It is selected instead of domesday-duplicator-gpif.h when the firmware
+ * is built with DOMDUP_GPIF_32BIT
+ * 
+ */
+
+#ifndef _INCLUDED_DOMESDAYDUPLICATOR_
+#define _INCLUDED_DOMESDAYDUPLICATOR_
+#include "cyu3types.h"
+#include "cyu3gpif.h"
+
+/* Summary
+   Number of states in the state machine
+ */
+#define CY_NUMBER_OF_STATES 7
+
+/* Summary
+   Mapping of user defined state names to state indices
+ */
+#define START 0
+#define TH0_REQUEST 2
+#define TH0_WAIT 1
+#define TH0_READ 3
+#define TH1_WAIT 4
+#define TH1_REQUEST 5
+#define TH1_READ 6
+
+
+/* Summary
+   Initial value of early outputs from the state machine.
+ */
+#define ALPHA_START 0x0
+
+
+/* Summary
+   Transition function values used in the state machine.
+ */
+uint16_t CyFxGpifTransition[]  = {
+    0x0000, 0xAAAA, 0x8888, 0xFFFF
+};
+
+/* Summary
+   Table containing the transition information for various states. 
+   This table has to be stored in the WAVEFORM Registers.
+   This array consists of non-replicated waveform descriptors and acts as a 
+   waveform table. 
+ */
+CyU3PGpifWaveData CyFxGpifWavedata[]  = {
+    {{0x2E701A01,0x00001000,0x80000000},{0x00000000,0x00000000,0x00000000}},
+    {{0x3E739C02,0x00000100,0x80C00080},{0x00000000,0x00000000,0x00000000}},
+    {{0x1E739403,0x20000000,0x80000040},{0x00000000,0x00000000,0x00000000}},
+    {{0x2E701A04,0x04001000,0x80000000},{0x00000000,0x00000000,0x00000000}},
+    {{0x3E739C05,0x00000100,0x80C00080},{0x00000000,0x00000000,0x00000000}},
+    {{0x1E739406,0x24000000,0x80000040},{0x00000000,0x00000000,0x00000000}}
+};
+
+/* Summary
+   Table that maps state indices to the descriptor table indices.
+ */
+uint8_t CyFxGpifWavedataPosition[]  = {
+    0,1,2,3,4,5,0
+};
+
+/* Summary
+   GPIF II configuration register values.
+ */
+uint32_t CyFxGpifRegValue[]  = {
+    0x80008300,  /*  CY_U3P_PIB_GPIF_CONFIG */
+    0x0000006C,  /*  CY_U3P_PIB_GPIF_BUS_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_BUS_CONFIG2 */
+    0x00000046,  /*  CY_U3P_PIB_GPIF_AD_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_STATUS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INTR */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INTR_MASK */
+    0x00000082,  /*  CY_U3P_PIB_GPIF_SERIAL_IN_CONFIG */
+    0x00000782,  /*  CY_U3P_PIB_GPIF_SERIAL_OUT_CONFIG */
+    0x00155414,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_DIRECTION */
+    0x0000E7E6,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_DEFAULT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_POLARITY */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_TOGGLE */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000002,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000001,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000003,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000008,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000009,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x0000000A,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x0000000B,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_BUS_SELECT */
+    0x00000006,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_RESET */
+    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_CTRL_COUNT_LIMIT */
+    0x0000010A,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_RESET */
+    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_ADDR_COUNT_LIMIT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_STATE_COUNT_CONFIG */
+    0x0000FFFF,  /*  CY_U3P_PIB_GPIF_STATE_COUNT_LIMIT */
+    0x00000109,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_RESET */
+    0x00001000,  /*  CY_U3P_PIB_GPIF_DATA_COUNT_LIMIT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COMP_VALUE */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CTRL_COMP_MASK */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COMP_VALUE */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_COMP_MASK */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COMP_VALUE */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_ADDR_COMP_MASK */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_DATA_CTRL */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_DATA */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_INGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_EGRESS_ADDRESS */
+    0x80010400,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
+    0x80010401,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
+    0x80010402,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
+    0x80010403,  /*  CY_U3P_PIB_GPIF_THREAD_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_LAMBDA_STAT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_ALPHA_STAT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_BETA_STAT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_CTRL_STAT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_SWITCH */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_WAVEFORM_SWITCH_TIMEOUT */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CRC_CONFIG */
+    0x00000000,  /*  CY_U3P_PIB_GPIF_CRC_DATA */
+    0xFFFFFFC1  /*  CY_U3P_PIB_GPIF_BETA_DEASSERT */
+};
+
+/* Summary
+   This structure holds all the configuration inputs for the GPIF II. 
+ */
+const CyU3PGpifConfig_t CyFxGpifConfig  = {
+    (uint16_t)(sizeof(CyFxGpifWavedataPosition)/sizeof(uint8_t)),
+    CyFxGpifWavedata,
+    CyFxGpifWavedataPosition,
+    (uint16_t)(sizeof(CyFxGpifTransition)/sizeof(uint16_t)),
+    CyFxGpifTransition,
+    (uint16_t)(sizeof(CyFxGpifRegValue)/sizeof(uint32_t)),
+    CyFxGpifRegValue
+};
+
+#endif   /* _INCLUDED_DOMESDAYDUPLICATOR_ */
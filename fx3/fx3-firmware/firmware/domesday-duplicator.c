@@ -23,27 +23,110 @@
 
 // Local includes
 #include "domesday-duplicator.h"
+#ifdef DOMDUP_GPIF_32BIT
+#include "domesday-duplicator-gpif32.h"
+#else
 #include "domesday-duplicator-gpif.h"
+#endif
+#include "telemetry.h"
+#include "fpga-registers.h"
+#include "command-queue.h"
+#include "trace.h"
+#include "dma-latency.h"
+#include "self-test.h"
+#include "sideband.h"
+#include "notify.h"
+#include "preview.h"
+#include "rf-stats.h"
+#include "fpga-status.h"
+#include "logic-analyzer.h"
+#include "cpu-load.h"
+#include "link-power.h"
+#include "socket-stats.h"
+#include "input-events.h"
+#include "capture-length.h"
+#include "memory-budget.h"
+#ifdef DOMDUP_BENCHMARK
+#include "benchmark.h"
+#endif
 
 // Global definitions
 CyU3PThread glAppThread; // Application thread structure
+CyU3PEvent glAppEvent; // Application thread event group (CY_FX_APP_EVENT_*)
 CyU3PDmaMultiChannel glDmaMultiChHandle; // DMA multi-channel handle
 
 CyBool_t glIsApplnActive = CyFalse; // Application active/ready flag
 CyBool_t glForceLinkU2 = CyFalse; // Force U2 flag
 
 volatile CyBool_t input0Flag = CyFalse; // Input 0 set flag
-volatile CyBool_t input1Flag = CyFalse; // Input 1 set flag
 volatile CyBool_t input2Flag = CyFalse; // Input 2 set flag
 volatile CyBool_t input3Flag = CyFalse; // Input 3 set flag
 
 CyBool_t input0HandledFlag = CyFalse; // Input 0 set condition handled flag
-CyBool_t input1HandledFlag = CyFalse; // Input 1 set condition handled flag
 CyBool_t input2HandledFlag = CyFalse; // Input 2 set condition handled flag
 CyBool_t input3HandledFlag = CyFalse; // Input 3 set condition handled flag
 
 volatile CyBool_t dataCollectionFlag = CyFalse; // Flag to show if the host application is collecting data
 
+CyBool_t glUsb2Mode = CyFalse; // Connected to a USB 2.0 port (reduced-rate streaming)
+uint16_t glRequestedConfiguration = 0; // Configuration bits last sent by the host (0xB6)
+uint16_t glAppliedConfiguration = 0; // Configuration bits in use
+
+// Stream profiles (CY_FX_VREQ_STREAM_PROFILE)
+//
+// Profile 0 is the compile-time default.  The others trade the USB 3 burst
+// length (some host controllers schedule shorter bursts better) against the
+// depth of the DMA pool.
+static const domDupStreamProfile_t glStreamProfiles[CY_FX_STREAM_PROFILES] = {
+	{ CY_FX_EP_BURST_LENGTH, CY_FX_STREAM_BUF_COUNT_DEFAULT },
+	{ 8, CY_FX_STREAM_BUF_COUNT_DEFAULT },
+	{ 4, CY_FX_STREAM_BUF_COUNT_DEFAULT },
+	{ CY_FX_EP_BURST_LENGTH, 2 },
+	{ CY_FX_EP_BURST_LENGTH, CY_FX_STREAM_BUF_COUNT_MAX },
+	{ 8, CY_FX_STREAM_BUF_COUNT_MAX }
+};
+uint16_t glStreamProfile = CY_FX_STREAM_PROFILE_DEFAULT; // Stream profile in use
+domDupStreamProfile_t glStreamSettings; // Burst length and buffer count in use (normally those of glStreamProfile)
+uint16_t glEpPacketSize = 0; // Consumer end-point packet size for the connection speed
+static uint32_t glPacketSize = CY_FX_DMA_BUF_SIZE; // Packet (DMA buffer) size in use
+static uint32_t glRequestedPacketSize = CY_FX_DMA_BUF_SIZE; // Packet size last selected by the host (0xD6)
+
+uint8_t glEp0Buffer[CY_FX_EP0_BUFFER_SIZE] __attribute__ ((aligned (32))); // Data phase buffer for vendor requests
+
+// A GPIO claimed from the GPIF interface at boot (see glGpioConfig)
+typedef struct {
+	uint8_t gpio;					// GPIO number
+	CyBool_t output;				// Driven by the FX3 (otherwise an input from the FPGA)
+	CyBool_t outValue;				// Initial output level
+	CyU3PGpioIntrMode_t intrMode;	// Interrupt mode of an input
+} domDupGpioConfig_t;
+
+// GPIOs claimed from the GPIF interface, in the order they are configured
+//
+// collectData is driven low before the FPGA is taken out of reset, so the
+// FPGA doesn't start collecting data.  GPIO 24 to 26 are used by the FPGA
+// register interface (nCS, SCLK and MOSI) and GPIO 21 is its MISO (polled,
+// so no interrupt).  The inputs interrupt on both edges, so the input events
+// ring records every change with the level read in the interrupt.  The configuration bits are all carried by the FPGA
+// control register, so outputE0 and outputD0 are spare.
+static const domDupGpioConfig_t glGpioConfig[] = {
+	{ CY_FX_GPIO_COLLECT_DATA,  CyTrue,  CyFalse, CY_U3P_GPIO_NO_INTR },		// collectData (not collecting)
+	{ CY_FX_GPIO_NRESET,        CyTrue,  CyTrue,  CY_U3P_GPIO_NO_INTR },		// nRESET (FPGA out of reset)
+
+	// Generic input signals from FPGA
+	{ CY_FX_GPIO_INPUT0,        CyFalse, CyTrue,  CY_U3P_GPIO_INTR_BOTH_EDGE },	// input0
+	{ CY_FX_FPGA_REG_MISO_GPIO, CyFalse, CyTrue,  CY_U3P_GPIO_NO_INTR },		// input1 (register interface MISO)
+	{ CY_FX_GPIO_INPUT2,        CyFalse, CyTrue,  CY_U3P_GPIO_INTR_BOTH_EDGE },	// input2
+	{ CY_FX_GPIO_INPUT3,        CyFalse, CyTrue,  CY_U3P_GPIO_INTR_BOTH_EDGE },	// input3
+
+	// Generic output signals to FPGA (GPIO 22 early, 23 to 26 delayed)
+	{ CY_FX_GPIO_OUTPUT_E0,     CyTrue,  CyFalse, CY_U3P_GPIO_NO_INTR },		// outputE0 (spare)
+	{ CY_FX_GPIO_OUTPUT_D0,     CyTrue,  CyFalse, CY_U3P_GPIO_NO_INTR },		// outputD0 (spare)
+	{ CY_FX_FPGA_REG_NCS_GPIO,  CyTrue,  CyTrue,  CY_U3P_GPIO_NO_INTR },		// outputD1 (register interface nCS, not selected)
+	{ CY_FX_FPGA_REG_SCLK_GPIO, CyTrue,  CyFalse, CY_U3P_GPIO_NO_INTR },		// outputD2 (register interface SCLK)
+	{ CY_FX_FPGA_REG_MOSI_GPIO, CyTrue,  CyFalse, CY_U3P_GPIO_NO_INTR }		// outputD3 (register interface MOSI)
+};
+
 // Main application function
 int main(void)
 {
@@ -52,6 +135,7 @@ int main(void)
     CyU3PGpioClock_t gpioClock;
     CyU3PGpioSimpleConfig_t gpioConfig;
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+    uint32_t index;
 
     // Perform initial clock configuration of the FX3
     CyU3PSysClockConfig_t clockConfig;
@@ -73,12 +157,28 @@ int main(void)
     }
 
     // Initialise the IO matrix
+#ifdef DOMDUP_GPIF_32BIT
+    io_cfg.isDQ32Bit = CyTrue; // Data bus is 32-bits
+    io_cfg.useUart   = CY_FX_USE_DEBUG_UART;
+    io_cfg.useI2C    = CyFalse;
+    io_cfg.useI2S    = CyFalse;
+    io_cfg.useSpi    = CyFalse;
+    io_cfg.lppMode   = CY_U3P_IO_MATRIX_LPP_DEFAULT; // 32-bit data bus (SPI is not available)
+#elif defined(DOMDUP_FAST_BOOT)
     io_cfg.isDQ32Bit = CyFalse; // Data bus is 16-bits
-    io_cfg.useUart   = CyTrue;
+    io_cfg.useUart   = CY_FX_USE_DEBUG_UART;
+    io_cfg.useI2C    = CyFalse;
+    io_cfg.useI2S    = CyFalse;
+    io_cfg.useSpi    = CyFalse;
+    io_cfg.lppMode   = CY_U3P_IO_MATRIX_LPP_DEFAULT; // 16-bit data bus (no debug UART)
+#else
+    io_cfg.isDQ32Bit = CyFalse; // Data bus is 16-bits
+    io_cfg.useUart   = CY_FX_USE_DEBUG_UART;
     io_cfg.useI2C    = CyFalse;
     io_cfg.useI2S    = CyFalse;
     io_cfg.useSpi    = CyFalse;
     io_cfg.lppMode   = CY_U3P_IO_MATRIX_LPP_UART_ONLY; // 16-bit data bus with UART
+#endif
 
     // Note:
     // If io_cfg.isDQ32Bit = CyFalse then GPIO[0:15] and CTL[0:4] will be reserved for GPIF
@@ -86,6 +186,9 @@ int main(void)
     io_cfg.gpioSimpleEn[1] = 0; // Least significant GPIOs 0-31
     io_cfg.gpioComplexEn[0] = 0;
     io_cfg.gpioComplexEn[1] = 0;
+#ifdef DOMDUP_DMA_LATENCY_STATS
+    io_cfg.gpioComplexEn[1] = 1 << (CY_FX_DMA_LATENCY_TIMER_GPIO - 32); // Timer for the DMA latency statistics
+#endif
 
     status = CyU3PDeviceConfigureIOMatrix(&io_cfg);
     if (status != CY_U3P_SUCCESS) {
@@ -93,7 +196,16 @@ int main(void)
     }
 
     // Start GPIF clocks, they need to be running before we attach a DMA channel to GPIF
+    //
+    // The GPIF interface clock is driven by the FPGA (60 MHz, or 80 MHz for an
+    // FPGA built with FX3_CLOCK_80MHZ).  The PIB core clock must be faster
+    // than the interface clock with some margin, so it is doubled for the 80 MHz
+    // interface.
+#ifdef DOMDUP_GPIF_CLOCK_80MHZ
+	pibClock.clkDiv = 2; // 403.2 / 2 = 201.6 MHz
+#else
 	pibClock.clkDiv = 4; // 403.2 / 4 = 100.8 MHz
+#endif
 	pibClock.clkSrc = CY_U3P_SYS_CLK;
 	pibClock.isHalfDiv = CyFalse;
 	pibClock.isDllEnable = CyFalse; // Disable Dll (not required for synchronous applications)
@@ -115,197 +227,23 @@ int main(void)
 		goto handleFatalError;
 	}
 
-	// Claim GPIO19 from the GPIF Interface (collectData signal)
-	status = CyU3PDeviceGpioOverride(19, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Put the FPGA in not collectData by driving GPIO19 low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(19, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO27 from the GPIF Interface (nRESET signal)
-	status = CyU3PDeviceGpioOverride(27, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Bring the FPGA out of reset by driving nRESET/GPIO27 high
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyTrue;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(27, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Generic input signals from FPGA (GPIO 20, 21, 28 and 29) -------------------------------------------------------
-
-	// Claim GPIO20 from the GPIF Interface (input0)
-	status = CyU3PDeviceGpioOverride(20, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Configure as input
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyTrue;
-	gpioConfig.driveLowEn = CyFalse;
-	gpioConfig.driveHighEn = CyFalse;
-	gpioConfig.inputEn = CyTrue;
-	gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
-
-	status = CyU3PGpioSetSimpleConfig(20, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO21 from the GPIF Interface (input1)
-	status = CyU3PDeviceGpioOverride(21, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Configure as input
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyTrue;
-	gpioConfig.driveLowEn = CyFalse;
-	gpioConfig.driveHighEn = CyFalse;
-	gpioConfig.inputEn = CyTrue;
-	gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
-
-	status = CyU3PGpioSetSimpleConfig(21, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO28 from the GPIF Interface (input2)
-	status = CyU3PDeviceGpioOverride(28, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Configure as input
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyTrue;
-	gpioConfig.driveLowEn = CyFalse;
-	gpioConfig.driveHighEn = CyFalse;
-	gpioConfig.inputEn = CyTrue;
-	gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
-
-	status = CyU3PGpioSetSimpleConfig(28, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO29 from the GPIF Interface (input3)
-	status = CyU3PDeviceGpioOverride(29, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Configure as input
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyTrue;
-	gpioConfig.driveLowEn = CyFalse;
-	gpioConfig.driveHighEn = CyFalse;
-	gpioConfig.inputEn = CyTrue;
-	gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
-
-	status = CyU3PGpioSetSimpleConfig(29, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Generic output signals to FPGA (GPIO 22 (early), 23 (delayed), -------------------------------------------------
-	// 24 (delayed), 25 (delayed), 26 (delayed))
-
-	// Claim GPIO22 from the GPIF Interface (outputE0)
-	status = CyU3PDeviceGpioOverride(22, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Drive pin low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(22, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO23 from the GPIF Interface (outputD0)
-	status = CyU3PDeviceGpioOverride(23, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Drive pin low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(23, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO24 from the GPIF Interface (outputD1)
-	status = CyU3PDeviceGpioOverride(24, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Drive pin low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(24, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO25 from the GPIF Interface (outputD2)
-	status = CyU3PDeviceGpioOverride(25, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Drive pin low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(25, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
-
-	// Claim GPIO26 from the GPIF Interface (outputD3)
-	status = CyU3PDeviceGpioOverride(26, CyTrue);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
-	}
+	// Claim the GPIOs used to control and signal the FPGA from the GPIF interface
+	for (index = 0; index < sizeof(glGpioConfig) / sizeof(glGpioConfig[0]); index++) {
+		status = CyU3PDeviceGpioOverride(glGpioConfig[index].gpio, CyTrue);
+		if (status != CY_U3P_SUCCESS) {
+			goto handleFatalError;
+		}
 
-	// Drive pin low
-	CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
-	gpioConfig.outValue = CyFalse;
-	gpioConfig.driveLowEn = CyTrue;
-	gpioConfig.driveHighEn = CyTrue;
-	status = CyU3PGpioSetSimpleConfig(26, &gpioConfig);
-	if (status != CY_U3P_SUCCESS) {
-		goto handleFatalError;
+		CyU3PMemSet((uint8_t *)&gpioConfig, 0, sizeof(gpioConfig));
+		gpioConfig.outValue = glGpioConfig[index].outValue;
+		gpioConfig.driveLowEn = glGpioConfig[index].output;
+		gpioConfig.driveHighEn = glGpioConfig[index].output;
+		gpioConfig.inputEn = !glGpioConfig[index].output;
+		gpioConfig.intrMode = glGpioConfig[index].intrMode;
+		status = CyU3PGpioSetSimpleConfig(glGpioConfig[index].gpio, &gpioConfig);
+		if (status != CY_U3P_SUCCESS) {
+			goto handleFatalError;
+		}
 	}
 
     // Initialise the RTOS kernel -------------------------------------------------------------------------------------
@@ -323,66 +261,101 @@ handleFatalError:
 // Function to initialise the application's main thread
 void domDupThreadInitialise(uint32_t input)
 {
-    CyU3PReturnStatus_t status;
-    CyU3PUsbLinkPowerMode powerState;
+    uint32_t eventFlags;
+    CyBool_t checkLinkState;
 
-    // Initialise the debug console
+    // Initialise the debug console (left out of fast boot builds, which have
+    // no debug messages built in)
+#ifndef DOMDUP_FAST_BOOT
     domDupDebugInit();
-    CyU3PDebugPrint(1, "\r\nDomesday Duplicator FX3 Firmware - Build 0062\r\n");
-    CyU3PDebugPrint(1, "(c)2018 Simon Inns - https://www.domesday86.com\r\n\r\n");
-    CyU3PDebugPrint(1, "domDupThreadInitialise(): Debug console initialised\r\n");
-
-    // Initialise the application
+#endif
+    domDupDebugPrint(CY_FX_DEBUG_BANNER, "\r\nDomesday Duplicator FX3 Firmware - Build 0062\r\n");
+    domDupDebugPrint(CY_FX_DEBUG_BANNER, "(c)2018 Simon Inns - https://www.domesday86.com\r\n\r\n");
+    domDupDebugPrint(CY_FX_DEBUG_BANNER, "domDupThreadInitialise(): Debug console initialised\r\n");
+    domDupDebugPrint(CY_FX_DEBUG_BANNER, "domDupThreadInitialise(): GPIF data bus is %d-bits wide\r\n", CY_FX_GPIF_BUS_WIDTH);
+
+    // Initialise the FPGA register interface and check that the FPGA responds
+    domDupFpgaInitialise();
+
+    // Initialise the telemetry counters, the CPU load measurement, the command
+    // queue and the application
+    domDupTelemetryInitialise();
+    domDupLinkPowerInitialise();
+    domDupSocketStatsInitialise();
+    domDupCpuLoadInitialise();
+#ifdef DOMDUP_DMA_LATENCY_STATS
+    domDupDmaLatencyInitialise();
+#endif
+    domDupCommandInitialise();
     domDupInitialiseApplication();
 
     // Main application thread loop
+    //
+    // The thread blocks until the GPIO interrupt or one of the USB callbacks
+    // signals an event.  Whilst the application is active it also wakes every
+    // CY_FX_TELEMETRY_UPDATE_MS to sample the telemetry counters and the link
+    // state.
     while(1) {
-        // Try to get the USB 3.0 link back to U0
-        if (glForceLinkU2) {
-        	status = CyU3PUsbGetLinkPowerState(&powerState);
-            while ((glForceLinkU2) && (status == CY_U3P_SUCCESS) && (powerState == CyU3PUsbLPM_U0)) {
-                // Try to get to U2 state
-                CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U2);
-                CyU3PThreadSleep(5);
-                status = CyU3PUsbGetLinkPowerState(&powerState);
-            }
-        } else {
-            // Try to get the USB link back to U0
-            if (CyU3PUsbGetSpeed () == CY_U3P_SUPER_SPEED) {
-            	status = CyU3PUsbGetLinkPowerState (&powerState);
-                while ((status == CY_U3P_SUCCESS) && (powerState >= CyU3PUsbLPM_U1) &&
-                	(powerState <= CyU3PUsbLPM_U3)) {
-                    CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U0);
-                    CyU3PThreadSleep(1);
-                    status = CyU3PUsbGetLinkPowerState(&powerState);
-                }
-            }
-        }
+    	eventFlags = 0;
+    	CyU3PEventGet(&glAppEvent, CY_FX_APP_EVENT_ALL, CYU3P_EVENT_OR_CLEAR, &eventFlags,
+    			glIsApplnActive ? CY_FX_TELEMETRY_UPDATE_MS : CYU3P_WAIT_FOREVER);
+
+        // Check the link state following a link or USB event, or on the
+        // periodic wake-up (eventFlags is 0 if the wait timed out)
+        checkLinkState = (eventFlags == 0) || ((eventFlags & (CY_FX_APP_EVENT_LINK | CY_FX_APP_EVENT_USB)) != 0);
+
+        // Hold the USB 3.0 link in U0 whilst collecting, or move it to U2
+        // on a function suspend (see link-power.c)
+        if (checkLinkState) domDupLinkPowerUpdate(glForceLinkU2);
+
+        // Update the telemetry counters
+        if (glIsApplnActive) domDupTelemetryUpdate(&glDmaMultiChHandle);
+        if (glIsApplnActive) domDupCpuLoadUpdate(dataCollectionFlag);
+        if (glIsApplnActive) domDupSocketStatsUpdate(&glDmaMultiChHandle, dataCollectionFlag);
+#ifdef DOMDUP_SIDEBAND_EP
+        if (glIsApplnActive) domDupSidebandUpdate(dataCollectionFlag);
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+        if (glIsApplnActive) domDupNotifyUpdate(dataCollectionFlag);
+#endif
+
+        // Read the signal preview from the FPGA
+        if (glIsApplnActive) domDupPreviewUpdate();
+
+        // Read the RF statistics from the FPGA
+        if (glIsApplnActive) domDupRfStatsUpdate();
+
+        // Read the FPGA status registers for the device to host requests
+        if (glIsApplnActive) domDupFpgaStatusUpdate(CyFalse);
+
+        // Read the logic analyzer capture from the FPGA once it is complete
+        if (glIsApplnActive) domDupLogicAnalyzerUpdate();
+
+        // Stop a capture once its length has been sent
+        if (glIsApplnActive) domDupCaptureLengthUpdate();
+
+        // Read the input markers from the FPGA
+        if (glIsApplnActive) domDupInputMarkersUpdate(dataCollectionFlag);
 
         // Process the input0 flag (generated via GPIO interrupt)
         if (input0Flag) {
         	// Ensure we only output the debug once
         	if (!input0HandledFlag) {
         		input0HandledFlag = CyTrue;
-        		CyU3PDebugPrint(4, "Main application loop: input0 pin set by the FPGA\r\n");
+        		domDupDebugPrint(CY_FX_DEBUG_STATUS, "Main application loop: input0 pin set by the FPGA\r\n");
+        		if (glIsApplnActive) domDupFpgaStatusUpdate(CyTrue);
+#ifdef DOMDUP_SIDEBAND_EP
+        		domDupSidebandOverflowEvent();
+#endif
         	}
         }
 
-        // Process the input1 flag (generated via GPIO interrupt)
-		if (input1Flag) {
-			// Ensure we only output the debug once
-			if (!input1HandledFlag) {
-				input1HandledFlag = CyTrue;
-				CyU3PDebugPrint(4, "Main application loop: input1 pin set by the FPGA\r\n");
-			}
-		}
-
-		// Process the input2 flag (generated via GPIO interrupt)
+        // Process the input2 flag (generated via GPIO interrupt)
 		if (input2Flag) {
 			// Ensure we only output the debug once
 			if (!input2HandledFlag) {
 				input2HandledFlag = CyTrue;
-				CyU3PDebugPrint(4, "Main application loop: input2 pin set by the FPGA\r\n");
+				domDupDebugPrint(CY_FX_DEBUG_STATUS, "Main application loop: input2 pin set by the FPGA\r\n");
 			}
 		}
 
@@ -391,7 +364,7 @@ void domDupThreadInitialise(uint32_t input)
 			// Ensure we only output the debug once
 			if (!input3HandledFlag) {
 				input3HandledFlag = CyTrue;
-				CyU3PDebugPrint(4, "Main application loop: input3 pin set by the FPGA\r\n");
+				domDupDebugPrint(CY_FX_DEBUG_STATUS, "Main application loop: input3 pin set by the FPGA\r\n");
 			}
 		}
     }
@@ -403,6 +376,20 @@ void CyFxApplicationDefine(void)
     void *ptr = NULL;
     uint32_t returnCode = CY_U3P_SUCCESS;
 
+    // Clear the trace log (before anything can add to it)
+    domDupTraceInitialise();
+    domDupTrace(CY_FX_TRACE_BOOT, 0, 0);
+    domDupInputEventsInitialise();
+
+    // Create the event group used to wake the application thread (before the
+    // thread and the callbacks which signal it are started)
+    returnCode = CyU3PEventCreate(&glAppEvent);
+    if (returnCode != 0) {
+    	// Could not create the event group
+    	// Application cannot start
+        while(1);
+    }
+
     // Allocate the memory for the threads
     ptr = CyU3PMemAlloc(CY_FX_GPIFTOUSB_THREAD_STACK);
 
@@ -438,7 +425,7 @@ void domDupInitialiseApplication(void)
     apiReturnStatus = CyU3PUsbStart();
     if (apiReturnStatus == CY_U3P_ERROR_NO_REENUM_REQUIRED) noRenum = CyTrue;
     else if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbStart failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbStart failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
@@ -456,63 +443,63 @@ void domDupInitialiseApplication(void)
     // Super speed device descriptor (USB 3)
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_SS_DEVICE_DESCR, 0, (uint8_t *)USB30DeviceDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc USB3 failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc USB3 failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // High speed device descriptor (USB 2)
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_HS_DEVICE_DESCR, 0, (uint8_t *)USB20DeviceDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc USB 2 failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc USB 2 failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // BOS descriptor
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_SS_BOS_DESCR, 0, (uint8_t *)USBBOSDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc BOS failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc BOS failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // Device qualifier descriptor
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_DEVQUAL_DESCR, 0, (uint8_t *)USBDeviceQualDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc qualifier descriptor failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc qualifier descriptor failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // Super speed configuration descriptor
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_SS_CONFIG_DESCR, 0, (uint8_t *)USBSSConfigDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc configuration descriptor failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc configuration descriptor failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // High speed configuration descriptor
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_HS_CONFIG_DESCR, 0, (uint8_t *)USBHSConfigDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc Other Speed Descriptor failed, Error Code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc Other Speed Descriptor failed, Error Code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // Full speed configuration descriptor
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_FS_CONFIG_DESCR, 0, (uint8_t *)USBFSConfigDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc Full-Speed Descriptor failed, Error Code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc Full-Speed Descriptor failed, Error Code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // String descriptor 0
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_STRING_DESCR, 0, (uint8_t *)USBStringLangIDDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc string 0 descriptor failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc string 0 descriptor failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // String descriptor 1
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_STRING_DESCR, 1, (uint8_t *)USBManufactureDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc string descriptor 1 failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc string descriptor 1 failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
@@ -520,18 +507,18 @@ void domDupInitialiseApplication(void)
     apiReturnStatus = CyU3PUsbSetDesc(CY_U3P_USB_SET_STRING_DESCR, 2, (uint8_t *)USBProductDscr);
     if (apiReturnStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PUsbSetDesc string descriptor 2 failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PUsbSetDesc string descriptor 2 failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
     // Show status in debug console
-    CyU3PDebugPrint(4, "domDupInitialiseApplication(): Initialisation successful; Connecting to host\r\n");
+    domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): Initialisation successful; Connecting to host\r\n");
 
     // Connect to the host
     if (!noRenum) {
         apiReturnStatus = CyU3PConnectState(CyTrue, CyTrue);
         if (apiReturnStatus != CY_U3P_SUCCESS) {
-            CyU3PDebugPrint(4, "domDupInitialiseApplication(): CyU3PConnectState failed, Error code = %d\r\n", apiReturnStatus);
+            domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInitialiseApplication(): CyU3PConnectState failed, Error code = %d\r\n", apiReturnStatus);
             domDupErrorHandler(apiReturnStatus);
         }
     } else {
@@ -541,15 +528,13 @@ void domDupInitialiseApplication(void)
         // Start the application
         domDupStartApplication();
     }
-    CyU3PDebugPrint(8, "domDupInitialiseApplication(): Application initialisation complete.\r\n");
+    domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupInitialiseApplication(): Application initialisation complete.\r\n");
 }
 
 // Function to start application once SET_CONF received from host
 void domDupStartApplication(void)
 {
     uint16_t size = 0;
-    CyU3PEpConfig_t epCfg;
-    CyU3PDmaMultiChannelConfig_t dmaMultiConfig;
     CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
     CyU3PUSBSpeed_t usbSpeed = CyU3PUsbGetSpeed();
 
@@ -568,95 +553,153 @@ void domDupStartApplication(void)
         break;
 
     default:
-        CyU3PDebugPrint(4, "domDupStartApplication(): ERROR - CyU3PUsbGetSpeed returned an invalid speed!\r\n");
-        domDupErrorHandler (CY_U3P_ERROR_FAILURE);
-        break;
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): ERROR - CyU3PUsbGetSpeed returned an invalid speed!\r\n");
+        return;
     }
 
-    // Check that we are connected to a USB 3 host
-    if (usbSpeed != CY_U3P_SUPER_SPEED) {
-    	CyU3PDebugPrint(4, "domDupStartApplication(): ERROR - USB 2 is not supported, connect device to a USB 3 port!\r\n");
-    	domDupErrorHandler (CY_U3P_ERROR_FAILURE);
+    // Check the connection speed
+    //
+    // A USB 2.0 (high speed) port can't carry the full data rate, so the
+    // FPGA is switched to packed and decimation modes (see
+    // domDupApplyConfiguration) for reduced-rate streaming.  Full speed is too
+    // slow to be useful, so the application is not started (the device stays
+    // enumerated and is started again if it is reconnected).
+    if (usbSpeed == CY_U3P_FULL_SPEED) {
+    	domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): ERROR - USB full speed is not supported, connect device to a USB 3 port!\r\n");
+    	return;
     }
 
-    CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
-    epCfg.enable = CyTrue;
-    epCfg.epType = CY_U3P_USB_EP_BULK;
-    epCfg.burstLen = (usbSpeed == CY_U3P_SUPER_SPEED) ? (CY_FX_EP_BURST_LENGTH) : 1;
-    epCfg.streams = 0;
-    epCfg.pcktSize = size;
+    glUsb2Mode = (usbSpeed == CY_U3P_HIGH_SPEED) ? CyTrue : CyFalse;
+    if (glUsb2Mode) {
+    	domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): WARNING - USB 2.0 port, using reduced-rate streaming (connect to a USB 3 port for full rate)\r\n");
+    }
+    domDupApplyConfiguration(glRequestedConfiguration);
+
+    // Configure the end-point and create the DMA channel
+    glEpPacketSize = size;
+    domDupGetStreamProfileSettings(glStreamProfile, &glStreamSettings);
+    apiReturnStatus = domDupCreateDataPath();
+    if (apiReturnStatus != CY_U3P_SUCCESS) domDupErrorHandler(apiReturnStatus);
+
+#ifdef DOMDUP_SIDEBAND_EP
+    // Start the sideband end-point (the RF data path works without it)
+    if (domDupSidebandStart(size) != CY_U3P_SUCCESS) {
+    	domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): WARNING - Sideband end-point not started\r\n");
+    }
+#endif
 
-    // Configure consumer end-point
-    apiReturnStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+#ifdef DOMDUP_NOTIFY_EP
+    // Start the notification end-point (the RF data path works without it)
+    if (domDupNotifyStart() != CY_U3P_SUCCESS) {
+    	domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): WARNING - Notification end-point not started\r\n");
+    }
+#endif
+
+    // Load the GPIF state machine
+    apiReturnStatus = CyU3PGpifLoad (&CyFxGpifConfig);
+
+    // Register callback for GPIF CPU interrupt events
+    CyU3PGpifRegisterCallback(gpifDmaEventCB);
+
+    // Register callback for PIB error events (counted by the telemetry)
+    CyU3PPibRegisterCallback(domDupPibEventCB, CYU3P_PIB_INTR_ERROR);
+
+    if (apiReturnStatus != CY_U3P_SUCCESS) {
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): CyU3PGpifLoad failed, error code = %d\r\n", apiReturnStatus);
+        domDupErrorHandler (apiReturnStatus);
+    }
+
+    // Set the thread water-mark levels (CY_FX_GPIF_WATERMARK unless the host
+    // has changed them, see socket-stats.c)
+    //
+    // Water-mark value = 3, bus width = 16 (or 6 and 32 in 32-bit mode)
+    // Therefore, the number of data words that may be written after the clock edge at which the partial
+    // flag is sampled asserted = (3 x (32/16)) - 4 = 2 (or (6 x (32/32)) - 4 = 2)
+    apiReturnStatus = domDupSocketConfigure();
+    if (apiReturnStatus != CY_U3P_SUCCESS) domDupErrorHandler(apiReturnStatus);
+
+	// Start the GPIF state machine
+    apiReturnStatus = CyU3PGpifSMStart (START, ALPHA_START);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStartApplication(): CyU3PGpifSMStart failed, error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 
-    // Flush the end-point
-    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+    // Set the application active flag to true
+    glIsApplnActive = CyTrue;
+    domDupTrace(CY_FX_TRACE_APP_START, usbSpeed, 0);
+}
+
+// Configure the consumer end-point and create the DMA channel with the stream
+// settings in use (glEpPacketSize must be set for the connection speed)
+CyU3PReturnStatus_t domDupCreateDataPath(void)
+{
+    CyU3PDmaMultiChannelConfig_t dmaMultiConfig;
+    domDupStreamProfile_t settings = glStreamSettings;
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+    // Configure consumer end-point
+    apiReturnStatus = domDupConfigureConsumerEp(settings.burstLength);
+    if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
 
     // Create a DMA manual multi-channel for the GPIF to USB transfer
     CyU3PMemSet ((uint8_t *)&dmaMultiConfig, 0, sizeof (dmaMultiConfig));
-    dmaMultiConfig.size  = CY_FX_DMA_BUF_SIZE;
-    dmaMultiConfig.count = CY_FX_DMA_BUF_COUNT;
-    dmaMultiConfig.validSckCount = 2;
+    dmaMultiConfig.size  = glPacketSize;
+    dmaMultiConfig.count = settings.bufferCount;
+    dmaMultiConfig.validSckCount = CY_FX_DMA_PRODUCER_SOCKETS;
     dmaMultiConfig.prodSckId[0] = CY_FX_EP_PRODUCER_SOCKET0;
     dmaMultiConfig.prodSckId[1] = CY_FX_EP_PRODUCER_SOCKET1;
     dmaMultiConfig.consSckId[0] = CY_FX_EP_CONSUMER_SOCKET;
     dmaMultiConfig.dmaMode = CY_U3P_DMA_MODE_BYTE;
+#ifdef DOMDUP_DMA_LATENCY_STATS
+    // Notify every buffer produced and consumed (for the latency statistics)
+    dmaMultiConfig.notification = CY_U3P_DMA_CB_PROD_EVENT | CY_U3P_DMA_CB_CONS_EVENT;
+    dmaMultiConfig.cb = domDupDmaLatencyCB;
+#endif
 
     apiReturnStatus = CyU3PDmaMultiChannelCreate(&glDmaMultiChHandle, CY_U3P_DMA_TYPE_AUTO_MANY_TO_ONE, &dmaMultiConfig);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PDmaMultiChannelCreate failed, Error code = %d\r\n", apiReturnStatus);
-        domDupErrorHandler(apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCreateDataPath(): CyU3PDmaMultiChannelCreate failed, Error code = %d\r\n", apiReturnStatus);
+        return apiReturnStatus;
     }
+    domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCreateDataPath(): Stream profile %d: burst length %d, DMA pool is %d x %d byte buffers per socket\r\n",
+    	glStreamProfile, glUsb2Mode ? 1 : settings.burstLength, settings.bufferCount, glPacketSize);
+    domDupTelemetryChannelReset();
 
     // Start the DMA channel transfer
     apiReturnStatus = CyU3PDmaMultiChannelSetXfer(&glDmaMultiChHandle, 0, 0);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-		CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PDmaMultiChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
-		domDupErrorHandler(apiReturnStatus);
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupCreateDataPath(): CyU3PDmaMultiChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
 	}
 
-    // Load the GPIF state machine
-    apiReturnStatus = CyU3PGpifLoad (&CyFxGpifConfig);
-
-    // Register callback for GPIF CPU interrupt events
-    CyU3PGpifRegisterCallback(gpifDmaEventCB);
-
-    if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PGpifLoad failed, error code = %d\r\n", apiReturnStatus);
-        domDupErrorHandler (apiReturnStatus);
-    }
-
-    // Water-mark value = 3, bus width = 16
-    // Therefore, the number of 16-bit data words that may be written after the clock edge at which the partial
-    // flag is sampled asserted = (3 x (32/16)) - 4 = 2
+    return CY_U3P_SUCCESS;
+}
 
-    // Set the thread 0 water-mark level to 1x 32 bit word
-    apiReturnStatus = CyU3PGpifSocketConfigure(0, CY_FX_EP_PRODUCER_SOCKET0, 3, CyFalse, 1);
-    if (apiReturnStatus != CY_U3P_SUCCESS) {
-		CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PGpifSocketConfigure failed for thread0, error code = %d\r\n", apiReturnStatus);
-		domDupErrorHandler (apiReturnStatus);
-	}
+// Configure the consumer end-point with a burst length (1 on a USB 2.0 port)
+// and flush it
+CyU3PReturnStatus_t domDupConfigureConsumerEp(uint16_t burstLength)
+{
+    CyU3PEpConfig_t epCfg;
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
 
-    // Set the thread 1 water-mark level to 1x 32 bit word
-	apiReturnStatus = CyU3PGpifSocketConfigure(1, CY_FX_EP_PRODUCER_SOCKET1, 3, CyFalse, 1);
-	if (apiReturnStatus != CY_U3P_SUCCESS) {
-		CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PGpifSocketConfigure failed for thread1, error code = %d\r\n", apiReturnStatus);
-		domDupErrorHandler (apiReturnStatus);
-	}
+    CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
+    epCfg.enable = CyTrue;
+    epCfg.epType = CY_U3P_USB_EP_BULK;
+    epCfg.burstLen = glUsb2Mode ? 1 : burstLength;
+    epCfg.streams = 0;
+    epCfg.pcktSize = glEpPacketSize;
 
-	// Start the GPIF state machine
-    apiReturnStatus = CyU3PGpifSMStart (START, ALPHA_START);
+    apiReturnStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupStartApplication(): CyU3PGpifSMStart failed, error code = %d\r\n", apiReturnStatus);
-        domDupErrorHandler(apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupConfigureConsumerEp(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
+        return apiReturnStatus;
     }
 
-    // Set the application active flag to true
-    glIsApplnActive = CyTrue;
+    // Flush the end-point
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+    return CY_U3P_SUCCESS;
 }
 
 // Function to stop the application.  Called when host signals RESET or DISCONNECT
@@ -667,6 +710,7 @@ void domDupStopApplication(void)
 
     // Set the application activity flag to false
     glIsApplnActive = CyFalse;
+    domDupTrace(CY_FX_TRACE_APP_STOP, 0, 0);
 
     // Disable the GPIF state-machine
     CyU3PGpifDisable(CyTrue);
@@ -676,6 +720,12 @@ void domDupStopApplication(void)
 
     // Destroy DMA channels
     CyU3PDmaMultiChannelDestroy(&glDmaMultiChHandle);
+#ifdef DOMDUP_SIDEBAND_EP
+    domDupSidebandStop();
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+    domDupNotifyStop();
+#endif
 
     // Flush end-points
     CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
@@ -687,11 +737,557 @@ void domDupStopApplication(void)
     // Un-configure consumer end-point
     apiReturnStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
-        CyU3PDebugPrint(4, "domDupStopApplication(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupStopApplication(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
         domDupErrorHandler(apiReturnStatus);
     }
 }
 
+// Discard any data held in the GPIF to USB path.  Called (with collectData low,
+// so the FPGA sample path is held in reset) before data collection starts.
+//
+// The GPIF state-machine is restarted as well as the DMA channel, so that the
+// first packet is produced on thread 0 (the socket the DMA channel consumes
+// first) even if a packet was cut short when collection last stopped.
+void domDupResetDataPath(void)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+    domDupTrace(CY_FX_TRACE_DATA_PATH_RESET, 0, 0);
+
+    // Stop the GPIF state-machine (keeping the configuration)
+    CyU3PGpifDisable(CyFalse);
+
+    // Discard the buffered data
+    CyU3PDmaMultiChannelReset(&glDmaMultiChHandle);
+    domDupTelemetryChannelReset();
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+    apiReturnStatus = CyU3PDmaMultiChannelSetXfer(&glDmaMultiChHandle, 0, 0);
+    if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupResetDataPath(): CyU3PDmaMultiChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
+	}
+
+    // Apply the thread water-mark levels set by the host (and clear the
+    // socket statistics)
+    domDupSocketConfigure();
+
+    // Restart the GPIF state-machine
+    apiReturnStatus = CyU3PGpifSMStart(START, ALPHA_START);
+    if (apiReturnStatus != CY_U3P_SUCCESS) {
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupResetDataPath(): CyU3PGpifSMStart failed, error code = %d\r\n", apiReturnStatus);
+    }
+}
+
+// Recover from a consumer end-point halt without restarting data collection
+// (called from the command thread, with the end-point NAKed)
+//
+// The data held in the DMA buffers is discarded, but the FPGA keeps running
+// and holds the samples that arrive during the recovery in its buffer, so the
+// stream resumes with a gap of at most the FX3 buffer pool (plus anything the
+// FPGA could not hold, which it reports as an overflow).  The position of the
+// gap is recorded in the telemetry (lastRecoveryOffset).
+//
+// The GPIF state-machine can only be restarted at a packet boundary (a packet
+// cut short would misalign all the packets that follow), so the recovery waits
+// until the GPIF is blocked in one of its wait states: with the end-point
+// NAKed the DMA buffers fill up and the GPIF stops before requesting the next
+// packet.  If that doesn't happen within CY_FX_RECOVERY_TIMEOUT_MS the FPGA
+// sample path is restarted instead (as for a start request).
+CyU3PReturnStatus_t domDupRecoverEndpoint(void)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+    uint8_t state = START;
+    uint8_t lastState = START;
+    uint32_t waitMs;
+    CyBool_t restart = CyFalse;
+
+    if (dataCollectionFlag) {
+    	// Wait for the GPIF to stay in the same wait state for 1 ms
+    	restart = CyTrue;
+    	for (waitMs = 0; waitMs < CY_FX_RECOVERY_TIMEOUT_MS; waitMs++) {
+    		if (CyU3PGpifGetSMState(&state) == CY_U3P_SUCCESS) {
+    			if (((state == TH0_WAIT) || (state == TH1_WAIT)) && (state == lastState)) {
+    				restart = CyFalse;
+    				break;
+    			}
+    			lastState = state;
+    		}
+    		CyU3PThreadSleep(1);
+    	}
+
+    	domDupTelemetryStreamRecovery(&glDmaMultiChHandle, restart);
+    	domDupTrace(CY_FX_TRACE_EP_RECOVERY, restart, waitMs);
+    }
+
+    if (restart) CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyFalse); // collectData GPIO low
+
+    // Stop the GPIF state-machine (keeping the configuration)
+    CyU3PGpifDisable(CyFalse);
+
+    // Discard the buffered data and reset the end-point
+    CyU3PDmaMultiChannelReset(&glDmaMultiChHandle);
+    domDupTelemetryChannelReset();
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+    CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
+
+    apiReturnStatus = CyU3PDmaMultiChannelSetXfer(&glDmaMultiChHandle, 0, 0);
+    if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupRecoverEndpoint(): CyU3PDmaMultiChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
+	}
+
+    // Restart the GPIF state-machine (from thread 0, the socket the DMA
+    // channel consumes first)
+    if (CyU3PGpifSMStart(START, ALPHA_START) != CY_U3P_SUCCESS) {
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupRecoverEndpoint(): CyU3PGpifSMStart failed\r\n");
+        apiReturnStatus = CY_U3P_ERROR_FAILURE;
+    }
+
+    if (restart) {
+    	// The stream starts again from sample 0, so the capture length does too
+    	domDupCaptureLengthStart();
+    	CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyTrue); // collectData GPIO high
+    }
+
+    // Resume sending data to the host
+    CyU3PUsbSetEpNak(CY_FX_EP_CONSUMER, CyFalse);
+
+    return apiReturnStatus;
+}
+
+// Select a stream profile (0xC3)
+//
+// The DMA channel is recreated with the profile's buffer count and the
+// consumer end-point is configured with its burst length, so the profile can
+// only be changed whilst data collection is stopped.  If the DMA pool can't be
+// allocated the default profile is used instead; the result is then that of
+// the default profile, and the fallback is traced (the host sees it as the
+// active profile in 0xC4).
+CyU3PReturnStatus_t domDupSetStreamProfile(uint16_t profile)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+    CyU3PReturnStatus_t profileStatus;
+    domDupStreamProfile_t settings;
+
+    if (profile >= CY_FX_STREAM_PROFILES) return CY_U3P_ERROR_BAD_ARGUMENT;
+    if (dataCollectionFlag) return CY_U3P_ERROR_INVALID_SEQUENCE;
+    if (profile == glStreamProfile) return CY_U3P_SUCCESS;
+
+    glStreamProfile = profile;
+    domDupGetStreamProfileSettings(profile, &settings);
+    apiReturnStatus = domDupSetStreamSettings(&settings);
+    if ((apiReturnStatus != CY_U3P_SUCCESS) && (profile != CY_FX_STREAM_PROFILE_DEFAULT)) {
+    	profileStatus = apiReturnStatus;
+    	glStreamProfile = CY_FX_STREAM_PROFILE_DEFAULT;
+    	domDupGetStreamProfileSettings(CY_FX_STREAM_PROFILE_DEFAULT, &settings);
+    	apiReturnStatus = domDupSetStreamSettings(&settings);
+    	if (apiReturnStatus != CY_U3P_SUCCESS) domDupErrorHandler(apiReturnStatus);
+
+    	domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSetStreamProfile(): Profile %d failed, Error code = %d, using the default profile\r\n",
+    		profile, profileStatus);
+    	domDupTrace(CY_FX_TRACE_PROFILE_FALLBACK, profile, profileStatus);
+    }
+    domDupTrace(CY_FX_TRACE_STREAM_PROFILE, glStreamProfile, domDupGetDmaBufferCount());
+
+    return apiReturnStatus;
+}
+
+// Recreate the data path with a burst length and DMA buffer count (per
+// socket) that need not be one of the stream profiles (called from the
+// command thread whilst data collection is stopped)
+//
+// The stream profile is not changed; selecting the profile again restores its
+// settings.  If the DMA pool can't be allocated the GPIF state-machine is left
+// stopped and the error is returned.
+CyU3PReturnStatus_t domDupSetStreamSettings(const domDupStreamProfile_t *settings)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+    // Stop the GPIF state-machine (keeping the configuration)
+    CyU3PGpifDisable(CyFalse);
+    CyU3PDmaMultiChannelDestroy(&glDmaMultiChHandle);
+
+    glStreamSettings = *settings;
+    apiReturnStatus = domDupCreateDataPath();
+    if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+    // Restart the GPIF state-machine
+    if (CyU3PGpifSMStart(START, ALPHA_START) != CY_U3P_SUCCESS) {
+        domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSetStreamSettings(): CyU3PGpifSMStart failed\r\n");
+        apiReturnStatus = CY_U3P_ERROR_FAILURE;
+    }
+
+    return apiReturnStatus;
+}
+
+// Release the data path DMA channel (with the GPIF state-machine stopped) so
+// that its buffers can be used by another channel; domDupSetStreamSettings
+// creates it again
+void domDupReleaseDataPath(void)
+{
+    CyU3PGpifDisable(CyFalse);
+    CyU3PDmaMultiChannelDestroy(&glDmaMultiChHandle);
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+}
+
+// Get the stream profile in use
+uint16_t domDupGetStreamProfile(void)
+{
+    return glStreamProfile;
+}
+
+// Get the burst length and the number of DMA buffers per socket of a stream
+// profile
+void domDupGetStreamProfileSettings(uint16_t profile, domDupStreamProfile_t *settings)
+{
+    if (profile >= CY_FX_STREAM_PROFILES) profile = CY_FX_STREAM_PROFILE_DEFAULT;
+
+    settings->burstLength = glStreamProfiles[profile].burstLength;
+    settings->bufferCount = glStreamProfiles[profile].bufferCount;
+    if (settings->bufferCount == CY_FX_STREAM_BUF_COUNT_MAX) settings->bufferCount = CY_FX_DMA_BUF_COUNT_MAX;
+}
+
+// Get the number of DMA buffers per socket in use
+uint16_t domDupGetDmaBufferCount(void)
+{
+    return glStreamSettings.bufferCount;
+}
+
+// Select the packet size (0xD6)
+//
+// The size is in Kbytes (4, 8 or 16) and takes effect when data collection is
+// next started (see domDupApplyPacketSize).
+CyU3PReturnStatus_t domDupSetPacketSize(uint16_t kbytes)
+{
+    uint32_t size = (uint32_t)kbytes * 1024;
+
+    if ((size != CY_FX_DMA_BUF_SIZE) && (size != CY_FX_DMA_BUF_SIZE / 2) && (size != CY_FX_PACKET_SIZE_MIN)) {
+    	return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    glRequestedPacketSize = size;
+    return CY_U3P_SUCCESS;
+}
+
+// Get the packet (DMA buffer) size in use
+uint32_t domDupGetPacketSize(void)
+{
+    return glPacketSize;
+}
+
+// Apply the packet size selected by the host (called from the command thread
+// on a start request, before the FPGA sample path is released)
+//
+// The FPGA packet length and the DMA buffer size are always changed together:
+// the GPIF fills one DMA buffer per FPGA packet, so a mismatch would misalign
+// every packet.  The size is written to the FPGA on every start, as the FPGA
+// register is cleared whenever the FPGA is reset.  An FPGA without the packet
+// size register only sends 16 Kbyte packets, so that size is used instead
+// (the debug console shows why).  The DMA channel is only recreated when the
+// size changes.
+static CyU3PReturnStatus_t domDupApplyPacketSize(void)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+    uint32_t size = glRequestedPacketSize;
+    uint32_t features = 0;
+    uint32_t code;
+
+    if (size != CY_FX_DMA_BUF_SIZE) {
+    	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_FEATURES, &features);
+    	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+    	if (!(features & CY_FX_FPGA_FEATURE_PACKET_SIZE)) {
+    		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupApplyPacketSize(): The FPGA only sends 16 Kbyte packets\r\n");
+    		size = CY_FX_DMA_BUF_SIZE;
+    	}
+    }
+
+    if (size == CY_FX_PACKET_SIZE_MIN) code = CY_FX_FPGA_PACKET_4K;
+    else if (size == CY_FX_DMA_BUF_SIZE / 2) code = CY_FX_FPGA_PACKET_8K;
+    else code = CY_FX_FPGA_PACKET_16K;
+
+    apiReturnStatus = domDupFpgaRegisterWrite(CY_FX_FPGA_REG_PACKET_SIZE, code);
+    if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+    if (size == glPacketSize) return CY_U3P_SUCCESS;
+
+    domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupApplyPacketSize(): Packet size %d bytes\r\n", size);
+    glPacketSize = size;
+    return domDupSetStreamSettings(&glStreamSettings);
+}
+
+// Apply the configuration bits (0xB6)
+//
+// The passed wValue is interpreted as a bit flag.  Bits 0 to 9 are
+// written to the same bits of the FPGA control register, which the
+// FPGA loads in a single clock at the end of the register write, so
+// every setting changes together (the FPGA is never left with a mix of
+// the old and new configuration).
+//
+// Bit 0 - Test mode (FPGA sends test data instead of ADC data)
+// Bit 1 - 10-bit packed mode (FPGA packs samples into 16-bit words)
+// Bit 2 - Packet header mode (FPGA adds a header to each packet)
+// Bits 3-4 - Sampling rate (40, 28.636 or 20 MHz)
+// Bit 5 - Decimation mode (FPGA filters and halves the sample rate)
+// Bit 6 - Compressed mode (FPGA compresses the samples)
+// Bit 7 - Soak mode (FPGA sends a PRBS and ends each packet with its CRC)
+// Bit 8 - Packet CRC mode (FPGA sends each packet's CRC in the next header)
+// Bit 9 - Two-channel mode (FPGA decimates both ADCs and interleaves them)
+//
+// Two-channel mode is dropped from the applied configuration unless the FPGA
+// was built with the second ADC (CY_FX_FPGA_FEATURE_DUAL_ADC).
+//
+// When connected to a USB 2.0 port the CY_FX_CONFIG_USB2_FORCED bits are set
+// whatever the host requested.  The requested bits are kept so they can be
+// applied again (without the forced bits) when the device is reconnected to a
+// USB 3 port.
+CyU3PReturnStatus_t domDupApplyConfiguration(uint16_t value)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+    uint32_t features = 0;
+
+    glRequestedConfiguration = value;
+    if (glUsb2Mode) value |= CY_FX_CONFIG_USB2_FORCED;
+
+    if (value & CY_FX_CONFIG_TWO_CHANNEL) {
+        apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_FEATURES, &features);
+        if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+        if (!(features & CY_FX_FPGA_FEATURE_DUAL_ADC)) {
+            domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupApplyConfiguration(): The FPGA has no second ADC; two-channel mode is off\r\n");
+            value &= ~CY_FX_CONFIG_TWO_CHANNEL;
+        }
+    }
+    glAppliedConfiguration = value;
+
+    domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupApplyConfiguration(): Configuration 0x%x: FPGA control register = 0x%x\r\n",
+    		value, value & CY_FX_CONFIG_MASK);
+    return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_CONTROL, value & CY_FX_CONFIG_MASK);
+}
+
+// Get the configuration bits last sent by the host
+uint16_t domDupGetRequestedConfiguration(void)
+{
+    return glRequestedConfiguration;
+}
+
+// Stop data collection (called from the command thread)
+//
+// The FPGA sample path is held in reset, but the packets already in the DMA
+// buffers are still sent to the host.
+static void domDupStopCollection(void)
+{
+	domDupCaptureLengthStop(CyTrue);
+	CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyFalse); // collectData GPIO low
+
+	// Flag that the host is not collecting data
+	dataCollectionFlag = CyFalse;
+	domDupLinkPowerCollecting(CyFalse);
+
+	// Clear the input flags
+	input0Flag = CyFalse;
+	input2Flag = CyFalse;
+	input3Flag = CyFalse;
+	input0HandledFlag = CyFalse;
+	input2HandledFlag = CyFalse;
+	input3HandledFlag = CyFalse;
+}
+
+// Carry out a host to device vendor command (called from the command thread)
+//
+// Returns the result of the command, which the host can read back with
+// CY_FX_VREQ_GET_COMMAND_STATUS.
+CyU3PReturnStatus_t domDupRunCommand(uint8_t request, uint16_t value)
+{
+    CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+    // The application may have been stopped since the command was queued
+    if (!glIsApplnActive) return CY_U3P_ERROR_NOT_STARTED;
+
+    switch (request) {
+    // Collection start/stop 0xB5
+    case CY_FX_VREQ_COLLECT_DATA:
+		if (value == 1) {
+			// Start collection request from USB host
+			//
+			// The FPGA holds its sample path in reset whilst collectData
+			// is low, so the stale data is flushed (restarting collection
+			// if it was already running) before collectData is raised and
+			// the first packet sent starts with sample 0.
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xB5: START data collection\r\n");
+			CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyFalse); // collectData GPIO low
+			apiReturnStatus = domDupApplyPacketSize();
+			if (apiReturnStatus != CY_U3P_SUCCESS) {
+				domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupRunCommand(): Failed to apply the packet size, Error code = %d\r\n", apiReturnStatus);
+				domDupStopCollection();
+				break;
+			}
+			domDupLinkPowerCollecting(CyTrue);
+			domDupResetDataPath();
+			domDupCaptureLengthStart();
+			CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyTrue); // collectData GPIO high
+
+			// Clear the input flags
+			input0Flag = CyFalse;
+			input2Flag = CyFalse;
+			input3Flag = CyFalse;
+			input0HandledFlag = CyFalse;
+			input2HandledFlag = CyFalse;
+			input3HandledFlag = CyFalse;
+
+			// Flag that the host is collecting data
+			dataCollectionFlag = CyTrue;
+		} else if (value == 0) {
+			// Stop collection request from USB host
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xB5: STOP data collection\r\n");
+			domDupStopCollection();
+		} else {
+			apiReturnStatus = CY_U3P_ERROR_BAD_ARGUMENT;
+		}
+		break;
+
+    // Configuration 0xB6 (see domDupApplyConfiguration)
+    case CY_FX_VREQ_CONFIGURATION:
+		apiReturnStatus = domDupApplyConfiguration(value);
+		break;
+
+    // Multi-device sync control 0xBD
+    //
+    // Bits 0-1 of wValue select the sync role (0 = stand-alone,
+    // 1 = master, 2 = slave).  Setting bit 2 on the master sends a
+    // start strobe, restarting the sequence numbers on every device.
+    case CY_FX_VREQ_SYNC_CONTROL:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xBD: Sync role = %d, start = %d\r\n",
+				value & CY_FX_FPGA_SYNC_ROLE_MASK, (value & CY_FX_FPGA_SYNC_START) ? 1 : 0);
+		apiReturnStatus = domDupFpgaRegisterWrite(CY_FX_FPGA_REG_SYNC_CONTROL,
+				value & (CY_FX_FPGA_SYNC_ROLE_MASK | CY_FX_FPGA_SYNC_START));
+		break;
+
+    // Stream profile 0xC3
+    //
+    // wValue selects the stream profile, or CY_FX_SELF_TEST_START runs the
+    // throughput self-test (see domDupSelfTestRun)
+    case CY_FX_VREQ_STREAM_PROFILE:
+		if (value == CY_FX_SELF_TEST_START) {
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xC3: Throughput self-test\r\n");
+			apiReturnStatus = domDupSelfTestRun();
+		} else {
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xC3: Stream profile %d\r\n", value);
+			apiReturnStatus = domDupSetStreamProfile(value);
+		}
+		break;
+
+    // Armed capture setting 0xC7
+    //
+    // Bits 15-14 of wValue select the setting (see CY_FX_TRIGGER_SET_*).
+    // The FPGA only reads the settings whilst data collection is stopped.
+    case CY_FX_VREQ_TRIGGER_CONTROL:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xC7: Trigger setting 0x%x\r\n", value);
+		if (dataCollectionFlag) {
+			apiReturnStatus = CY_U3P_ERROR_INVALID_SEQUENCE;
+		} else {
+			apiReturnStatus = domDupFpgaSetTrigger(value);
+		}
+		break;
+
+    // Logic analyzer 0xCB
+    //
+    // Bits 15-14 of wValue select the setting or action (see
+    // CY_FX_ANALYZER_*)
+    case CY_FX_VREQ_LOGIC_ANALYZER:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xCB: Logic analyzer 0x%x\r\n", value);
+		apiReturnStatus = domDupLogicAnalyzerCommand(value);
+		break;
+
+    // GPIF thread watermark 0xCD
+    //
+    // Bits 7-0 of wValue are the watermark and bits 9-8 select the threads
+    // (see CY_FX_WATERMARK_*).  The watermark is applied when data
+    // collection is next started.
+    case CY_FX_VREQ_SOCKET_WATERMARK:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xCD: Socket watermark 0x%x\r\n", value);
+		apiReturnStatus = domDupSocketSetWatermark(value);
+		break;
+
+    // Capture length 0xD1
+    //
+    // Bit 15 of wValue selects which half of the length (in packets)
+    // bits 14-0 are written to (see CY_FX_CAPTURE_SET_*).  The
+    // FPGA only reads the length whilst data collection is stopped.
+    case CY_FX_VREQ_CAPTURE_LENGTH:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xD1: Capture length setting 0x%x\r\n", value);
+		if (dataCollectionFlag) {
+			apiReturnStatus = CY_U3P_ERROR_INVALID_SEQUENCE;
+		} else {
+			apiReturnStatus = domDupCaptureLengthCommand(value);
+		}
+		break;
+
+    // Packet size 0xD6
+    //
+    // wValue is the packet size in Kbytes (4, 8 or 16), applied when data
+    // collection is next started
+    case CY_FX_VREQ_PACKET_SIZE:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xD6: Packet size %d Kbytes\r\n", value);
+		apiReturnStatus = domDupSetPacketSize(value);
+		break;
+
+#ifdef DOMDUP_BENCHMARK
+    // Throughput benchmark 0xC9 (benchmark firmware)
+    //
+    // wValue selects the data source (see CY_FX_BENCHMARK_SOURCE_*)
+    case CY_FX_VREQ_BENCHMARK:
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Command 0xC9: Throughput benchmark, source %d\r\n", value);
+		apiReturnStatus = domDupBenchmarkRun(value);
+		break;
+#endif
+
+    // Consumer end-point halt cleared (queued by domDupUSBSetupCB)
+    case CY_FX_COMMAND_RECOVER_ENDPOINT:
+		apiReturnStatus = domDupRecoverEndpoint();
+		break;
+
+    // Capture length reached (queued by domDupCaptureLengthUpdate)
+    //
+    // wValue is the capture number; the command is ignored if the host has
+    // stopped or restarted collection since it was queued.
+    case CY_FX_COMMAND_CAPTURE_COMPLETE:
+		if (dataCollectionFlag && domDupCaptureLengthIsComplete(value)) {
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupRunCommand(): Capture length reached: STOP data collection\r\n");
+			domDupStopCollection();
+			apiReturnStatus = domDupCaptureLengthEndStream(&glDmaMultiChHandle);
+		}
+		break;
+
+    default:
+		apiReturnStatus = CY_U3P_ERROR_BAD_ARGUMENT;
+		break;
+    }
+
+    return apiReturnStatus;
+}
+
+// Initialise the FPGA register interface
+//
+// A missing or incompatible FPGA configuration is not fatal (the data path does
+// not depend on the register interface), so the result is only reported on the
+// debug console.
+void domDupFpgaInitialise(void)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t interfaceId = 0;
+
+	apiReturnStatus = domDupFpgaRegisterInitialise();
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupFpgaInitialise(): domDupFpgaRegisterInitialise failed, Error code = %d\r\n", apiReturnStatus);
+		domDupErrorHandler(apiReturnStatus);
+	}
+
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_ID, &interfaceId);
+	if ((apiReturnStatus != CY_U3P_SUCCESS) || (interfaceId != CY_FX_FPGA_INTERFACE_ID)) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupFpgaInitialise(): WARNING - FPGA register interface not found (ID = 0x%x)\r\n", interfaceId);
+	} else {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupFpgaInitialise(): FPGA register interface ID = 0x%x\r\n", interfaceId);
+	}
+}
+
 // Error handling function
 void domDupErrorHandler(CyU3PReturnStatus_t apiReturnStatus)
 {
@@ -737,7 +1333,7 @@ void domDupDebugInit(void)
     }
 
     // Initialise debug on the UART
-    apiReturnStatus = CyU3PDebugInit(CY_U3P_LPP_SOCKET_UART_CONS, 8);
+    apiReturnStatus = CyU3PDebugInit(CY_U3P_LPP_SOCKET_UART_CONS, DOMDUP_LOG_LEVEL);
     if (apiReturnStatus != CY_U3P_SUCCESS) {
         domDupErrorHandler(apiReturnStatus);
     }
@@ -750,16 +1346,23 @@ void domDupDebugInit(void)
 // Handle CPU_INT from GPIF callback (set when the FPGA FIFO buffer is full)
 void gpifDmaEventCB(CyU3PGpifEventType Event, uint8_t State)
 {
-	if (Event == CYU3P_GPIF_EVT_SM_INTERRUPT) CyU3PDebugPrint(8, "gpifDmaEventCB(): Unhandled INT_CPU signal received from GPIF\r\n");
+	// Unhandled (recorded in the trace log only)
+	domDupTrace(CY_FX_TRACE_GPIF_INTERRUPT, Event, State);
 }
 
 // USB set-up request callback
+//
+// The device to host requests are answered from copies kept by the
+// application and command threads (see fpga-status.c and rf-stats.c), so the
+// callback never reads the FPGA registers or waits for a mutex; EP0 responds
+// in the same time whatever the threads are doing.
 CyBool_t domDupUSBSetupCB(uint32_t setupData0, uint32_t setupData1)
 {
     uint8_t  bRequest, bReqType;
     uint8_t  bType, bTarget;
     uint16_t wValue;
     uint16_t wIndex;
+    uint16_t wLength;
     CyBool_t isHandled = CyFalse;
 
     /* Decode the fields from the setup request. */
@@ -769,102 +1372,216 @@ CyBool_t domDupUSBSetupCB(uint32_t setupData0, uint32_t setupData1)
     bRequest = ((setupData0 & CY_U3P_USB_REQUEST_MASK) >> CY_U3P_USB_REQUEST_POS);
     wValue   = ((setupData0 & CY_U3P_USB_VALUE_MASK)   >> CY_U3P_USB_VALUE_POS);
     wIndex   = ((setupData1 & CY_U3P_USB_INDEX_MASK)   >> CY_U3P_USB_INDEX_POS);
+    wLength  = ((setupData1 & CY_U3P_USB_LENGTH_MASK)  >> CY_U3P_USB_LENGTH_POS);
+
+    // Handle vendor specific requests from the host (device to host)
+    if ((bType == CY_U3P_USB_VENDOR_RQT) && (bReqType & 0x80)) {
+    	// Windows reads the Microsoft OS 2.0 descriptor set during enumeration,
+    	// before the device is configured
+    	if ((bRequest == CY_FX_VREQ_MS_OS_20) && (wIndex == CY_FX_MS_OS_20_DESCRIPTOR_INDEX)) {
+    		return domDupSendVendorResponse((uint8_t *)USBMsOs20DscrSet, CY_FX_MS_OS_20_SET_LENGTH, wLength);
+    	}
 
-    // Handle vendor specific requests from the host
-    if (bType == CY_U3P_USB_VENDOR_RQT) {
     	if (glIsApplnActive) {
-			// Handle vendor request for collection start/stop
-			if (bRequest == 0xB5) {
-				if (wValue == 1) {
-					// Start collection request from USB host
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Vendor specific command received: START data collection\r\n");
-					CyU3PGpioSetValue(19, CyTrue); // collectData GPIO high
-
-					// Clear the input flags
-					input0Flag = CyFalse;
-					input1Flag = CyFalse;
-					input2Flag = CyFalse;
-					input3Flag = CyFalse;
-					input0HandledFlag = CyFalse;
-					input1HandledFlag = CyFalse;
-					input2HandledFlag = CyFalse;
-					input3HandledFlag = CyFalse;
-
-					// Flag that the host is collecting data
-					dataCollectionFlag = CyTrue;
-				}
-
-				if (wValue == 0) {
-					// Stop collection request from USB host
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Vendor specific command received: STOP data collection\r\n");
-					CyU3PGpioSetValue(19, CyFalse); // collectData GPIO low
-
-					// Flag that the host is not collecting data
-					dataCollectionFlag = CyFalse;
-
-					// Clear the input flags
-					input0Flag = CyFalse;
-					input1Flag = CyFalse;
-					input2Flag = CyFalse;
-					input3Flag = CyFalse;
-					input0HandledFlag = CyFalse;
-					input1HandledFlag = CyFalse;
-					input2HandledFlag = CyFalse;
-					input3HandledFlag = CyFalse;
-				}
-			}
+    		// Handle vendor request for the DMA buffer configuration
+    		if (bRequest == CY_FX_VREQ_GET_BUFFER_CONFIG) {
+    			domDupBufferConfig_t bufferConfig;
+
+    			bufferConfig.bufferSize = glPacketSize;
+    			bufferConfig.buffersPerSocket = domDupGetDmaBufferCount();
+    			bufferConfig.producerSockets = CY_FX_DMA_PRODUCER_SOCKETS;
+    			bufferConfig.totalBytes = glPacketSize * bufferConfig.buffersPerSocket * CY_FX_DMA_PRODUCER_SOCKETS;
+    			isHandled = domDupSendVendorResponse((uint8_t *)&bufferConfig, sizeof(bufferConfig), wLength);
+    		}
+
+    		// Handle vendor request for the telemetry counters
+    		if (bRequest == CY_FX_VREQ_GET_TELEMETRY) {
+    			domDupTelemetry_t telemetry;
+
+    			domDupTelemetrySnapshot(&telemetry);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&telemetry, sizeof(telemetry), wLength);
+    		}
+
+    		// Handle vendor request for the FPGA overflow status
+    		if (bRequest == CY_FX_VREQ_GET_OVERFLOW_STATUS) {
+    			domDupOverflowStatus_t overflowStatus;
+
+    			if (domDupFpgaStatusGetOverflow(&overflowStatus)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&overflowStatus, sizeof(overflowStatus), wLength);
+    			}
+    		}
+
+    		// Handle vendor request for the current sampling rate
+    		if (bRequest == CY_FX_VREQ_GET_SAMPLE_RATE) {
+    			uint32_t sampleRate;
+
+    			if (domDupFpgaStatusGetSampleRate(&sampleRate)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&sampleRate, sizeof(sampleRate), wLength);
+    			}
+    		}
+
+    		// Handle vendor request for an FPGA register
+    		if (bRequest == CY_FX_VREQ_GET_FPGA_REGISTER) {
+    			uint32_t registerValue;
+
+    			if (domDupFpgaStatusGetRegister(wIndex, &registerValue)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&registerValue, sizeof(registerValue), wLength);
+    			}
+    		}
+
+#ifdef DOMDUP_DMA_LATENCY_STATS
+    		// Handle vendor request for the DMA latency statistics
+    		if (bRequest == CY_FX_VREQ_GET_DMA_LATENCY) {
+    			domDupDmaLatency_t dmaLatency;
+
+    			domDupDmaLatencySnapshot(&dmaLatency);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&dmaLatency, sizeof(dmaLatency), wLength);
+    		}
+#endif
+
+    		// Handle vendor request for the current configuration
+    		if (bRequest == CY_FX_VREQ_GET_CONFIGURATION) {
+    			domDupConfiguration_t configuration;
+
+    			configuration.requested = glRequestedConfiguration;
+    			configuration.applied = glAppliedConfiguration;
+    			configuration.usbSpeed = CyU3PUsbGetSpeed();
+    			isHandled = domDupSendVendorResponse((uint8_t *)&configuration, sizeof(configuration), wLength);
+    		}
+
+    		// Handle vendor request for the throughput self-test results
+    		if (bRequest == CY_FX_VREQ_GET_SELF_TEST) {
+    			domDupSelfTest_t selfTest;
+
+    			domDupSelfTestGetResults(&selfTest);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&selfTest, sizeof(selfTest), wLength);
+    		}
+
+#ifdef DOMDUP_BENCHMARK
+    		// Handle vendor request for the throughput benchmark results
+    		if (bRequest == CY_FX_VREQ_GET_BENCHMARK) {
+    			domDupBenchmark_t benchmark;
+
+    			domDupBenchmarkGetResults(&benchmark);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&benchmark, sizeof(benchmark), wLength);
+    		}
+#endif
+
+    		// Handle vendor request for the signal preview
+    		if (bRequest == CY_FX_VREQ_GET_PREVIEW) {
+    			domDupPreview_t preview;
+
+    			domDupPreviewSnapshot(&preview);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&preview, sizeof(preview), wLength);
+    		}
+
+    		// Handle vendor request for the RF statistics
+    		if (bRequest == CY_FX_VREQ_GET_RF_STATS) {
+    			isHandled = domDupRfStatsSend(wLength);
+    		}
+
+    		// Handle vendor request for the GPIF producer socket statistics
+    		if (bRequest == CY_FX_VREQ_GET_SOCKET_STATS) {
+    			domDupSocketStats_t socketStats;
+
+    			domDupSocketStatsSnapshot(&socketStats);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&socketStats, sizeof(socketStats), wLength);
+    		}
+
+    		// Handle vendor request for the armed capture status
+    		if (bRequest == CY_FX_VREQ_GET_TRIGGER_STATUS) {
+    			domDupTriggerStatus_t triggerStatus;
+
+    			if (domDupFpgaStatusGetTrigger(&triggerStatus)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&triggerStatus, sizeof(triggerStatus), wLength);
+    			}
+    		}
+
+    		// Handle vendor request for the logic analyzer capture
+    		if (bRequest == CY_FX_VREQ_GET_LOGIC_ANALYZER) {
+    			isHandled = domDupLogicAnalyzerSend(wLength);
+    		}
+
+    		// Handle vendor request for the trace log
+    		if (bRequest == CY_FX_VREQ_GET_TRACE) {
+    			isHandled = domDupTraceSend(wLength);
+    		}
+
+    		// Handle vendor request to drain the FPGA input events
+    		if (bRequest == CY_FX_VREQ_GET_INPUT_EVENTS) {
+    			isHandled = domDupInputEventsSend(wLength);
+    		}
+
+    		// Handle vendor request for the capture length state
+    		if (bRequest == CY_FX_VREQ_GET_CAPTURE_LENGTH) {
+    			domDupCaptureLength_t captureLength;
+
+    			domDupCaptureLengthSnapshot(&captureLength);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&captureLength, sizeof(captureLength), wLength);
+    		}
+
+    		// Handle vendor request for the FPGA pipeline statistics
+    		if (bRequest == CY_FX_VREQ_GET_PIPELINE_STATS) {
+    			domDupPipelineStats_t pipelineStats;
+
+    			if (domDupFpgaStatusGetPipeline(&pipelineStats)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&pipelineStats, sizeof(pipelineStats), wLength);
+    			}
+    		}
+
+    		// Handle vendor request for the memory budget
+    		if (bRequest == CY_FX_VREQ_GET_MEMORY_BUDGET) {
+    			domDupMemoryBudget_t memoryBudget;
+
+    			domDupMemoryBudgetSnapshot(&memoryBudget);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&memoryBudget, sizeof(memoryBudget), wLength);
+    		}
+
+    		// Handle vendor request for the status of the queued commands
+    		if (bRequest == CY_FX_VREQ_GET_COMMAND_STATUS) {
+    			domDupCommandStatus_t commandStatus;
+
+    			domDupCommandGetStatus(&commandStatus);
+    			isHandled = domDupSendVendorResponse((uint8_t *)&commandStatus, sizeof(commandStatus), wLength);
+    		}
+
+    		// Handle vendor request for the multi-device sync status
+    		if (bRequest == CY_FX_VREQ_GET_SYNC_STATUS) {
+    			domDupSyncStatus_t syncStatus;
+
+    			if (domDupFpgaStatusGetSync(&syncStatus)) {
+    				isHandled = domDupSendVendorResponse((uint8_t *)&syncStatus, sizeof(syncStatus), wLength);
+    			}
+    		}
+    	}
+
+    	// Unknown requests are stalled by the USB driver
+    	return isHandled;
+    }
 
-			// Handle vendor request for configuration 0xB6
-			//
-			// The passed wValue is interpreted as a bit flag and causes
-			// GPIOs 22 to 26 to be set according to bits 0-4 (bits 5 to 7
-			// are ignored).
-			if (bRequest == 0xB6) {
-				// Check bit 0 (GPIO 22)
-				if ((wValue & 0x01) != 0) {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 0 = GPIO22 High\r\n");
-					CyU3PGpioSetValue(22, CyTrue); // GPIO high
-				} else {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 0 = GPIO22 Low\r\n");
-					CyU3PGpioSetValue(22, CyFalse); // GPIO Low
-				}
-
-				// Check bit 1 (GPIO 23)
-				if ((wValue & 0x02) != 0) {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 1 = GPIO23 High\r\n");
-					CyU3PGpioSetValue(23, CyTrue); // GPIO high
-				} else {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 1 = GPIO23 Low\r\n");
-					CyU3PGpioSetValue(23, CyFalse); // GPIO Low
-				}
-
-				// Check bit 2 (GPIO 24)
-				if ((wValue & 0x04) != 0) {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 2 = GPIO24 High\r\n");
-					CyU3PGpioSetValue(24, CyTrue); // GPIO high
-				} else {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 2 = GPIO24 Low\r\n");
-					CyU3PGpioSetValue(24, CyFalse); // GPIO Low
-				}
-
-				// Check bit 3 (GPIO 25)
-				if ((wValue & 0x08) != 0) {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 3 = GPIO25 High\r\n");
-					CyU3PGpioSetValue(25, CyTrue); // GPIO high
-				} else {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 3 = GPIO25 Low\r\n");
-					CyU3PGpioSetValue(25, CyFalse); // GPIO Low
-				}
-
-				// Check bit 4 (GPIO 26)
-				if ((wValue & 0x10) != 0) {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 4 = GPIO26 High\r\n");
-					CyU3PGpioSetValue(26, CyTrue); // GPIO high
-				} else {
-					CyU3PDebugPrint(8, "domDupUSBSetupCB(): Command 0xB6: Bit 4 = GPIO26 Low\r\n");
-					CyU3PGpioSetValue(26, CyFalse); // GPIO Low
-				}
-			}
+    // Handle vendor specific requests from the host (host to device)
+    //
+    // The commands are queued and carried out by the command thread (see
+    // domDupRunCommand()) so that EP0 is not held up.  If the queue is full the
+    // request is stalled.
+    if (bType == CY_U3P_USB_VENDOR_RQT) {
+    	if (glIsApplnActive) {
+    		if ((bRequest == CY_FX_VREQ_COLLECT_DATA) ||
+    			(bRequest == CY_FX_VREQ_CONFIGURATION) ||
+    			(bRequest == CY_FX_VREQ_SYNC_CONTROL) ||
+    			(bRequest == CY_FX_VREQ_STREAM_PROFILE) ||
+    			(bRequest == CY_FX_VREQ_TRIGGER_CONTROL) ||
+    			(bRequest == CY_FX_VREQ_LOGIC_ANALYZER) ||
+    			(bRequest == CY_FX_VREQ_SOCKET_WATERMARK) ||
+    			(bRequest == CY_FX_VREQ_CAPTURE_LENGTH) ||
+    			(bRequest == CY_FX_VREQ_PACKET_SIZE)) {
+    			if (!domDupCommandPost(bRequest, wValue)) return CyFalse;
+    		}
+#ifdef DOMDUP_BENCHMARK
+    		if (bRequest == CY_FX_VREQ_BENCHMARK) {
+    			if (!domDupCommandPost(bRequest, wValue)) return CyFalse;
+    		}
+#endif
 
 			// ACK the request
 			isHandled = CyTrue;
@@ -886,6 +1603,7 @@ CyBool_t domDupUSBSetupCB(uint32_t setupData0, uint32_t setupData1)
                 } else {
                     glForceLinkU2 = CyFalse;
                 }
+                CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_LINK, CYU3P_EVENT_OR);
             }
             else CyU3PUsbStall(0, CyTrue, CyFalse);
 
@@ -898,14 +1616,45 @@ CyBool_t domDupUSBSetupCB(uint32_t setupData0, uint32_t setupData1)
         	(wValue == CY_U3P_USBX_FS_EP_HALT)) {
             if (glIsApplnActive) {
                 if (wIndex == CY_FX_EP_CONSUMER) {
-                    CyU3PDmaMultiChannelReset(&glDmaMultiChHandle);
-                    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
-                    CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
-                    CyU3PDmaMultiChannelSetXfer(&glDmaMultiChHandle, 0, 0);
+                    // The end-point is NAKed whilst the command thread
+                    // recovers the data path (see domDupRecoverEndpoint)
+                    domDupTrace(CY_FX_TRACE_EP_HALT_CLEAR, wIndex, 0);
+                    CyU3PUsbSetEpNak(CY_FX_EP_CONSUMER, CyTrue);
+                    CyU3PUsbStall(wIndex, CyFalse, CyTrue);
+                    isHandled = CyTrue;
+                    CyU3PUsbAckSetup();
+
+                    if (!domDupCommandPost(CY_FX_COMMAND_RECOVER_ENDPOINT, 0)) {
+                        // Queue full; discard the buffered data here
+                        CyU3PDmaMultiChannelReset(&glDmaMultiChHandle);
+                        domDupTelemetryChannelReset();
+                        CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+                        CyU3PUsbResetEp(CY_FX_EP_CONSUMER);
+                        CyU3PDmaMultiChannelSetXfer(&glDmaMultiChHandle, 0, 0);
+                        CyU3PUsbSetEpNak(CY_FX_EP_CONSUMER, CyFalse);
+                    }
+                }
+#ifdef DOMDUP_SIDEBAND_EP
+                if (wIndex == CY_FX_EP_SIDEBAND) {
+                    // Nothing to recover: the queued records are discarded
+                    domDupTrace(CY_FX_TRACE_EP_HALT_CLEAR, wIndex, 0);
+                    domDupSidebandReset();
+                    CyU3PUsbStall(wIndex, CyFalse, CyTrue);
+                    isHandled = CyTrue;
+                    CyU3PUsbAckSetup();
+                }
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+                if (wIndex == CY_FX_EP_NOTIFY) {
+                    // Nothing to recover: the notifications in the DMA
+                    // buffers are discarded
+                    domDupTrace(CY_FX_TRACE_EP_HALT_CLEAR, wIndex, 0);
+                    domDupNotifyReset();
                     CyU3PUsbStall(wIndex, CyFalse, CyTrue);
                     isHandled = CyTrue;
                     CyU3PUsbAckSetup();
                 }
+#endif
             }
         }
     }
@@ -913,16 +1662,44 @@ CyBool_t domDupUSBSetupCB(uint32_t setupData0, uint32_t setupData1)
     return isHandled;
 }
 
+// Send the data phase of a device to host vendor request
+//
+// The response is copied to the aligned EP0 buffer and truncated to the length
+// requested by the host.  Returns CyFalse (causing the request to be stalled)
+// if the response cannot be sent.
+CyBool_t domDupSendVendorResponse(uint8_t *data, uint16_t length, uint16_t wLength)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+	if (length > CY_FX_EP0_BUFFER_SIZE) return CyFalse;
+	if (length > wLength) length = wLength;
+
+	CyU3PMemCopy(glEp0Buffer, data, length);
+	apiReturnStatus = CyU3PUsbSendEP0Data(length, glEp0Buffer);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSendVendorResponse(): CyU3PUsbSendEP0Data failed, Error code = %d\r\n", apiReturnStatus);
+		return CyFalse;
+	}
+
+	return CyTrue;
+}
+
 // Callback function to handle USB events
 void domDupUSBEventCB(CyU3PUsbEventType_t eventType, uint16_t eventData)
 {
+    domDupTelemetryUsbEvent(eventType);
+    domDupTrace(CY_FX_TRACE_USB_EVENT, eventType, eventData);
+#ifdef DOMDUP_NOTIFY_EP
+    domDupNotifyUsbEvent(eventType, eventData);
+#endif
+
     switch (eventType) {
     case CY_U3P_USB_EVENT_CONNECT:
-		CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_CONNECT received - No action taken\r\n");
+		domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_CONNECT received - No action taken\r\n");
 		break;
 
     case CY_U3P_USB_EVENT_SETCONF:
-    	CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_SETCONF received - Restarting application\r\n");
+    	domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_SETCONF received - Restarting application\r\n");
     	// If the application is already active, stop it
         if (glIsApplnActive) {
             domDupStopApplication();
@@ -933,34 +1710,35 @@ void domDupUSBEventCB(CyU3PUsbEventType_t eventType, uint16_t eventData)
         break;
 
     case CY_U3P_USB_EVENT_SUSPEND:
-        CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_SUSPEND received\r\n");
+        domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_SUSPEND received\r\n");
         
         // Always handle suspend properly - stop data collection if active
         if (dataCollectionFlag) {
-            CyU3PDebugPrint(8, "domDupUSBEventCB(): Stopping active data collection for suspend\r\n");
-            CyU3PGpioSetValue(19, CyFalse); // collectData GPIO low
+            domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): Stopping active data collection for suspend\r\n");
+            domDupCaptureLengthStop(CyFalse);
+            CyU3PGpioSetValue(CY_FX_GPIO_COLLECT_DATA, CyFalse); // collectData GPIO low
             dataCollectionFlag = CyFalse;
+            domDupLinkPowerCollecting(CyFalse);
         }
         
         // Clear all input flags
         input0Flag = CyFalse;
-        input1Flag = CyFalse;
         input2Flag = CyFalse;
         input3Flag = CyFalse;
         input0HandledFlag = CyFalse;
-        input1HandledFlag = CyFalse;
         input2HandledFlag = CyFalse;
         input3HandledFlag = CyFalse;
         
         // Flush and reset DMA channel only if application is active
         if (glIsApplnActive) {
             CyU3PDmaMultiChannelReset(&glDmaMultiChHandle);
+            domDupTelemetryChannelReset();
             CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
         }
         break;
 
     case CY_U3P_USB_EVENT_RESUME:
-        CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_RESUME received\r\n");
+        domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_RESUME received\r\n");
         // Device has resumed - ready to accept new commands from host
         // Data collection will be restarted by host via vendor command if needed
         break;
@@ -968,6 +1746,8 @@ void domDupUSBEventCB(CyU3PUsbEventType_t eventType, uint16_t eventData)
     case CY_U3P_USB_EVENT_RESET:
     case CY_U3P_USB_EVENT_DISCONNECT:
         glForceLinkU2 = CyFalse;
+        domDupLinkPowerCollecting(CyFalse);
+        domDupCaptureLengthStop(CyFalse);
 
         // Stop the application
         if (glIsApplnActive) {
@@ -975,38 +1755,38 @@ void domDupUSBEventCB(CyU3PUsbEventType_t eventType, uint16_t eventData)
         }
 
         if (eventType == CY_U3P_USB_EVENT_DISCONNECT) {
-            CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_DISCONNECT received - Application stopped\r\n");
+            domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_DISCONNECT received - Application stopped\r\n");
         }
 
         if (eventType == CY_U3P_USB_EVENT_RESET) {
-			CyU3PDebugPrint(8, "domDupUSBEventCB(): CY_U3P_USB_EVENT_RESET received - Application stopped\r\n");
+			domDupDebugPrint(CY_FX_DEBUG_EVENT, "domDupUSBEventCB(): CY_U3P_USB_EVENT_RESET received - Application stopped\r\n");
 		}
         break;
 
     default:
         break;
     }
+
+    // Wake the application thread (the link state or the application state
+    // may have changed)
+    CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_USB, CYU3P_EVENT_OR);
 }
 
 // Callback function to handle LPM requests
 CyBool_t domDupLPMRequestCB(CyU3PUsbLinkPowerMode linkMode)
 {
     // Handle Link Power Management requests from the USB 3.0 host
-    // linkMode: CyU3PUsbLPM_U0 = fully active, CyU3PUsbLPM_U1 = light sleep, 
-    //           CyU3PUsbLPM_U2 = deeper sleep, CyU3PUsbLPM_U3 = suspend
-    
-    // Reject U2/U3 while actively collecting data to prevent data corruption
-    // and ensure reliable high-speed streaming
-    if (dataCollectionFlag) {
-        if (linkMode >= CyU3PUsbLPM_U2) {
-            CyU3PDebugPrint(8, "domDupLPMRequestCB(): Rejecting LPM %d - data collection active\r\n", linkMode);
-            return CyFalse;  // Reject U2/U3 entry
-        }
-    }
-    
-    // Accept U1 (very brief, minimal impact on streaming)
-    // Accept all power states when idle
-    return CyTrue;
+    //
+    // U1, U2 and U3 are rejected whilst collecting data and accepted when
+    // idle (see link-power.c).  The application thread is woken to check
+    // the link state.
+    CyBool_t accept = domDupLinkPowerRequest(linkMode);
+
+#ifdef DOMDUP_NOTIFY_EP
+    domDupNotifyPost(CY_FX_NOTIFY_LPM_REQUEST, linkMode, accept ? 1 : 0);
+#endif
+    CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_LINK, CYU3P_EVENT_OR);
+    return accept;
 }
 
 // Callback function for GPIO pin interrupt
@@ -1021,36 +1801,41 @@ void gpioInterruptCallback(uint8_t gpioTriggerPin)
     // Get the status of the pin (that caused the interrupt)
     apiReturnStatus = CyU3PGpioGetValue(gpioTriggerPin, &gpioValue);
     if (apiReturnStatus == CY_U3P_SUCCESS) {
-    	// Generic input signals from FPGA (GPIO 20, 21, 28 and 29)
-        if (gpioTriggerPin == 20) {
-        	if (gpioValue == CyTrue) {
-        		if (dataCollectionFlag) input0Flag = CyTrue;
-        	} else {
-        		input0Flag = CyFalse;
-        	}
-        }
-
-        if (gpioTriggerPin == 21) {
+    	domDupTrace(CY_FX_TRACE_GPIO_INPUT, gpioTriggerPin, gpioValue);
+    	domDupInputEventPush(gpioTriggerPin, gpioValue, dataCollectionFlag);
+
+    	// Generic input signals from FPGA (GPIO 20, 28 and 29)
+    	//
+    	// The interrupt is on both edges; the flags are set by a rising edge
+    	// and stay set until data collection is next started or stopped.
+        if (gpioTriggerPin == CY_FX_GPIO_INPUT0) {
         	if (gpioValue == CyTrue) {
-        		if (dataCollectionFlag) input1Flag = CyTrue;
-        	} else {
-        		input1Flag = CyFalse;
+        		domDupTelemetryOverflowEvent();
+#ifdef DOMDUP_NOTIFY_EP
+        		domDupNotifyPost(CY_FX_NOTIFY_OVERFLOW, dataCollectionFlag ? 1 : 0, 0);
+#endif
+        		if (dataCollectionFlag) {
+        			input0Flag = CyTrue;
+        			CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_INPUT, CYU3P_EVENT_OR);
+        		}
         	}
         }
 
-        if (gpioTriggerPin == 28) {
+        if (gpioTriggerPin == CY_FX_GPIO_INPUT2) {
         	if (gpioValue == CyTrue) {
-        		if (dataCollectionFlag) input2Flag = CyTrue;
-        	} else {
-        		input2Flag = CyFalse;
+        		if (dataCollectionFlag) {
+        			input2Flag = CyTrue;
+        			CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_INPUT, CYU3P_EVENT_OR);
+        		}
         	}
         }
 
-        if (gpioTriggerPin == 29) {
+        if (gpioTriggerPin == CY_FX_GPIO_INPUT3) {
         	if (gpioValue == CyTrue) {
-        		if (dataCollectionFlag) input3Flag = CyTrue;
-        	} else {
-        		input3Flag = CyFalse;
+        		if (dataCollectionFlag) {
+        			input3Flag = CyTrue;
+        			CyU3PEventSet(&glAppEvent, CY_FX_APP_EVENT_INPUT, CYU3P_EVENT_OR);
+        		}
         	}
         }
     }
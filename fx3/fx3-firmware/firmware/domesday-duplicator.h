@@ -17,16 +17,49 @@
 #include "cyu3types.h"
 #include "cyu3usbconst.h"
 #include "cyu3gpif.h"
+#include "memory-map.h"
 
 #define CY_FX_GPIFTOUSB_THREAD_STACK       (0x1000) // Application thread stack size
 #define CY_FX_GPIFTOUSB_THREAD_PRIORITY    (8) 		// Application thread priority
 
+// Application thread event flags (glAppEvent)
+#define CY_FX_APP_EVENT_INPUT              (1 << 0) // An FPGA input flag has been set (GPIO interrupt)
+#define CY_FX_APP_EVENT_LINK               (1 << 1) // USB link power state request (LPM or SET/CLEAR_FEATURE)
+#define CY_FX_APP_EVENT_USB                (1 << 2) // USB event (connect, configure, suspend, reset...)
+#define CY_FX_APP_EVENT_ALL                (CY_FX_APP_EVENT_INPUT | CY_FX_APP_EVENT_LINK | CY_FX_APP_EVENT_USB)
+
+// GPIOs claimed from the GPIF interface for the FPGA signals (see glGpioConfig
+// and DomesdayDuplicator.v; GPIO 21 and 24 to 26 are the register interface,
+// see fpga-registers.h)
+#define CY_FX_GPIO_COLLECT_DATA            (19) // Output - the host is collecting data
+#define CY_FX_GPIO_INPUT0                  (20) // Input  - buffer overflow
+#define CY_FX_GPIO_OUTPUT_E0               (22) // Output - spare (held low)
+#define CY_FX_GPIO_OUTPUT_D0               (23) // Output - spare (held low)
+#define CY_FX_GPIO_NRESET                  (27) // Output - FPGA reset (active low)
+#define CY_FX_GPIO_INPUT2                  (28) // Input  - generic
+#define CY_FX_GPIO_INPUT3                  (29) // Input  - generic
+
 // End-point and socket definitions
 #define CY_FX_EP_CONSUMER               0x81
 #define CY_FX_EP_CONSUMER_SOCKET        CY_U3P_UIB_SOCKET_CONS_1
 #define CY_FX_EP_PRODUCER_SOCKET0		CY_U3P_PIB_SOCKET_0
 #define CY_FX_EP_PRODUCER_SOCKET1		CY_U3P_PIB_SOCKET_1
 
+// Sideband end-point (DOMDUP_SIDEBAND_EP, see sideband.c).  Each record is
+// sent in its own DMA buffer as a single USB transfer.
+#define CY_FX_EP_SIDEBAND               0x82
+#define CY_FX_EP_SIDEBAND_SOCKET        CY_U3P_UIB_SOCKET_CONS_2
+#define CY_FX_SIDEBAND_BUF_SIZE         (1024)
+#define CY_FX_SIDEBAND_BUF_COUNT        (4)
+
+// Status notification end-point (DOMDUP_NOTIFY_EP, see notify.c).  Each
+// notification is a single 16 byte interrupt packet.
+#define CY_FX_EP_NOTIFY                 0x83
+#define CY_FX_EP_NOTIFY_SOCKET          CY_U3P_UIB_SOCKET_CONS_3
+#define CY_FX_NOTIFY_PACKET_SIZE        (16)
+#define CY_FX_NOTIFY_BUF_SIZE           (32)
+#define CY_FX_NOTIFY_BUF_COUNT          (8)
+
 // NOTE:
 //
 // The size of the DMA buffer causes an automatic COMMIT in the GPIF state-machine
@@ -36,27 +69,216 @@
 //
 // The DMA buffer count does not change the 'size' of the DMA buffer (from the
 // perspective of the COMMIT counter), it increases the amount of data the FX3
-// can hold for transfer at any one time.
+// can hold for transfer at any one time.  Note that the count is per producer
+// socket; the multi-channel allocates CY_FX_DMA_BUF_COUNT buffers for each of
+// the two GPIF threads.
 //
 // If you are thinking of altering the 3 parameters below, make sure you really
 // know what your doing as there are soft-dependencies in the rest of the
 // project code :)
 //
+// The burst length and the buffer count can be changed at run-time by
+// selecting one of the stream profiles (see CY_FX_VREQ_STREAM_PROFILE); the
+// values below are the default profile.  The buffer size must match the FPGA
+// packet; the host can select a smaller packet (CY_FX_VREQ_PACKET_SIZE),
+// which sets both when data collection is next started.
+//
 // Set USB 3 burst length to 16Kbytes
 #define CY_FX_EP_BURST_LENGTH           (16)
-// Set the DMA buffer size to 16Kbytes for the application
+// Set the DMA buffer size to 16Kbytes for the application (the largest packet)
 #define CY_FX_DMA_BUF_SIZE              (16384)
-// Set the total number of DMA buffers available to 4 (64Kbytes total)
+// Smallest packet (DMA buffer) size the host can select
+#define CY_FX_PACKET_SIZE_MIN           (4096)
+// Number of GPIF threads (producer sockets) feeding the multi-channel
+#define CY_FX_DMA_PRODUCER_SOCKETS      (2)
+
+// Most DMA buffers per socket: as much of the DMA buffer heap as possible,
+// leaving CY_FX_DMA_HEAP_RESERVE bytes free for the buffers the SDK allocates
+// for itself (EP0 and the debug UART) and the sideband and notification
+// channels.  With the default memory map this is 6 buffers per socket
+// (192Kbytes total, ~2.4ms at 40 MSPS), or 7 (224Kbytes, ~2.8ms) with the
+// large DMA heap layout (DOMDUP_LARGE_DMA_HEAP, see memory-map.h)
+#ifdef DOMDUP_SIDEBAND_EP
+#define CY_FX_SIDEBAND_HEAP_BYTES       (CY_FX_SIDEBAND_BUF_COUNT * \
+	(CY_FX_SIDEBAND_BUF_SIZE + CY_U3P_BUFFER_ALLOC_OVERHEAD))
+#else
+#define CY_FX_SIDEBAND_HEAP_BYTES       (0)
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+#define CY_FX_NOTIFY_HEAP_BYTES         (CY_FX_NOTIFY_BUF_COUNT * \
+	(CY_FX_NOTIFY_BUF_SIZE + CY_U3P_BUFFER_ALLOC_OVERHEAD))
+#else
+#define CY_FX_NOTIFY_HEAP_BYTES         (0)
+#endif
+#define CY_FX_DMA_HEAP_RESERVE          (16384 + CY_FX_SIDEBAND_HEAP_BYTES + CY_FX_NOTIFY_HEAP_BYTES)
+#define CY_FX_DMA_BUF_COUNT_MAX         ((CY_U3P_BUFFER_HEAP_SIZE - CY_FX_DMA_HEAP_RESERVE) / \
+	(CY_FX_DMA_PRODUCER_SOCKETS * (CY_FX_DMA_BUF_SIZE + CY_U3P_BUFFER_ALLOC_OVERHEAD)))
+
+// Stream profile buffer count meaning CY_FX_DMA_BUF_COUNT_MAX (which is not a
+// compile-time constant)
+#define CY_FX_STREAM_BUF_COUNT_MAX      (0)
+
+#ifdef DOMDUP_DEEP_DMA_BUFFERS
+// Deep buffer mode: give the multi-channel as many buffers as possible
+#define CY_FX_DMA_BUF_COUNT             CY_FX_DMA_BUF_COUNT_MAX
+#define CY_FX_STREAM_BUF_COUNT_DEFAULT  CY_FX_STREAM_BUF_COUNT_MAX
+#else
+// Set the number of DMA buffers per socket to 4 (128Kbytes total)
 #define CY_FX_DMA_BUF_COUNT             (4)
+#define CY_FX_STREAM_BUF_COUNT_DEFAULT  CY_FX_DMA_BUF_COUNT
+#endif
+
+// Number of stream profiles (USB 3 burst length and DMA buffer count
+// combinations, see glStreamProfiles) and the profile used at start-up
+#define CY_FX_STREAM_PROFILES           (6)
+#define CY_FX_STREAM_PROFILE_DEFAULT    (0)
+
+// GPIF data bus width and socket watermark
+//
+// The watermark sets the number of data words that may be written after the
+// clock edge at which the partial flag is sampled asserted:
+// (watermark x (32/bus width)) - 4.  Both settings give 2 words.
+#ifdef DOMDUP_GPIF_32BIT
+#define CY_FX_GPIF_BUS_WIDTH            (32)
+#define CY_FX_GPIF_WATERMARK            (6)
+#else
+#define CY_FX_GPIF_BUS_WIDTH            (16)
+#define CY_FX_GPIF_WATERMARK            (3)
+#endif
+
+// Debug console UART (left out of fast boot builds to shorten the time from
+// power-on to enumeration)
+#ifdef DOMDUP_FAST_BOOT
+#define CY_FX_USE_DEBUG_UART            (CyFalse)
+#else
+#define CY_FX_USE_DEBUG_UART            (CyTrue)
+#endif
+
+// Debug message levels (the CyU3PDebugPrint priority; lower is more important)
+#define CY_FX_DEBUG_BANNER              (1) // Start-up banner
+#define CY_FX_DEBUG_STATUS              (4) // Errors and status
+#define CY_FX_DEBUG_EVENT               (8) // USB events and host commands
+
+// Highest debug message level built into the firmware
+//
+// domDupDebugPrint() calls for the levels above DOMDUP_LOG_LEVEL are removed
+// at compile time, so they cost nothing in the USB callbacks and the command
+// thread (and their strings are left out of the image).  Fast boot builds
+// have no debug console, so every message is removed.
+#ifdef DOMDUP_FAST_BOOT
+#undef DOMDUP_LOG_LEVEL
+#define DOMDUP_LOG_LEVEL                (0)
+#elif !defined(DOMDUP_LOG_LEVEL)
+#define DOMDUP_LOG_LEVEL                (CY_FX_DEBUG_STATUS)
+#endif
+
+#define domDupDebugPrint(level, ...) \
+	do { if ((level) <= DOMDUP_LOG_LEVEL) CyU3PDebugPrint((level), __VA_ARGS__); } while (0)
+
+// Vendor specific requests (bRequest values)
+#define CY_FX_VREQ_COLLECT_DATA         (0xB5) // Host to device: start (wValue = 1) or stop (wValue = 0) collection
+#define CY_FX_VREQ_CONFIGURATION        (0xB6) // Host to device: FPGA configuration bits in wValue
+#define CY_FX_VREQ_GET_BUFFER_CONFIG    (0xB7) // Device to host: DMA buffer configuration (domDupBufferConfig_t)
+#define CY_FX_VREQ_GET_TELEMETRY        (0xB8) // Device to host: telemetry counters (domDupTelemetry_t)
+#define CY_FX_VREQ_GET_OVERFLOW_STATUS  (0xB9) // Device to host: FPGA overflow count and position (domDupOverflowStatus_t)
+#define CY_FX_VREQ_GET_SAMPLE_RATE      (0xBC) // Device to host: current FPGA sampling rate in Hz (uint32_t)
+#define CY_FX_VREQ_SYNC_CONTROL         (0xBD) // Host to device: sync role in wValue bits 0-1, start strobe in bit 2
+#define CY_FX_VREQ_GET_SYNC_STATUS      (0xBE) // Device to host: multi-device sync status (domDupSyncStatus_t)
+#define CY_FX_VREQ_GET_COMMAND_STATUS   (0xBF) // Device to host: status of the queued commands (domDupCommandStatus_t)
+#define CY_FX_VREQ_GET_TRACE            (0xC0) // Device to host: trace log (domDupTraceHeader_t and the records)
+#define CY_FX_VREQ_GET_DMA_LATENCY      (0xC1) // Device to host: DMA buffer latency statistics (domDupDmaLatency_t)
+#define CY_FX_VREQ_GET_CONFIGURATION    (0xC2) // Device to host: requested and applied configuration (domDupConfiguration_t)
+#define CY_FX_VREQ_STREAM_PROFILE       (0xC3) // Host to device: stream profile in wValue, or CY_FX_SELF_TEST_START
+#define CY_FX_VREQ_GET_SELF_TEST        (0xC4) // Device to host: throughput self-test results (domDupSelfTest_t)
+#define CY_FX_VREQ_GET_PREVIEW          (0xC5) // Device to host: signal preview windows (domDupPreview_t)
+#define CY_FX_VREQ_GET_RF_STATS         (0xC6) // Device to host: RF level and clipping statistics (domDupRfStats_t)
+#define CY_FX_VREQ_TRIGGER_CONTROL      (0xC7) // Host to device: armed capture setting in wValue (CY_FX_TRIGGER_SET_*)
+#define CY_FX_VREQ_GET_TRIGGER_STATUS   (0xC8) // Device to host: armed capture settings and status (domDupTriggerStatus_t)
+#define CY_FX_VREQ_BENCHMARK            (0xC9) // Host to device: run the throughput benchmark from the source in wValue (benchmark firmware)
+#define CY_FX_VREQ_GET_BENCHMARK        (0xCA) // Device to host: throughput benchmark results (domDupBenchmark_t, benchmark firmware)
+#define CY_FX_VREQ_LOGIC_ANALYZER       (0xCB) // Host to device: logic analyzer setting or action in wValue (CY_FX_ANALYZER_*)
+#define CY_FX_VREQ_GET_LOGIC_ANALYZER   (0xCC) // Device to host: logic analyzer capture (domDupLogicAnalyzerHeader_t and the entries)
+#define CY_FX_VREQ_SOCKET_WATERMARK     (0xCD) // Host to device: GPIF thread watermark in wValue (CY_FX_WATERMARK_*)
+#define CY_FX_VREQ_GET_SOCKET_STATS     (0xCE) // Device to host: GPIF producer socket statistics (domDupSocketStats_t)
+#define CY_FX_VREQ_GET_INPUT_EVENTS     (0xCF) // Device to host: drain the FPGA input events (domDupInputEventsHeader_t and the events)
+#define CY_FX_VREQ_GET_FPGA_REGISTER    (0xD0) // Device to host: FPGA register at the address in wIndex (uint32_t)
+#define CY_FX_VREQ_CAPTURE_LENGTH       (0xD1) // Host to device: capture length setting in wValue (CY_FX_CAPTURE_SET_*)
+#define CY_FX_VREQ_GET_CAPTURE_LENGTH   (0xD2) // Device to host: capture length and state (domDupCaptureLength_t)
+#define CY_FX_VREQ_MS_OS_20             (0xD3) // Device to host: Microsoft OS 2.0 descriptor set (wIndex CY_FX_MS_OS_20_DESCRIPTOR_INDEX)
+#define CY_FX_VREQ_GET_MEMORY_BUDGET    (0xD4) // Device to host: SRAM layout and free space (domDupMemoryBudget_t)
+#define CY_FX_VREQ_GET_PIPELINE_STATS   (0xD5) // Device to host: FPGA buffer to FX3 pipeline statistics (domDupPipelineStats_t)
+#define CY_FX_VREQ_PACKET_SIZE          (0xD6) // Host to device: packet size in Kbytes in wValue (4, 8 or 16), applied at the next start
+
+// Microsoft OS 2.0 descriptors (see usb-descriptor.c)
+#define CY_FX_MS_OS_20_DESCRIPTOR_INDEX (0x07) // wIndex of the descriptor set request
+#define CY_FX_MS_OS_20_SET_LENGTH       (0xA2) // Length of the descriptor set
+
+// Configuration bits (CY_FX_VREQ_CONFIGURATION wValue)
+#define CY_FX_CONFIG_TEST_MODE          (0x01) // Test mode (FPGA sends the test pattern)
+#define CY_FX_CONFIG_PACKED             (0x02) // 10-bit packed mode
+#define CY_FX_CONFIG_PACKET_HEADER      (0x04) // Packet header mode
+#define CY_FX_CONFIG_DECIMATION         (0x20) // Decimation mode
+#define CY_FX_CONFIG_SOAK               (0x80) // Soak mode (PRBS samples and a CRC-32C at the end of each packet)
+#define CY_FX_CONFIG_PACKET_CRC         (0x100) // Packet CRC mode (each packet header carries the CRC-32C of the previous packet)
+#define CY_FX_CONFIG_TWO_CHANNEL        (0x200) // Two-channel mode (both ADCs decimated and interleaved; DUAL_ADC FPGAs only)
+#define CY_FX_CONFIG_MASK               (0x3FF) // Bits written to the FPGA control register
+
+// Configuration bits forced on when connected to a USB 2.0 (high speed) port,
+// to bring the data rate within the bandwidth of the port (25 MB/s at 40 MSPS)
+#define CY_FX_CONFIG_USB2_FORCED        (CY_FX_CONFIG_PACKED | CY_FX_CONFIG_DECIMATION)
+
+// Longest time to wait for the GPIF to stop at a packet boundary when
+// recovering from an end-point halt (see domDupRecoverEndpoint)
+#define CY_FX_RECOVERY_TIMEOUT_MS       (20)
+
+// Size of the buffer used for the data phase of vendor requests
+#define CY_FX_EP0_BUFFER_SIZE           (512)
+
+// Response to CY_FX_VREQ_GET_BUFFER_CONFIG (little-endian)
+typedef struct {
+	uint32_t bufferSize;			// Size of each DMA buffer in bytes
+	uint32_t buffersPerSocket;		// Number of DMA buffers per producer socket
+	uint32_t producerSockets;		// Number of producer sockets (GPIF threads)
+	uint32_t totalBytes;			// Total number of bytes held by the DMA pool
+} domDupBufferConfig_t;
+
+// A stream profile (bufferCount is per producer socket)
+typedef struct {
+	uint16_t burstLength;			// USB 3 end-point burst length (1Kbyte packets)
+	uint16_t bufferCount;			// DMA buffers per socket (or CY_FX_STREAM_BUF_COUNT_MAX)
+} domDupStreamProfile_t;
+
+// Response to CY_FX_VREQ_GET_CONFIGURATION (little-endian)
+typedef struct {
+	uint16_t requested;				// Configuration bits last sent by the host (0xB6)
+	uint16_t applied;				// Configuration bits in use (including any forced bits)
+	uint32_t usbSpeed;				// Connection speed: 1 = full, 2 = high (USB 2.0), 3 = super speed
+} domDupConfiguration_t;
 
 // Function prototypes
 void domDupThreadInitialise(uint32_t input);
 void CyFxApplicationDefine(void);
 void domDupInitialiseApplication(void);
 void domDupStartApplication(void);
+CyU3PReturnStatus_t domDupCreateDataPath(void);
+CyU3PReturnStatus_t domDupConfigureConsumerEp(uint16_t burstLength);
 void domDupStopApplication(void);
+void domDupResetDataPath(void);
+CyU3PReturnStatus_t domDupApplyConfiguration(uint16_t value);
+uint16_t domDupGetRequestedConfiguration(void);
+CyU3PReturnStatus_t domDupRecoverEndpoint(void);
+CyU3PReturnStatus_t domDupSetStreamProfile(uint16_t profile);
+uint16_t domDupGetStreamProfile(void);
+void domDupGetStreamProfileSettings(uint16_t profile, domDupStreamProfile_t *settings);
+uint16_t domDupGetDmaBufferCount(void);
+CyU3PReturnStatus_t domDupSetStreamSettings(const domDupStreamProfile_t *settings);
+void domDupReleaseDataPath(void);
+CyU3PReturnStatus_t domDupSetPacketSize(uint16_t kbytes);
+uint32_t domDupGetPacketSize(void);
 void domDupErrorHandler(CyU3PReturnStatus_t apiReturnStatus);
 void domDupDebugInit(void);
+void domDupFpgaInitialise(void);
+CyBool_t domDupSendVendorResponse(uint8_t *data, uint16_t length, uint16_t wLength);
 
 // Callback function prototypes
 void gpifDmaEventCB(CyU3PGpifEventType Event, uint8_t State);
@@ -75,7 +297,8 @@ extern const uint8_t USBBOSDscr[];
 extern const uint8_t USBSSConfigDscr[];
 extern const uint8_t USBStringLangIDDscr[];
 extern const uint8_t USBManufactureDscr[];
-extern const uint8_t USBProductDscr[];
+extern const uint8_t * const USBProductDscr;
+extern const uint8_t USBMsOs20DscrSet[];
 
 #include <cyu3externcend.h>
 
@@ -0,0 +1,293 @@
+/************************************************************************
+
+	fpga-registers.c
+
+	FX3 Firmware FPGA register interface
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3gpio.h"
+#include "cyu3utils.h"
+
+// Local includes
+#include "fpga-registers.h"
+
+// The registers are accessed over a bit-banged serial interface (see
+// registerInterface.v in the FPGA project for the protocol).  The FPGA
+// samples the GPIOs with its 60 MHz (or 80 MHz) clock, so each clock phase is held
+// for CY_FX_FPGA_REG_DELAY_US to give the FPGA time to see the edge.
+#define CY_FX_FPGA_REG_DELAY_US         (1)
+
+#define CY_FX_FPGA_REG_READ             (0x80) // Command bit 7 = read
+
+// Mutex to prevent concurrent transactions from the application and command
+// threads
+//
+// The registers must not be accessed from the USB set-up callback, which would
+// then wait for the other threads' transactions (see fpga-status.c).
+static CyU3PMutex glFpgaRegisterMutex;
+
+// Initialise the register interface
+//
+// The GPIOs are configured in main() along with the other FPGA signals; this
+// must be called from thread context once the RTOS has started.
+CyU3PReturnStatus_t domDupFpgaRegisterInitialise(void)
+{
+	uint32_t status;
+
+	status = CyU3PMutexCreate(&glFpgaRegisterMutex, CYU3P_NO_INHERIT);
+	if (status != CY_U3P_SUCCESS) return status;
+
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_SCLK_GPIO, CyFalse);
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_MOSI_GPIO, CyFalse);
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_NCS_GPIO, CyTrue);
+
+	return CY_U3P_SUCCESS;
+}
+
+// Perform a single 40-bit transaction (MSB first)
+//
+// The read data is shifted in during the data phase of every transaction; for
+// a write the FPGA returns zero.
+static uint32_t domDupFpgaRegisterTransfer(uint8_t command, uint32_t data)
+{
+	uint64_t shiftOut = ((uint64_t)command << 32) | data;
+	uint32_t shiftIn = 0;
+	CyBool_t miso = CyFalse;
+	int8_t bit;
+
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_NCS_GPIO, CyFalse);
+	CyU3PBusyWait(CY_FX_FPGA_REG_DELAY_US);
+
+	for (bit = 39; bit >= 0; bit--) {
+		// Sample the read data (the FPGA updates miso after the falling edge)
+		if (bit < 32) {
+			CyU3PGpioSimpleGetValue(CY_FX_FPGA_REG_MISO_GPIO, &miso);
+			shiftIn = (shiftIn << 1) | (miso ? 1 : 0);
+		}
+
+		CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_MOSI_GPIO, ((shiftOut >> bit) & 1) ? CyTrue : CyFalse);
+		CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_SCLK_GPIO, CyTrue);
+		CyU3PBusyWait(CY_FX_FPGA_REG_DELAY_US);
+		CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_SCLK_GPIO, CyFalse);
+		CyU3PBusyWait(CY_FX_FPGA_REG_DELAY_US);
+	}
+
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_MOSI_GPIO, CyFalse);
+	CyU3PGpioSimpleSetValue(CY_FX_FPGA_REG_NCS_GPIO, CyTrue);
+	CyU3PBusyWait(CY_FX_FPGA_REG_DELAY_US);
+
+	return shiftIn;
+}
+
+// Read an FPGA register
+CyU3PReturnStatus_t domDupFpgaRegisterRead(uint8_t address, uint32_t *value)
+{
+	if (address & CY_FX_FPGA_REG_READ) return CY_U3P_ERROR_BAD_ARGUMENT;
+	if (CyU3PMutexGet(&glFpgaRegisterMutex, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS) return CY_U3P_ERROR_MUTEX_FAILURE;
+
+	*value = domDupFpgaRegisterTransfer(CY_FX_FPGA_REG_READ | address, 0);
+
+	CyU3PMutexPut(&glFpgaRegisterMutex);
+	return CY_U3P_SUCCESS;
+}
+
+// Read consecutive FPGA registers as one group
+//
+// No other thread's transaction comes between the reads, so registers that
+// are read together (such as the pipeline statistics snapshot taken by
+// reading CY_FX_FPGA_REG_PIPE_CLOCKS) are from the same snapshot.
+CyU3PReturnStatus_t domDupFpgaRegisterReadGroup(uint8_t address, uint8_t count, uint32_t *values)
+{
+	uint8_t i;
+
+	if ((count == 0) || (((uint16_t)address + count) > CY_FX_FPGA_REG_READ)) return CY_U3P_ERROR_BAD_ARGUMENT;
+	if (CyU3PMutexGet(&glFpgaRegisterMutex, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS) return CY_U3P_ERROR_MUTEX_FAILURE;
+
+	for (i = 0; i < count; i++) {
+		values[i] = domDupFpgaRegisterTransfer(CY_FX_FPGA_REG_READ | (address + i), 0);
+	}
+
+	CyU3PMutexPut(&glFpgaRegisterMutex);
+	return CY_U3P_SUCCESS;
+}
+
+// Write an FPGA register
+CyU3PReturnStatus_t domDupFpgaRegisterWrite(uint8_t address, uint32_t value)
+{
+	if (address & CY_FX_FPGA_REG_READ) return CY_U3P_ERROR_BAD_ARGUMENT;
+	if (CyU3PMutexGet(&glFpgaRegisterMutex, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS) return CY_U3P_ERROR_MUTEX_FAILURE;
+
+	domDupFpgaRegisterTransfer(address, value);
+
+	CyU3PMutexPut(&glFpgaRegisterMutex);
+	return CY_U3P_SUCCESS;
+}
+
+// Check whether the host may read a register with CY_FX_VREQ_GET_FPGA_REGISTER
+//
+// Reading the preview FIFO, the logic analyzer entry or the input marker index
+// register moves the FPGA on, which would lose data the firmware has yet to
+// collect, so these are only read by the firmware (the host reads them through
+// 0xC5, 0xCC and 0xCF).
+CyBool_t domDupFpgaRegisterHostReadable(uint16_t address)
+{
+	if (address >= CY_FX_FPGA_REG_COUNT) return CyFalse;
+	if (address == CY_FX_FPGA_REG_PREVIEW) return CyFalse;
+	if (address == CY_FX_FPGA_REG_ANALYZER_ENTRY) return CyFalse;
+	if (address == CY_FX_FPGA_REG_MARKER_INDEX) return CyFalse;
+	return CyTrue;
+}
+
+// Read the FPGA overflow counter and the position of the last overflow
+//
+// The three registers are read separately, so the count is read again at the
+// end and the read is repeated if an overflow occurred part way through.
+CyU3PReturnStatus_t domDupFpgaGetOverflowStatus(domDupOverflowStatus_t *status)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t indexLow, indexHigh, countCheck;
+	uint8_t retry;
+
+	for (retry = 0; retry < 3; retry++) {
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_OVERFLOW_COUNT, &status->overflowCount);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_OVERFLOW_INDEX_L, &indexLow);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_OVERFLOW_INDEX_H, &indexHigh);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_OVERFLOW_COUNT, &countCheck);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+		if (countCheck == status->overflowCount) {
+			status->reserved = 0;
+			status->overflowIndex = ((uint64_t)(indexHigh & 0xFFFF) << 32) | indexLow;
+			return CY_U3P_SUCCESS;
+		}
+	}
+
+	return CY_U3P_ERROR_FAILURE;
+}
+
+// Read the FPGA multi-device synchronisation status
+CyU3PReturnStatus_t domDupFpgaGetSyncStatus(domDupSyncStatus_t *status)
+{
+	CyU3PReturnStatus_t apiReturnStatus;
+
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_SYNC_CONTROL, &status->role);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_SYNC_STATUS, &status->status);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	return domDupFpgaRegisterRead(CY_FX_FPGA_REG_SAMPLE_RATE, &status->sampleRate);
+}
+
+// Read the FPGA pipeline statistics
+//
+// Reading the clock count takes a snapshot of the other statistics in the
+// FPGA, so the group is read without another thread's reads between them;
+// the packet count is read separately, just after it.  Whilst the
+// stream keeps up, packets leave the buffer as fast as they are filled, so
+// the mean time between packets is the time to fill a bank, and the buffer
+// absorbs a stall of up to (banks - 1) bank fill times less the time taken
+// to read a packet.
+CyU3PReturnStatus_t domDupFpgaGetPipelineStats(domDupPipelineStats_t *stats)
+{
+	CyU3PReturnStatus_t apiReturnStatus;
+	uint32_t snapshot[CY_FX_FPGA_PIPE_REGISTERS];
+	uint32_t status, captureStatus;
+
+	apiReturnStatus = domDupFpgaRegisterReadGroup(CY_FX_FPGA_REG_PIPE_CLOCKS, CY_FX_FPGA_PIPE_REGISTERS, snapshot);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_CAPTURE_STATUS, &captureStatus);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	stats->clocks = snapshot[CY_FX_FPGA_REG_PIPE_CLOCKS - CY_FX_FPGA_REG_PIPE_CLOCKS];
+	stats->busWords = snapshot[CY_FX_FPGA_REG_PIPE_BUS_WORDS - CY_FX_FPGA_REG_PIPE_CLOCKS];
+	stats->stallMax = snapshot[CY_FX_FPGA_REG_PIPE_STALL_MAX - CY_FX_FPGA_REG_PIPE_CLOCKS];
+	stats->stallTotal = snapshot[CY_FX_FPGA_REG_PIPE_STALL_TOTAL - CY_FX_FPGA_REG_PIPE_CLOCKS];
+	status = snapshot[CY_FX_FPGA_REG_PIPE_STATUS - CY_FX_FPGA_REG_PIPE_CLOCKS];
+
+	stats->version = CY_FX_PIPELINE_STATS_VERSION;
+	stats->bankCount = (status >> CY_FX_FPGA_PIPE_BANKS_SHIFT) & CY_FX_FPGA_PIPE_BANKS_MASK;
+	stats->peakBanksWaiting = status & CY_FX_FPGA_PIPE_PEAK_MASK;
+#ifdef DOMDUP_GPIF_CLOCK_80MHZ
+	stats->clockHz = 80000000;
+#else
+	stats->clockHz = 60000000;
+#endif
+	stats->packets = captureStatus & CY_FX_FPGA_CAPTURE_SENT_MASK;
+
+	// The oldest waiting bank must be read by the time the last free bank
+	// is full, so the reading time of a packet (busWords / packets) comes
+	// off the bank fill time
+	if ((stats->packets != 0) && (stats->bankCount != 0) &&
+			((uint64_t)stats->clocks * (stats->bankCount - 1) > stats->busWords)) {
+		stats->stallTolerated = (uint32_t)((((uint64_t)stats->clocks * (stats->bankCount - 1)) - stats->busWords) / stats->packets);
+	} else {
+		stats->stallTolerated = 0;
+	}
+
+	if (stats->clocks != 0) {
+		stats->wordsPerKiloClock = (uint32_t)(((uint64_t)stats->busWords * 1000) / stats->clocks);
+	} else {
+		stats->wordsPerKiloClock = 0;
+	}
+
+	return CY_U3P_SUCCESS;
+}
+
+// Write one of the armed capture settings (CY_FX_VREQ_TRIGGER_CONTROL wValue)
+//
+// The settings must only be changed whilst data collection is stopped.
+CyU3PReturnStatus_t domDupFpgaSetTrigger(uint16_t value)
+{
+	uint16_t setting = value & ~CY_FX_TRIGGER_SET_MASK;
+
+	switch (value & CY_FX_TRIGGER_SET_MASK) {
+	case CY_FX_TRIGGER_SET_CONTROL:
+		return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_TRIGGER_CONTROL, setting &
+				(CY_FX_FPGA_TRIGGER_ARMED | CY_FX_FPGA_TRIGGER_ACTIVITY | CY_FX_FPGA_TRIGGER_LEVEL_MASK));
+
+	case CY_FX_TRIGGER_SET_HOLD:
+		return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_TRIGGER_HOLD, (uint32_t)setting * CY_FX_TRIGGER_HOLD_UNIT);
+
+	case CY_FX_TRIGGER_SET_PRE:
+		if (setting > CY_FX_FPGA_TRIGGER_PRE_MAX) return CY_U3P_ERROR_BAD_ARGUMENT;
+		return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_TRIGGER_PRE, setting);
+
+	default:
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+}
+
+// Read the FPGA armed capture settings and status
+CyU3PReturnStatus_t domDupFpgaGetTriggerStatus(domDupTriggerStatus_t *status)
+{
+	CyU3PReturnStatus_t apiReturnStatus;
+	uint32_t indexLow, indexHigh;
+
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_CONTROL, &status->control);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_HOLD, &status->holdCount);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_PRE, &status->preTrigger);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_STATUS, &status->status);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	// The index is static once the trigger status is set
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_INDEX_L, &indexLow);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_TRIGGER_INDEX_H, &indexHigh);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	status->firstSampleIndex = ((uint64_t)(indexHigh & 0xFFFF) << 32) | indexLow;
+
+	return CY_U3P_SUCCESS;
+}
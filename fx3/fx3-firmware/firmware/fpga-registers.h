@@ -0,0 +1,203 @@
+/************************************************************************
+
+	fpga-registers.h
+
+	FX3 Firmware FPGA register interface
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _FPGA_REGISTERS_H_
+#define _FPGA_REGISTERS_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+
+// GPIOs used by the register interface (see registerInterface.v)
+#define CY_FX_FPGA_REG_NCS_GPIO         (24) // Output - chip select (active low)
+#define CY_FX_FPGA_REG_SCLK_GPIO        (25) // Output - serial clock
+#define CY_FX_FPGA_REG_MOSI_GPIO        (26) // Output - data to the FPGA
+#define CY_FX_FPGA_REG_MISO_GPIO        (21) // Input  - data from the FPGA
+
+// Register addresses
+#define CY_FX_FPGA_REG_ID               (0x00) // R  - Interface ID
+#define CY_FX_FPGA_REG_OVERFLOW_COUNT   (0x01) // R  - Buffer overflow event count
+#define CY_FX_FPGA_REG_OVERFLOW_INDEX_L (0x02) // R  - Stream word index of the last overflow (bits 31-0)
+#define CY_FX_FPGA_REG_OVERFLOW_INDEX_H (0x03) // R  - Stream word index of the last overflow (bits 47-32)
+#define CY_FX_FPGA_REG_SCRATCH          (0x04) // RW - Scratch register
+#define CY_FX_FPGA_REG_CONTROL          (0x05) // RW - Control register (0xB6 configuration bits 0-9, CY_FX_CONFIG_MASK)
+#define CY_FX_FPGA_REG_SAMPLE_RATE      (0x06) // R  - Current sampling rate in Hz (0 whilst changing)
+#define CY_FX_FPGA_REG_SYNC_CONTROL     (0x07) // RW - Sync control register (role and start strobe)
+#define CY_FX_FPGA_REG_SYNC_STATUS      (0x08) // R  - Sync status register
+#define CY_FX_FPGA_REG_PREVIEW          (0x09) // R  - Preview FIFO (reading removes the oldest window)
+#define CY_FX_FPGA_REG_STATS_CONTROL    (0x0A) // RW - RF statistics control register
+#define CY_FX_FPGA_REG_STATS_WINDOW     (0x0B) // R  - RF statistics window number
+#define CY_FX_FPGA_REG_STATS_MIN_MAX    (0x0C) // R  - Largest (bits 19-10) and smallest (bits 9-0) sample
+#define CY_FX_FPGA_REG_STATS_SUM        (0x0D) // R  - Sum of the samples
+#define CY_FX_FPGA_REG_STATS_CLIP_LOW   (0x0E) // R  - Samples clipped low
+#define CY_FX_FPGA_REG_STATS_CLIP_HIGH  (0x0F) // R  - Samples clipped high
+#define CY_FX_FPGA_REG_TRIGGER_CONTROL  (0x10) // RW - Armed capture control register
+#define CY_FX_FPGA_REG_TRIGGER_HOLD     (0x11) // RW - Samples the trigger condition must hold for
+#define CY_FX_FPGA_REG_TRIGGER_PRE      (0x12) // RW - Pre-trigger history in samples
+#define CY_FX_FPGA_REG_TRIGGER_STATUS   (0x13) // R  - Armed capture status register
+#define CY_FX_FPGA_REG_TRIGGER_INDEX_L  (0x14) // R  - Index of the first sample passed on (bits 31-0)
+#define CY_FX_FPGA_REG_TRIGGER_INDEX_H  (0x15) // R  - Index of the first sample passed on (bits 47-32)
+#define CY_FX_FPGA_REG_ANALYZER_CONTROL (0x16) // RW - Logic analyzer control register
+#define CY_FX_FPGA_REG_ANALYZER_STATUS  (0x17) // R  - Logic analyzer status register (0 without the logic analyzer)
+#define CY_FX_FPGA_REG_ANALYZER_ADDRESS (0x18) // RW - Logic analyzer read address
+#define CY_FX_FPGA_REG_ANALYZER_ENTRY   (0x19) // R  - Logic analyzer entry (reading moves the read address on)
+#define CY_FX_FPGA_REG_CAPTURE_LENGTH   (0x1A) // RW - Capture length in packets (0 = no limit)
+#define CY_FX_FPGA_REG_CAPTURE_STATUS   (0x1B) // R  - Capture length status register
+#define CY_FX_FPGA_REG_MARKER_HEAD      (0x1C) // R  - Input marker FIFO head (lines and index bits 47-32)
+#define CY_FX_FPGA_REG_MARKER_INDEX     (0x1D) // R  - Input marker index bits 31-0 (reading removes the marker)
+#define CY_FX_FPGA_REG_MARKERS_LOST     (0x1E) // R  - Input markers lost because the FIFO was full
+#define CY_FX_FPGA_REG_PIPE_CLOCKS      (0x1F) // R  - Clocks since collection started (reading takes the 0x20-0x23 snapshot)
+#define CY_FX_FPGA_REG_PIPE_BUS_WORDS   (0x20) // R  - Bus words read by the FX3
+#define CY_FX_FPGA_REG_PIPE_STALL_MAX   (0x21) // R  - Longest service stall in clocks
+#define CY_FX_FPGA_REG_PIPE_STALL_TOTAL (0x22) // R  - Total service stall clocks
+#define CY_FX_FPGA_REG_PIPE_STATUS      (0x23) // R  - Pipeline statistics status register
+#define CY_FX_FPGA_REG_FEATURES         (0x24) // R  - Build features (the options the FPGA was built with)
+#define CY_FX_FPGA_REG_PACKET_SIZE      (0x25) // RW - Packet size (must match the DMA buffer size)
+#define CY_FX_FPGA_REG_STATS_HISTOGRAM  (0x40) // R  - Histogram bins (0x40 to 0x7F)
+#define CY_FX_FPGA_REG_COUNT            (0x80) // Number of register addresses (7-bit address)
+
+// Preview FIFO register bits
+#define CY_FX_FPGA_PREVIEW_VALID        (0x80000000) // Window valid (0 = FIFO empty)
+
+// Input marker FIFO head register bits
+#define CY_FX_FPGA_MARKER_VALID         (0x80000000) // Marker valid (0 = FIFO empty)
+#define CY_FX_FPGA_MARKER_CHANGED_SHIFT (24)         // Input lines that changed (bits 27-24)
+#define CY_FX_FPGA_MARKER_LEVELS_SHIFT  (20)         // Input line levels after the change (bits 23-20)
+#define CY_FX_FPGA_MARKER_LINES_MASK    (0x0F)
+#define CY_FX_FPGA_MARKER_INDEX_H_MASK  (0x0000FFFF) // Sample index bits 47-32
+
+// RF statistics control register bits
+#define CY_FX_FPGA_STATS_HOLD           (0x01) // Hold the statistics snapshot
+
+// Armed capture control register bits
+#define CY_FX_FPGA_TRIGGER_ARMED        (0x001) // Armed mode
+#define CY_FX_FPGA_TRIGGER_ACTIVITY     (0x002) // Activity condition (0 = level condition)
+#define CY_FX_FPGA_TRIGGER_LEVEL_MASK   (0xFFC) // Trigger level (bits 11-2)
+#define CY_FX_FPGA_TRIGGER_PRE_MAX      (4095)  // Largest pre-trigger history in samples
+
+// Armed capture status register bits
+#define CY_FX_FPGA_TRIGGER_TRIGGERED    (0x01) // Trigger condition met (samples are being passed on)
+
+// Logic analyzer control register bits
+#define CY_FX_FPGA_ANALYZER_TRIGGER_MASK  (0x0000007F) // Trigger mask (bits 6-0)
+#define CY_FX_FPGA_ANALYZER_VALUE_SHIFT   (8)          // Trigger value (bits 14-8)
+#define CY_FX_FPGA_ANALYZER_POST_SHIFT    (16)         // Entries recorded after the trigger entry (bits 24-16)
+#define CY_FX_FPGA_ANALYZER_POST_MAX      (511)
+#define CY_FX_FPGA_ANALYZER_ENABLE        (0x80000000) // Writing 1 starts a capture, 0 stops it
+
+// Logic analyzer status register bits
+#define CY_FX_FPGA_ANALYZER_ADDRESS_MASK  (0x000001FF) // Address of the next entry to be written
+#define CY_FX_FPGA_ANALYZER_TRIGGER_SHIFT (16)         // Address of the trigger entry (bits 24-16)
+#define CY_FX_FPGA_ANALYZER_RECORDING     (0x08000000) // Recording
+#define CY_FX_FPGA_ANALYZER_WRAPPED       (0x10000000) // The ring has wrapped (all entries are valid)
+#define CY_FX_FPGA_ANALYZER_DONE          (0x20000000) // The post-trigger entries have been recorded
+#define CY_FX_FPGA_ANALYZER_TRIGGERED     (0x40000000) // Triggered
+#define CY_FX_FPGA_ANALYZER_PRESENT       (0x80000000) // The FPGA is built with the logic analyzer
+
+// Capture length status register bits
+#define CY_FX_FPGA_CAPTURE_SENT_MASK    (0x3FFFFFFF) // Packets sent since collection started
+#define CY_FX_FPGA_CAPTURE_DONE         (0x80000000) // The capture length has been sent
+
+// Pipeline statistics status register bits
+#define CY_FX_FPGA_PIPE_REGISTERS       (CY_FX_FPGA_REG_PIPE_STATUS - CY_FX_FPGA_REG_PIPE_CLOCKS + 1) // Registers in the snapshot group (0x1F-0x23)
+#define CY_FX_FPGA_PIPE_PEAK_MASK       (0x00000003) // Most banks waiting to be read
+#define CY_FX_FPGA_PIPE_BANKS_SHIFT     (8)          // Number of buffer banks (bits 11-8)
+#define CY_FX_FPGA_PIPE_BANKS_MASK      (0x0F)
+
+// Build features register bits (an older FPGA reads the register as 0)
+#define CY_FX_FPGA_FEATURE_DUAL_ADC     (0x01) // Second ADC and two-channel mode
+#define CY_FX_FPGA_FEATURE_SDRAM_FIFO   (0x02) // SDRAM FIFO
+#define CY_FX_FPGA_FEATURE_ANALYZER     (0x04) // Logic analyzer
+#define CY_FX_FPGA_FEATURE_GPIF_32BIT   (0x08) // 32-bit FX3 data bus
+#define CY_FX_FPGA_FEATURE_CLOCK_80MHZ  (0x10) // 80 MHz FX3 GPIF clock
+#define CY_FX_FPGA_FEATURE_PACKET_SIZE  (0x20) // Packet size register
+
+// Packet size register values
+#define CY_FX_FPGA_PACKET_16K           (0x00) // 16 Kbytes
+#define CY_FX_FPGA_PACKET_8K            (0x01) // 8 Kbytes
+#define CY_FX_FPGA_PACKET_4K            (0x02) // 4 Kbytes
+
+// CY_FX_VREQ_TRIGGER_CONTROL wValue: bits 15-14 select the setting written
+// from bits 13-0
+#define CY_FX_TRIGGER_SET_MASK          (0xC000)
+#define CY_FX_TRIGGER_SET_CONTROL       (0x0000) // Armed capture control register bits 11-0
+#define CY_FX_TRIGGER_SET_HOLD          (0x4000) // Hold count in units of CY_FX_TRIGGER_HOLD_UNIT samples
+#define CY_FX_TRIGGER_SET_PRE           (0x8000) // Pre-trigger history in samples
+#define CY_FX_TRIGGER_HOLD_UNIT         (64)
+
+// Sync control register bits
+#define CY_FX_FPGA_SYNC_ROLE_MASK       (0x03) // Role: 0 = stand-alone, 1 = master, 2 = slave
+#define CY_FX_FPGA_SYNC_START           (0x04) // Send a start strobe (master only)
+
+// Expected value of CY_FX_FPGA_REG_ID
+#define CY_FX_FPGA_INTERFACE_ID         (0xDD000002)
+
+// Response to CY_FX_VREQ_GET_OVERFLOW_STATUS (little-endian)
+typedef struct {
+	uint32_t overflowCount;			// Number of FPGA buffer overflows since the FPGA was reset
+	uint32_t reserved;				// Reserved (0)
+	uint64_t overflowIndex;			// Stream position (16-bit words) of the first word discarded by the last overflow
+} domDupOverflowStatus_t;
+
+// Response to CY_FX_VREQ_GET_SYNC_STATUS (little-endian)
+typedef struct {
+	uint32_t role;					// Sync role (0 = stand-alone, 1 = master, 2 = slave)
+	uint32_t status;				// Sync status register (see registerInterface.v and DomesdayDuplicator.v)
+	uint32_t sampleRate;			// Current sampling rate in Hz (0 whilst changing)
+} domDupSyncStatus_t;
+
+// Response to CY_FX_VREQ_GET_TRIGGER_STATUS (little-endian)
+typedef struct {
+	uint32_t control;				// Armed capture control register
+	uint32_t holdCount;				// Samples the trigger condition must hold for (0 = 1 sample)
+	uint32_t preTrigger;			// Pre-trigger history in samples
+	uint32_t status;				// Armed capture status register
+	uint64_t firstSampleIndex;		// Index of the first sample passed on (valid once triggered)
+} domDupTriggerStatus_t;
+
+// Version of the domDupPipelineStats_t structure returned to the host
+#define CY_FX_PIPELINE_STATS_VERSION    (1)
+
+// Response to CY_FX_VREQ_GET_PIPELINE_STATS (little-endian)
+//
+// The counters are from the FPGA (see pipelineStats.v) and restart when data
+// collection is started.  They wrap, so whilst the stream is running the host
+// compares them with the previous values.  An FPGA without the statistics
+// reads them all as 0 (bankCount = 0).
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_PIPELINE_STATS_VERSION)
+	uint8_t bankCount;				// Number of FPGA buffer banks
+	uint8_t peakBanksWaiting;		// Most banks waiting to be read by the FX3
+	uint32_t clockHz;				// GPIF interface clock in Hz (the unit of the clock counts)
+	uint32_t clocks;				// Clocks since data collection started
+	uint32_t busWords;				// Words read by the FX3 from the data bus
+	uint32_t packets;				// Packets sent since data collection started
+	uint32_t stallMax;				// Longest time a complete packet waited for the FX3 (clocks)
+	uint32_t stallTotal;			// All the packet waiting time (clocks)
+	uint32_t stallTolerated;		// Longest wait the buffer absorbs without overflowing (clocks, 0 before the first packet)
+	uint32_t wordsPerKiloClock;		// Sustained bus words per 1000 clocks
+} domDupPipelineStats_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupFpgaRegisterInitialise(void);
+CyU3PReturnStatus_t domDupFpgaRegisterRead(uint8_t address, uint32_t *value);
+CyU3PReturnStatus_t domDupFpgaRegisterReadGroup(uint8_t address, uint8_t count, uint32_t *values);
+CyU3PReturnStatus_t domDupFpgaRegisterWrite(uint8_t address, uint32_t value);
+CyBool_t domDupFpgaRegisterHostReadable(uint16_t address);
+CyU3PReturnStatus_t domDupFpgaGetOverflowStatus(domDupOverflowStatus_t *status);
+CyU3PReturnStatus_t domDupFpgaGetSyncStatus(domDupSyncStatus_t *status);
+CyU3PReturnStatus_t domDupFpgaGetPipelineStats(domDupPipelineStats_t *stats);
+CyU3PReturnStatus_t domDupFpgaSetTrigger(uint16_t value);
+CyU3PReturnStatus_t domDupFpgaGetTriggerStatus(domDupTriggerStatus_t *status);
+
+#include <cyu3externcend.h>
+
+#endif // _FPGA_REGISTERS_H_
@@ -0,0 +1,245 @@
+/************************************************************************
+
+	fpga-status.c
+
+	FX3 Firmware FPGA status snapshot
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "fpga-status.h"
+#include "rf-stats.h"
+
+// The device to host requests that return FPGA registers are answered from
+// the copy kept here, so the USB set-up callback never waits for the register
+// interface (each register is a bit-banged transaction of about 90 us, and the
+// application or command thread may be part way through several of them).
+//
+// The application thread reads the registers every CY_FX_FPGA_STATUS_POLL_MS
+// and when the FPGA signals an overflow.  The command thread reads them again
+// after each command, so a host that waits for its commands to finish (0xBF)
+// sees their effect.  The copy is written by both threads and read by the USB
+// set-up callback, so all access is made with the interrupts disabled.  Until
+// a value has been read its request is stalled.
+//
+// CY_FX_VREQ_GET_FPGA_REGISTER is answered from a copy of every register the
+// host may read, which is refreshed every CY_FX_FPGA_REGISTER_POLL_MS (and
+// after each command).  The histogram registers are not copied; the bins of
+// the last RF statistics window read are returned instead (see rf-stats.c).
+
+// Values held in the copy (glStatusValid bits)
+#define CY_FX_FPGA_STATUS_OVERFLOW      (0x01)
+#define CY_FX_FPGA_STATUS_SAMPLE_RATE   (0x02)
+#define CY_FX_FPGA_STATUS_SYNC          (0x04)
+#define CY_FX_FPGA_STATUS_TRIGGER       (0x08)
+#define CY_FX_FPGA_STATUS_PIPELINE      (0x10)
+#define CY_FX_FPGA_STATUS_REGISTER_COPY (0x20)
+
+static domDupOverflowStatus_t glOverflowStatus;
+static uint32_t glSampleRate;
+static domDupSyncStatus_t glSyncStatus;
+static domDupTriggerStatus_t glTriggerStatus;
+static domDupPipelineStats_t glPipelineStats;
+static uint32_t glRegisters[CY_FX_FPGA_STATUS_REGISTERS];
+static uint32_t glStatusValid = 0;
+static uint32_t glLastPollTime = 0;
+static uint32_t glLastRegisterPollTime = 0;
+
+// Read the registers the host may read with CY_FX_VREQ_GET_FPGA_REGISTER
+//
+// The copy is only replaced once all the registers have been read.  Reading
+// CY_FX_FPGA_REG_PIPE_CLOCKS takes the FPGA's pipeline statistics snapshot,
+// so the snapshot group is read in one go; otherwise the other thread could
+// take a new snapshot part way through and the copy would mix the two.
+static void domDupFpgaStatusReadRegisters(void)
+{
+	uint32_t registers[CY_FX_FPGA_STATUS_REGISTERS];
+	uint8_t address;
+	uint32_t intMask;
+
+	for (address = 0; address < CY_FX_FPGA_STATUS_REGISTERS; address++) {
+		registers[address] = 0;
+		if (address == CY_FX_FPGA_REG_PIPE_CLOCKS) {
+			if (domDupFpgaRegisterReadGroup(address, CY_FX_FPGA_PIPE_REGISTERS, &registers[address]) != CY_U3P_SUCCESS) return;
+			address += CY_FX_FPGA_PIPE_REGISTERS - 1;
+			continue;
+		}
+		if (!domDupFpgaRegisterHostReadable(address)) continue;
+		if (domDupFpgaRegisterRead(address, &registers[address]) != CY_U3P_SUCCESS) return;
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)glRegisters, (uint8_t *)registers, sizeof(registers));
+	glStatusValid |= CY_FX_FPGA_STATUS_REGISTER_COPY;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Read the status registers from the FPGA (called from the main application
+// loop, and with force set from the command thread)
+void domDupFpgaStatusUpdate(CyBool_t force)
+{
+	domDupOverflowStatus_t overflowStatus;
+	uint32_t sampleRate;
+	domDupSyncStatus_t syncStatus;
+	domDupTriggerStatus_t triggerStatus;
+	domDupPipelineStats_t pipelineStats;
+	uint32_t now;
+	uint32_t intMask;
+
+	now = CyU3PGetTime();
+	if (force || ((now - glLastRegisterPollTime) >= CY_FX_FPGA_REGISTER_POLL_MS)) {
+		glLastRegisterPollTime = now;
+		domDupFpgaStatusReadRegisters();
+	}
+
+	if (!force && ((now - glLastPollTime) < CY_FX_FPGA_STATUS_POLL_MS)) return;
+	glLastPollTime = now;
+
+	// If overflows keep arriving whilst the status is read the last copy is
+	// kept
+	if (domDupFpgaGetOverflowStatus(&overflowStatus) == CY_U3P_SUCCESS) {
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glOverflowStatus, (uint8_t *)&overflowStatus, sizeof(overflowStatus));
+		glStatusValid |= CY_FX_FPGA_STATUS_OVERFLOW;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_SAMPLE_RATE, &sampleRate) == CY_U3P_SUCCESS) {
+		intMask = CyU3PVicDisableAllInterrupts();
+		glSampleRate = sampleRate;
+		glStatusValid |= CY_FX_FPGA_STATUS_SAMPLE_RATE;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	if (domDupFpgaGetSyncStatus(&syncStatus) == CY_U3P_SUCCESS) {
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glSyncStatus, (uint8_t *)&syncStatus, sizeof(syncStatus));
+		glStatusValid |= CY_FX_FPGA_STATUS_SYNC;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	if (domDupFpgaGetTriggerStatus(&triggerStatus) == CY_U3P_SUCCESS) {
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glTriggerStatus, (uint8_t *)&triggerStatus, sizeof(triggerStatus));
+		glStatusValid |= CY_FX_FPGA_STATUS_TRIGGER;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	if (domDupFpgaGetPipelineStats(&pipelineStats) == CY_U3P_SUCCESS) {
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glPipelineStats, (uint8_t *)&pipelineStats, sizeof(pipelineStats));
+		glStatusValid |= CY_FX_FPGA_STATUS_PIPELINE;
+		CyU3PVicEnableInterrupts(intMask);
+	}
+}
+
+// Copy the last FPGA overflow status read (called from the USB set-up
+// callback); returns CyFalse if it has not been read
+CyBool_t domDupFpgaStatusGetOverflow(domDupOverflowStatus_t *status)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)status, (uint8_t *)&glOverflowStatus, sizeof(glOverflowStatus));
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_OVERFLOW) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
+
+// Copy the last sampling rate read (called from the USB set-up callback);
+// returns CyFalse if it has not been read
+CyBool_t domDupFpgaStatusGetSampleRate(uint32_t *sampleRate)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	*sampleRate = glSampleRate;
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_SAMPLE_RATE) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
+
+// Copy the last multi-device sync status read (called from the USB set-up
+// callback); returns CyFalse if it has not been read
+CyBool_t domDupFpgaStatusGetSync(domDupSyncStatus_t *status)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)status, (uint8_t *)&glSyncStatus, sizeof(glSyncStatus));
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_SYNC) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
+
+// Copy the last armed capture settings and status read (called from the USB
+// set-up callback); returns CyFalse if they have not been read
+CyBool_t domDupFpgaStatusGetTrigger(domDupTriggerStatus_t *status)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)status, (uint8_t *)&glTriggerStatus, sizeof(glTriggerStatus));
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_TRIGGER) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
+
+// Copy the last FPGA pipeline statistics read (called from the USB set-up
+// callback); returns CyFalse if they have not been read
+CyBool_t domDupFpgaStatusGetPipeline(domDupPipelineStats_t *stats)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)stats, (uint8_t *)&glPipelineStats, sizeof(glPipelineStats));
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_PIPELINE) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
+
+// Get an FPGA register from the last copy read (called from the USB set-up
+// callback for CY_FX_VREQ_GET_FPGA_REGISTER); returns CyFalse if the host
+// may not read the register, or the registers have not been read
+//
+// The addresses between the last register and the histogram read as 0, as
+// they do from the FPGA.
+CyBool_t domDupFpgaStatusGetRegister(uint16_t address, uint32_t *value)
+{
+	CyBool_t valid;
+	uint32_t intMask;
+
+	if (!domDupFpgaRegisterHostReadable(address)) return CyFalse;
+
+	if (address >= CY_FX_FPGA_REG_STATS_HISTOGRAM) {
+		*value = domDupRfStatsGetBin(address - CY_FX_FPGA_REG_STATS_HISTOGRAM);
+		return CyTrue;
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	*value = (address < CY_FX_FPGA_STATUS_REGISTERS) ? glRegisters[address] : 0;
+	valid = (glStatusValid & CY_FX_FPGA_STATUS_REGISTER_COPY) ? CyTrue : CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	return valid;
+}
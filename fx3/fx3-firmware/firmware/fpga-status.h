@@ -0,0 +1,41 @@
+/************************************************************************
+
+	fpga-status.h
+
+	FX3 Firmware FPGA status snapshot
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _FPGA_STATUS_H_
+#define _FPGA_STATUS_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "fpga-registers.h"
+
+// Interval between reads of the FPGA status registers
+#define CY_FX_FPGA_STATUS_POLL_MS       (100)
+
+// Interval between reads of all the registers for CY_FX_VREQ_GET_FPGA_REGISTER
+// (there are about 35 of them, so they are read less often)
+#define CY_FX_FPGA_REGISTER_POLL_MS     (250)
+
+// Registers held for CY_FX_VREQ_GET_FPGA_REGISTER (0x00 to the last register
+// below the RF statistics histogram)
+#define CY_FX_FPGA_STATUS_REGISTERS     (CY_FX_FPGA_REG_PACKET_SIZE + 1)
+
+// Function prototypes
+void domDupFpgaStatusUpdate(CyBool_t force);
+CyBool_t domDupFpgaStatusGetOverflow(domDupOverflowStatus_t *status);
+CyBool_t domDupFpgaStatusGetSampleRate(uint32_t *sampleRate);
+CyBool_t domDupFpgaStatusGetSync(domDupSyncStatus_t *status);
+CyBool_t domDupFpgaStatusGetTrigger(domDupTriggerStatus_t *status);
+CyBool_t domDupFpgaStatusGetPipeline(domDupPipelineStats_t *stats);
+CyBool_t domDupFpgaStatusGetRegister(uint16_t address, uint32_t *value);
+
+#include <cyu3externcend.h>
+
+#endif // _FPGA_STATUS_H_
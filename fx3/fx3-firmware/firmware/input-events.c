@@ -0,0 +1,189 @@
+/************************************************************************
+
+	input-events.c
+
+	FX3 Firmware FPGA input edge event ring
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "input-events.h"
+#include "fpga-registers.h"
+
+// The input flags only show that an input has been seen since data collection
+// was last started or stopped, so repeated edges (such as a burst of FPGA
+// overflows) are lost.  The GPIO interrupt callback also adds each edge to
+// this ring, and the host drains it with CY_FX_VREQ_GET_INPUT_EVENTS.
+//
+// The edges are only seen by the FX3 some time after the samples around them
+// have left the FPGA, so the FPGA also records the sample index of each change
+// in a marker FIFO (see inputMarkers.v).  Whilst the host is collecting data
+// the application thread moves the markers into the same ring, so the host
+// can place each change exactly in the sample stream.
+//
+// The ring has a single consumer (the USB set-up callback), so no lock is
+// needed: glInputEventsPushed is only written by the producers and
+// glInputEventsRead only by the consumer, and each only moves on once its
+// slots have been written or copied.  The producers are the GPIO interrupt
+// and the application thread, which adds the markers with the interrupts
+// disabled so the two never add an event at the same time.  Unlike the trace,
+// a full ring is never overwritten; the new event is dropped and counted
+// instead, so the events the host reads are always in order and the host can
+// tell how many were lost.
+static domDupInputEvent_t glInputEventRing[CY_FX_INPUT_EVENTS];
+static volatile uint32_t glInputEventsPushed;
+static volatile uint32_t glInputEventsRead;
+static volatile uint32_t glInputEventsDropped;
+static volatile uint32_t glInputMarkersLost;
+static uint32_t glLastPollTime = 0;
+
+// GPIO pin of each FPGA input marker line (see inputMarkers.v; line 1 is the
+// register interface data and is never marked)
+static const uint8_t glInputMarkerPin[4] = {
+	CY_FX_GPIO_INPUT0, CY_FX_FPGA_REG_MISO_GPIO, CY_FX_GPIO_INPUT2, CY_FX_GPIO_INPUT3
+};
+
+// Buffer for the data phase of CY_FX_VREQ_GET_INPUT_EVENTS (header and the
+// events)
+static uint8_t glInputEventsEp0Buffer[sizeof(domDupInputEventsHeader_t) + sizeof(glInputEventRing)] __attribute__ ((aligned (32)));
+
+// Empty the ring (call once before the GPIO interrupt is enabled)
+void domDupInputEventsInitialise(void)
+{
+	glInputEventsPushed = 0;
+	glInputEventsRead = 0;
+	glInputEventsDropped = 0;
+	glInputMarkersLost = 0;
+}
+
+// Add an event to the ring (dropping it if the ring is full)
+static void domDupInputEventAdd(uint8_t pin, uint8_t flags, uint64_t sampleIndex)
+{
+	domDupInputEvent_t *event;
+	uint32_t pushed = glInputEventsPushed;
+
+	if ((pushed - glInputEventsRead) >= CY_FX_INPUT_EVENTS) {
+		glInputEventsDropped++;
+		return;
+	}
+
+	event = &glInputEventRing[pushed & (CY_FX_INPUT_EVENTS - 1)];
+	event->pin = pin;
+	event->flags = flags;
+	event->sequence = (uint16_t)pushed;
+	event->timestamp = CyU3PGetTime();
+	event->sampleIndex = sampleIndex;
+	glInputEventsPushed = pushed + 1;
+}
+
+// Add an edge to the ring
+void domDupInputEventPush(uint8_t pin, CyBool_t level, CyBool_t collecting)
+{
+	domDupInputEventAdd(pin, (level ? CY_FX_INPUT_EVENT_LEVEL : 0) | (collecting ? CY_FX_INPUT_EVENT_COLLECTING : 0), 0);
+}
+
+// Move the FPGA input markers into the ring (called from the main application
+// loop)
+//
+// The FPGA empties its marker FIFO when data collection starts, so the FIFO is
+// only read whilst collecting; markers still in the FIFO when collection stops
+// are lost.  Each line that changed is added as a separate event.
+void domDupInputMarkersUpdate(CyBool_t collecting)
+{
+	uint32_t head, indexLow, lost;
+	uint32_t changed, levels;
+	uint64_t sampleIndex;
+	uint32_t intMask;
+	uint32_t count;
+	uint32_t line;
+	uint32_t now;
+
+	if (!collecting) return;
+
+	now = CyU3PGetTime();
+	if ((now - glLastPollTime) < CY_FX_INPUT_MARKER_POLL_MS) return;
+	glLastPollTime = now;
+
+	// The head stays in the FIFO until its index is read
+	for (count = 0; count < CY_FX_INPUT_MARKER_FIFO_DEPTH; count++) {
+		if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_MARKER_HEAD, &head) != CY_U3P_SUCCESS) return;
+		if (!(head & CY_FX_FPGA_MARKER_VALID)) break;
+		if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_MARKER_INDEX, &indexLow) != CY_U3P_SUCCESS) return;
+
+		sampleIndex = ((uint64_t)(head & CY_FX_FPGA_MARKER_INDEX_H_MASK) << 32) | indexLow;
+		changed = (head >> CY_FX_FPGA_MARKER_CHANGED_SHIFT) & CY_FX_FPGA_MARKER_LINES_MASK;
+		levels = (head >> CY_FX_FPGA_MARKER_LEVELS_SHIFT) & CY_FX_FPGA_MARKER_LINES_MASK;
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		for (line = 0; line < 4; line++) {
+			if (!(changed & (1 << line))) continue;
+			domDupInputEventAdd(glInputMarkerPin[line], CY_FX_INPUT_EVENT_MARKER | CY_FX_INPUT_EVENT_COLLECTING |
+					((levels & (1 << line)) ? CY_FX_INPUT_EVENT_LEVEL : 0), sampleIndex);
+		}
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_MARKERS_LOST, &lost) == CY_U3P_SUCCESS) glInputMarkersLost = lost;
+}
+
+// Send the waiting events to the host and remove them from the ring (the data
+// phase of CY_FX_VREQ_GET_INPUT_EVENTS)
+//
+// Only as many events as fit in wLength are sent; the rest are left for the
+// next request.  The events are only removed once the response has been
+// handed to the USB driver.  Returns CyFalse (causing the request to be
+// stalled) if the response cannot be sent.
+CyBool_t domDupInputEventsSend(uint16_t wLength)
+{
+	domDupInputEventsHeader_t *header = (domDupInputEventsHeader_t *)glInputEventsEp0Buffer;
+	domDupInputEvent_t *events = (domDupInputEvent_t *)(glInputEventsEp0Buffer + sizeof(domDupInputEventsHeader_t));
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t pushed;
+	uint32_t read;
+	uint32_t count;
+	uint32_t index;
+	uint16_t length;
+
+	pushed = glInputEventsPushed;
+	read = glInputEventsRead;
+
+	count = pushed - read;
+	if (wLength < sizeof(domDupInputEventsHeader_t)) count = 0;
+	else if (count > ((wLength - sizeof(domDupInputEventsHeader_t)) / sizeof(domDupInputEvent_t))) {
+		count = (wLength - sizeof(domDupInputEventsHeader_t)) / sizeof(domDupInputEvent_t);
+	}
+
+	for (index = 0; index < count; index++) {
+		events[index] = glInputEventRing[(read + index) & (CY_FX_INPUT_EVENTS - 1)];
+	}
+
+	header->version = CY_FX_INPUT_EVENTS_VERSION;
+	header->eventSize = sizeof(domDupInputEvent_t);
+	header->eventCount = count;
+	header->pushed = pushed;
+	header->dropped = glInputEventsDropped;
+	header->markersLost = glInputMarkersLost;
+
+	length = sizeof(domDupInputEventsHeader_t) + (count * sizeof(domDupInputEvent_t));
+	if (length > wLength) length = wLength;
+
+	apiReturnStatus = CyU3PUsbSendEP0Data(length, glInputEventsEp0Buffer);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupInputEventsSend(): CyU3PUsbSendEP0Data failed, Error code = %d\r\n", apiReturnStatus);
+		return CyFalse;
+	}
+
+	glInputEventsRead = read + count;
+	return CyTrue;
+}
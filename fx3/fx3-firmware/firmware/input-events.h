@@ -0,0 +1,64 @@
+/************************************************************************
+
+	input-events.h
+
+	FX3 Firmware FPGA input edge event ring
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _INPUT_EVENTS_H_
+#define _INPUT_EVENTS_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Version of the CY_FX_VREQ_GET_INPUT_EVENTS response
+#define CY_FX_INPUT_EVENTS_VERSION      (2)
+
+// Number of events held by the ring (must be a power of 2)
+#define CY_FX_INPUT_EVENTS              (256)
+
+// Depth of the FPGA input marker FIFO (see registerInterface.v) and the
+// interval between reads of it whilst collecting
+#define CY_FX_INPUT_MARKER_FIFO_DEPTH   (16)
+#define CY_FX_INPUT_MARKER_POLL_MS      (10)
+
+// Event flags
+#define CY_FX_INPUT_EVENT_LEVEL         (0x01) // Pin level read in the interrupt (after the edge, unless a short pulse had already ended)
+#define CY_FX_INPUT_EVENT_COLLECTING    (0x02) // The host was collecting data
+#define CY_FX_INPUT_EVENT_MARKER        (0x04) // FPGA input marker (the level is after the change and sampleIndex is valid)
+
+// An input event (returned to the host little-endian)
+typedef struct {
+	uint8_t pin;					// GPIO pin (20 = input0, 28 = input2, 29 = input3)
+	uint8_t flags;					// Event flags (CY_FX_INPUT_EVENT_*)
+	uint16_t sequence;				// Event number (bits 15-0, counted from power-on)
+	uint32_t timestamp;				// Time since the RTOS started in milliseconds (for a marker, when it was read)
+	uint64_t sampleIndex;			// Index of the first sample after the change (markers only, otherwise 0)
+} domDupInputEvent_t;
+
+// Header of the CY_FX_VREQ_GET_INPUT_EVENTS response (followed by the events,
+// oldest first)
+typedef struct {
+	uint16_t version;				// Response version (CY_FX_INPUT_EVENTS_VERSION)
+	uint16_t eventSize;				// Size of each event in bytes
+	uint32_t eventCount;			// Number of events that follow
+	uint32_t pushed;				// Events recorded since power-on
+	uint32_t dropped;				// Events lost since power-on because the ring was full
+	uint32_t markersLost;			// Markers lost by the FPGA this collection because its FIFO was full
+} domDupInputEventsHeader_t;
+
+// Function prototypes
+void domDupInputEventsInitialise(void);
+CyBool_t domDupInputEventsSend(uint16_t wLength);
+void domDupInputMarkersUpdate(CyBool_t collecting);
+
+// Record an edge (called from the GPIO interrupt callback)
+void domDupInputEventPush(uint8_t pin, CyBool_t level, CyBool_t collecting);
+
+#include <cyu3externcend.h>
+
+#endif // _INPUT_EVENTS_H_
@@ -0,0 +1,106 @@
+/************************************************************************
+
+	link-power.c
+
+	FX3 Firmware USB 3 link power management policy
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "link-power.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// Whilst data is being collected every exit from U1 or U2 delays the next
+// burst to the host by the link exit latency, which is enough to overflow the
+// FPGA buffer at the start of a capture.  The link is therefore held in U0:
+// LPM is disabled in the FX3 (so the host's U1/U2 requests are rejected by
+// the USB block) and any request that still reaches the callback is
+// rejected.
+//
+// When idle the host is free to put the link into U1 or U2 and the firmware
+// leaves it there; the next transfer brings it back to U0.  A function
+// suspend (glForceLinkU2) asks the firmware to put the link into U2 itself.
+//
+// Nothing here waits for the link to change state.  The application thread
+// checks the state each time it wakes (at least every
+// CY_FX_TELEMETRY_UPDATE_MS whilst the application is active) and asks again
+// if the link has not yet reached the wanted state.
+static volatile CyBool_t glLinkCollecting;
+
+// Initialise the policy (call once before the USB is started)
+void domDupLinkPowerInitialise(void)
+{
+	glLinkCollecting = CyFalse;
+}
+
+// Apply the policy for the start or stop of data collection
+//
+// May be called from the USB event callback.
+void domDupLinkPowerCollecting(CyBool_t collecting)
+{
+	CyU3PUsbLinkPowerMode powerState;
+
+	if (collecting == glLinkCollecting) return;
+	glLinkCollecting = collecting;
+
+	// LPM stays disabled across a reset or disconnect unless it is enabled
+	// again here
+	if (!collecting) {
+		CyU3PUsbLPMEnable();
+		return;
+	}
+
+	CyU3PUsbLPMDisable();
+
+	// Start the exit now, so the link is in U0 before the first burst
+	if ((CyU3PUsbGetSpeed() == CY_U3P_SUPER_SPEED) &&
+			(CyU3PUsbGetLinkPowerState(&powerState) == CY_U3P_SUCCESS) &&
+			(powerState >= CyU3PUsbLPM_U1) && (powerState <= CyU3PUsbLPM_U3)) {
+		CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U0);
+	}
+}
+
+// Move the link towards the state wanted by the policy (called from the main
+// application loop when the link state should be checked)
+void domDupLinkPowerUpdate(CyBool_t forceU2)
+{
+	CyU3PUsbLinkPowerMode powerState;
+
+	if (CyU3PUsbGetSpeed() != CY_U3P_SUPER_SPEED) return;
+	if (CyU3PUsbGetLinkPowerState(&powerState) != CY_U3P_SUCCESS) return;
+
+	if (glLinkCollecting) {
+		if ((powerState >= CyU3PUsbLPM_U1) && (powerState <= CyU3PUsbLPM_U3)) {
+			CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U0);
+			domDupTelemetryLinkExit();
+		}
+	} else if (forceU2) {
+		if (powerState == CyU3PUsbLPM_U0) CyU3PUsbSetLinkPowerState(CyU3PUsbLPM_U2);
+	}
+}
+
+// Decide whether to accept an LPM request from the host
+//
+// linkMode: CyU3PUsbLPM_U0 = fully active, CyU3PUsbLPM_U1 = light sleep,
+//           CyU3PUsbLPM_U2 = deeper sleep, CyU3PUsbLPM_U3 = suspend
+CyBool_t domDupLinkPowerRequest(CyU3PUsbLinkPowerMode linkMode)
+{
+	CyBool_t accept;
+
+	accept = (!glLinkCollecting) || (linkMode == CyU3PUsbLPM_U0);
+
+	domDupTelemetryLpmRequest(accept);
+	domDupTrace(CY_FX_TRACE_LPM_REQUEST, linkMode, accept ? 1 : 0);
+	return accept;
+}
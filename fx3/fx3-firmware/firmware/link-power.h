@@ -0,0 +1,29 @@
+/************************************************************************
+
+	link-power.h
+
+	FX3 Firmware USB 3 link power management policy
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _LINK_POWER_H_
+#define _LINK_POWER_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3usb.h"
+
+// Function prototypes
+void domDupLinkPowerInitialise(void);
+void domDupLinkPowerCollecting(CyBool_t collecting);
+void domDupLinkPowerUpdate(CyBool_t forceU2);
+
+// Called from the LPM request callback (interrupt context)
+CyBool_t domDupLinkPowerRequest(CyU3PUsbLinkPowerMode linkMode);
+
+#include <cyu3externcend.h>
+
+#endif // _LINK_POWER_H_
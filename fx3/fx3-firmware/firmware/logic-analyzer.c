@@ -0,0 +1,212 @@
+/************************************************************************
+
+	logic-analyzer.c
+
+	FX3 Firmware GPIF handshake logic analyzer
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "logic-analyzer.h"
+#include "fpga-registers.h"
+
+// FPGAs built with LOGIC_ANALYZER record the GPIF handshake into a ring of
+// CY_FX_LOGIC_ANALYZER_ENTRIES entries (see logicAnalyzer.v).  The host sets
+// the trigger and arms a capture with CY_FX_VREQ_LOGIC_ANALYZER (carried out
+// by the command thread).  Whilst the capture is armed the application thread
+// checks the FPGA status; once recording has stopped (the post-trigger entries
+// have been recorded, or the host stopped the capture) it reads the whole ring
+// and keeps it for CY_FX_VREQ_GET_LOGIC_ANALYZER, so the request doesn't hold
+// up EP0 with register reads.
+//
+// glAnalyzerGeneration counts the captures armed.  A capture read by the
+// application thread is discarded if the host armed another capture part way
+// through, and the response is sent without entries if the ring is replaced
+// whilst it is being copied.
+static domDupLogicAnalyzerHeader_t glAnalyzerHeader;
+static uint32_t glAnalyzerEntries[CY_FX_LOGIC_ANALYZER_ENTRIES];
+static uint32_t glAnalyzerControl;
+static volatile uint32_t glAnalyzerGeneration;
+static uint32_t glLastPollTime = 0;
+
+// Number of entries copied with the interrupts disabled when the response is
+// formed
+#define CY_FX_ANALYZER_COPY_CHUNK       (64)
+
+// Buffer for the data phase of CY_FX_VREQ_GET_LOGIC_ANALYZER
+static uint8_t glAnalyzerEp0Buffer[sizeof(domDupLogicAnalyzerHeader_t) + sizeof(glAnalyzerEntries)] __attribute__ ((aligned (32)));
+
+// Carry out CY_FX_VREQ_LOGIC_ANALYZER (called from the command thread)
+//
+// The trigger and post-trigger settings take effect when the next capture is
+// armed.
+CyU3PReturnStatus_t domDupLogicAnalyzerCommand(uint16_t value)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint16_t setting = value & ~CY_FX_ANALYZER_SET_MASK;
+	uint32_t mask, triggerValue;
+	uint32_t status;
+
+	switch (value & CY_FX_ANALYZER_SET_MASK) {
+	case CY_FX_ANALYZER_SET_TRIGGER:
+		mask = setting & CY_FX_FPGA_ANALYZER_TRIGGER_MASK;
+		triggerValue = (setting >> 7) & CY_FX_FPGA_ANALYZER_TRIGGER_MASK;
+		glAnalyzerControl = (glAnalyzerControl & ~((CY_FX_FPGA_ANALYZER_TRIGGER_MASK << CY_FX_FPGA_ANALYZER_VALUE_SHIFT) |
+				CY_FX_FPGA_ANALYZER_TRIGGER_MASK)) | (triggerValue << CY_FX_FPGA_ANALYZER_VALUE_SHIFT) | mask;
+		return CY_U3P_SUCCESS;
+
+	case CY_FX_ANALYZER_SET_POST:
+		if (setting > CY_FX_FPGA_ANALYZER_POST_MAX) return CY_U3P_ERROR_BAD_ARGUMENT;
+		glAnalyzerControl = (glAnalyzerControl & ~(CY_FX_FPGA_ANALYZER_POST_MAX << CY_FX_FPGA_ANALYZER_POST_SHIFT)) |
+				((uint32_t)setting << CY_FX_FPGA_ANALYZER_POST_SHIFT);
+		return CY_U3P_SUCCESS;
+
+	case CY_FX_ANALYZER_ARM:
+		// An FPGA without the logic analyzer reads the status as 0
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_ANALYZER_STATUS, &status);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+		if (!(status & CY_FX_FPGA_ANALYZER_PRESENT)) {
+			glAnalyzerHeader.state = CY_FX_ANALYZER_UNAVAILABLE;
+			return CY_U3P_ERROR_NOT_SUPPORTED;
+		}
+
+		apiReturnStatus = domDupFpgaRegisterWrite(CY_FX_FPGA_REG_ANALYZER_CONTROL,
+				glAnalyzerControl | CY_FX_FPGA_ANALYZER_ENABLE);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+		glAnalyzerGeneration++;
+		glAnalyzerHeader.control = glAnalyzerControl | CY_FX_FPGA_ANALYZER_ENABLE;
+		glAnalyzerHeader.state = CY_FX_ANALYZER_ARMED;
+		return CY_U3P_SUCCESS;
+
+	case CY_FX_ANALYZER_STOP:
+		// The application thread reads the ring once recording has stopped
+		return domDupFpgaRegisterWrite(CY_FX_FPGA_REG_ANALYZER_CONTROL, glAnalyzerControl);
+
+	default:
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+}
+
+// Read the recorded entries from the FPGA ring, oldest first
+static CyU3PReturnStatus_t domDupLogicAnalyzerRead(uint32_t status, uint32_t generation)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint16_t first, count, index;
+	uint32_t entry;
+
+	if (status & CY_FX_FPGA_ANALYZER_WRAPPED) {
+		first = status & CY_FX_FPGA_ANALYZER_ADDRESS_MASK;
+		count = CY_FX_LOGIC_ANALYZER_ENTRIES;
+	} else {
+		first = 0;
+		count = status & CY_FX_FPGA_ANALYZER_ADDRESS_MASK;
+	}
+
+	// The read address moves on with each read of the entry register
+	apiReturnStatus = domDupFpgaRegisterWrite(CY_FX_FPGA_REG_ANALYZER_ADDRESS, first);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	for (index = 0; index < count; index++) {
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_ANALYZER_ENTRY, &entry);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+		if (generation != glAnalyzerGeneration) return CY_U3P_ERROR_ABORTED;
+		glAnalyzerEntries[index] = entry;
+	}
+
+	glAnalyzerHeader.entryCount = count;
+	glAnalyzerHeader.status = status;
+	if (status & CY_FX_FPGA_ANALYZER_TRIGGERED) {
+		glAnalyzerHeader.triggerEntry = (((status >> CY_FX_FPGA_ANALYZER_TRIGGER_SHIFT) & CY_FX_FPGA_ANALYZER_ADDRESS_MASK) - first) &
+				(CY_FX_LOGIC_ANALYZER_ENTRIES - 1);
+	} else {
+		glAnalyzerHeader.triggerEntry = CY_FX_ANALYZER_NO_TRIGGER;
+	}
+	glAnalyzerHeader.state = CY_FX_ANALYZER_CAPTURED;
+	return CY_U3P_SUCCESS;
+}
+
+// Check an armed capture (called from the main application loop)
+void domDupLogicAnalyzerUpdate(void)
+{
+	uint32_t generation;
+	uint32_t status;
+	uint32_t now;
+
+	if (glAnalyzerHeader.state != CY_FX_ANALYZER_ARMED) return;
+
+	now = CyU3PGetTime();
+	if ((now - glLastPollTime) < CY_FX_LOGIC_ANALYZER_POLL_MS) return;
+	glLastPollTime = now;
+
+	generation = glAnalyzerGeneration;
+	if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_ANALYZER_STATUS, &status) != CY_U3P_SUCCESS) return;
+	if (status & CY_FX_FPGA_ANALYZER_RECORDING) return;
+
+	// The state stays armed whilst the entries are read, so the response is
+	// sent without them until the read is complete
+	if (domDupLogicAnalyzerRead(status, generation) != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupLogicAnalyzerUpdate(): Failed to read the capture\r\n");
+	}
+}
+
+// Send the last capture to the host (called from the USB set-up callback)
+//
+// Returns CyFalse (causing the request to be stalled) if the response cannot
+// be sent.
+CyBool_t domDupLogicAnalyzerSend(uint16_t wLength)
+{
+	domDupLogicAnalyzerHeader_t *header = (domDupLogicAnalyzerHeader_t *)glAnalyzerEp0Buffer;
+	uint32_t *entries = (uint32_t *)(glAnalyzerEp0Buffer + sizeof(domDupLogicAnalyzerHeader_t));
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t generation;
+	uint32_t copied;
+	uint32_t chunk;
+	uint32_t intMask;
+	uint16_t count;
+	uint16_t length;
+
+	generation = glAnalyzerGeneration;
+	CyU3PMemCopy((uint8_t *)header, (uint8_t *)&glAnalyzerHeader, sizeof(glAnalyzerHeader));
+	header->version = CY_FX_LOGIC_ANALYZER_VERSION;
+	header->entrySize = sizeof(uint32_t);
+	count = (header->state == CY_FX_ANALYZER_CAPTURED) ? header->entryCount : 0;
+
+	for (copied = 0; copied < count; copied += chunk) {
+		chunk = count - copied;
+		if (chunk > CY_FX_ANALYZER_COPY_CHUNK) chunk = CY_FX_ANALYZER_COPY_CHUNK;
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&entries[copied], (uint8_t *)&glAnalyzerEntries[copied], chunk * sizeof(uint32_t));
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	// The ring was replaced whilst it was copied (the host should read again)
+	if (generation != glAnalyzerGeneration) {
+		header->state = CY_FX_ANALYZER_ARMED;
+		count = 0;
+	}
+	header->entryCount = count;
+
+	length = sizeof(domDupLogicAnalyzerHeader_t) + (count * sizeof(uint32_t));
+	if (length > wLength) length = wLength;
+
+	apiReturnStatus = CyU3PUsbSendEP0Data(length, glAnalyzerEp0Buffer);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupLogicAnalyzerSend(): CyU3PUsbSendEP0Data failed, Error code = %d\r\n", apiReturnStatus);
+		return CyFalse;
+	}
+
+	return CyTrue;
+}
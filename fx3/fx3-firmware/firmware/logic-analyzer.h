@@ -0,0 +1,64 @@
+/************************************************************************
+
+	logic-analyzer.h
+
+	FX3 Firmware GPIF handshake logic analyzer
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _LOGIC_ANALYZER_H_
+#define _LOGIC_ANALYZER_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+
+// Version of the CY_FX_VREQ_GET_LOGIC_ANALYZER response
+#define CY_FX_LOGIC_ANALYZER_VERSION    (1)
+
+// Number of entries in the FPGA ring (see logicAnalyzer.v)
+#define CY_FX_LOGIC_ANALYZER_ENTRIES    (512)
+
+// Interval between checks of the FPGA status whilst a capture is armed
+#define CY_FX_LOGIC_ANALYZER_POLL_MS    (100)
+
+// CY_FX_VREQ_LOGIC_ANALYZER wValue: bits 15-14 select the action
+#define CY_FX_ANALYZER_SET_MASK         (0xC000)
+#define CY_FX_ANALYZER_SET_TRIGGER      (0x0000) // Trigger mask (bits 6-0) and value (bits 13-7)
+#define CY_FX_ANALYZER_SET_POST         (0x4000) // Entries recorded after the trigger entry (bits 8-0)
+#define CY_FX_ANALYZER_ARM              (0x8000) // Clear the ring and start a capture
+#define CY_FX_ANALYZER_STOP             (0xC000) // Stop the capture and read what has been recorded
+
+// Capture states
+#define CY_FX_ANALYZER_IDLE             (0) // Not armed since power-on
+#define CY_FX_ANALYZER_ARMED            (1) // Recording (waiting for the trigger or the post-trigger entries)
+#define CY_FX_ANALYZER_CAPTURED         (2) // The entries of the last capture have been read
+#define CY_FX_ANALYZER_UNAVAILABLE      (3) // The FPGA is built without LOGIC_ANALYZER
+
+// triggerEntry when the capture was stopped before the trigger
+#define CY_FX_ANALYZER_NO_TRIGGER       (0xFFFF)
+
+// Response to CY_FX_VREQ_GET_LOGIC_ANALYZER (little-endian, followed by
+// entryCount 32-bit entries, oldest first; see logicAnalyzer.v for the
+// entry format)
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_LOGIC_ANALYZER_VERSION)
+	uint8_t state;					// Capture state (CY_FX_ANALYZER_*)
+	uint8_t entrySize;				// Size of each entry in bytes
+	uint16_t entryCount;			// Number of entries that follow
+	uint16_t triggerEntry;			// Entry that met the trigger (or CY_FX_ANALYZER_NO_TRIGGER)
+	uint32_t control;				// FPGA logic analyzer control register used for the capture
+	uint32_t status;				// FPGA logic analyzer status register when the capture was read
+} domDupLogicAnalyzerHeader_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupLogicAnalyzerCommand(uint16_t value);
+void domDupLogicAnalyzerUpdate(void);
+CyBool_t domDupLogicAnalyzerSend(uint16_t wLength);
+
+#include <cyu3externcend.h>
+
+#endif // _LOGIC_ANALYZER_H_
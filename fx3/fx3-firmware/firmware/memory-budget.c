@@ -0,0 +1,47 @@
+/************************************************************************
+
+	memory-budget.c
+
+	FX3 Firmware SRAM budget
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "memory-budget.h"
+
+// Ends of the code and data sections (from the SDK linker script, fx3.ld)
+extern char _etext[];
+extern char __exidx_end[];
+
+// Fill in the memory budget (called from the USB set-up callback)
+//
+// The SRAM is split into the code region, the data region, the MEM heap and
+// the DMA buffer heap (see memory-map.h).  The last part of the buffer heap
+// that the GPIF to USB pool can't use is CY_FX_DMA_HEAP_RESERVE plus the
+// remainder of a pair of buffers.
+void domDupMemoryBudgetSnapshot(domDupMemoryBudget_t *snapshot)
+{
+	uint16_t bufferCount = domDupGetDmaBufferCount();
+
+	snapshot->version = CY_FX_MEMORY_BUDGET_VERSION;
+	snapshot->layout = CY_FX_MEMORY_LAYOUT;
+	snapshot->codeRegionBytes = CY_FX_CODE_REGION_SIZE;
+	snapshot->codeBytes = (uint32_t)_etext - CY_FX_CODE_REGION_BASE;
+	snapshot->dataRegionBytes = CY_FX_DATA_REGION_SIZE;
+	snapshot->dataBytes = (uint32_t)__exidx_end - CY_FX_DATA_REGION_BASE;
+	snapshot->memHeapBytes = CY_U3P_MEM_HEAP_SIZE;
+	snapshot->memHeapFree = domDupMemHeapFree();
+	snapshot->bufferHeapBytes = CY_U3P_BUFFER_HEAP_SIZE;
+	snapshot->bufferHeapFree = domDupBufferHeapFree();
+	snapshot->dmaPoolBytes = domDupGetPacketSize() * bufferCount * CY_FX_DMA_PRODUCER_SOCKETS;
+	snapshot->dmaBufCountMax = CY_FX_DMA_BUF_COUNT_MAX;
+	snapshot->dmaBufCount = bufferCount;
+}
@@ -0,0 +1,50 @@
+/************************************************************************
+
+	memory-budget.h
+
+	FX3 Firmware SRAM budget
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _MEMORY_BUDGET_H_
+#define _MEMORY_BUDGET_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Version of the domDupMemoryBudget_t structure returned to the host
+#define CY_FX_MEMORY_BUDGET_VERSION     (1)
+
+// Memory layouts (see memory-map.h)
+#define CY_FX_MEMORY_LAYOUT_STANDARD    (0) // 32 KB kept for the 2-stage boot loader
+#define CY_FX_MEMORY_LAYOUT_LARGE_DMA   (1) // DOMDUP_LARGE_DMA_HEAP
+
+// Response to CY_FX_VREQ_GET_MEMORY_BUDGET (little-endian)
+//
+// The code and data sizes are from the linker; the free space is at the time
+// of the request.
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_MEMORY_BUDGET_VERSION)
+	uint16_t layout;				// Memory layout (CY_FX_MEMORY_LAYOUT_*)
+	uint32_t codeRegionBytes;		// Size of the code region
+	uint32_t codeBytes;				// Code and constant data in the code region
+	uint32_t dataRegionBytes;		// Size of the data region
+	uint32_t dataBytes;				// Variables in the data region
+	uint32_t memHeapBytes;			// Size of the MEM heap (thread stacks and OS objects)
+	uint32_t memHeapFree;			// Bytes free in the MEM heap
+	uint32_t bufferHeapBytes;		// Size of the DMA buffer heap
+	uint32_t bufferHeapFree;		// Bytes free in the DMA buffer heap
+	uint32_t dmaPoolBytes;			// Bytes held by the GPIF to USB buffer pool (stream profile in use)
+	uint16_t dmaBufCountMax;		// Most DMA buffers per producer socket the buffer heap can hold
+	uint16_t dmaBufCount;			// DMA buffers per producer socket in use
+} domDupMemoryBudget_t;
+
+// Function prototypes
+void domDupMemoryBudgetSnapshot(domDupMemoryBudget_t *snapshot);
+
+#include <cyu3externcend.h>
+
+#endif // _MEMORY_BUDGET_H_
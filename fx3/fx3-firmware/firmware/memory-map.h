@@ -0,0 +1,62 @@
+/************************************************************************
+
+	memory-map.h
+
+	FX3 Firmware SRAM layout
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _MEMORY_MAP_H_
+#define _MEMORY_MAP_H_
+
+// The heap layout is shared between the RTOS porting file (cyfxtx.c), which
+// creates the heaps, and the application, which sizes the DMA buffer pool
+// from the space that is actually available.
+
+// The MEM heap is a Memory byte pool which is used to allocate OS objects
+// such as thread stacks and memory for message queues. The Cypress FX3
+// libraries require a Mem heap size of at least 32 KB.
+#define CY_U3P_MEM_HEAP_BASE         ((uint8_t *)0x40038000)
+#define CY_U3P_MEM_HEAP_SIZE         (0x8000)
+
+// The last 32 KB of RAM is reserved for 2-stage boot operation. This value can be changed to
+// 0x40080000 if 2-stage boot is not used by the application.
+//
+// The Domesday Duplicator firmware is always loaded by the FX3 boot ROM (over
+// USB or from the I2C EEPROM), so with the large DMA heap layout
+// (DOMDUP_LARGE_DMA_HEAP) the reserved 32 KB is added to the buffer heap.
+// The MEM heap is already at the minimum the libraries need; the SDK threads
+// take most of it, and the application only allocates its thread stacks.
+#ifdef DOMDUP_LARGE_DMA_HEAP
+#define CY_U3P_SYS_MEM_TOP           (0x40080000)
+#define CY_FX_MEMORY_LAYOUT          (1)
+#else
+#define CY_U3P_SYS_MEM_TOP           (0x40078000)
+#define CY_FX_MEMORY_LAYOUT          (0)
+#endif
+
+// The buffer heap is used to obtain data buffers for DMA transfers in or out of
+// the FX3 device. The reference implementation of the buffer allocator makes use
+// of a reserved area in the SYSTEM RAM and ensures that all allocated DMA buffers
+// are aligned to cache lines.
+#define CY_U3P_BUFFER_HEAP_BASE      (((uint32_t)(CY_U3P_MEM_HEAP_BASE) + (CY_U3P_MEM_HEAP_SIZE)))
+#define CY_U3P_BUFFER_HEAP_SIZE      ((CY_U3P_SYS_MEM_TOP) - (CY_U3P_BUFFER_HEAP_BASE))
+
+// The buffer allocator works in 32 byte blocks and adds one spare block to
+// every allocation (see CyU3PDmaBufferAlloc)
+#define CY_U3P_BUFFER_ALLOC_OVERHEAD (32)
+
+// Code and data regions (must match the SDK linker script, fx3.ld)
+#define CY_FX_CODE_REGION_BASE       (0x40003000)
+#define CY_FX_CODE_REGION_SIZE       (0x2D000)
+#define CY_FX_DATA_REGION_BASE       (0x40030000)
+#define CY_FX_DATA_REGION_SIZE       (0x8000)
+
+// Free space in the MEM heap and the buffer heap in bytes (see cyfxtx.c)
+uint32_t domDupMemHeapFree(void);
+uint32_t domDupBufferHeapFree(void);
+
+#endif // _MEMORY_MAP_H_
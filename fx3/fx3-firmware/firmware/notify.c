@@ -0,0 +1,225 @@
+/************************************************************************
+
+	notify.c
+
+	FX3 Firmware status notification end-point
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "notify.h"
+
+#ifdef DOMDUP_NOTIFY_EP
+
+// The events are seen in the GPIO interrupt, the USB event callback and the
+// LPM callback, none of which can wait for a DMA buffer.  Each event is put in
+// a small queue (with the interrupts disabled) and the callbacks wake the
+// application thread, which copies the queued notifications into a manual DMA
+// channel feeding the interrupt end-point.  The host polls the end-point every
+// millisecond, so it hears about an event within a few milliseconds without
+// any EP0 traffic.
+//
+// If the host is not reading the end-point the DMA buffers and then the queue
+// fill up, and further notifications are dropped (the gap shows in the
+// sequence numbers).  The RF data path is never held up.
+static CyU3PDmaChannel glNotifyChHandle;
+static volatile CyBool_t glNotifyActive = CyFalse;
+static domDupNotification_t glNotifyQueue[CY_FX_NOTIFY_QUEUE_SIZE];
+static volatile uint16_t glNotifyHead = 0;
+static volatile uint16_t glNotifyCount = 0;
+static volatile uint32_t glNotifySequence = 0;
+static CyBool_t glLastCollecting = CyFalse;
+static CyU3PUsbLinkPowerMode glLastLinkState = CyU3PUsbLPM_U0;
+
+// Configure the notification end-point and create its DMA channel (called when
+// the application is started)
+CyU3PReturnStatus_t domDupNotifyStart(void)
+{
+	CyU3PEpConfig_t epCfg;
+	CyU3PDmaChannelConfig_t dmaConfig;
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t intMask;
+
+	CyU3PMemSet((uint8_t *)&epCfg, 0, sizeof(epCfg));
+	epCfg.enable = CyTrue;
+	epCfg.epType = CY_U3P_USB_EP_INTR;
+	epCfg.burstLen = 1;
+	epCfg.streams = 0;
+	epCfg.pcktSize = CY_FX_NOTIFY_PACKET_SIZE;
+
+	apiReturnStatus = CyU3PSetEpConfig(CY_FX_EP_NOTIFY, &epCfg);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupNotifyStart(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
+	}
+	CyU3PUsbFlushEp(CY_FX_EP_NOTIFY);
+
+	CyU3PMemSet((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size = CY_FX_NOTIFY_BUF_SIZE;
+	dmaConfig.count = CY_FX_NOTIFY_BUF_COUNT;
+	dmaConfig.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId = CY_FX_EP_NOTIFY_SOCKET;
+	dmaConfig.dmaMode = CY_U3P_DMA_MODE_BYTE;
+
+	apiReturnStatus = CyU3PDmaChannelCreate(&glNotifyChHandle, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupNotifyStart(): CyU3PDmaChannelCreate failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
+	}
+
+	apiReturnStatus = CyU3PDmaChannelSetXfer(&glNotifyChHandle, 0);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupNotifyStart(): CyU3PDmaChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
+		CyU3PDmaChannelDestroy(&glNotifyChHandle);
+		return apiReturnStatus;
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glNotifyHead = 0;
+	glNotifyCount = 0;
+	glNotifySequence = 0;
+	glNotifyActive = CyTrue;
+	CyU3PVicEnableInterrupts(intMask);
+
+	glLastCollecting = CyFalse;
+	glLastLinkState = CyU3PUsbLPM_U0;
+	return CY_U3P_SUCCESS;
+}
+
+// Destroy the notification DMA channel and disable the end-point (called when
+// the application is stopped)
+void domDupNotifyStop(void)
+{
+	CyU3PEpConfig_t epCfg;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (!glNotifyActive) {
+		CyU3PVicEnableInterrupts(intMask);
+		return;
+	}
+	glNotifyActive = CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	CyU3PDmaChannelDestroy(&glNotifyChHandle);
+	CyU3PUsbFlushEp(CY_FX_EP_NOTIFY);
+
+	CyU3PMemSet((uint8_t *)&epCfg, 0, sizeof(epCfg));
+	epCfg.enable = CyFalse;
+	CyU3PSetEpConfig(CY_FX_EP_NOTIFY, &epCfg);
+}
+
+// Discard the notifications in the DMA buffers and reset the end-point (called
+// when the host clears an end-point halt)
+void domDupNotifyReset(void)
+{
+	if (!glNotifyActive) return;
+
+	CyU3PDmaChannelReset(&glNotifyChHandle);
+	CyU3PUsbFlushEp(CY_FX_EP_NOTIFY);
+	CyU3PUsbResetEp(CY_FX_EP_NOTIFY);
+	CyU3PDmaChannelSetXfer(&glNotifyChHandle, 0);
+}
+
+// Queue a notification
+//
+// May be called from interrupt context or any thread.  The caller wakes the
+// application thread to send it.
+void domDupNotifyPost(uint16_t type, uint16_t value, uint32_t data)
+{
+	domDupNotification_t *notification;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (glNotifyActive) {
+		if (glNotifyCount < CY_FX_NOTIFY_QUEUE_SIZE) {
+			notification = &glNotifyQueue[(glNotifyHead + glNotifyCount) & (CY_FX_NOTIFY_QUEUE_SIZE - 1)];
+			notification->type = type;
+			notification->value = value;
+			notification->sequence = glNotifySequence;
+			notification->timestamp = CyU3PGetTime();
+			notification->data = data;
+			glNotifyCount++;
+		}
+
+		// A dropped notification still takes a sequence number
+		glNotifySequence++;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Queue a notification for a USB event (called from the USB event callback)
+//
+// Only the events the host can't otherwise see are sent.  A reset or
+// disconnect stops the application (and the end-point with it), and the
+// status phase of every control request would swamp the others.
+void domDupNotifyUsbEvent(CyU3PUsbEventType_t eventType, uint16_t eventData)
+{
+	switch (eventType) {
+	case CY_U3P_USB_EVENT_SUSPEND:
+	case CY_U3P_USB_EVENT_RESUME:
+	case CY_U3P_USB_EVENT_EP_UNDERRUN:
+	case CY_U3P_USB_EVENT_LNK_RECOVERY:
+	case CY_U3P_USB_EVENT_USB3_LNKFAIL:
+	case CY_U3P_USB_EVENT_LMP_EXCH_FAIL:
+		domDupNotifyPost(CY_FX_NOTIFY_USB_EVENT, eventType, eventData);
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Queue the notifications seen by the application thread and send the queued
+// notifications (called from the main application loop)
+//
+// The USB 3 link state is checked each time the thread wakes, so a stay in
+// U1 or U2 shorter than CY_FX_TELEMETRY_UPDATE_MS can be missed.
+void domDupNotifyUpdate(CyBool_t collecting)
+{
+	CyU3PDmaBuffer_t buffer;
+	CyU3PUsbLinkPowerMode linkState;
+	uint32_t intMask;
+
+	if (!glNotifyActive) return;
+
+	if (collecting != glLastCollecting) {
+		glLastCollecting = collecting;
+		domDupNotifyPost(CY_FX_NOTIFY_COLLECTION, collecting ? 1 : 0, 0);
+	}
+
+	if ((CyU3PUsbGetSpeed() == CY_U3P_SUPER_SPEED) &&
+			(CyU3PUsbGetLinkPowerState(&linkState) == CY_U3P_SUCCESS) &&
+			(linkState != glLastLinkState)) {
+		domDupNotifyPost(CY_FX_NOTIFY_LINK_STATE, linkState, glLastLinkState);
+		glLastLinkState = linkState;
+	}
+
+	// Each notification is sent in its own DMA buffer (a single interrupt
+	// packet); the rest stay queued until a buffer is free
+	while (glNotifyCount != 0) {
+		if (CyU3PDmaChannelGetBuffer(&glNotifyChHandle, &buffer, CYU3P_NO_WAIT) != CY_U3P_SUCCESS) return;
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy(buffer.buffer, (uint8_t *)&glNotifyQueue[glNotifyHead], sizeof(domDupNotification_t));
+		glNotifyHead = (glNotifyHead + 1) & (CY_FX_NOTIFY_QUEUE_SIZE - 1);
+		glNotifyCount--;
+		CyU3PVicEnableInterrupts(intMask);
+
+		if (CyU3PDmaChannelCommitBuffer(&glNotifyChHandle, sizeof(domDupNotification_t), 0) != CY_U3P_SUCCESS) return;
+	}
+}
+
+#endif // DOMDUP_NOTIFY_EP
@@ -0,0 +1,56 @@
+/************************************************************************
+
+	notify.h
+
+	FX3 Firmware status notification end-point
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _NOTIFY_H_
+#define _NOTIFY_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+
+// The notification end-point is only present when the firmware is built with
+// DOMDUP_NOTIFY_EP.  It is an interrupt IN end-point in the same interface as
+// the RF data end-point, carrying a short packet for each event the host would
+// otherwise have to poll for.
+
+// (The end-point and its DMA buffers are defined in domesday-duplicator.h)
+
+// Notifications waiting to be sent (a power of 2)
+#define CY_FX_NOTIFY_QUEUE_SIZE         (16)
+
+// Notification types
+#define CY_FX_NOTIFY_OVERFLOW           (0x0001) // FPGA buffer overflow (value = 1 if collecting)
+#define CY_FX_NOTIFY_USB_EVENT          (0x0002) // USB event (value = CyU3PUsbEventType_t, data = event data)
+#define CY_FX_NOTIFY_LPM_REQUEST        (0x0003) // LPM request (value = link state requested, data = 1 if accepted)
+#define CY_FX_NOTIFY_LINK_STATE         (0x0004) // USB 3 link state change (value = new state, data = previous state)
+#define CY_FX_NOTIFY_COLLECTION         (0x0005) // Data collection started or stopped (value = 1 if started)
+
+// Notification packet (little-endian, CY_FX_NOTIFY_PACKET_SIZE bytes)
+typedef struct {
+	uint16_t type;					// Notification type (CY_FX_NOTIFY_*)
+	uint16_t value;					// Depends on the type
+	uint32_t sequence;				// Notification number since the application started
+	uint32_t timestamp;				// Time of the event since the RTOS started in milliseconds
+	uint32_t data;					// Depends on the type
+} domDupNotification_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupNotifyStart(void);
+void domDupNotifyStop(void);
+void domDupNotifyReset(void);
+void domDupNotifyPost(uint16_t type, uint16_t value, uint32_t data);
+void domDupNotifyUsbEvent(CyU3PUsbEventType_t eventType, uint16_t eventData);
+void domDupNotifyUpdate(CyBool_t collecting);
+
+#include <cyu3externcend.h>
+
+#endif // _NOTIFY_H_
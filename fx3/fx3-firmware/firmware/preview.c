@@ -0,0 +1,87 @@
+/************************************************************************
+
+	preview.c
+
+	FX3 Firmware signal preview
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "preview.h"
+#include "fpga-registers.h"
+#include "sideband.h"
+
+// The FPGA measures the envelope of the signal (the smallest and largest
+// sample in each window of 2^18 samples, see previewGenerator.v) whether or
+// not the host is collecting data.  The windows are read from the FPGA preview
+// FIFO by the application thread and the most recent are kept for
+// CY_FX_VREQ_GET_PREVIEW.  With DOMDUP_SIDEBAND_EP the windows read on each
+// poll are also sent to the host as a sideband record.
+//
+// The windows are read by the application thread and copied by the USB set-up
+// callback, so all access is made with the interrupts disabled.
+static uint32_t glPreviewWindow[CY_FX_PREVIEW_WINDOWS];
+static uint32_t glPreviewWritten = 0;
+static uint32_t glLastPollTime = 0;
+
+// Read the new preview windows from the FPGA (called from the main
+// application loop)
+void domDupPreviewUpdate(void)
+{
+	uint32_t window[CY_FX_PREVIEW_FIFO_DEPTH];
+	uint32_t windowCount;
+	uint32_t now;
+	uint32_t intMask;
+	uint32_t i;
+
+	now = CyU3PGetTime();
+	if ((now - glLastPollTime) < CY_FX_PREVIEW_POLL_MS) return;
+	glLastPollTime = now;
+
+	for (windowCount = 0; windowCount < CY_FX_PREVIEW_FIFO_DEPTH; windowCount++) {
+		if (domDupFpgaRegisterRead(CY_FX_FPGA_REG_PREVIEW, &window[windowCount]) != CY_U3P_SUCCESS) break;
+		if (!(window[windowCount] & CY_FX_FPGA_PREVIEW_VALID)) break;
+	}
+	if (windowCount == 0) return;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	for (i = 0; i < windowCount; i++) {
+		glPreviewWindow[glPreviewWritten % CY_FX_PREVIEW_WINDOWS] = window[i];
+		glPreviewWritten++;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+
+#ifdef DOMDUP_SIDEBAND_EP
+	domDupSidebandSend(CY_FX_SIDEBAND_PREVIEW, (uint8_t *)window, windowCount * sizeof(uint32_t));
+#endif
+}
+
+// Copy the most recent preview windows, oldest first (for sending to the host)
+void domDupPreviewSnapshot(domDupPreview_t *snapshot)
+{
+	uint32_t first;
+	uint32_t i;
+	uint32_t intMask;
+
+	CyU3PMemSet((uint8_t *)snapshot, 0, sizeof(domDupPreview_t));
+	snapshot->version = CY_FX_PREVIEW_VERSION;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	snapshot->windowsRead = glPreviewWritten;
+	snapshot->windowCount = (glPreviewWritten < CY_FX_PREVIEW_WINDOWS) ? glPreviewWritten : CY_FX_PREVIEW_WINDOWS;
+	first = glPreviewWritten - snapshot->windowCount;
+	for (i = 0; i < snapshot->windowCount; i++) {
+		snapshot->window[i] = glPreviewWindow[(first + i) % CY_FX_PREVIEW_WINDOWS];
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
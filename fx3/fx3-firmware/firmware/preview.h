@@ -0,0 +1,50 @@
+/************************************************************************
+
+	preview.h
+
+	FX3 Firmware signal preview
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _PREVIEW_H_
+#define _PREVIEW_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Version of the domDupPreview_t structure returned to the host
+#define CY_FX_PREVIEW_VERSION           (1)
+
+// Interval between reads of the FPGA preview FIFO (which holds about 100 ms
+// of windows at 40 MSPS)
+#define CY_FX_PREVIEW_POLL_MS           (50)
+
+// Most windows read from the FPGA on each poll (the FPGA FIFO depth)
+#define CY_FX_PREVIEW_FIFO_DEPTH        (16)
+
+// Number of the most recent windows kept for CY_FX_VREQ_GET_PREVIEW
+#define CY_FX_PREVIEW_WINDOWS           (48)
+
+// Preview window fields (as read from the FPGA preview FIFO register)
+#define CY_FX_PREVIEW_NUMBER(w)         (((w) >> 20) & 0x7FF) // Window number
+#define CY_FX_PREVIEW_MAX(w)            (((w) >> 10) & 0x3FF) // Largest sample
+#define CY_FX_PREVIEW_MIN(w)            ((w) & 0x3FF)         // Smallest sample
+
+// Response to CY_FX_VREQ_GET_PREVIEW (little-endian)
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_PREVIEW_VERSION)
+	uint16_t windowCount;			// Number of valid entries in window (oldest first)
+	uint32_t windowsRead;			// Windows read from the FPGA since power-on
+	uint32_t window[CY_FX_PREVIEW_WINDOWS];	// Preview windows (CY_FX_PREVIEW_* fields)
+} domDupPreview_t;
+
+// Function prototypes
+void domDupPreviewUpdate(void);
+void domDupPreviewSnapshot(domDupPreview_t *snapshot);
+
+#include <cyu3externcend.h>
+
+#endif // _PREVIEW_H_
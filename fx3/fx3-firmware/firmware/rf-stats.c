@@ -0,0 +1,122 @@
+/************************************************************************
+
+	rf-stats.c
+
+	FX3 Firmware RF level and clipping statistics
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "rf-stats.h"
+#include "fpga-registers.h"
+
+// The FPGA accumulates the statistics over windows of 2^20 samples whether or
+// not the host is collecting data (see rfStatistics.v).  The application
+// thread holds the FPGA snapshot, reads all the registers from the same
+// window and keeps the result for CY_FX_VREQ_GET_RF_STATS, so answering the
+// request doesn't hold up EP0 with register reads.
+//
+// The statistics are read by the application thread and copied by the USB
+// set-up callback, so all access is made with the interrupts disabled.
+static domDupRfStats_t glRfStats;
+static domDupRfStats_t glRfStatsResponse;
+static uint32_t glLastPollTime = 0;
+
+// Read the statistics snapshot from the FPGA
+static CyU3PReturnStatus_t domDupRfStatsRead(domDupRfStats_t *stats)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t minMax = 0;
+	uint32_t bin;
+
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_WINDOW, &stats->windowNumber);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_MIN_MAX, &minMax);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_SUM, &stats->sum);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_CLIP_LOW, &stats->clipLow);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_CLIP_HIGH, &stats->clipHigh);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	for (bin = 0; bin < CY_FX_RF_STATS_BINS; bin++) {
+		apiReturnStatus = domDupFpgaRegisterRead(CY_FX_FPGA_REG_STATS_HISTOGRAM + bin, &stats->histogram[bin]);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	}
+
+	stats->minimum = minMax & 0x3FF;
+	stats->maximum = (minMax >> 10) & 0x3FF;
+	return CY_U3P_SUCCESS;
+}
+
+// Read the statistics from the FPGA (called from the main application loop)
+void domDupRfStatsUpdate(void)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	domDupRfStats_t stats;
+	uint32_t now;
+	uint32_t intMask;
+
+	now = CyU3PGetTime();
+	if ((now - glLastPollTime) < CY_FX_RF_STATS_POLL_MS) return;
+	glLastPollTime = now;
+
+	CyU3PMemSet((uint8_t *)&stats, 0, sizeof(stats));
+	stats.version = CY_FX_RF_STATS_VERSION;
+	stats.windowSamples = CY_FX_RF_STATS_WINDOW_SAMPLES;
+	stats.readTime = now;
+
+	// Hold the snapshot whilst it is read
+	apiReturnStatus = domDupFpgaRegisterWrite(CY_FX_FPGA_REG_STATS_CONTROL, CY_FX_FPGA_STATS_HOLD);
+	if (apiReturnStatus == CY_U3P_SUCCESS) apiReturnStatus = domDupRfStatsRead(&stats);
+	domDupFpgaRegisterWrite(CY_FX_FPGA_REG_STATS_CONTROL, 0);
+
+	// An FPGA without the statistics reads window 0
+	if ((apiReturnStatus != CY_U3P_SUCCESS) || (stats.windowNumber == 0)) return;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)&glRfStats, (uint8_t *)&stats, sizeof(stats));
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Send the last statistics read to the host (called from the USB set-up
+// callback)
+CyBool_t domDupRfStatsSend(uint16_t wLength)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)&glRfStatsResponse, (uint8_t *)&glRfStats, sizeof(glRfStats));
+	CyU3PVicEnableInterrupts(intMask);
+
+	glRfStatsResponse.version = CY_FX_RF_STATS_VERSION;
+	glRfStatsResponse.windowSamples = CY_FX_RF_STATS_WINDOW_SAMPLES;
+	return domDupSendVendorResponse((uint8_t *)&glRfStatsResponse, sizeof(glRfStatsResponse), wLength);
+}
+
+// Get a histogram bin from the last statistics read (for
+// CY_FX_VREQ_GET_FPGA_REGISTER, called from the USB set-up callback)
+uint32_t domDupRfStatsGetBin(uint16_t bin)
+{
+	uint32_t value;
+	uint32_t intMask;
+
+	if (bin >= CY_FX_RF_STATS_BINS) return 0;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	value = glRfStats.histogram[bin];
+	CyU3PVicEnableInterrupts(intMask);
+
+	return value;
+}
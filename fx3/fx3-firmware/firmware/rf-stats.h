@@ -0,0 +1,55 @@
+/************************************************************************
+
+	rf-stats.h
+
+	FX3 Firmware RF level and clipping statistics
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _RF_STATS_H_
+#define _RF_STATS_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Version of the domDupRfStats_t structure returned to the host
+#define CY_FX_RF_STATS_VERSION          (1)
+
+// Interval between reads of the FPGA statistics (the FPGA window is 26 ms at
+// 40 MSPS; reading every window would cost more CPU time than it is worth)
+#define CY_FX_RF_STATS_POLL_MS          (250)
+
+// Number of samples in each FPGA statistics window (see rfStatistics.v)
+#define CY_FX_RF_STATS_WINDOW_SAMPLES   (1 << 20)
+
+// Number of histogram bins (each bin covers 16 ADC values)
+#define CY_FX_RF_STATS_BINS             (64)
+
+// Response to CY_FX_VREQ_GET_RF_STATS (little-endian)
+//
+// All values are from the same FPGA window.  windowNumber is 0 if the
+// statistics have not been read (or the FPGA doesn't have them).
+typedef struct {
+	uint32_t version;				// Structure version (CY_FX_RF_STATS_VERSION)
+	uint32_t windowSamples;			// Number of samples in the window
+	uint32_t windowNumber;			// FPGA window number (counted from the FPGA reset)
+	uint32_t readTime;				// Time since the RTOS started when the window was read (ms)
+	uint16_t minimum;				// Smallest sample in the window
+	uint16_t maximum;				// Largest sample in the window
+	uint32_t sum;					// Sum of the samples (mean = sum / windowSamples)
+	uint32_t clipLow;				// Samples at the bottom of the ADC range (0)
+	uint32_t clipHigh;				// Samples at the top of the ADC range (1023)
+	uint32_t histogram[CY_FX_RF_STATS_BINS];	// Bin n counts the samples from n x 16 to n x 16 + 15
+} domDupRfStats_t;
+
+// Function prototypes
+void domDupRfStatsUpdate(void);
+CyBool_t domDupRfStatsSend(uint16_t wLength);
+uint32_t domDupRfStatsGetBin(uint16_t bin);
+
+#include <cyu3externcend.h>
+
+#endif // _RF_STATS_H_
@@ -0,0 +1,146 @@
+/************************************************************************
+
+	self-test.c
+
+	FX3 Firmware throughput self-test
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "self-test.h"
+#include "telemetry.h"
+#include "command-queue.h"
+#include "trace.h"
+
+// The self-test streams the FPGA test pattern (configuration bit 0) at full
+// rate with each stream profile in turn and measures the sustained throughput
+// from the telemetry counters.  The host must keep reading the bulk end-point
+// for the whole test (about CY_FX_STREAM_PROFILES x 1.1 seconds); the data can
+// also be checked against the test pattern by the host.
+//
+// The results are written by the command thread and read by the USB set-up
+// callback, so all access is made with the interrupts disabled.
+static domDupSelfTest_t glSelfTest = {
+	CY_FX_SELF_TEST_VERSION, CY_FX_SELF_TEST_IDLE, CY_FX_STREAM_PROFILES,
+	CY_FX_STREAM_PROFILE_DEFAULT, CY_FX_SELF_TEST_NO_PROFILE
+};
+
+// Set the self-test state
+static void domDupSelfTestSetState(uint8_t state)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glSelfTest.state = state;
+	glSelfTest.activeProfile = domDupGetStreamProfile();
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Stream with one profile and measure the throughput
+static CyU3PReturnStatus_t domDupSelfTestProfile(uint16_t profile, domDupSelfTestResult_t *result)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	domDupStreamProfile_t settings;
+	domDupTelemetry_t start;
+	domDupTelemetry_t end;
+
+	CyU3PMemSet((uint8_t *)result, 0, sizeof(domDupSelfTestResult_t));
+	domDupGetStreamProfileSettings(profile, &settings);
+	result->burstLength = settings.burstLength;
+	result->bufferCount = settings.bufferCount;
+
+	apiReturnStatus = domDupSetStreamProfile(profile);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 1);
+	if (apiReturnStatus != CY_U3P_SUCCESS) return apiReturnStatus;
+
+	// Let the host's transfers get going before measuring
+	CyU3PThreadSleep(CY_FX_SELF_TEST_SETTLE_MS);
+	domDupTelemetrySnapshot(&start);
+	CyU3PThreadSleep(CY_FX_SELF_TEST_MEASURE_MS);
+	domDupTelemetrySnapshot(&end);
+
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0);
+
+	result->durationMs = end.uptimeMs - start.uptimeMs;
+	result->bytes = end.consumedBytes - start.consumedBytes;
+	if (result->durationMs != 0) result->throughputKBps = (uint32_t)(result->bytes / result->durationMs);
+	result->pibErrors = end.pibErrors - start.pibErrors;
+	result->overflowEvents = end.overflowEvents - start.overflowEvents;
+
+	return apiReturnStatus;
+}
+
+// Run the self-test (called from the command thread)
+//
+// Data collection is stopped when the test completes, and the stream profile
+// and the configuration the host selected are restored.
+CyU3PReturnStatus_t domDupSelfTestRun(void)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	domDupSelfTestResult_t result;
+	uint16_t savedProfile;
+	uint16_t savedConfiguration;
+	uint16_t profile;
+	uint32_t bestThroughput = 0;
+	uint32_t intMask;
+
+	savedProfile = domDupGetStreamProfile();
+	savedConfiguration = domDupGetRequestedConfiguration();
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemSet((uint8_t *)glSelfTest.result, 0, sizeof(glSelfTest.result));
+	glSelfTest.bestProfile = CY_FX_SELF_TEST_NO_PROFILE;
+	CyU3PVicEnableInterrupts(intMask);
+	domDupSelfTestSetState(CY_FX_SELF_TEST_RUNNING);
+
+	// Stop collection and switch the FPGA to the test pattern
+	apiReturnStatus = domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0);
+	if (apiReturnStatus == CY_U3P_SUCCESS) apiReturnStatus = domDupApplyConfiguration(CY_FX_CONFIG_TEST_MODE);
+
+	for (profile = 0; (profile < CY_FX_STREAM_PROFILES) && (apiReturnStatus == CY_U3P_SUCCESS); profile++) {
+		apiReturnStatus = domDupSelfTestProfile(profile, &result);
+		domDupTrace(CY_FX_TRACE_SELF_TEST, profile, result.throughputKBps);
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSelfTestRun(): Profile %d: %d KB/s, %d PIB errors, %d overflows\r\n",
+			profile, result.throughputKBps, result.pibErrors, result.overflowEvents);
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		CyU3PMemCopy((uint8_t *)&glSelfTest.result[profile], (uint8_t *)&result, sizeof(result));
+		if ((apiReturnStatus == CY_U3P_SUCCESS) && (result.pibErrors == 0) && (result.overflowEvents == 0) &&
+			(result.throughputKBps > bestThroughput)) {
+			bestThroughput = result.throughputKBps;
+			glSelfTest.bestProfile = profile;
+		}
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	// Restore the host's settings (unless the application has been stopped)
+	if (domDupRunCommand(CY_FX_VREQ_COLLECT_DATA, 0) == CY_U3P_SUCCESS) {
+		domDupSetStreamProfile(savedProfile);
+		domDupApplyConfiguration(savedConfiguration);
+	}
+
+	domDupSelfTestSetState((apiReturnStatus == CY_U3P_SUCCESS) ? CY_FX_SELF_TEST_DONE : CY_FX_SELF_TEST_ABORTED);
+	return apiReturnStatus;
+}
+
+// Copy the self-test results (for sending to the host)
+void domDupSelfTestGetResults(domDupSelfTest_t *results)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glSelfTest.activeProfile = domDupGetStreamProfile();
+	CyU3PMemCopy((uint8_t *)results, (uint8_t *)&glSelfTest, sizeof(glSelfTest));
+	CyU3PVicEnableInterrupts(intMask);
+}
@@ -0,0 +1,68 @@
+/************************************************************************
+
+	self-test.h
+
+	FX3 Firmware throughput self-test
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _SELF_TEST_H_
+#define _SELF_TEST_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+#include "domesday-duplicator.h"
+
+// Version of the domDupSelfTest_t structure returned to the host
+#define CY_FX_SELF_TEST_VERSION         (1)
+
+// CY_FX_VREQ_STREAM_PROFILE wValue that runs the self-test
+#define CY_FX_SELF_TEST_START           (0x8000)
+
+// Time each profile streams for before (settle) and whilst (measure) the
+// throughput is measured
+#define CY_FX_SELF_TEST_SETTLE_MS       (100)
+#define CY_FX_SELF_TEST_MEASURE_MS      (1000)
+
+// Self-test states
+#define CY_FX_SELF_TEST_IDLE            (0) // Not run since power-on
+#define CY_FX_SELF_TEST_RUNNING         (1) // Running (the results are incomplete)
+#define CY_FX_SELF_TEST_DONE            (2) // Completed
+#define CY_FX_SELF_TEST_ABORTED         (3) // Stopped early (device disconnected or reset)
+
+// bestProfile when no profile streamed without errors
+#define CY_FX_SELF_TEST_NO_PROFILE      (0xFFFF)
+
+// Self-test result for one stream profile
+typedef struct {
+	uint16_t burstLength;			// USB 3 end-point burst length
+	uint16_t bufferCount;			// DMA buffers per producer socket
+	uint32_t durationMs;			// Measurement time in milliseconds
+	uint64_t bytes;					// Bytes sent to the host during the measurement
+	uint32_t throughputKBps;		// Sustained throughput in Kbytes (1000 bytes) per second
+	uint32_t pibErrors;				// PIB/GPIF error interrupts (including GPIF stalls)
+	uint32_t overflowEvents;		// FPGA buffer overflow events
+	uint32_t reserved;
+} domDupSelfTestResult_t;
+
+// Response to CY_FX_VREQ_GET_SELF_TEST (little-endian)
+typedef struct {
+	uint16_t version;				// Structure version (CY_FX_SELF_TEST_VERSION)
+	uint8_t state;					// Self-test state (CY_FX_SELF_TEST_*)
+	uint8_t profileCount;			// Number of entries in result
+	uint16_t activeProfile;			// Stream profile in use
+	uint16_t bestProfile;			// Fastest profile without errors (or CY_FX_SELF_TEST_NO_PROFILE)
+	domDupSelfTestResult_t result[CY_FX_STREAM_PROFILES];	// Result for each stream profile
+} domDupSelfTest_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupSelfTestRun(void);
+void domDupSelfTestGetResults(domDupSelfTest_t *results);
+
+#include <cyu3externcend.h>
+
+#endif // _SELF_TEST_H_
@@ -0,0 +1,182 @@
+/************************************************************************
+
+	sideband.c
+
+	FX3 Firmware sideband end-point
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "sideband.h"
+#include "telemetry.h"
+#include "fpga-registers.h"
+
+#ifdef DOMDUP_SIDEBAND_EP
+
+// The records are written by the CPU into a manual DMA channel feeding the
+// sideband end-point.  The buffers are only taken without waiting: if the host
+// is not reading the end-point the records are dropped (the gap shows in the
+// sequence numbers) and the RF data path is never held up.
+//
+// The records are only sent from the application thread.
+static CyU3PDmaChannel glSidebandChHandle;
+static CyBool_t glSidebandActive = CyFalse;
+static uint32_t glSidebandSequence = 0;
+static uint32_t glLastTelemetryTime = 0;
+static CyBool_t glLastCollecting = CyFalse;
+
+// Configure the sideband end-point and create its DMA channel (called when the
+// application is started)
+CyU3PReturnStatus_t domDupSidebandStart(uint16_t packetSize)
+{
+	CyU3PEpConfig_t epCfg;
+	CyU3PDmaChannelConfig_t dmaConfig;
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+
+	CyU3PMemSet((uint8_t *)&epCfg, 0, sizeof(epCfg));
+	epCfg.enable = CyTrue;
+	epCfg.epType = CY_U3P_USB_EP_BULK;
+	epCfg.burstLen = 1;
+	epCfg.streams = 0;
+	epCfg.pcktSize = packetSize;
+
+	apiReturnStatus = CyU3PSetEpConfig(CY_FX_EP_SIDEBAND, &epCfg);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSidebandStart(): CyU3PSetEpConfig failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
+	}
+	CyU3PUsbFlushEp(CY_FX_EP_SIDEBAND);
+
+	CyU3PMemSet((uint8_t *)&dmaConfig, 0, sizeof(dmaConfig));
+	dmaConfig.size = CY_FX_SIDEBAND_BUF_SIZE;
+	dmaConfig.count = CY_FX_SIDEBAND_BUF_COUNT;
+	dmaConfig.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+	dmaConfig.consSckId = CY_FX_EP_SIDEBAND_SOCKET;
+	dmaConfig.dmaMode = CY_U3P_DMA_MODE_BYTE;
+
+	apiReturnStatus = CyU3PDmaChannelCreate(&glSidebandChHandle, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaConfig);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSidebandStart(): CyU3PDmaChannelCreate failed, Error code = %d\r\n", apiReturnStatus);
+		return apiReturnStatus;
+	}
+
+	apiReturnStatus = CyU3PDmaChannelSetXfer(&glSidebandChHandle, 0);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSidebandStart(): CyU3PDmaChannelSetXfer failed, Error code = %d\r\n", apiReturnStatus);
+		CyU3PDmaChannelDestroy(&glSidebandChHandle);
+		return apiReturnStatus;
+	}
+
+	glSidebandSequence = 0;
+	glLastTelemetryTime = CyU3PGetTime();
+	glLastCollecting = CyFalse;
+	glSidebandActive = CyTrue;
+	return CY_U3P_SUCCESS;
+}
+
+// Destroy the sideband DMA channel and disable the end-point (called when the
+// application is stopped)
+void domDupSidebandStop(void)
+{
+	CyU3PEpConfig_t epCfg;
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (!glSidebandActive) {
+		CyU3PVicEnableInterrupts(intMask);
+		return;
+	}
+	glSidebandActive = CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+
+	CyU3PDmaChannelDestroy(&glSidebandChHandle);
+	CyU3PUsbFlushEp(CY_FX_EP_SIDEBAND);
+
+	CyU3PMemSet((uint8_t *)&epCfg, 0, sizeof(epCfg));
+	epCfg.enable = CyFalse;
+	CyU3PSetEpConfig(CY_FX_EP_SIDEBAND, &epCfg);
+}
+
+// Discard the queued records and reset the end-point (called when the host
+// clears an end-point halt)
+void domDupSidebandReset(void)
+{
+	if (!glSidebandActive) return;
+
+	CyU3PDmaChannelReset(&glSidebandChHandle);
+	CyU3PUsbFlushEp(CY_FX_EP_SIDEBAND);
+	CyU3PUsbResetEp(CY_FX_EP_SIDEBAND);
+	CyU3PDmaChannelSetXfer(&glSidebandChHandle, 0);
+}
+
+// Send a record (returns CyFalse if the record was dropped)
+CyBool_t domDupSidebandSend(uint16_t type, const uint8_t *data, uint16_t length)
+{
+	CyU3PDmaBuffer_t buffer;
+	domDupSidebandHeader_t header;
+
+	if (!glSidebandActive) return CyFalse;
+	if ((sizeof(header) + length) > CY_FX_SIDEBAND_BUF_SIZE) return CyFalse;
+
+	header.type = type;
+	header.length = length;
+	header.sequence = glSidebandSequence++;
+	header.timestamp = CyU3PGetTime();
+
+	if (CyU3PDmaChannelGetBuffer(&glSidebandChHandle, &buffer, CYU3P_NO_WAIT) != CY_U3P_SUCCESS) return CyFalse;
+
+	CyU3PMemCopy(buffer.buffer, (uint8_t *)&header, sizeof(header));
+	if (length != 0) CyU3PMemCopy(buffer.buffer + sizeof(header), (uint8_t *)data, length);
+
+	return (CyU3PDmaChannelCommitBuffer(&glSidebandChHandle, sizeof(header) + length, 0) == CY_U3P_SUCCESS);
+}
+
+// Send the periodic records (called from the main application loop)
+void domDupSidebandUpdate(CyBool_t collecting)
+{
+	domDupTelemetry_t telemetry;
+	uint32_t state;
+	uint32_t now;
+
+	if (!glSidebandActive) return;
+
+	if (collecting != glLastCollecting) {
+		glLastCollecting = collecting;
+		state = collecting ? 1 : 0;
+		domDupSidebandSend(CY_FX_SIDEBAND_COLLECTION, (uint8_t *)&state, sizeof(state));
+	}
+
+	now = CyU3PGetTime();
+	if ((now - glLastTelemetryTime) >= CY_FX_SIDEBAND_TELEMETRY_MS) {
+		glLastTelemetryTime = now;
+		domDupTelemetrySnapshot(&telemetry);
+		domDupSidebandSend(CY_FX_SIDEBAND_TELEMETRY, (uint8_t *)&telemetry, sizeof(telemetry));
+	}
+}
+
+// Send an overflow record (called from the main application loop when the
+// FPGA signals a buffer overflow)
+void domDupSidebandOverflowEvent(void)
+{
+	domDupOverflowStatus_t overflowStatus;
+
+	if (!glSidebandActive) return;
+
+	CyU3PMemSet((uint8_t *)&overflowStatus, 0, sizeof(overflowStatus));
+	domDupFpgaGetOverflowStatus(&overflowStatus);
+	domDupSidebandSend(CY_FX_SIDEBAND_OVERFLOW, (uint8_t *)&overflowStatus, sizeof(overflowStatus));
+}
+
+#endif // DOMDUP_SIDEBAND_EP
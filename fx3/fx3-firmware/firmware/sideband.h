@@ -0,0 +1,53 @@
+/************************************************************************
+
+	sideband.h
+
+	FX3 Firmware sideband end-point
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _SIDEBAND_H_
+#define _SIDEBAND_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+
+// The sideband end-point is only present when the firmware is built with
+// DOMDUP_SIDEBAND_EP.  It is a second bulk IN end-point in the same interface
+// as the RF data end-point, carrying status records the host would otherwise
+// have to poll for on EP0.
+
+// (The end-point and its DMA buffers are defined in domesday-duplicator.h)
+
+// Interval between telemetry records
+#define CY_FX_SIDEBAND_TELEMETRY_MS     (100)
+
+// Record types
+#define CY_FX_SIDEBAND_TELEMETRY        (0x0001) // Telemetry counters (domDupTelemetry_t)
+#define CY_FX_SIDEBAND_OVERFLOW         (0x0002) // FPGA buffer overflow (domDupOverflowStatus_t)
+#define CY_FX_SIDEBAND_COLLECTION       (0x0003) // Data collection started or stopped (uint32_t, 1 = started)
+#define CY_FX_SIDEBAND_PREVIEW          (0x0004) // Signal preview windows (uint32_t each, see preview.h)
+
+// Header of each sideband record (little-endian, followed by 'length' bytes)
+typedef struct {
+	uint16_t type;					// Record type (CY_FX_SIDEBAND_*)
+	uint16_t length;				// Length of the record data in bytes
+	uint32_t sequence;				// Record number since the application started
+	uint32_t timestamp;				// Time since the RTOS started in milliseconds
+} domDupSidebandHeader_t;
+
+// Function prototypes
+CyU3PReturnStatus_t domDupSidebandStart(uint16_t packetSize);
+void domDupSidebandStop(void);
+void domDupSidebandReset(void);
+void domDupSidebandUpdate(CyBool_t collecting);
+void domDupSidebandOverflowEvent(void);
+CyBool_t domDupSidebandSend(uint16_t type, const uint8_t *data, uint16_t length);
+
+#include <cyu3externcend.h>
+
+#endif // _SIDEBAND_H_
@@ -0,0 +1,216 @@
+/************************************************************************
+
+	socket-stats.c
+
+	FX3 Firmware GPIF producer socket statistics and watermarks
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3gpif.h"
+#include "cyu3socket.h"
+#include "cyu3vic.h"
+#include "pib_regs.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "socket-stats.h"
+#include "telemetry.h"
+
+// The GPIF fills a buffer on one thread until the partial flag (set by the
+// socket watermark) is sampled, then switches to the other thread.  If the
+// other socket has no free buffer it stalls, and the state-machine waits
+// whilst the FPGA buffer fills.
+//
+// The FX3 has no counters for this, so the application thread samples the
+// PIB socket registers each time it wakes whilst data is being collected
+// (at least every CY_FX_TELEMETRY_UPDATE_MS):
+//
+//   - The STALL interrupt bit is latched by the socket whenever it waits
+//     for a buffer (whether or not the interrupt is enabled), and is cleared
+//     here after each sample, so stallEvents counts the samples in which the
+//     socket had stalled since the previous one
+//   - A socket found in the stall state is counted as stalled for the whole
+//     time since the previous sample (stallTimeMs is an estimate)
+//   - AVL_COUNT is the number of free buffers beyond the one being filled
+//
+// The commit counts come from the DMA channel.  The GPIF alternates between
+// the threads, so the counts should never differ by more than one; a larger
+// maxImbalance shows that one socket is being starved.
+//
+// The watermarks are applied each time the GPIF state-machine is started
+// (CyU3PGpifSocketConfigure() is not safe on a running state-machine), so a
+// new setting takes effect when data collection is next started.
+static domDupSocketStats_t glSocketStats;
+static uint16_t glSocketWatermark[CY_FX_DMA_PRODUCER_SOCKETS];
+static uint32_t glLastCommitCount[CY_FX_DMA_PRODUCER_SOCKETS];
+static uint32_t glLastSampleTime;
+static CyBool_t glLastSampleValid;
+
+static const CyU3PDmaSocketId_t glProducerSocket[CY_FX_DMA_PRODUCER_SOCKETS] = {
+	CY_FX_EP_PRODUCER_SOCKET0, CY_FX_EP_PRODUCER_SOCKET1
+};
+
+// Clear the statistics (keeping the watermarks)
+static void domDupSocketStatsClear(void)
+{
+	uint32_t intMask;
+	uint8_t socket;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemSet((uint8_t *)&glSocketStats, 0, sizeof(glSocketStats));
+	glSocketStats.version = CY_FX_SOCKET_STATS_VERSION;
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		glSocketStats.socket[socket].watermark = glSocketWatermark[socket];
+		glSocketStats.socket[socket].minFreeBuffers = 0xFFFF;
+		glLastCommitCount[socket] = 0;
+	}
+	glLastSampleValid = CyFalse;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Initialise the watermarks and statistics (call once before the USB is
+// started)
+void domDupSocketStatsInitialise(void)
+{
+	uint8_t socket;
+
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) glSocketWatermark[socket] = CY_FX_GPIF_WATERMARK;
+	domDupSocketStatsClear();
+}
+
+// Set the thread watermarks and clear the statistics (call with the GPIF
+// state-machine stopped, before it is started)
+CyU3PReturnStatus_t domDupSocketConfigure(void)
+{
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint8_t socket;
+
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		apiReturnStatus = CyU3PGpifSocketConfigure(socket, glProducerSocket[socket], glSocketWatermark[socket], CyFalse, 1);
+		if (apiReturnStatus != CY_U3P_SUCCESS) {
+			domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupSocketConfigure(): CyU3PGpifSocketConfigure failed for thread%d, error code = %d\r\n",
+				socket, apiReturnStatus);
+			return apiReturnStatus;
+		}
+
+		// Discard a stall latched before the state-machine was started
+		CY_U3P_PIB_SCK_INTR(CyU3PDmaGetSckNum(glProducerSocket[socket])) = CY_U3P_PIB_STALL;
+	}
+
+	domDupSocketStatsClear();
+	return CY_U3P_SUCCESS;
+}
+
+// Carry out CY_FX_VREQ_SOCKET_WATERMARK (called from the command thread)
+//
+// The watermark takes effect when data collection is next started.
+CyU3PReturnStatus_t domDupSocketSetWatermark(uint16_t value)
+{
+	uint16_t watermark = value & CY_FX_WATERMARK_VALUE_MASK;
+	uint16_t sockets = (value & CY_FX_WATERMARK_SOCKET_MASK) >> CY_FX_WATERMARK_SOCKET_SHIFT;
+	uint8_t socket;
+
+	if ((value & ~(CY_FX_WATERMARK_VALUE_MASK | CY_FX_WATERMARK_SOCKET_MASK)) != 0) return CY_U3P_ERROR_BAD_ARGUMENT;
+	if ((watermark < CY_FX_WATERMARK_MIN) || (watermark > CY_FX_WATERMARK_MAX)) return CY_U3P_ERROR_BAD_ARGUMENT;
+	if (sockets == 0) sockets = (1 << CY_FX_DMA_PRODUCER_SOCKETS) - 1;
+
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		if (sockets & (1 << socket)) glSocketWatermark[socket] = watermark;
+	}
+	return CY_U3P_SUCCESS;
+}
+
+// Sample the producer sockets (called from the main application loop)
+void domDupSocketStatsUpdate(CyU3PDmaMultiChannel *channel, CyBool_t collecting)
+{
+	domDupSocketStatsSocket_t *stats;
+	CyU3PDmaState_t state;
+	uint32_t commitCount[CY_FX_DMA_PRODUCER_SOCKETS];
+	uint32_t sckStatus[CY_FX_DMA_PRODUCER_SOCKETS];
+	uint32_t sckStalled[CY_FX_DMA_PRODUCER_SOCKETS];
+	uint32_t consumed;
+	uint32_t elapsed;
+	uint32_t freeBuffers;
+	uint32_t imbalance;
+	uint32_t stallMs = 0;
+	uint32_t stallEvents = 0;
+	uint32_t intMask;
+	uint32_t now;
+	uint8_t socket;
+	uint8_t index;
+
+	if (!collecting) {
+		glLastSampleValid = CyFalse;
+		return;
+	}
+
+	now = CyU3PGetTime();
+
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		if (CyU3PDmaMultiChannelGetStatus(channel, &state, &commitCount[socket], &consumed, socket) != CY_U3P_SUCCESS) return;
+
+		// Read the socket state and take the latched stall flag
+		index = CyU3PDmaGetSckNum(glProducerSocket[socket]);
+		sckStatus[socket] = CY_U3P_PIB_SCK_STATUS(index);
+		sckStalled[socket] = CY_U3P_PIB_SCK_INTR(index) & CY_U3P_PIB_STALL;
+		if (sckStalled[socket]) CY_U3P_PIB_SCK_INTR(index) = CY_U3P_PIB_STALL;
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	elapsed = glLastSampleValid ? (now - glLastSampleTime) : 0;
+	glSocketStats.sampledTimeMs += elapsed;
+
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		stats = &glSocketStats.socket[socket];
+
+		// The transfer count is in bytes and is cleared if the channel is
+		// reset (by an end-point halt recovery)
+		commitCount[socket] /= domDupGetPacketSize();
+		if (commitCount[socket] < glLastCommitCount[socket]) glLastCommitCount[socket] = 0;
+		stats->commits += commitCount[socket] - glLastCommitCount[socket];
+		glLastCommitCount[socket] = commitCount[socket];
+
+		if (sckStalled[socket]) {
+			stats->stallEvents++;
+			stallEvents++;
+		}
+		if (((sckStatus[socket] & CY_U3P_PIB_STATE_MASK) >> CY_U3P_PIB_STATE_POS) == CY_U3P_PIB_STATE_STALL) {
+			stats->stallTimeMs += elapsed;
+			stallMs = elapsed;
+		}
+
+		freeBuffers = (sckStatus[socket] & CY_U3P_PIB_AVL_COUNT_MASK) >> CY_U3P_PIB_AVL_COUNT_POS;
+		if (freeBuffers < stats->minFreeBuffers) stats->minFreeBuffers = freeBuffers;
+	}
+
+	imbalance = (glSocketStats.socket[0].commits > glSocketStats.socket[1].commits) ?
+		glSocketStats.socket[0].commits - glSocketStats.socket[1].commits :
+		glSocketStats.socket[1].commits - glSocketStats.socket[0].commits;
+	if (imbalance > glSocketStats.maxImbalance) glSocketStats.maxImbalance = imbalance;
+
+	glLastSampleTime = now;
+	glLastSampleValid = CyTrue;
+	CyU3PVicEnableInterrupts(intMask);
+
+	// The telemetry keeps the totals since power-on (the time either thread
+	// was waiting counts once)
+	domDupTelemetryDmaStall(stallMs, stallEvents);
+}
+
+// Take a copy of the statistics (may be called from the USB set-up callback)
+void domDupSocketStatsSnapshot(domDupSocketStats_t *snapshot)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)snapshot, (uint8_t *)&glSocketStats, sizeof(glSocketStats));
+	CyU3PVicEnableInterrupts(intMask);
+}
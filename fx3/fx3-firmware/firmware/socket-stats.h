@@ -0,0 +1,64 @@
+/************************************************************************
+
+	socket-stats.h
+
+	FX3 Firmware GPIF producer socket statistics and watermarks
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _SOCKET_STATS_H_
+#define _SOCKET_STATS_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3error.h"
+#include "cyu3dma.h"
+#include "domesday-duplicator.h"
+
+// Version of the domDupSocketStats_t structure returned to the host
+#define CY_FX_SOCKET_STATS_VERSION      (1)
+
+// CY_FX_VREQ_SOCKET_WATERMARK wValue: bits 7-0 are the watermark, bits 9-8
+// select the sockets (bit 8 = thread 0, bit 9 = thread 1, neither = both)
+#define CY_FX_WATERMARK_VALUE_MASK      (0x00FF)
+#define CY_FX_WATERMARK_SOCKET_SHIFT    (8)
+#define CY_FX_WATERMARK_SOCKET_MASK     (0x0300)
+
+// Watermark range: the lowest lets no words be written after the partial flag
+// is sampled, (CY_FX_WATERMARK_MIN x (32/bus width)) - 4 = 0
+#define CY_FX_WATERMARK_MIN             (CY_FX_GPIF_BUS_WIDTH / 8)
+#define CY_FX_WATERMARK_MAX             (64)
+
+// Statistics for one producer socket
+typedef struct {
+	uint16_t watermark;				// Watermark in use
+	uint16_t minFreeBuffers;		// Fewest free buffers seen beyond the one being filled
+	uint32_t commits;				// Buffers committed by the GPIF
+	uint32_t stallEvents;			// Samples in which the socket had waited for a free buffer
+	uint32_t stallTimeMs;			// Estimated time spent waiting for a free buffer in milliseconds
+} domDupSocketStatsSocket_t;
+
+// Response to CY_FX_VREQ_GET_SOCKET_STATS (little-endian)
+//
+// The statistics are sampled by the application thread whilst data is being
+// collected, and cleared when data collection is started.
+typedef struct {
+	uint32_t version;				// Structure version (CY_FX_SOCKET_STATS_VERSION)
+	uint32_t sampledTimeMs;			// Collection time covered by the samples in milliseconds
+	uint32_t maxImbalance;			// Largest difference between the commit counts of the sockets
+	domDupSocketStatsSocket_t socket[CY_FX_DMA_PRODUCER_SOCKETS];
+} domDupSocketStats_t;
+
+// Function prototypes
+void domDupSocketStatsInitialise(void);
+CyU3PReturnStatus_t domDupSocketConfigure(void);
+CyU3PReturnStatus_t domDupSocketSetWatermark(uint16_t value);
+void domDupSocketStatsUpdate(CyU3PDmaMultiChannel *channel, CyBool_t collecting);
+void domDupSocketStatsSnapshot(domDupSocketStats_t *snapshot);
+
+#include <cyu3externcend.h>
+
+#endif // _SOCKET_STATS_H_
@@ -0,0 +1,321 @@
+/************************************************************************
+
+	telemetry.c
+
+	FX3 Firmware throughput and error telemetry
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3pib.h"
+#include "cyu3gpif.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "dma-latency.h"
+
+// The counters are updated from the application thread, the USB driver thread
+// and from interrupt context, so all access is made with the interrupts
+// disabled (the critical sections are only a few instructions long).
+static domDupTelemetry_t glTelemetry;
+
+// Last DMA transfer counts read from the multi-channel
+//
+// The FX3 only provides 32-bit byte counts (which are cleared when the channel
+// is reset), so these are used to accumulate the 64-bit totals.
+static uint32_t glLastProducedCount[CY_FX_DMA_PRODUCER_SOCKETS];
+static uint32_t glLastConsumedCount;
+
+// Incremented every time the DMA channel is created or reset.  Used to discard
+// a sample of the transfer counts which may have been taken before the reset.
+static uint32_t glChannelGeneration;
+
+static uint32_t glLastUpdateTime;
+static CyU3PUsbLinkPowerMode glLastLinkState;
+static CyBool_t glLastLinkStateValid;
+
+static void domDupTelemetrySample(CyU3PDmaMultiChannel *channel, uint32_t *inFlight);
+
+// Initialise the telemetry counters (call once before the USB is started)
+void domDupTelemetryInitialise(void)
+{
+	CyU3PMemSet((uint8_t *)&glTelemetry, 0, sizeof(glTelemetry));
+	glTelemetry.version = CY_FX_TELEMETRY_VERSION;
+
+	domDupTelemetryChannelReset();
+	glLastUpdateTime = CyU3PGetTime();
+	glLastLinkState = CyU3PUsbLPM_U0;
+	glLastLinkStateValid = CyFalse;
+}
+
+// Record that the DMA multi-channel has been created or reset (which clears
+// the FX3 transfer counts)
+void domDupTelemetryChannelReset(void)
+{
+	uint32_t intMask;
+	uint8_t socket;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) glLastProducedCount[socket] = 0;
+	glLastConsumedCount = 0;
+	glChannelGeneration++;
+	CyU3PVicEnableInterrupts(intMask);
+
+#ifdef DOMDUP_DMA_LATENCY_STATS
+	domDupDmaLatencyReset();
+#endif
+}
+
+// Update the DMA and link state counters
+//
+// Called from the main application loop; the counters are only sampled every
+// CY_FX_TELEMETRY_UPDATE_MS to keep the overhead in the loop low.  Must not be
+// called from interrupt context (CyU3PDmaMultiChannelGetStatus takes the channel
+// mutex).
+void domDupTelemetryUpdate(CyU3PDmaMultiChannel *channel)
+{
+	uint32_t now;
+
+	now = CyU3PGetTime();
+	if ((now - glLastUpdateTime) < CY_FX_TELEMETRY_UPDATE_MS) return;
+	glLastUpdateTime = now;
+
+	domDupTelemetrySample(channel, NULL);
+}
+
+// Sample the DMA transfer counts and the link state and update the counters
+//
+// If inFlight is not NULL it is set to the number of bytes produced by the
+// GPIF that have not yet been consumed by the USB end-point.
+static void domDupTelemetrySample(CyU3PDmaMultiChannel *channel, uint32_t *inFlight)
+{
+	uint32_t producedCount[CY_FX_DMA_PRODUCER_SOCKETS];
+	uint32_t consumedCount = 0;
+	uint32_t unused;
+	uint32_t generation;
+	uint32_t delta;
+	uint32_t intMask;
+	uint32_t now;
+	uint8_t socket;
+	CyU3PDmaState_t state;
+	CyU3PUsbLinkPowerMode linkState;
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t errorCountStatus = CY_U3P_ERROR_FAILURE;
+	uint16_t phyErrors = 0;
+	uint16_t linkErrors = 0;
+
+	now = CyU3PGetTime();
+	if (inFlight != NULL) *inFlight = 0;
+
+	// Sample the transfer counts for each producer socket (the consumer count
+	// is the same for every socket index)
+	generation = glChannelGeneration;
+	for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+		apiReturnStatus = CyU3PDmaMultiChannelGetStatus(channel, &state, &producedCount[socket],
+			(socket == 0) ? &consumedCount : &unused, socket);
+		if (apiReturnStatus != CY_U3P_SUCCESS) return;
+	}
+
+	// The counts are cleared when the channel is reset, so the difference is
+	// the data still held in the DMA buffers
+	if (inFlight != NULL) {
+		for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) *inFlight += producedCount[socket];
+		*inFlight -= consumedCount;
+	}
+
+	// Sample the USB 3 link state and take the PHY and link error counts (the
+	// USB block clears them when they are read, and they saturate at 0xFFFF,
+	// which can't be reached in one sample period)
+	apiReturnStatus = CY_U3P_ERROR_FAILURE;
+	if (CyU3PUsbGetSpeed() == CY_U3P_SUPER_SPEED) {
+		apiReturnStatus = CyU3PUsbGetLinkPowerState(&linkState);
+		errorCountStatus = CyU3PUsbGetErrorCounts(&phyErrors, &linkErrors);
+	}
+
+	intMask = CyU3PVicDisableAllInterrupts();
+
+	// Accumulate the transfer counts (unsigned subtraction handles the 32-bit wrap)
+	//
+	// The counts may be sampled by the application and command threads at the
+	// same time, so a sample older than the last one accumulated is ignored.
+	if (generation == glChannelGeneration) {
+		for (socket = 0; socket < CY_FX_DMA_PRODUCER_SOCKETS; socket++) {
+			delta = producedCount[socket] - glLastProducedCount[socket];
+			if ((int32_t)delta < 0) continue;
+			glLastProducedCount[socket] = producedCount[socket];
+			glTelemetry.producedBytes[socket] += delta;
+			glTelemetry.producedBuffers += delta / domDupGetPacketSize();
+		}
+
+		delta = consumedCount - glLastConsumedCount;
+		if ((int32_t)delta >= 0) {
+			glLastConsumedCount = consumedCount;
+			glTelemetry.consumedBytes += delta;
+			glTelemetry.consumedBuffers += delta / domDupGetPacketSize();
+		}
+	}
+
+	if (apiReturnStatus == CY_U3P_SUCCESS) {
+		if ((glLastLinkStateValid) && (linkState != glLastLinkState)) {
+			glTelemetry.linkStateChanges++;
+			if (linkState <= CyU3PUsbLPM_U3) glTelemetry.linkStateEntries[linkState]++;
+		}
+		glLastLinkState = linkState;
+		glLastLinkStateValid = CyTrue;
+	}
+
+	if (errorCountStatus == CY_U3P_SUCCESS) {
+		glTelemetry.usbPhyErrors += phyErrors;
+		glTelemetry.usbLinkErrors += linkErrors;
+	}
+
+	glTelemetry.uptimeMs = now;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Record a recovery from an end-point halt (call before the DMA channel is
+// reset)
+//
+// The data held in the DMA buffers is about to be discarded, so the stream
+// sent to the host has a gap after the bytes consumed so far.  restarted is
+// CyTrue if data collection had to be restarted (the FPGA sample path was
+// reset) rather than resumed.
+void domDupTelemetryStreamRecovery(CyU3PDmaMultiChannel *channel, CyBool_t restarted)
+{
+	uint32_t inFlight;
+	uint32_t intMask;
+
+	domDupTelemetrySample(channel, &inFlight);
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (restarted) glTelemetry.streamRestarts++;
+	else glTelemetry.streamRecoveries++;
+	glTelemetry.lastRecoveryOffset = glTelemetry.consumedBytes;
+	glTelemetry.discardedBytes += inFlight;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Copy the current counters (for sending to the host)
+void domDupTelemetrySnapshot(domDupTelemetry_t *snapshot)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemCopy((uint8_t *)snapshot, (uint8_t *)&glTelemetry, sizeof(glTelemetry));
+	CyU3PVicEnableInterrupts(intMask);
+
+	snapshot->uptimeMs = CyU3PGetTime();
+	domDupCpuLoadGet(&snapshot->cpuLoad);
+}
+
+// Record an FPGA buffer overflow (input0 rising edge)
+void domDupTelemetryOverflowEvent(void)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glTelemetry.overflowEvents++;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Record the result of an LPM request from the host
+void domDupTelemetryLpmRequest(CyBool_t accepted)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	if (accepted) glTelemetry.lpmAccepted++;
+	else glTelemetry.lpmRejected++;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Record that the link had to be brought back to U0 whilst collecting
+void domDupTelemetryLinkExit(void)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glTelemetry.linkExits++;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Record a USB suspend, reset, disconnect or link recovery event
+void domDupTelemetryUsbEvent(CyU3PUsbEventType_t eventType)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	switch (eventType) {
+	case CY_U3P_USB_EVENT_SUSPEND:
+		glTelemetry.usbSuspends++;
+		break;
+
+	case CY_U3P_USB_EVENT_RESET:
+	case CY_U3P_USB_EVENT_DISCONNECT:
+		glTelemetry.usbResets++;
+		break;
+
+	case CY_U3P_USB_EVENT_LNK_RECOVERY:
+		glTelemetry.usbLinkRecoveries++;
+		break;
+
+	default:
+		break;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Record the time the GPIF waited for a free DMA buffer (called from the main
+// application loop with each sample of the producer sockets, see
+// socket-stats.c)
+void domDupTelemetryDmaStall(uint32_t stallMs, uint32_t stallEvents)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glTelemetry.dmaStallTimeMs += stallMs;
+	glTelemetry.dmaStallEvents += stallEvents;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Call back functions ----------------------------------------------------------------------------------
+
+// Handle PIB error interrupts
+//
+// A GPIF stall is counted when the GPIF attempts to write to a DMA thread that
+// is not ready, or when the socket/DMA controller is overrun.  In normal
+// operation the state machine waits on the DMA ready flags, so any of these
+// indicates that data has been lost between the GPIF and the DMA buffers.
+void domDupPibEventCB(CyU3PPibIntrType cbType, uint16_t cbArg)
+{
+	CyU3PPibErrorType pibError;
+	CyU3PGpifErrorType gpifError;
+	uint32_t intMask;
+
+	if (cbType != CYU3P_PIB_INTR_ERROR) return;
+	domDupTrace(CY_FX_TRACE_PIB_ERROR, cbType, cbArg);
+
+	pibError = CYU3P_GET_PIB_ERROR_TYPE(cbArg);
+	gpifError = CYU3P_GET_GPIF_ERROR_TYPE(cbArg);
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	glTelemetry.pibErrors++;
+
+	if ((gpifError == CYU3P_GPIF_ERR_DATA_WRITE_ERR) ||
+		(pibError == CYU3P_PIB_ERR_THR0_WR_OVERRUN) || (pibError == CYU3P_PIB_ERR_THR1_WR_OVERRUN) ||
+		(pibError == CYU3P_PIB_ERR_THR0_ADAP_OVERRUN) || (pibError == CYU3P_PIB_ERR_THR1_ADAP_OVERRUN)) {
+		glTelemetry.gpifStalls++;
+	}
+	CyU3PVicEnableInterrupts(intMask);
+}
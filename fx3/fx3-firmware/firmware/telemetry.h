@@ -0,0 +1,83 @@
+/************************************************************************
+
+	telemetry.h
+
+	FX3 Firmware throughput and error telemetry
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+#include "cyu3dma.h"
+#include "cyu3pib.h"
+#include "cyu3usb.h"
+#include "cpu-load.h"
+
+// Version of the domDupTelemetry_t structure returned to the host
+#define CY_FX_TELEMETRY_VERSION         (5)
+
+// Interval between samples of the DMA transfer counts in milliseconds
+// Note: The FX3 transfer counts are 32-bit byte counts which wrap after
+// ~50 seconds at 80 MB/s, so this must be much shorter than that.
+#define CY_FX_TELEMETRY_UPDATE_MS       (10)
+
+// Telemetry counters (returned to the host little-endian)
+//
+// All counters are cumulative from power-on.  The host is expected to
+// poll the counters periodically and compare them with the previous
+// values.
+typedef struct {
+	uint32_t version;				// Structure version (CY_FX_TELEMETRY_VERSION)
+	uint32_t uptimeMs;				// Time since the RTOS started in milliseconds
+	uint64_t producedBytes[2];		// Bytes committed by each GPIF thread (producer socket)
+	uint64_t consumedBytes;			// Bytes consumed by the USB end-point
+	uint32_t producedBuffers;		// DMA buffers committed by the GPIF (both threads)
+	uint32_t consumedBuffers;		// DMA buffers sent to the host
+	uint32_t overflowEvents;		// FPGA buffer overflow events (rising edges of input0)
+	uint32_t gpifStalls;			// GPIF writes to a DMA thread that was not ready
+	uint32_t pibErrors;				// All PIB/GPIF error interrupts (including stalls)
+	uint32_t linkStateChanges;		// USB 3 link power state changes seen by the firmware
+	uint32_t lpmAccepted;			// LPM (U1/U2/U3) requests accepted
+	uint32_t lpmRejected;			// LPM (U1/U2/U3) requests rejected (all of them whilst collecting)
+	uint32_t usbSuspends;			// USB suspend events
+	uint32_t usbResets;				// USB reset and disconnect events
+	uint32_t streamRecoveries;		// End-point halts recovered without restarting data collection
+	uint32_t streamRestarts;		// End-point halts that needed data collection to be restarted
+	uint64_t lastRecoveryOffset;	// consumedBytes at the last recovery (the position of the gap)
+	uint64_t discardedBytes;		// Bytes discarded from the DMA buffers by recoveries
+	domDupCpuLoad_t cpuLoad;		// CPU load (not cumulative; see cpu-load.h)
+	uint32_t linkStateEntries[4];	// Entries into U0, U1, U2 and U3 seen by the firmware
+	uint32_t linkExits;				// Times the firmware brought the link back to U0 whilst collecting
+	uint32_t dmaStallTimeMs;		// Estimated time a GPIF thread waited for a free DMA buffer in milliseconds
+	uint32_t dmaStallEvents;		// Samples in which a GPIF thread had waited for a free DMA buffer
+	uint32_t usbPhyErrors;			// USB 3 PHY errors (decode, CRC, elastic buffer, training, lock loss)
+	uint32_t usbLinkErrors;			// USB 3 link errors (ACK and credit time-outs, sequence errors; each causes a retry)
+	uint32_t usbLinkRecoveries;		// USB 3 link recovery (retraining) events
+} domDupTelemetry_t;
+
+// Function prototypes
+void domDupTelemetryInitialise(void);
+void domDupTelemetryChannelReset(void);
+void domDupTelemetryUpdate(CyU3PDmaMultiChannel *channel);
+void domDupTelemetrySnapshot(domDupTelemetry_t *snapshot);
+void domDupTelemetryStreamRecovery(CyU3PDmaMultiChannel *channel, CyBool_t restarted);
+
+// Event recording (may be called from interrupt context)
+void domDupTelemetryOverflowEvent(void);
+void domDupTelemetryLpmRequest(CyBool_t accepted);
+void domDupTelemetryLinkExit(void);
+void domDupTelemetryUsbEvent(CyU3PUsbEventType_t eventType);
+void domDupTelemetryDmaStall(uint32_t stallMs, uint32_t stallEvents);
+
+// Callback function prototypes
+void domDupPibEventCB(CyU3PPibIntrType cbType, uint16_t cbArg);
+
+#include <cyu3externcend.h>
+
+#endif // _TELEMETRY_H_
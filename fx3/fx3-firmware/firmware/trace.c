@@ -0,0 +1,127 @@
+/************************************************************************
+
+	trace.c
+
+	FX3 Firmware binary trace log
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+// External includes
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3vic.h"
+
+// Local includes
+#include "domesday-duplicator.h"
+#include "trace.h"
+
+// The trace is a ring of fixed size binary records held in SRAM.  Adding a
+// record only takes a few instructions (no formatting or UART output), so the
+// trace can be left on during capture and called from the callbacks and from
+// interrupt context.  The host reads the whole ring with CY_FX_VREQ_GET_TRACE.
+//
+// The records are written with the interrupts disabled; glTraceWritten counts
+// the records written since power-on and selects the next slot in the ring.
+static domDupTraceRecord_t glTraceRing[CY_FX_TRACE_RECORDS];
+static uint32_t glTraceWritten;
+
+// Number of records copied with the interrupts disabled when the ring is read
+#define CY_FX_TRACE_COPY_CHUNK          (16)
+
+// Buffer for the data phase of CY_FX_VREQ_GET_TRACE (header and the records)
+static uint8_t glTraceEp0Buffer[sizeof(domDupTraceHeader_t) + sizeof(glTraceRing)] __attribute__ ((aligned (32)));
+
+// Clear the trace (call once before the callbacks are registered)
+void domDupTraceInitialise(void)
+{
+	uint32_t intMask;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	CyU3PMemSet((uint8_t *)glTraceRing, 0, sizeof(glTraceRing));
+	glTraceWritten = 0;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Add a record to the trace (overwriting the oldest record once the ring is
+// full)
+void domDupTrace(uint16_t eventId, uint32_t arg0, uint32_t arg1)
+{
+	domDupTraceRecord_t *record;
+	uint32_t timestamp;
+	uint32_t intMask;
+
+	timestamp = CyU3PGetTime();
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	record = &glTraceRing[glTraceWritten & (CY_FX_TRACE_RECORDS - 1)];
+	record->eventId = eventId;
+	record->sequence = (uint16_t)glTraceWritten;
+	record->timestamp = timestamp;
+	record->arg0 = arg0;
+	record->arg1 = arg1;
+	glTraceWritten++;
+	CyU3PVicEnableInterrupts(intMask);
+}
+
+// Send the trace to the host (the data phase of CY_FX_VREQ_GET_TRACE)
+//
+// The records are copied oldest first in small chunks, so the interrupts are
+// not disabled for the whole copy.  A record which is overwritten whilst the
+// ring is being copied appears out of sequence in the response; the host can
+// use the sequence numbers to discard it.  The response is truncated to the
+// length requested by the host.  Returns CyFalse (causing the request to be
+// stalled) if the response cannot be sent.
+CyBool_t domDupTraceSend(uint16_t wLength)
+{
+	domDupTraceHeader_t *header = (domDupTraceHeader_t *)glTraceEp0Buffer;
+	domDupTraceRecord_t *records = (domDupTraceRecord_t *)(glTraceEp0Buffer + sizeof(domDupTraceHeader_t));
+	CyU3PReturnStatus_t apiReturnStatus = CY_U3P_SUCCESS;
+	uint32_t written;
+	uint32_t first;
+	uint32_t count;
+	uint32_t copied;
+	uint32_t chunk;
+	uint32_t index;
+	uint32_t intMask;
+	uint16_t length;
+
+	intMask = CyU3PVicDisableAllInterrupts();
+	written = glTraceWritten;
+	CyU3PVicEnableInterrupts(intMask);
+
+	count = (written < CY_FX_TRACE_RECORDS) ? written : CY_FX_TRACE_RECORDS;
+	first = written - count;
+
+	for (copied = 0; copied < count; copied += chunk) {
+		chunk = count - copied;
+		if (chunk > CY_FX_TRACE_COPY_CHUNK) chunk = CY_FX_TRACE_COPY_CHUNK;
+
+		intMask = CyU3PVicDisableAllInterrupts();
+		for (index = 0; index < chunk; index++) {
+			records[copied + index] = glTraceRing[(first + copied + index) & (CY_FX_TRACE_RECORDS - 1)];
+		}
+		CyU3PVicEnableInterrupts(intMask);
+	}
+
+	header->version = CY_FX_TRACE_VERSION;
+	header->recordSize = sizeof(domDupTraceRecord_t);
+	header->recordCount = count;
+	header->written = written;
+	header->reserved = 0;
+
+	length = sizeof(domDupTraceHeader_t) + (count * sizeof(domDupTraceRecord_t));
+	if (length > wLength) length = wLength;
+
+	apiReturnStatus = CyU3PUsbSendEP0Data(length, glTraceEp0Buffer);
+	if (apiReturnStatus != CY_U3P_SUCCESS) {
+		domDupDebugPrint(CY_FX_DEBUG_STATUS, "domDupTraceSend(): CyU3PUsbSendEP0Data failed, Error code = %d\r\n", apiReturnStatus);
+		return CyFalse;
+	}
+
+	return CyTrue;
+}
@@ -0,0 +1,72 @@
+/************************************************************************
+
+	trace.h
+
+	FX3 Firmware binary trace log
+	DomesdayDuplicator - LaserDisc RF sampler
+	SPDX-FileCopyrightText: 2018-2025 Simon Inns
+	SPDX-License-Identifier: GPL-3.0-or-later
+
+************************************************************************/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include "cyu3externcstart.h"
+#include "cyu3types.h"
+
+// Version of the trace response returned to the host
+#define CY_FX_TRACE_VERSION             (1)
+
+// Number of records held by the trace ring (must be a power of 2)
+#define CY_FX_TRACE_RECORDS             (256)
+
+// Trace event IDs (arguments in brackets)
+#define CY_FX_TRACE_BOOT                (0x0001) // Firmware started
+#define CY_FX_TRACE_APP_START           (0x0002) // Application started (USB speed)
+#define CY_FX_TRACE_APP_STOP            (0x0003) // Application stopped
+#define CY_FX_TRACE_DATA_PATH_RESET     (0x0004) // GPIF to USB path flushed
+#define CY_FX_TRACE_STREAM_PROFILE      (0x0005) // Stream profile selected (profile, DMA buffers per socket)
+#define CY_FX_TRACE_SELF_TEST           (0x0006) // Self-test profile measured (profile, throughput in KB/s)
+#define CY_FX_TRACE_BENCHMARK           (0x0007) // Benchmark point measured (source << 16 | burst << 8 | buffers, throughput in KB/s)
+#define CY_FX_TRACE_CAPTURE_COMPLETE    (0x0008) // Capture length reached (capture number, packets sent)
+#define CY_FX_TRACE_PROFILE_FALLBACK    (0x0009) // Stream profile failed, default used (profile requested, error code)
+#define CY_FX_TRACE_COMMAND             (0x0010) // Vendor command carried out (bRequest | wValue << 16, result)
+#define CY_FX_TRACE_COMMAND_REJECTED    (0x0011) // Vendor command stalled, queue full (bRequest, wValue)
+#define CY_FX_TRACE_USB_EVENT           (0x0020) // USB event callback (event type, event data)
+#define CY_FX_TRACE_LPM_REQUEST         (0x0021) // LPM request (link mode, 1 = accepted)
+#define CY_FX_TRACE_EP_HALT_CLEAR       (0x0022) // CLEAR_FEATURE(ENDPOINT_HALT) (end-point)
+#define CY_FX_TRACE_EP_RECOVERY         (0x0023) // End-point halt recovered (1 = collection restarted, wait in ms)
+#define CY_FX_TRACE_GPIO_INPUT          (0x0030) // FPGA input changed (GPIO pin, value)
+#define CY_FX_TRACE_PIB_ERROR           (0x0031) // PIB error interrupt (interrupt type, argument)
+#define CY_FX_TRACE_GPIF_INTERRUPT      (0x0032) // GPIF CPU interrupt (event, state)
+
+// A trace record (returned to the host little-endian)
+typedef struct {
+	uint16_t eventId;				// Event ID (CY_FX_TRACE_*)
+	uint16_t sequence;				// Record number (bits 15-0, counted from power-on)
+	uint32_t timestamp;				// Time since the RTOS started in milliseconds
+	uint32_t arg0;					// Event specific arguments
+	uint32_t arg1;
+} domDupTraceRecord_t;
+
+// Header of the CY_FX_VREQ_GET_TRACE response (followed by the records,
+// oldest first)
+typedef struct {
+	uint16_t version;				// Response version (CY_FX_TRACE_VERSION)
+	uint16_t recordSize;			// Size of each record in bytes
+	uint32_t recordCount;			// Number of records that follow
+	uint32_t written;				// Records written since power-on
+	uint32_t reserved;
+} domDupTraceHeader_t;
+
+// Function prototypes
+void domDupTraceInitialise(void);
+CyBool_t domDupTraceSend(uint16_t wLength);
+
+// Add a record (may be called from interrupt context)
+void domDupTrace(uint16_t eventId, uint32_t arg0, uint32_t arg1);
+
+#include <cyu3externcend.h>
+
+#endif // _TRACE_H_
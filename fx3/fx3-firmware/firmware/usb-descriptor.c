@@ -10,7 +10,6 @@
 ************************************************************************/
 
 #include "domesday-duplicator.h"
-#include "generated_descriptor_data.h"
 
 // VID and PID definition (Domesday Duplicator 0x1D50 / 0x603B)
 #define VID_H	0x1D
@@ -24,6 +23,26 @@
 //#define PID_H	0x00
 //#define PID_L	0xF1
 
+// Configuration descriptor lengths and end-point count (the sideband
+// end-point follows the consumer end-point when built with DOMDUP_SIDEBAND_EP,
+// then the notification end-point when built with DOMDUP_NOTIFY_EP).  Each
+// extra end-point adds an end-point descriptor (7 bytes), and at super speed
+// its companion descriptor (6 bytes).
+#ifdef DOMDUP_SIDEBAND_EP
+#define CY_FX_SIDEBAND_ENDPOINTS 1
+#else
+#define CY_FX_SIDEBAND_ENDPOINTS 0
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+#define CY_FX_NOTIFY_ENDPOINTS  1
+#else
+#define CY_FX_NOTIFY_ENDPOINTS  0
+#endif
+#define CY_FX_EXTRA_ENDPOINTS   (CY_FX_SIDEBAND_ENDPOINTS + CY_FX_NOTIFY_ENDPOINTS)
+#define CY_FX_NUM_ENDPOINTS     (0x01 + CY_FX_EXTRA_ENDPOINTS)
+#define CY_FX_SS_CONFIG_LENGTH  (0x1F + (0x0D * CY_FX_EXTRA_ENDPOINTS))
+#define CY_FX_HS_CONFIG_LENGTH  (0x19 + (0x07 * CY_FX_EXTRA_ENDPOINTS))
+
 // Standard device descriptor for USB 3.0
 const uint8_t USB30DeviceDscr[] __attribute__ ((aligned (32))) = {
     0x12,                           // Descriptor size
@@ -61,11 +80,15 @@ const uint8_t USB20DeviceDscr[] __attribute__ ((aligned (32))) = {
 };
 
 // Binary device object store descriptor
+//
+// The Microsoft OS 2.0 platform capability tells Windows (8.1 and later) to
+// fetch the descriptor set below with the vendor request CY_FX_VREQ_MS_OS_20,
+// so the WinUSB driver is bound without an INF file.
 const uint8_t USBBOSDscr[] __attribute__ ((aligned (32))) = {
     0x05,                           // Descriptor size
     CY_U3P_BOS_DESCR,               // Device descriptor type
-    0x16,0x00,                      // Length of this descriptor and all sub descriptors
-    0x02,                           // Number of device capability descriptors
+    0x32,0x00,                      // Length of this descriptor and all sub descriptors
+    0x03,                           // Number of device capability descriptors
 
     // USB 2.0 extension
     0x07,                           // Descriptor size
@@ -81,7 +104,59 @@ const uint8_t USBBOSDscr[] __attribute__ ((aligned (32))) = {
     0x0E,0x00,                      // Speeds supported by the device : SS, HS and FS
     0x03,                           // Functionality support
     0x0A,                           // U1 Device Exit latency: 10us (proper LPM support)
-    0xFF,0x07                       // U2 Device Exit latency: 2047us (proper LPM support)
+    0xFF,0x07,                      // U2 Device Exit latency: 2047us (proper LPM support)
+
+    // Microsoft OS 2.0 platform capability
+    0x1C,                           // Descriptor size
+    CY_U3P_DEVICE_CAPB_DESCR,       // Device capability type descriptor
+    0x05,                           // Platform capability type
+    0x00,                           // Reserved
+    0xDF,0x60,0xDD,0xD8,            // MS OS 2.0 platform capability UUID
+    0x89,0x45,0xC7,0x4C,            // {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F}
+    0x9C,0xD2,0x65,0x9D,
+    0x9E,0x64,0x8A,0x9F,
+    0x00,0x00,0x03,0x06,            // Minimum Windows version: 8.1
+    CY_FX_MS_OS_20_SET_LENGTH,0x00, // Length of the MS OS 2.0 descriptor set
+    CY_FX_VREQ_MS_OS_20,            // Vendor request code for the descriptor set
+    0x00                            // No alternate enumeration
+};
+
+// Microsoft OS 2.0 descriptor set (returned for CY_FX_VREQ_MS_OS_20)
+//
+// The device has a single interface, so there are no configuration or
+// function subsets.  The interface GUID lets applications find the device
+// through the WinUSB API.
+const uint8_t USBMsOs20DscrSet[] __attribute__ ((aligned (32))) = {
+    // Descriptor set header
+    0x0A,0x00,                      // Descriptor size
+    0x00,0x00,                      // MS_OS_20_SET_HEADER_DESCRIPTOR
+    0x00,0x00,0x03,0x06,            // Minimum Windows version: 8.1
+    CY_FX_MS_OS_20_SET_LENGTH,0x00, // Length of the descriptor set
+
+    // Compatible ID
+    0x14,0x00,                      // Descriptor size
+    0x03,0x00,                      // MS_OS_20_FEATURE_COMPATBLE_ID
+    'W','I','N','U','S','B',0x00,0x00, // Compatible ID
+    0x00,0x00,0x00,0x00,            // Sub-compatible ID
+    0x00,0x00,0x00,0x00,
+
+    // Registry property: DeviceInterfaceGUIDs
+    0x84,0x00,                      // Descriptor size
+    0x04,0x00,                      // MS_OS_20_FEATURE_REG_PROPERTY
+    0x07,0x00,                      // Property data type: REG_MULTI_SZ
+    0x2A,0x00,                      // Property name length
+    'D',0x00,'e',0x00,'v',0x00,'i',0x00,'c',0x00,'e',0x00,
+    'I',0x00,'n',0x00,'t',0x00,'e',0x00,'r',0x00,'f',0x00,
+    'a',0x00,'c',0x00,'e',0x00,'G',0x00,'U',0x00,'I',0x00,
+    'D',0x00,'s',0x00,0x00,0x00,
+    0x50,0x00,                      // Property data length
+    '{',0x00,'C',0x00,'D',0x00,'C',0x00,'C',0x00,'4',0x00,
+    '5',0x00,'8',0x00,'5',0x00,'-',0x00,'1',0x00,'D',0x00,
+    'A',0x00,'B',0x00,'-',0x00,'4',0x00,'9',0x00,'8',0x00,
+    'C',0x00,'-',0x00,'9',0x00,'3',0x00,'5',0x00,'8',0x00,
+    '-',0x00,'F',0x00,'5',0x00,'7',0x00,'4',0x00,'9',0x00,
+    '1',0x00,'B',0x00,'0',0x00,'1',0x00,'F',0x00,'2',0x00,
+    '3',0x00,'}',0x00,0x00,0x00,0x00,0x00
 };
 
 // Standard device qualifier descriptor
@@ -102,7 +177,7 @@ const uint8_t USBSSConfigDscr[] __attribute__ ((aligned (32))) = {
     // Configuration descriptor
     0x09,                           // Descriptor size
     CY_U3P_USB_CONFIG_DESCR,        // Configuration descriptor type
-    0x1F,0x00,                      // Length of this descriptor and all sub descriptors
+    CY_FX_SS_CONFIG_LENGTH,0x00,    // Length of this descriptor and all sub descriptors
     0x01,                           // Number of interfaces
     0x01,                           // Configuration number
     0x00,                           // COnfiguration string index
@@ -114,7 +189,7 @@ const uint8_t USBSSConfigDscr[] __attribute__ ((aligned (32))) = {
     CY_U3P_USB_INTRFC_DESCR,        // Interface Descriptor type
     0x00,                           // Interface number
     0x00,                           // Alternate setting number
-    0x01,                           // Number of end points
+    CY_FX_NUM_ENDPOINTS,            // Number of end points
     0xFF,                           // Interface class
     0x00,                           // Interface sub class
     0x00,                           // Interface protocol code
@@ -134,6 +209,40 @@ const uint8_t USBSSConfigDscr[] __attribute__ ((aligned (32))) = {
     (CY_FX_EP_BURST_LENGTH - 1),    // Max no. of packets in a burst(0-15) - 0: burst 1 packet at a time
     0x00,                           // Max streams for bulk EP = 0 (No streams)
     0x00,0x00                       // Service interval for the EP : 0 for bulk
+#ifdef DOMDUP_SIDEBAND_EP
+    ,
+    // End-point descriptor for sideband EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_SIDEBAND,              // End-point address and description
+    CY_U3P_USB_EP_BULK,             // Bulk end-point type
+    0x00,0x04,                      // Max packet size = 1024 bytes
+    0x00,                           // Servicing interval for data transfers : 0 for Bulk
+
+    // Super speed end-point companion descriptor for sideband EP
+    0x06,                           // Descriptor size
+    CY_U3P_SS_EP_COMPN_DESCR,       // SS end-point companion descriptor type
+    0x00,                           // Max no. of packets in a burst(0-15) - 0: burst 1 packet at a time
+    0x00,                           // Max streams for bulk EP = 0 (No streams)
+    0x00,0x00                       // Service interval for the EP : 0 for bulk
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+    ,
+    // End-point descriptor for notification EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_NOTIFY,                // End-point address and description
+    CY_U3P_USB_EP_INTR,             // Interrupt end-point type
+    CY_FX_NOTIFY_PACKET_SIZE,0x00,  // Max packet size = 16 bytes
+    0x04,                           // Servicing interval : 2^(4-1) x 125 us = 1 ms
+
+    // Super speed end-point companion descriptor for notification EP
+    0x06,                           // Descriptor size
+    CY_U3P_SS_EP_COMPN_DESCR,       // SS end-point companion descriptor type
+    0x00,                           // Max no. of packets in a burst(0-15) - 0: burst 1 packet at a time
+    0x00,                           // Attributes : 0 for interrupt
+    CY_FX_NOTIFY_PACKET_SIZE,0x00   // Bytes per service interval : 16
+#endif
 };
 
 // Standard high speed configuration descriptor
@@ -141,7 +250,7 @@ const uint8_t USBHSConfigDscr[] __attribute__ ((aligned (32))) = {
     // Configuration descriptor
     0x09,                           // Descriptor size
     CY_U3P_USB_CONFIG_DESCR,        // Configuration descriptor type
-    0x19,0x00,                      // Length of this descriptor and all sub descriptors
+    CY_FX_HS_CONFIG_LENGTH,0x00,    // Length of this descriptor and all sub descriptors
     0x01,                           // Number of interfaces
     0x01,                           // Configuration number
     0x00,                           // COnfiguration string index
@@ -153,7 +262,7 @@ const uint8_t USBHSConfigDscr[] __attribute__ ((aligned (32))) = {
     CY_U3P_USB_INTRFC_DESCR,        // Interface Descriptor type
     0x00,                           // Interface number
     0x00,                           // Alternate setting number
-    0x01,                           // Number of end-points
+    CY_FX_NUM_ENDPOINTS,            // Number of end-points
     0xFF,                           // Interface class
     0x00,                           // Interface sub class
     0x00,                           // Interface protocol code
@@ -166,6 +275,26 @@ const uint8_t USBHSConfigDscr[] __attribute__ ((aligned (32))) = {
     CY_U3P_USB_EP_BULK,             // Bulk end-point type
     0x00,0x02,                      // Max packet size = 512 bytes
     0x00                            // Servicing interval for data transfers : 0 for bulk
+#ifdef DOMDUP_SIDEBAND_EP
+    ,
+    // End-point descriptor for sideband EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_SIDEBAND,              // End-point address and description
+    CY_U3P_USB_EP_BULK,             // Bulk end-point type
+    0x00,0x02,                      // Max packet size = 512 bytes
+    0x00                            // Servicing interval for data transfers : 0 for bulk
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+    ,
+    // End-point descriptor for notification EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_NOTIFY,                // End-point address and description
+    CY_U3P_USB_EP_INTR,             // Interrupt end-point type
+    CY_FX_NOTIFY_PACKET_SIZE,0x00,  // Max packet size = 16 bytes
+    0x04                            // Servicing interval : 2^(4-1) x 125 us = 1 ms
+#endif
 };
 
 // Standard full speed configuration descriptor
@@ -173,7 +302,7 @@ const uint8_t USBFSConfigDscr[] __attribute__ ((aligned (32))) = {
     // Configuration descriptor
     0x09,                           // Descriptor size
     CY_U3P_USB_CONFIG_DESCR,        // Configuration descriptor type
-    0x19,0x00,                      // Length of this descriptor and all sub descriptors
+    CY_FX_HS_CONFIG_LENGTH,0x00,    // Length of this descriptor and all sub descriptors
     0x01,                           // Number of interfaces
     0x01,                           // Configuration number
     0x00,                           // COnfiguration string index
@@ -185,7 +314,7 @@ const uint8_t USBFSConfigDscr[] __attribute__ ((aligned (32))) = {
     CY_U3P_USB_INTRFC_DESCR,        // Interface descriptor type
     0x00,                           // Interface number
     0x00,                           // Alternate setting number
-    0x01,                           // Number of end-points
+    CY_FX_NUM_ENDPOINTS,            // Number of end-points
     0xFF,                           // Interface class
     0x00,                           // Interface sub class
     0x00,                           // Interface protocol code
@@ -198,6 +327,26 @@ const uint8_t USBFSConfigDscr[] __attribute__ ((aligned (32))) = {
     CY_U3P_USB_EP_BULK,             // Bulk end-point type
     0x40,0x00,                      // Max packet size = 64 bytes
     0x00                            // Servicing interval for data transfers : 0 for bulk
+#ifdef DOMDUP_SIDEBAND_EP
+    ,
+    // End-point descriptor for sideband EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_SIDEBAND,              // End-point address and description
+    CY_U3P_USB_EP_BULK,             // Bulk end-point type
+    0x40,0x00,                      // Max packet size = 64 bytes
+    0x00                            // Servicing interval for data transfers : 0 for bulk
+#endif
+#ifdef DOMDUP_NOTIFY_EP
+    ,
+    // End-point descriptor for notification EP
+    0x07,                           // Descriptor size
+    CY_U3P_USB_ENDPNT_DESCR,        // End-point descriptor type
+    CY_FX_EP_NOTIFY,                // End-point address and description
+    CY_U3P_USB_EP_INTR,             // Interrupt end-point type
+    CY_FX_NOTIFY_PACKET_SIZE,0x00,  // Max packet size = 16 bytes
+    0x01                            // Servicing interval : 1 ms
+#endif
 };
 
 // Standard language ID string descriptor
@@ -223,20 +372,27 @@ const uint8_t USBManufactureDscr[] __attribute__ ((aligned (32))) = {
     '6',0x00
 };
 
-// Product string descriptor with embedded git commit hash
-// Generated at build time via generate-descriptor.sh
-// Format: "Domesday Duplicator (xxxxxxxx)" where xxxxxxxx is 8-char git commit
+// Product string descriptor: "Domesday Duplicator (xxxxxxxx)", where
+// xxxxxxxx is the git commit the firmware was built from (FIRMWARE_GIT_COMMIT,
+// set by CMakeLists.txt)
+//
+// The string is a UTF-16 literal, so the compiler encodes it (the FX3 is
+// little-endian, as USB requires) and the descriptor is a constant table like
+// the others.  The terminating null is not part of the descriptor.
+#define CY_FX_PRODUCT_STRING    u"Domesday Duplicator (" FIRMWARE_GIT_COMMIT ")"
+#define CY_FX_PRODUCT_LENGTH    ((sizeof(CY_FX_PRODUCT_STRING) / sizeof(uint16_t)) - 1)
 
-// Firmware version string constant
-#define STRINGIFY(x) #x
-#define TOSTRING(x) STRINGIFY(x)
-const char firmware_version_string[] = "Domesday Duplicator (" TOSTRING(FIRMWARE_GIT_COMMIT) ")";
-
-// USB product string descriptor (dynamically generated at build time)
-// USB_DESC_PRODUCT_BYTES includes: size byte, type byte (0x03), and UTF-16LE string data
-const uint8_t USBProductDscr[] __attribute__ ((aligned (32))) = {
-    USB_DESC_PRODUCT_BYTES          // Full descriptor: size, type, and data
+static const struct {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint16_t bString[CY_FX_PRODUCT_LENGTH];
+} __attribute__ ((packed)) glProductDscr __attribute__ ((aligned (32))) = {
+    2 + (CY_FX_PRODUCT_LENGTH * sizeof(uint16_t)), // Descriptor size
+    CY_U3P_USB_STRING_DESCR,        // Device descriptor type
+    CY_FX_PRODUCT_STRING            // UTF-16LE string
 };
 
+const uint8_t * const USBProductDscr = (const uint8_t *)&glProductDscr;
+
 // No more code after this line!
 const uint8_t CyFxUsbDscrAlignBuffer[32] __attribute__ ((aligned (32)));
@@ -6,6 +6,7 @@
  * - Discover connected FX3 devices
  * - Upload firmware to FX3 RAM/EEPROM/Flash
  * - Verify firmware upload
+ * - Program every connected device at once
  * 
  * This implementation is based on the Cypress cyusb_linux project:
  * https://github.com/Cypress-Semiconductor/cyusb_linux
@@ -20,6 +21,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <pthread.h>
 #include <libusb-1.0/libusb.h>
 
 #define FX3_VENDOR_ID       0x04b4
@@ -37,6 +41,8 @@
 #define FX3_I2C_WRITE_CMD    0xBA  // Flash programmer I2C write
 #define FX3_I2C_READ_CMD     0xBB  // Flash programmer I2C read/verify
 #define MAX_WRITE_SIZE       2048
+#define DL_QUEUE_DEPTH       8     // RAM download transfers in flight (default)
+#define DL_QUEUE_DEPTH_MAX   32
 #define SPI_FLASH_PAGE_SIZE  256   // SPI flash page size for FX3
 #define SPI_FLASH_SECTOR_SIZE (64 * 1024)
 #define I2C_PAGE_SIZE        64
@@ -44,6 +50,8 @@
 #define FLASH_PROG_MAGIC     "FX3PROG"
 #define GET_LSW(x)           ((x) & 0xFFFF)
 #define GET_MSW(x)           ((x) >> 16)
+#define MAX_DEVICES          16
+#define MAX_PORT_DEPTH       7     // USB 3 allows at most 7 tiers of hubs
 
 typedef struct {
     libusb_device_handle *handle;
@@ -52,16 +60,76 @@ typedef struct {
     uint8_t bus;
     uint8_t addr;
     uint8_t dev_class;
+    uint8_t ports[MAX_PORT_DEPTH];  // Port path (stays the same when the device re-enumerates)
+    int port_count;
     int is_bootloader;
     int index;
+    const char *volatile stage;     // Current operation (-a mode status display)
+    volatile int percent;           // Progress through the current operation (-a mode)
 } fx3_device_t;
 
-static fx3_device_t fx3_devices[16];
+/* Operations carried out on each device by a worker thread (-a mode) */
+typedef struct {
+    pthread_t thread;
+    int device_idx;
+    const char *firmware_file;
+    const char *prom_file;
+    int verify;
+    int incremental;
+    int started;
+    volatile int finished;
+    int result;
+} fx3_job_t;
+
+static fx3_device_t fx3_devices[MAX_DEVICES];
 static int num_devices = 0;
+static int download_queue_depth = DL_QUEUE_DEPTH;
+static int parallel_mode = 0;
+
+/* A RAM download control transfer (see fx3_download_section) */
+typedef struct {
+    struct libusb_transfer *transfer;
+    unsigned char buffer[LIBUSB_CONTROL_SETUP_SIZE + MAX_WRITE_SIZE];
+    volatile int busy;
+    int device_idx;
+    int length;
+    int offset;
+    int image_size;
+    int *failed;
+    int *completed;
+} dl_slot_t;
+
+/* Contiguous run of firmware image sections (see fx3_parse_image) */
+typedef struct {
+    uint32_t address;
+    int bytes;
+    int sections;
+    const uint8_t *record;          // Length word of the first section in the mapped image
+} dl_run_t;
 
 /* Forward declarations */
 int fx3_download_firmware(int device_idx, const char *filename);
 int fx3_discover_devices(void);
+int is_fx3_bootloader(libusb_device_handle *handle);
+
+/*
+ * Report progress through a long operation.  A dot is printed for each step
+ * when working on a single device; in -a mode several devices are worked on
+ * at once, so the percentage is kept for the status display instead.
+ */
+static void fx3_progress(int device_idx, int done, int total) {
+    if (parallel_mode) {
+        fx3_devices[device_idx].percent = (total > 0) ? (int)(((long)done * 100) / total) : 100;
+    } else {
+        printf(".");
+        fflush(stdout);
+    }
+}
+
+static void fx3_set_stage(int device_idx, const char *stage) {
+    fx3_devices[device_idx].percent = 0;
+    fx3_devices[device_idx].stage = stage;
+}
 
 /* I2C write via flash programmer */
 static int fx3_i2c_write(libusb_device_handle *h, unsigned char *buf, int devAddr, int start, int len) {
@@ -116,6 +184,20 @@ static int fx3_i2c_read_verify(libusb_device_handle *h, unsigned char *expData,
 
     return 0;
 }
+/* Read a block of up to MAX_WRITE_SIZE bytes from an I2C EEPROM address via flash programmer */
+static int fx3_i2c_read_block(libusb_device_handle *h, unsigned char *buf, int devAddr, int address, int len) {
+    int r = libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_IN,
+                                    FX3_I2C_READ_CMD, devAddr, address, buf, len, USB_TIMEOUT_MS);
+    return (r == len) ? 0 : -1;
+}
+
+/* Write a block of up to MAX_WRITE_SIZE bytes to an I2C EEPROM address via flash programmer */
+static int fx3_i2c_write_block(libusb_device_handle *h, unsigned char *buf, int devAddr, int address, int len) {
+    int r = libusb_control_transfer(h, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
+                                    FX3_I2C_WRITE_CMD, devAddr, address, buf, len, USB_TIMEOUT_MS);
+    return (r == len) ? 0 : -1;
+}
+
 /* Check if a handle is the Cypress flash programmer (secondary loader). */
 static int is_flash_programmer(libusb_device_handle *handle) {
     unsigned char buf[8];
@@ -160,6 +242,58 @@ static char *find_flashprog_image(void) {
     return NULL;
 }
 
+/* Read the port path of a device (empty if it cannot be read) */
+static int fx3_get_ports(libusb_device *dev, uint8_t *ports) {
+    int count = libusb_get_port_numbers(dev, ports, MAX_PORT_DEPTH);
+    return (count < 0) ? 0 : count;
+}
+
+/* Reopen a device after it has re-enumerated (found by its bus and port path) */
+static int fx3_reopen_device(int device_idx) {
+    fx3_device_t *fx3 = &fx3_devices[device_idx];
+    libusb_device **devices;
+    libusb_device_handle *handle = NULL;
+    struct libusb_device_descriptor desc;
+    uint8_t ports[MAX_PORT_DEPTH];
+    ssize_t num, i;
+    int found = 0;
+
+    if (fx3->handle) {
+        libusb_close(fx3->handle);
+        fx3->handle = NULL;
+    }
+
+    num = libusb_get_device_list(NULL, &devices);
+    if (num < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < num && !found; i++) {
+        if (libusb_get_bus_number(devices[i]) != fx3->bus) {
+            continue;
+        }
+        if (fx3_get_ports(devices[i], ports) != fx3->port_count ||
+            memcmp(ports, fx3->ports, fx3->port_count) != 0) {
+            continue;
+        }
+        libusb_get_device_descriptor(devices[i], &desc);
+        if (desc.idVendor != FX3_VENDOR_ID || libusb_open(devices[i], &handle) != 0) {
+            continue;
+        }
+
+        fx3->handle = handle;
+        fx3->vid = desc.idVendor;
+        fx3->pid = desc.idProduct;
+        fx3->addr = libusb_get_device_address(devices[i]);
+        fx3->dev_class = desc.bDeviceClass;
+        fx3->is_bootloader = is_fx3_bootloader(handle);
+        found = 1;
+    }
+
+    libusb_free_device_list(devices, 1);
+    return found ? 0 : -1;
+}
+
 /* Download flash programmer to RAM (from bootloader) and return handle to it. */
 static int load_flash_programmer(int device_idx, libusb_device_handle **out_handle) {
     if (device_idx < 0 || device_idx >= num_devices) {
@@ -187,39 +321,178 @@ static int load_flash_programmer(int device_idx, libusb_device_handle **out_hand
     }
 
     printf("Downloading flash programmer %s to device %d...\n", img, device_idx);
+    fx3_set_stage(device_idx, "loader");
     int r = fx3_download_firmware(device_idx, img);
     free(img);
     if (r != 0) {
-        fprintf(stderr, "Error: Failed to load flash programmer into RAM\n");
+        fprintf(stderr, "Error: Failed to load flash programmer into RAM on device %d\n", device_idx);
         return r;
     }
 
-    /* Device will disconnect/re-enumerate as flash programmer. Refresh handles. */
-    for (int i = 0; i < num_devices; i++) {
-        if (fx3_devices[i].handle) {
-            libusb_close(fx3_devices[i].handle);
-            fx3_devices[i].handle = NULL;
-        }
-    }
+    /*
+     * Device will disconnect/re-enumerate as flash programmer on the same port.
+     * Only this device's handle is refreshed, so other devices (which may be
+     * being programmed by other threads in -a mode) are left alone.
+     */
+    libusb_close(h);
+    fx3_devices[device_idx].handle = NULL;
 
     for (int attempt = 0; attempt < 10; attempt++) {
         sleep(1);
-        if (fx3_discover_devices() < 0) {
+        if (fx3_reopen_device(device_idx) != 0) {
             continue;
         }
-        for (int i = 0; i < num_devices; i++) {
-            if (fx3_devices[i].vid == FX3_VENDOR_ID && is_flash_programmer(fx3_devices[i].handle)) {
-                *out_handle = fx3_devices[i].handle;
-                printf("Found FX3 flash programmer (device %d)\n", i);
-                return 0;
-            }
+        if (is_flash_programmer(fx3_devices[device_idx].handle)) {
+            *out_handle = fx3_devices[device_idx].handle;
+            printf("Found FX3 flash programmer (device %d)\n", device_idx);
+            return 0;
         }
     }
 
-    fprintf(stderr, "Error: Flash programmer did not enumerate\n");
+    fprintf(stderr, "Error: Flash programmer did not enumerate on device %d\n", device_idx);
     return -1;
 }
 
+/* Name of a libusb transfer status (for error messages) */
+static const char *transfer_status_name(enum libusb_transfer_status status) {
+    switch (status) {
+    case LIBUSB_TRANSFER_COMPLETED: return "completed";
+    case LIBUSB_TRANSFER_ERROR:     return "error";
+    case LIBUSB_TRANSFER_TIMED_OUT: return "timed out";
+    case LIBUSB_TRANSFER_CANCELLED: return "cancelled";
+    case LIBUSB_TRANSFER_STALL:     return "stalled";
+    case LIBUSB_TRANSFER_NO_DEVICE: return "no device";
+    case LIBUSB_TRANSFER_OVERFLOW:  return "overflow";
+    default:                        return "unknown";
+    }
+}
+
+static void LIBUSB_CALL download_callback(struct libusb_transfer *transfer) {
+    dl_slot_t *slot = transfer->user_data;
+
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED || transfer->actual_length != slot->length) {
+        if (!*slot->failed) {
+            fprintf(stderr, "\nUSB transfer failed at offset %d (0x%x): %s\n",
+                    slot->offset, slot->offset, transfer_status_name(transfer->status));
+        }
+        *slot->failed = 1;
+    } else {
+        fx3_progress(slot->device_idx, slot->offset + slot->length, slot->image_size);
+    }
+    slot->busy = 0;
+    *slot->completed = 1;
+}
+
+/*
+ * Send a firmware section to RAM with vendor request 0xA0
+ *
+ * The boot loader takes at most MAX_WRITE_SIZE bytes per request.  Rather
+ * than waiting for each request to finish before sending the next, up to
+ * download_queue_depth requests are submitted at once.  Control transfers on
+ * EP0 are carried out one at a time in the order they are submitted, so the
+ * host controller sends each request as soon as the previous one completes
+ * instead of waiting for a round trip through the program.  image_offset is
+ * the position of the section data in the image of image_size bytes (for
+ * progress and error messages).
+ *
+ * In -a mode the event handling for all the devices is shared between their
+ * threads, so a callback may be run by another thread; completed wakes this
+ * thread when one of its own transfers finishes.
+ */
+static int fx3_download_section(int device_idx, uint32_t address, uint8_t *data,
+                                int length, int image_offset, int image_size) {
+    libusb_device_handle *handle = fx3_devices[device_idx].handle;
+    dl_slot_t *slots;
+    int depth = download_queue_depth;
+    int offset = 0;
+    int failed = 0;
+    int completed = 0;
+    int in_flight = 0;
+    int i;
+
+    slots = calloc(depth, sizeof(dl_slot_t));
+    if (!slots) {
+        fprintf(stderr, "\nFailed to allocate memory for the download transfers\n");
+        return -1;
+    }
+    for (i = 0; i < depth; i++) {
+        slots[i].transfer = libusb_alloc_transfer(0);
+        slots[i].device_idx = device_idx;
+        slots[i].image_size = image_size;
+        slots[i].failed = &failed;
+        slots[i].completed = &completed;
+        if (!slots[i].transfer) {
+            fprintf(stderr, "\nFailed to allocate the download transfers\n");
+            failed = 1;
+            break;
+        }
+    }
+
+    while (!failed && (offset < length || in_flight > 0)) {
+        completed = 0;
+
+        /* Submit the next chunks to the free slots */
+        for (i = 0; i < depth && !failed && offset < length; i++) {
+            dl_slot_t *slot = &slots[i];
+            int chunk_size;
+
+            if (slot->busy) {
+                continue;
+            }
+
+            chunk_size = (length - offset > MAX_WRITE_SIZE) ? MAX_WRITE_SIZE : (length - offset);
+            libusb_fill_control_setup(slot->buffer, LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
+                                      FX3_DL_CMD, GET_LSW(address + offset), GET_MSW(address + offset),
+                                      chunk_size);
+            memcpy(slot->buffer + LIBUSB_CONTROL_SETUP_SIZE, data + offset, chunk_size);
+            libusb_fill_control_transfer(slot->transfer, handle, slot->buffer, download_callback,
+                                         slot, USB_TIMEOUT_MS);
+            slot->length = chunk_size;
+            slot->offset = image_offset + offset;
+
+            int r = libusb_submit_transfer(slot->transfer);
+            if (r < 0) {
+                fprintf(stderr, "\nUSB transfer failed at offset %d (0x%x): %s\n",
+                        slot->offset, slot->offset, libusb_error_name(r));
+                failed = 1;
+                break;
+            }
+            slot->busy = 1;
+            offset += chunk_size;
+        }
+
+        /* Wait for a transfer to finish */
+        in_flight = 0;
+        for (i = 0; i < depth; i++) {
+            in_flight += slots[i].busy;
+        }
+        if (in_flight > 0) {
+            struct timeval tv = { 1, 0 };
+            libusb_handle_events_timeout_completed(NULL, &tv, &completed);
+        }
+    }
+
+    /* After a failure, let the transfers already submitted finish */
+    for (;;) {
+        completed = 0;
+        in_flight = 0;
+        for (i = 0; i < depth; i++) {
+            in_flight += slots[i].busy;
+        }
+        if (in_flight == 0) {
+            break;
+        }
+        struct timeval tv = { 1, 0 };
+        libusb_handle_events_timeout_completed(NULL, &tv, &completed);
+    }
+
+    for (i = 0; i < depth; i++) {
+        libusb_free_transfer(slots[i].transfer);
+    }
+    free(slots);
+    return failed ? -1 : 0;
+}
+
 /* Detect if device is in bootloader mode by reading product string */
 int is_fx3_bootloader(libusb_device_handle *handle) {
     unsigned char product_string[256];
@@ -253,7 +526,7 @@ int fx3_discover_devices(void) {
 
     num_devices = 0;
 
-    for (i = 0; i < num && num_devices < 16; i++) {
+    for (i = 0; i < num && num_devices < MAX_DEVICES; i++) {
         libusb_get_device_descriptor(devices[i], &desc);
 
         /* Look for any Cypress FX3 device (bootloader/app/flashprog) or Domesday Duplicator firmware */
@@ -267,6 +540,7 @@ int fx3_discover_devices(void) {
                 fx3_devices[num_devices].bus = libusb_get_bus_number(devices[i]);
                 fx3_devices[num_devices].addr = libusb_get_device_address(devices[i]);
                 fx3_devices[num_devices].dev_class = desc.bDeviceClass;
+                fx3_devices[num_devices].port_count = fx3_get_ports(devices[i], fx3_devices[num_devices].ports);
                 fx3_devices[num_devices].is_bootloader = is_fx3_bootloader(handle);
                 fx3_devices[num_devices].index = num_devices;
                 num_devices++;
@@ -310,17 +584,136 @@ void fx3_list_devices(void) {
     printf("\n");
 }
 
+/* Read a little-endian 32-bit word from the image */
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Check a mapped firmware image and find the data to download
+ *
+ * Firmware format: CY header (2 bytes) + bImageCTL (1) + bImageType (1),
+ * then sections of length (in 32-bit words), address and data, ended by a
+ * zero length, the program entry address and a checksum (the 32-bit sum of
+ * all the section data words).
+ *
+ * The whole image is checked, including the checksum, before anything is
+ * sent, so a truncated or corrupt file never reaches the device.  Sections
+ * that follow on from the one before in memory are merged into a single run,
+ * so they are sent as full MAX_WRITE_SIZE transfers rather than each section
+ * ending with a short one.  The runs are returned in *out_runs (to be freed
+ * by the caller).
+ */
+static int fx3_parse_image(const uint8_t *image, int size, dl_run_t **out_runs, int *out_run_count,
+                           int *out_sections, uint32_t *out_entry) {
+    const uint8_t *pdata = image + 4;
+    int remaining = size - 4;
+    dl_run_t *runs = NULL;
+    int run_count = 0, run_alloc = 0, sections = 0;
+    uint32_t checksum = 0;
+
+    if (size < 4 || image[0] != 'C' || image[1] != 'Y') {
+        fprintf(stderr, "Invalid firmware file: missing CY header\n");
+        return -1;
+    }
+
+    /* Check image control byte (bit 0 = executable code flag) */
+    if (image[2] & 0x01) {
+        fprintf(stderr, "Invalid firmware: image does not contain executable code\n");
+        return -1;
+    }
+
+    /* Check image type byte (0xB0 = normal firmware with checksum) */
+    if (image[3] != 0xB0) {
+        fprintf(stderr, "Invalid firmware: not a normal FW binary with checksum (got 0x%02x)\n", image[3]);
+        return -1;
+    }
+
+    for (;;) {
+        uint32_t len, address;
+
+        if (remaining < 4) {
+            fprintf(stderr, "Invalid firmware: image is truncated (no end marker)\n");
+            free(runs);
+            return -1;
+        }
+        len = get_le32(pdata);
+        pdata += 4;
+        remaining -= 4;
+
+        if (len == 0) {
+            /* End marker, followed by the program entry address and checksum */
+            if (remaining < 8) {
+                fprintf(stderr, "Invalid firmware: image is truncated (no entry address or checksum)\n");
+                free(runs);
+                return -1;
+            }
+            if (get_le32(pdata + 4) != checksum) {
+                fprintf(stderr, "Invalid firmware: checksum mismatch (image 0x%08x, calculated 0x%08x)\n",
+                        get_le32(pdata + 4), checksum);
+                free(runs);
+                return -1;
+            }
+            *out_entry = get_le32(pdata);
+            break;
+        }
+
+        if (remaining < 4 || (uint32_t)(remaining - 4) / 4 < len) {
+            fprintf(stderr, "Invalid firmware: image is truncated (section %d)\n", sections);
+            free(runs);
+            return -1;
+        }
+        address = get_le32(pdata);
+        pdata += 4;
+        remaining -= 4;
+
+        for (uint32_t i = 0; i < len; i++) {
+            checksum += get_le32(pdata + (i * 4));
+        }
+
+        /* Merge the section into the last run if it follows on in memory */
+        if (run_count > 0 && runs[run_count - 1].address + runs[run_count - 1].bytes == address) {
+            runs[run_count - 1].bytes += len * 4;
+            runs[run_count - 1].sections++;
+        } else {
+            if (run_count == run_alloc) {
+                dl_run_t *grown;
+                run_alloc = run_alloc ? (run_alloc * 2) : 16;
+                grown = realloc(runs, run_alloc * sizeof(dl_run_t));
+                if (!grown) {
+                    fprintf(stderr, "Failed to allocate memory for firmware sections\n");
+                    free(runs);
+                    return -1;
+                }
+                runs = grown;
+            }
+            runs[run_count].address = address;
+            runs[run_count].bytes = len * 4;
+            runs[run_count].sections = 1;
+            runs[run_count].record = pdata - 8;
+            run_count++;
+        }
+
+        sections++;
+        pdata += len * 4;
+        remaining -= len * 4;
+    }
+
+    *out_runs = runs;
+    *out_run_count = run_count;
+    *out_sections = sections;
+    return 0;
+}
+
 /* Download firmware to FX3 device */
 int fx3_download_firmware(int device_idx, const char *filename) {
     int fd, ret, bytes_sent = 0;
     struct stat st;
     libusb_device_handle *handle;
-    int size, len, chunk_size;
-    uint32_t address;
-    uint8_t *pdata;
-    uint8_t *firmware_buf;
-    ssize_t bytes_read;
-    int remaining;
+    int size, run_count = 0, sections = 0;
+    uint32_t entry_address = 0;
+    uint8_t *image;
+    dl_run_t *runs = NULL;
 
     if (device_idx < 0 || device_idx >= num_devices) {
         fprintf(stderr, "Invalid device index\n");
@@ -343,127 +736,84 @@ int fx3_download_firmware(int device_idx, const char *filename) {
     }
 
     size = st.st_size;
-    printf("Uploading %s (%d bytes) to FX3 device %d...\n", filename, size, device_idx);
-    printf("Target device: VID:PID=%04x:%04x\n", fx3_devices[device_idx].vid, fx3_devices[device_idx].pid);
-
-    /* Allocate buffer for entire firmware */
-    firmware_buf = malloc(size);
-    if (!firmware_buf) {
-        fprintf(stderr, "Failed to allocate memory for firmware\n");
+    if (size < 4) {
+        fprintf(stderr, "Invalid firmware file: missing CY header\n");
         close(fd);
         return -1;
     }
 
-    /* Read entire file into buffer */
-    bytes_read = read(fd, firmware_buf, size);
+    /* Map the image rather than reading a copy of it */
+    image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
     close(fd);
-    
-    if (bytes_read != size) {
-        fprintf(stderr, "Failed to read entire firmware file (read %ld of %d bytes)\n", bytes_read, size);
-        free(firmware_buf);
-        return -1;
-    }
-
-    /* Parse firmware sections and download each one */
-    /* Firmware format:  CY header (2 bytes) + bImageCTL (1) + bImageType (1) + sections with address and data */
-    if (size < 4 || firmware_buf[0] != 'C' || firmware_buf[1] != 'Y') {
-        fprintf(stderr, "Invalid firmware file: missing CY header\n");
-        free(firmware_buf);
-        return -1;
-    }
-
-    /* Check image control byte (bit 0 = executable code flag) */
-    if (firmware_buf[2] & 0x01) {
-        fprintf(stderr, "Invalid firmware: image does not contain executable code\n");
-        free(firmware_buf);
+    if (image == MAP_FAILED) {
+        perror("Failed to map firmware file");
         return -1;
     }
 
-    /* Check image type byte (0xB0 = normal firmware with checksum) */
-    if (firmware_buf[3] != 0xB0) {
-        fprintf(stderr, "Invalid firmware: not a normal FW binary with checksum (got 0x%02x)\n", firmware_buf[3]);
-        free(firmware_buf);
+    if (fx3_parse_image(image, size, &runs, &run_count, &sections, &entry_address) != 0) {
+        munmap(image, size);
         return -1;
     }
 
-    pdata = firmware_buf + 4;
-    remaining = size - 4;
-    bytes_sent = 0;
-
-    while (remaining >= 4) {
-        /* Read length (4 bytes, little-endian) */
-        uint32_t *plen = (uint32_t *)pdata;
-        len = *plen;
-        pdata += 4;
-        remaining -= 4;
-
-        if (len == 0) {
-            /* End marker, read program entry address */
-            if (remaining >= 4) {
-                uint32_t *paddr = (uint32_t *)pdata;
-                address = *paddr;
-                printf("\nProgram entry address: 0x%08x\n", address);
-                pdata += 4;
-                remaining -= 4;
-
-                /* Send entry address with no data to start execution */
-                ret = libusb_control_transfer(handle,
-                                             LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
-                                             FX3_DL_CMD,
-                                             GET_LSW(address),
-                                             GET_MSW(address),
-                                             NULL,
-                                             0,
-                                             USB_TIMEOUT_MS);
-                if (ret < 0) {
-                    fprintf(stderr, "\nError sending program entry: %s\n", libusb_error_name(ret));
-                }
-            }
-            break;
-        }
-
-        /* Read address (4 bytes, little-endian) */
-        if (remaining < 4) break;
-        uint32_t *paddr = (uint32_t *)pdata;
-        address = *paddr;
-        pdata += 4;
-        remaining -= 4;
-
-        /* Read data section */
-        if (remaining < len * 4) break;
-        uint8_t *section_data = pdata;
-        pdata += len * 4;
-        remaining -= len * 4;
-
-        /* Send data in chunks */
-        int section_bytes = len * 4;
-        int section_offset = 0;
-
-        while (section_offset < section_bytes) {
-            chunk_size = (section_bytes - section_offset > MAX_WRITE_SIZE) ?
-                        MAX_WRITE_SIZE : (section_bytes - section_offset);
-
-            ret = libusb_control_transfer(handle,
-                                         LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
-                                         FX3_DL_CMD,
-                                         GET_LSW(address + section_offset),
-                                         GET_MSW(address + section_offset),
-                                         section_data + section_offset,
-                                         chunk_size,
-                                         USB_TIMEOUT_MS);
-
-            if (ret < 0) {
-                fprintf(stderr, "\nUSB transfer failed at offset %d (0x%x): %s\n",
-                       bytes_sent + section_offset, bytes_sent + section_offset,
-                       libusb_error_name(ret));
+    printf("Uploading %s (%d bytes) to FX3 device %d...\n", filename, size, device_idx);
+    printf("Target device: VID:PID=%04x:%04x\n", fx3_devices[device_idx].vid, fx3_devices[device_idx].pid);
+    printf("Image: %d section(s), sent as %d contiguous run(s)\n", sections, run_count);
+
+    for (int r = 0; r < run_count; r++) {
+        uint8_t *run_data;
+        uint8_t *merged = NULL;
+
+        if (runs[r].sections == 1) {
+            /* Send straight from the mapped image */
+            run_data = (uint8_t *)runs[r].record + 8;
+        } else {
+            /* Gather the data of the merged sections (each follows its own length and address) */
+            const uint8_t *record = runs[r].record;
+            int copied = 0;
+
+            merged = malloc(runs[r].bytes);
+            if (!merged) {
+                fprintf(stderr, "\nFailed to allocate memory for firmware sections\n");
+                free(runs);
+                munmap(image, size);
                 return -1;
             }
+            for (int s = 0; s < runs[r].sections; s++) {
+                int section_bytes = get_le32(record) * 4;
+                memcpy(merged + copied, record + 8, section_bytes);
+                copied += section_bytes;
+                record += 8 + section_bytes;
+            }
+            run_data = merged;
+        }
 
-            section_offset += ret;
-            bytes_sent += ret;
-            printf(".");
-            fflush(stdout);
+        /* Send the run data (several chunks in flight at once) */
+        ret = fx3_download_section(device_idx, runs[r].address, run_data, runs[r].bytes, bytes_sent, size);
+        free(merged);
+        if (ret != 0) {
+            free(runs);
+            munmap(image, size);
+            return -1;
         }
+        bytes_sent += runs[r].bytes;
+    }
+
+    free(runs);
+    munmap(image, size);
+
+    printf("\nProgram entry address: 0x%08x\n", entry_address);
+
+    /* Send entry address with no data to start execution */
+    ret = libusb_control_transfer(handle,
+                                 LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_ENDPOINT_OUT,
+                                 FX3_DL_CMD,
+                                 GET_LSW(entry_address),
+                                 GET_MSW(entry_address),
+                                 NULL,
+                                 0,
+                                 USB_TIMEOUT_MS);
+    if (ret < 0) {
+        fprintf(stderr, "\nError sending program entry: %s\n", libusb_error_name(ret));
     }
 
     printf("\n");
@@ -493,6 +843,8 @@ int fx3_program_prom(int device_idx, const char *filename) {
         return -1;
     }
 
+    fx3_set_stage(device_idx, "program");
+
     /* Open firmware file */
     fd = open(filename, O_RDONLY);
     if (fd < 0) {
@@ -550,12 +902,119 @@ int fx3_program_prom(int device_idx, const char *filename) {
         remaining -= chunk;
         address++;
         bytes_sent += chunk;
-        printf(".");
-        fflush(stdout);
+        fx3_progress(device_idx, offset, bytes_to_write);
+    }
+
+    free(firmware_buf);
+    printf("\nSuccessfully programmed %d bytes to FX3 I2C EEPROM on device %d\n", bytes_sent, device_idx);
+    return 0;
+}
+
+/*
+ * Update firmware in the I2C EEPROM on FX3 device, rewriting only what has changed
+ *
+ * The EEPROM is read back in MAX_WRITE_SIZE blocks and each block is compared
+ * with the new image.  Only the blocks that differ are written, and only those
+ * are read back again to verify them, so a small change to the firmware is
+ * written in a few seconds rather than rewriting the whole EEPROM.  Reading a
+ * block is much quicker than writing it (every EEPROM page write takes a few
+ * milliseconds), so nothing is lost when every block has changed.
+ *
+ * Every block has been checked against the image by the time this returns,
+ * so a separate verify is not needed.
+ */
+int fx3_update_prom(int device_idx, const char *filename) {
+    int fd;
+    struct stat st;
+    libusb_device_handle *prog_handle = NULL;
+    int size;
+    uint8_t *firmware_buf;
+    uint8_t block_buf[MAX_WRITE_SIZE];
+    ssize_t bytes_read;
+    int bytes_to_write;
+    int offset;
+    int blocks = 0, blocks_written = 0;
+
+    if (device_idx < 0 || device_idx >= num_devices) {
+        fprintf(stderr, "Invalid device index\n");
+        return -1;
+    }
+
+    /* Ensure flash programmer is running (loads cyfxflashprog.img if needed) */
+    if (load_flash_programmer(device_idx, &prog_handle) != 0) {
+        return -1;
+    }
+
+    fx3_set_stage(device_idx, "update");
+
+    /* Open firmware file */
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open firmware file");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("Failed to stat firmware file");
+        close(fd);
+        return -1;
+    }
+
+    size = st.st_size;
+    bytes_to_write = ((size + I2C_PAGE_SIZE - 1) / I2C_PAGE_SIZE) * I2C_PAGE_SIZE;
+    printf("Updating FX3 I2C EEPROM with %s (%d bytes, padded to %d), writing changed blocks only...\n",
+           filename, size, bytes_to_write);
+
+    firmware_buf = calloc(1, bytes_to_write);
+    if (!firmware_buf) {
+        fprintf(stderr, "Failed to allocate memory for firmware\n");
+        close(fd);
+        return -1;
+    }
+
+    bytes_read = read(fd, firmware_buf, size);
+    close(fd);
+    if (bytes_read != size) {
+        fprintf(stderr, "Failed to read entire firmware file (read %ld of %d bytes)\n", bytes_read, size);
+        free(firmware_buf);
+        return -1;
+    }
+
+    /* Blocks never straddle a 64KB I2C slave address (MAX_WRITE_SIZE divides I2C_SLAVE_SIZE) */
+    for (offset = 0; offset < bytes_to_write; offset += MAX_WRITE_SIZE) {
+        int chunk = (bytes_to_write - offset > MAX_WRITE_SIZE) ? MAX_WRITE_SIZE : (bytes_to_write - offset);
+        int devAddr = offset / I2C_SLAVE_SIZE;
+        int address = offset % I2C_SLAVE_SIZE;
+
+        blocks++;
+        if (fx3_i2c_read_block(prog_handle, block_buf, devAddr, address, chunk) != 0) {
+            fprintf(stderr, "\nError: I2C read failed at devAddr %d offset %d\n", devAddr, offset);
+            free(firmware_buf);
+            return -1;
+        }
+
+        if (memcmp(block_buf, firmware_buf + offset, chunk) != 0) {
+            if (fx3_i2c_write_block(prog_handle, firmware_buf + offset, devAddr, address, chunk) != 0) {
+                fprintf(stderr, "\nError: I2C write failed at devAddr %d offset %d\n", devAddr, offset);
+                free(firmware_buf);
+                return -1;
+            }
+
+            if (fx3_i2c_read_block(prog_handle, block_buf, devAddr, address, chunk) != 0 ||
+                memcmp(block_buf, firmware_buf + offset, chunk) != 0) {
+                fprintf(stderr, "\nError: I2C verify failed at devAddr %d offset %d\n", devAddr, offset);
+                free(firmware_buf);
+                return -1;
+            }
+            blocks_written++;
+        }
+
+        fx3_progress(device_idx, offset + chunk, bytes_to_write);
     }
 
     free(firmware_buf);
-    printf("\nSuccessfully programmed %d bytes to FX3 I2C EEPROM\n", bytes_sent);
+    printf("\nSuccessfully updated FX3 I2C EEPROM on device %d: %d of %d blocks (%d bytes each) changed\n",
+           device_idx, blocks_written, blocks, MAX_WRITE_SIZE);
     return 0;
 }
 
@@ -585,6 +1044,8 @@ int fx3_verify_firmware(int device_idx, const char *filename) {
         return -1;
     }
 
+    fx3_set_stage(device_idx, "verify");
+
     /* Open firmware file */
     fd = open(filename, O_RDONLY);
     if (fd < 0) {
@@ -634,12 +1095,11 @@ int fx3_verify_firmware(int device_idx, const char *filename) {
         offset += chunk;
         remaining -= chunk;
         address++;
-        printf(".");
-        fflush(stdout);
+        fx3_progress(device_idx, offset, bytes_to_verify);
     }
 
     free(firmware_buf);
-    printf("\nVerification successful: EEPROM matches %s\n", filename);
+    printf("\nVerification successful: EEPROM on device %d matches %s\n", device_idx, filename);
     return 0;
 }
 
@@ -655,6 +1115,121 @@ int fx3_reset_device(int device_idx) {
     return 0;
 }
 
+/* Carry out the requested operations on one device (-a mode worker thread) */
+static void *fx3_device_worker(void *arg) {
+    fx3_job_t *job = arg;
+    int ret = 0;
+
+    if (job->firmware_file) {
+        fx3_set_stage(job->device_idx, "upload");
+        ret = fx3_download_firmware(job->device_idx, job->firmware_file);
+    }
+
+    if (ret == 0 && job->prom_file && job->incremental) {
+        ret = fx3_update_prom(job->device_idx, job->prom_file);
+    } else if (ret == 0 && job->prom_file) {
+        ret = fx3_program_prom(job->device_idx, job->prom_file);
+        if (ret == 0 && job->verify) {
+            ret = fx3_verify_firmware(job->device_idx, job->prom_file);
+        }
+    }
+
+    fx3_set_stage(job->device_idx, (ret == 0) ? "done" : "failed");
+    job->result = ret;
+    job->finished = 1;
+    return NULL;
+}
+
+/*
+ * Program every device in bootloader or flash programmer mode at the same
+ * time, one worker thread per device, so updating a bench of units takes
+ * as long as the slowest one.  Devices running application firmware are
+ * skipped.  The progress of each device is shown once a second, followed by
+ * the result for each device.
+ */
+static int fx3_program_all(const char *firmware_file, const char *prom_file, int verify, int incremental) {
+    static fx3_job_t jobs[MAX_DEVICES];
+    char status[MAX_DEVICES * 32];
+    char last_status[MAX_DEVICES * 32] = "";
+    int i, running, len, failures = 0, started = 0;
+
+    parallel_mode = 1;
+
+    for (i = 0; i < num_devices; i++) {
+        fx3_job_t *job = &jobs[i];
+
+        memset(job, 0, sizeof(*job));
+        job->device_idx = i;
+        job->firmware_file = firmware_file;
+        job->prom_file = prom_file;
+        job->verify = verify;
+        job->incremental = incremental;
+
+        if (!fx3_devices[i].is_bootloader && !is_flash_programmer(fx3_devices[i].handle)) {
+            continue;
+        }
+
+        fx3_set_stage(i, "waiting");
+        if (pthread_create(&job->thread, NULL, fx3_device_worker, job) != 0) {
+            fprintf(stderr, "Failed to start a thread for device %d\n", i);
+            job->result = -1;
+            continue;
+        }
+        job->started = 1;
+        started++;
+    }
+
+    if (started == 0) {
+        fprintf(stderr, "No devices in bootloader or flash programmer mode\n");
+        parallel_mode = 0;
+        return -1;
+    }
+    printf("Programming %d device(s)...\n", started);
+
+    do {
+        sleep(1);
+        running = 0;
+        len = 0;
+        for (i = 0; i < num_devices; i++) {
+            if (!jobs[i].started) {
+                continue;
+            }
+            if (!jobs[i].finished) {
+                running++;
+            }
+            len += snprintf(status + len, sizeof(status) - len, " [%d] %s %d%%",
+                            i, fx3_devices[i].stage, fx3_devices[i].percent);
+        }
+        if (strcmp(status, last_status) != 0) {
+            printf("Progress:%s\n", status);
+            fflush(stdout);
+            strcpy(last_status, status);
+        }
+    } while (running > 0);
+
+    printf("\nResults:\n");
+    for (i = 0; i < num_devices; i++) {
+        const char *result;
+
+        if (jobs[i].started) {
+            pthread_join(jobs[i].thread, NULL);
+            result = (jobs[i].result == 0) ? "OK" : "FAILED";
+        } else if (jobs[i].result != 0) {
+            result = "FAILED (thread not started)";
+        } else {
+            result = "skipped (application mode)";
+        }
+
+        if (jobs[i].result != 0) {
+            failures++;
+        }
+        printf("  [%d] Bus=%03d Device=%03d: %s\n", i, fx3_devices[i].bus, fx3_devices[i].addr, result);
+    }
+
+    parallel_mode = 0;
+    return (failures == 0) ? 0 : -1;
+}
+
 /* Print usage information */
 void print_usage(const char *prog) {
     printf("FX3 Firmware Programmer\n\n");
@@ -662,9 +1237,13 @@ void print_usage(const char *prog) {
     printf("Options:\n");
     printf("  -l                 List connected FX3 devices\n");
     printf("  -d DEVICE_IDX      Target device index (default: 0)\n");
+    printf("  -a                 Target every device in bootloader mode, in parallel (with -u/-p/-v)\n");
     printf("  -u FIRMWARE_FILE   Upload firmware to device RAM\n");
     printf("  -p FIRMWARE_FILE   Program firmware to SPI flash (persistent)\n");
     printf("  -v                 Verify EEPROM contents against firmware file (use with -p)\n");
+    printf("  -i                 Only rewrite the EEPROM blocks that have changed (use with -p)\n");
+    printf("  -q DEPTH           RAM upload transfers in flight (default: %d, max: %d, 1 = one at a time)\n",
+           DL_QUEUE_DEPTH, DL_QUEUE_DEPTH_MAX);
     printf("  -r                 Reset device\n");
     printf("  -h                 Show this help message\n\n");
     printf("Examples:\n");
@@ -674,6 +1253,8 @@ void print_usage(const char *prog) {
     printf("  %s -d 1 -u firmware.img        Upload firmware to RAM on device 1\n", prog);
     printf("  %s -d 0 -v                     Verify device 0 firmware\n", prog);
     printf("  %s -d 0 -r                     Reset device 0\n", prog);
+    printf("  %s -a -p firmware.img -v       Program and verify every device in bootloader mode\n", prog);
+    printf("  %s -p firmware.img -i          Update the EEPROM on device 0, writing changed blocks only\n", prog);
     printf("\n");
     printf("Notes:\n");
     printf("  - SPI flash programming requires device to be in bootloader mode\n");
@@ -690,6 +1271,8 @@ int main(int argc, char *argv[]) {
     int reset_flag = 0;
     int upload_flag = 0;
     int prom_flag = 0;
+    int all_flag = 0;
+    int incremental_flag = 0;
 
     /* Initialize libusb */
     if (libusb_init(NULL) < 0) {
@@ -698,7 +1281,7 @@ int main(int argc, char *argv[]) {
     }
 
     /* Parse command line arguments */
-    while ((opt = getopt(argc, argv, "ld:u:p:vrh")) != -1) {
+    while ((opt = getopt(argc, argv, "ld:au:p:viq:rh")) != -1) {
         switch (opt) {
         case 'l':
             list_devices_flag = 1;
@@ -706,6 +1289,9 @@ int main(int argc, char *argv[]) {
         case 'd':
             device_idx = atoi(optarg);
             break;
+        case 'a':
+            all_flag = 1;
+            break;
         case 'u':
             firmware_file = optarg;
             upload_flag = 1;
@@ -717,6 +1303,17 @@ int main(int argc, char *argv[]) {
         case 'v':
             verify_flag = 1;
             break;
+        case 'i':
+            incremental_flag = 1;
+            break;
+        case 'q':
+            download_queue_depth = atoi(optarg);
+            if (download_queue_depth < 1 || download_queue_depth > DL_QUEUE_DEPTH_MAX) {
+                fprintf(stderr, "Invalid queue depth: %s (1 to %d)\n", optarg, DL_QUEUE_DEPTH_MAX);
+                libusb_exit(NULL);
+                return 1;
+            }
+            break;
         case 'r':
             reset_flag = 1;
             break;
@@ -751,11 +1348,34 @@ int main(int argc, char *argv[]) {
         fx3_list_devices();
     }
 
+    if (all_flag) {
+        if (verify_flag && !prom_flag) {
+            fprintf(stderr, "Verify requires a firmware file. Use -p <file> -v to program and verify.\n");
+            ret = -1;
+        } else if (upload_flag || prom_flag) {
+            ret = fx3_program_all(upload_flag ? firmware_file : NULL, prom_flag ? prom_file : NULL,
+                                  verify_flag, incremental_flag);
+            if (ret == 0 && prom_flag) {
+                printf("Power cycle the devices (remove J4/PMODE to boot from EEPROM)\n");
+            }
+        }
+        upload_flag = 0;
+        prom_flag = 0;
+        verify_flag = 0;
+        reset_flag = 0;
+    }
+
     if (upload_flag && firmware_file) {
         ret = fx3_download_firmware(device_idx, firmware_file);
     }
 
-    if (prom_flag && prom_file) {
+    if (prom_flag && prom_file && incremental_flag) {
+        /* Every block is checked against the image, so -v adds nothing */
+        ret = fx3_update_prom(device_idx, prom_file);
+        if (ret == 0) {
+            printf("Power cycle the device (remove J4/PMODE to boot from EEPROM)\n");
+        }
+    } else if (prom_flag && prom_file) {
         ret = fx3_program_prom(device_idx, prom_file);
         if (verify_flag && ret == 0) {
             ret = fx3_verify_firmware(device_idx, prom_file);